@@ -0,0 +1,288 @@
+/*============================================================================
+*
+*    名称：agtest00.c
+*
+*    目的：测试 'solagg.c' 中的流式统计。
+*
+*        若干站点、一年的逐分钟网格，边计算边按站点和当地月份统计：
+*        地外辐射累计量（Wh/平方米）、最大太阳高度角及其时刻、太阳
+*        高度角大于 0 的小时数、倾斜面入射角余弦的中位数和 90% 分位数。
+*
+*        一、用 1、2、4 个线程分别统计，核对所有结果逐位相同。
+*        二、对 0 号站点另算完整序列，用双精度直接求和、排序取分位数
+*        作为对照，打印最大偏差。
+*        三、打印 0 号站点的月度统计表，以及累加器占用的内存与完整
+*        序列所需内存的对比。
+*        四、NaN：一列五行 NaN、2、NaN、5、-1（第一行就是 NaN），求和、
+*        均值、最大、最小、中位数应只算三个数，跳过数为 NaN 个数乘
+*        统计项数。
+*
+*        第一、四部分检查不过时返回 1。
+*
+*    用法：
+*         agtest [站点数 [天数]]        默认 16 个站点，365 天
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "solpos00.h"
+#include "solagg.h"
+#include "solrt.h"
+
+#define START  1672531200LL          /* 2023-01-01 00:00 UTC */
+
+static int cmpf(const void *a, const void *b)
+{
+    float x = *(const float *) a, y = *(const float *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+int main(int argc, char *argv[])
+{
+    struct posdata     *sites;
+    struct solgrid      grid;
+    struct solagg_spec  spec;
+    struct solagg       agg[3];
+    struct solbatch     batch;
+    struct tm           tm;
+    long long *utc, t0, when;
+    float     *etr, *elev, *cosinc, *sorted;
+    long      *retval, ntime, r, p, n, first, cnt;
+    double    *sum, sec, d, dmax[5] = { 0 }, ref, ref2, v;
+    int        nsite = 16, days = 365, threads[3] = { 1, 2, 4 }, k, t, same,
+               y, m, dd;
+    time_t     lt;
+
+    if (argc > 1) nsite = atoi(argv[1]);
+    if (argc > 2) days  = atoi(argv[2]);
+    if (nsite < 1) nsite = 1;
+    if (days < 1) days = 1;
+
+    sites = (struct posdata *) malloc(nsite * sizeof(*sites));
+    if (!sites)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    for (k = 0; k < nsite; k++)
+    {
+        S_init(&sites[k]);
+        sites[k].latitude  = -60.0 + 120.0 * k / nsite + 1.0;
+        sites[k].longitude = -180.0 + 360.0 * k / nsite;
+        sites[k].timezone  = (float) (int) (sites[k].longitude / 15.0);
+        sites[k].tilt      = 30.0;
+    }
+    /* 0 号站点放在大连 */
+    sites[0].latitude  = 38.9;
+    sites[0].longitude = 121.6;
+    sites[0].timezone  = 8.0;
+
+    memset(&grid, 0, sizeof(grid));
+    grid.sites = sites;
+    grid.nsite = nsite;
+    grid.start = START;
+    grid.step  = 60;
+    grid.ntime = 1440L * days;
+
+    memset(&spec, 0, sizeof(spec));
+    spec.sites = sites;
+    spec.nsite = nsite;
+    spec.start = START;
+    spec.end   = START + grid.ntime * grid.step;
+    spec.step  = grid.step;
+    spec.by    = S_AGG_MONTH;
+    spec.nop   = 5;
+    spec.op[0].col = C_ETR;     spec.op[0].kind = A_INTEG;
+    spec.op[1].col = C_ELEVREF; spec.op[1].kind = A_MAX;
+    spec.op[2].col = C_ELEVREF; spec.op[2].kind = A_HOURS;
+    spec.op[3].col = C_COSINC;  spec.op[3].kind = A_PCTL; spec.op[3].arg = 50;
+    spec.op[4].col = C_COSINC;  spec.op[4].kind = A_PCTL; spec.op[4].arg = 90;
+    for (k = 3; k < 5; k++)
+    {
+        spec.op[k].lo    = -1.0;
+        spec.op[k].hi    =  1.0;
+        spec.op[k].nbins = 2000;
+    }
+
+    /* 一、不同线程数的结果应逐位相同 */
+    for (t = 0; t < 3; t++)
+    {
+        if (S_agg_init(&agg[t], &spec) != 0)
+        {
+            printf("内存不足\n");
+            return 1;
+        }
+        t0 = S_rt_now();
+        cnt = S_agg_grid(&grid, &agg[t], threads[t]);
+        sec = (S_rt_now() - t0) * 1.0e-9;
+        printf("%d 线程：%ld 行，出错 %ld，跳过 %ld，%.3f 秒，%.0f 行/秒\n",
+               threads[t], agg[t].rows, cnt, agg[t].skipped, sec,
+               agg[t].rows / sec);
+    }
+    same = 1;
+    for (t = 1; t < 3; t++)
+        if (memcmp(agg[0].acc, agg[t].acc,
+                   agg[0].ngroup * spec.nop * sizeof(struct solacc)) != 0 ||
+            memcmp(agg[0].hist, agg[t].hist,
+                   agg[0].ngroup * agg[0].hbins * sizeof(*agg[0].hist)) != 0)
+            same = 0;
+    printf("1、2、4 线程的统计结果%s\n", same ? "逐位相同" : "不同！");
+
+    /* 二、0 号站点的完整序列作对照 */
+    ntime  = grid.ntime;
+    utc    = (long long *) malloc(ntime * sizeof(*utc));
+    retval = (long *) malloc(ntime * sizeof(*retval));
+    etr    = (float *) malloc(ntime * sizeof(float));
+    elev   = (float *) malloc(ntime * sizeof(float));
+    cosinc = (float *) malloc(ntime * sizeof(float));
+    sorted = (float *) malloc(ntime * sizeof(float));
+    sum    = (double *) calloc(agg[0].nperiod * 3, sizeof(double));
+    if (!utc || !retval || !etr || !elev || !cosinc || !sorted || !sum)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    for (r = 0; r < ntime; r++)
+        utc[r] = START + r * grid.step;
+    memset(&batch, 0, sizeof(batch));
+    batch.count  = ntime;
+    batch.utc    = utc;
+    batch.sites  = sites;
+    batch.retval = retval;
+    batch.col[C_ETR]     = etr;
+    batch.col[C_ELEVREF] = elev;
+    batch.col[C_COSINC]  = cosinc;
+    S_batch(&batch, 0, ntime);
+
+    for (r = 0; r < ntime; r++)
+    {
+        lt = (time_t) (utc[r] + (long long) (sites[0].timezone * 3600));
+        gmtime_r(&lt, &tm);
+        p = (tm.tm_year + 1900) * 12L + tm.tm_mon - agg[0].first;
+        sum[3 * p]     += etr[r] * grid.step / 3600.0;
+        if (elev[r] > sum[3 * p + 1] || sum[3 * p + 2] == 0)
+            sum[3 * p + 1] = elev[r];
+        sum[3 * p + 2] += 1;
+    }
+    first = 0;
+    for (p = 0; p < agg[0].nperiod; p++)
+    {
+        n = (long) sum[3 * p + 2];
+        if (n == 0)
+            continue;
+        d = fabs(S_agg_value(&agg[0], 0, p, 0, NULL) - sum[3 * p]);
+        if (d > dmax[0]) dmax[0] = d;
+        d = fabs(S_agg_value(&agg[0], 0, p, 1, NULL) - sum[3 * p + 1]);
+        if (d > dmax[1]) dmax[1] = d;
+        for (cnt = 0, r = first; r < first + n; r++)
+            cnt += elev[r] > 0.0;
+        d = fabs(S_agg_value(&agg[0], 0, p, 2, NULL) - cnt * grid.step / 3600.0);
+        if (d > dmax[2]) dmax[2] = d;
+        memcpy(sorted, cosinc + first, n * sizeof(float));
+        qsort(sorted, n, sizeof(float), cmpf);
+        for (k = 3; k < 5; k++)
+        {
+            r = (long) ceil(spec.op[k].arg / 100.0 * n) - 1;
+            d = fabs(S_agg_value(&agg[0], 0, p, k, NULL) - sorted[r < 0 ? 0 : r]);
+            if (d > dmax[k]) dmax[k] = d;
+        }
+        first += n;
+    }
+    printf("与完整序列对照的最大偏差：累计量 %.3g Wh/平方米，最大高度角 %.3g 度，"
+           "小时数 %.3g，中位数 %.3g，90%% 分位数 %.3g（分箱宽 %.3g）\n",
+           dmax[0], dmax[1], dmax[2], dmax[3], dmax[4], 2.0 / spec.op[3].nbins);
+
+    /* 三、0 号站点的月度统计 */
+    printf("\n0 号站点（%.1f, %.1f）\n", sites[0].latitude, sites[0].longitude);
+    printf("   月份     地外辐射 kWh/m2  最大高度角  时刻(UTC)          "
+           "白昼小时  cosinc 中位  90%%\n");
+    for (p = 0; p < agg[0].nperiod; p++)
+    {
+        v = S_agg_value(&agg[0], 0, p, 1, &when);
+        if (isnan(v))                     /* 其他站点时区才有的月份 */
+            continue;
+        S_agg_label(&agg[0], p, &y, &m, &dd);
+        lt = (time_t) when;
+        gmtime_r(&lt, &tm);
+        ref  = S_agg_value(&agg[0], 0, p, 3, NULL);
+        ref2 = S_agg_value(&agg[0], 0, p, 4, NULL);
+        printf("  %04d-%02d  %14.2f  %10.2f  %04d-%02d-%02d %02d:%02d  %8.1f  "
+               "%9.3f  %6.3f\n", y, m,
+               S_agg_value(&agg[0], 0, p, 0, NULL) / 1000.0, v,
+               tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour,
+               tm.tm_min, S_agg_value(&agg[0], 0, p, 2, NULL), ref, ref2);
+    }
+
+    printf("\n累加器 %.1f KB（其中直方图 %.1f KB），完整序列三列需 %.1f MB\n",
+           (agg[0].ngroup * spec.nop * sizeof(struct solacc) +
+            agg[0].ngroup * agg[0].hbins * sizeof(*agg[0].hist)) / 1024.0,
+           agg[0].ngroup * agg[0].hbins * sizeof(*agg[0].hist) / 1024.0,
+           (double) nsite * ntime * 3 * sizeof(float) / 1048576.0);
+
+    /* 四、NaN 不进统计 */
+    {
+        static const int  kind[5] = { A_SUM, A_MEAN, A_MAX, A_MIN, A_PCTL };
+        static const double want[5] = { 6.0, 2.0, 5.0, -1.0, 2.0 };
+        long long tt[5];
+        float     val[5] = { NAN, 2.0f, NAN, 5.0f, -1.0f };
+        struct solagg a;
+
+        for (r = 0; r < 5; r++)
+            tt[r] = START + r * 60;
+        memset(&batch, 0, sizeof(batch));
+        batch.count  = 5;
+        batch.utc    = tt;
+        batch.sites  = sites;
+        batch.col[C_ETR] = val;
+        spec.nsite = 1;
+        spec.end   = START + 3600;
+        spec.by    = S_AGG_ALL;
+        spec.nop   = 5;
+        for (k = 0; k < 5; k++)
+        {
+            memset(&spec.op[k], 0, sizeof(spec.op[k]));
+            spec.op[k].col  = C_ETR;
+            spec.op[k].kind = kind[k];
+        }
+        spec.op[4].arg   = 50;
+        spec.op[4].lo    = -10.0;
+        spec.op[4].hi    = 10.0;
+        spec.op[4].nbins = 20000;
+        if (S_agg_init(&a, &spec) != 0)
+            return 1;
+        S_agg_add(&a, &batch, 0, 5);
+        printf("\nNaN：行 %ld，跳过 %ld（应为 5、10）；和、均值、最大、最小、"
+               "中位数", a.rows, a.skipped);
+        if (a.rows != 5 || a.skipped != 10)
+            same = 0;
+        for (k = 0; k < 5; k++)
+        {
+            v = S_agg_value(&a, 0, 0, k, &when);
+            printf(" %g", v);
+            if (!(fabs(v - want[k]) < 1.0e-3))
+                same = 0;
+        }
+        printf("（应为 6 2 5 -1 2）\n");
+        S_agg_free(&a);
+    }
+
+    for (t = 0; t < 3; t++)
+        S_agg_free(&agg[t]);
+    free(sites);
+    free(utc);
+    free(retval);
+    free(etr);
+    free(elev);
+    free(cosinc);
+    free(sorted);
+    free(sum);
+    printf("\n检查%s\n", same ? "通过" : "不过");
+    return !same;
+}
@@ -0,0 +1,173 @@
+/*============================================================================
+*
+*    名称：artest00.c
+*
+*    目的：测试 'solarrow.c' 的 Arrow C Data Interface 导出。
+*
+*        计算一批数据后导出为 ArrowArray/ArrowSchema，本程序扮演使用方
+*        （pyarrow、polars 之类）：按模式逐列检查格式和名称，确认数据
+*        缓冲区就是批量计算的原数组（没有复制），并通过 Arrow 结构读回
+*        数据求和核对。然后按接口允许的方式把一列“移走”，先释放整个
+*        数组，再释放移走的列，检查结果数组只在最后一次释放时归还
+*        （done 回调恰好调用一次）。
+*
+*        格式或名称不符、缓冲区被复制、求和不等、done 调用次数或
+*        释放标志不对时返回 1。
+*
+*    用法：
+*         artest [站点数 [天数]]     默认 16 站点，7 天
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solpos00.h"
+#include "solarrow.h"
+
+struct owner          /* 批量计算结果的所有者 */
+{
+    long long *utc;
+    int       *site;
+    long      *retval;
+    float     *azim, *zenref, *etrtilt;
+    int        freed;
+};
+
+static void done(void *p)
+{
+    struct owner *o = (struct owner *) p;
+
+    free(o->utc);
+    free(o->site);
+    free(o->retval);
+    free(o->azim);
+    free(o->zenref);
+    free(o->etrtilt);
+    o->freed++;
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *expect[][2] = {
+        { "utc", "tss:UTC" }, { "site", "i" }, { "retval", "l" },
+        { "azim", "f" }, { "etrtilt", "f" }, { "zenref", "f" } };
+    struct owner       own;
+    struct posdata    *sites;
+    struct solbatch    batch;
+    struct ArrowArray  array, moved;
+    struct ArrowSchema schema;
+    const float *f;
+    double  sum_src = 0.0, sum_arrow = 0.0;
+    long    rows, ntime, r;
+    int     nsite = 16, days = 7, k, bad = 0, copied = 0;
+
+    if (argc > 1) nsite = atoi(argv[1]);
+    if (argc > 2) days  = atoi(argv[2]);
+    if (nsite < 1) nsite = 1;
+    ntime = 1440L * days;
+    rows  = ntime * nsite;
+
+    sites = (struct posdata *) malloc(nsite * sizeof(*sites));
+    memset(&own, 0, sizeof(own));
+    own.utc     = (long long *) malloc(rows * sizeof(long long));
+    own.site    = (int *) malloc(rows * sizeof(int));
+    own.retval  = (long *) malloc(rows * sizeof(long));
+    own.azim    = (float *) malloc(rows * sizeof(float));
+    own.zenref  = (float *) malloc(rows * sizeof(float));
+    own.etrtilt = (float *) malloc(rows * sizeof(float));
+    if (!sites || !own.utc || !own.site || !own.retval || !own.azim ||
+        !own.zenref || !own.etrtilt)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    for (k = 0; k < nsite; k++)
+    {
+        S_init(&sites[k]);
+        sites[k].latitude  = -60.0 + 120.0 * k / nsite;
+        sites[k].longitude = -180.0 + 360.0 * k / nsite;
+        sites[k].timezone  = (float) (int) (sites[k].longitude / 15.0);
+        sites[k].tilt      = 30.0;
+    }
+    for (r = 0; r < rows; r++)
+    {
+        own.site[r] = (int) (r / ntime);
+        own.utc[r]  = 1672531200LL + (r % ntime) * 60;
+    }
+
+    memset(&batch, 0, sizeof(batch));
+    batch.count  = rows;
+    batch.utc    = own.utc;
+    batch.site   = own.site;
+    batch.sites  = sites;
+    batch.retval = own.retval;
+    batch.col[C_AZIM]    = own.azim;
+    batch.col[C_ZENREF]  = own.zenref;
+    batch.col[C_ETRTILT] = own.etrtilt;
+    S_batch_parallel(&batch, 4);
+    for (r = 0; r < rows; r++)
+        sum_src += own.etrtilt[r];
+
+    if (S_arrow_export(&batch, &array, &schema, done, &own) != 0)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+
+    /* 使用方：先看模式 */
+    printf("模式 %s，%lld 列，%lld 行\n", schema.format,
+           (long long) schema.n_children, (long long) array.length);
+    for (k = 0; k < schema.n_children; k++)
+    {
+        printf("  %-8s %s\n", schema.children[k]->name,
+               schema.children[k]->format);
+        if (strcmp(schema.children[k]->name, expect[k][0]) != 0 ||
+            strcmp(schema.children[k]->format, expect[k][1]) != 0 ||
+            array.children[k]->length != rows ||
+            array.children[k]->n_buffers != 2 ||
+            array.children[k]->buffers[0] != NULL)
+            bad++;
+    }
+
+    /* 数据缓冲区应当就是原数组 */
+    if (array.children[0]->buffers[1] != own.utc)     copied++;
+    if (array.children[3]->buffers[1] != own.azim)    copied++;
+    if (array.children[4]->buffers[1] != own.etrtilt) copied++;
+
+    f = (const float *) array.children[4]->buffers[1];
+    for (r = 0; r < array.length; r++)
+        sum_arrow += f[r];
+
+    /* 移走 zenref 列，然后释放模式和整个数组 */
+    moved = *array.children[5];
+    array.children[5]->release = NULL;
+    schema.release(&schema);
+    array.release(&array);
+    printf("释放数组后 done 调用 %d 次（应为 0，移走的列还在用）\n",
+           own.freed);
+    if (own.freed != 0)
+        bad++;
+    printf("移走的列第一行 zenref = %.4f\n",
+           ((const float *) moved.buffers[1])[0]);
+    if (own.freed == 0 && moved.buffers[1] != own.zenref)
+        copied++;
+    moved.release(&moved);
+    printf("释放移走的列后 done 调用 %d 次（应为 1）\n", own.freed);
+    if (own.freed != 1 || moved.release != NULL)
+        bad++;
+
+    printf("列格式或名称不符 %d 处，被复制的缓冲区 %d 个\n", bad, copied);
+    printf("etrtilt 求和：原数组 %.6e，经 Arrow 读回 %.6e\n",
+           sum_src, sum_arrow);
+    printf("释放标志：数组 %s，模式 %s\n",
+           array.release ? "未清" : "已清", schema.release ? "未清" : "已清");
+    if (sum_arrow != sum_src || array.release || schema.release)
+        bad++;
+
+    free(sites);
+    printf("\n检查不过 %d 处\n", bad + copied);
+    return bad + copied != 0;
+}
@@ -0,0 +1,253 @@
+/*============================================================================
+*
+*    名称：axtest00.c
+*
+*    目的：测试 'soltrack.c' 的单轴跟踪器转角与逆跟踪（backtracking）。
+*
+*        敦煌附近一座电站一年的逐时批量计算，NTRACK 排跟踪器：南北向
+*        水平轴（部分排的轴向南倾斜 5 度），地坪坡度 0 - 8 度、坡向
+*        各不相同，用 S_track_slope 得到各排的横轴坡度；gcr 0.4，限位
+*        +/- 55 度。
+*
+*        一、与按 pvlib singleaxis() 的公式逐行用双精度写成的对照计算
+*        比较，打印理想转角、实际转角、面板倾角、方位角和 cosinc 的最大
+*        偏差；验算横轴坡度那条线确实在坡面上。
+*        二、遮挡检验：对每排每时，用双精度算前排阴影宽度与行距之比，
+*        逆跟踪时应没有一小时被遮挡，不逆跟踪（真跟踪）时则有。
+*        三、平地那一排全年面板上的地外直射量：逆跟踪、真跟踪、水平面。
+*        四、速度：时刻 x 排 每秒多少，与双精度对照计算比较；只有一排
+*        时沿时间方向计算，结果应与多排时的第 0 排相同。
+*
+*        第一部分四个角度的最大偏差超过 2.5e-4 度、逆跟踪时有遮挡或
+*        只有一排时结果与第 0 排不同时返回 1。
+*
+*    用法：
+*         axtest [排数]        默认 200 排
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solpos00.h"
+#include "solrt.h"
+#include "soltrack.h"
+
+#define START  1672531200LL          /* 2023-01-01 00:00 UTC */
+#define NTIME  8760L
+#define RAD    0.017453292519943295
+
+/* 对照：双精度，按 pvlib 的 singleaxis() 与 calc_surface_orientation() */
+static void reference(double zen, double az, const struct soltracker *t,
+                      double *out)
+{
+    double x, y, z, ca, sa, cb, sb, xp, zp, wid, l, temp, th, tilt, d, asp;
+
+    x  = sin(zen * RAD) * sin(az * RAD);
+    y  = sin(zen * RAD) * cos(az * RAD);
+    z  = cos(zen * RAD);
+    ca = cos(t->axis_azimuth * RAD);
+    sa = sin(t->axis_azimuth * RAD);
+    cb = cos(t->axis_tilt * RAD);
+    sb = sin(t->axis_tilt * RAD);
+    xp = x * ca - y * sa;
+    zp = x * sb * sa + y * sb * ca + z * cb;
+    wid = atan2(xp, zp) / RAD;
+    th  = wid;
+    if (t->backtrack)
+    {
+        l    = 1.0 / (t->gcr * cos(t->cross_tilt * RAD));
+        temp = fabs(l * cos((wid - t->cross_tilt) * RAD));
+        if (temp < 1.0)
+            th = wid - (wid > 0 ? 1 : wid < 0 ? -1 : 0) * acos(temp) / RAD;
+    }
+    th = fmax(fmin(th, t->max_angle), -t->max_angle);
+    if (zen >= 90.0)
+        wid = th = 0.0;
+
+    tilt = acos(cos(th * RAD) * cos(t->axis_tilt * RAD)) / RAD;
+    d    = asin(fmax(fmin(sin(th * RAD) / sin(tilt * RAD), 1.0), -1.0)) / RAD;
+    if (fabs(th) >= 90.0)
+        d = -d + (th > 0 ? 180.0 : -180.0);
+    asp = fmod(t->axis_azimuth + d + 360.0, 360.0);
+
+    out[0] = wid;
+    out[1] = th;
+    out[2] = tilt;
+    out[3] = asp;
+    out[4] = cos(zen * RAD) * cos(tilt * RAD) +
+             sin(zen * RAD) * sin(tilt * RAD) * cos((az - asp) * RAD);
+}
+
+int main(int argc, char *argv[])
+{
+    struct posdata     site;
+    struct solbatch    batch;
+    struct soltracker *tr, *tt;
+    long long *utc, t0;
+    float     *buf, *out[5], *one[5], *zen, *azi;
+    double     ref[5], dmax[5], d, sec, rsec, wid, l, w, e, cx, cz, res;
+    double     rmax;
+    double     sum[3];
+    long       r, i, shade[2], cells;
+    int        ntrack = 200, k, f, rep, fail = 0;
+
+    if (argc > 1) ntrack = atoi(argv[1]);
+    if (ntrack < 2) ntrack = 2;
+
+    cells = NTIME * ntrack;
+    utc = (long long *) malloc(NTIME * sizeof(*utc));
+    buf = (float *) malloc((3 * NTIME + 15 * cells) * sizeof(float));
+    tr  = (struct soltracker *) malloc(2 * ntrack * sizeof(*tr));
+    if (!utc || !buf || !tr)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    tt = tr + ntrack;
+
+    S_init(&site);
+    site.latitude  = 40.1;                /* 敦煌 */
+    site.longitude = 94.7;
+    site.timezone  = 8.0;
+    for (r = 0; r < NTIME; r++)
+        utc[r] = START + r * 3600 + 1800; /* 每小时的中点 */
+    memset(&batch, 0, sizeof(batch));
+    batch.count = NTIME;
+    batch.utc   = utc;
+    batch.sites = &site;
+    zen = batch.col[C_ZENREF] = buf;
+    azi = batch.col[C_AZIM]   = buf + NTIME;
+    batch.col[C_ETRN] = buf + 2 * NTIME;
+    S_batch(&batch, 0, NTIME);
+    for (f = 0; f < 5; f++)
+        out[f] = buf + 3 * NTIME + f * cells;
+    for (f = 0; f < 5; f++)
+        one[f] = buf + 3 * NTIME + (5 + f) * cells;
+
+    rmax = 0.0;
+    for (k = 0; k < ntrack; k++)
+    {
+        tr[k].axis_tilt    = k % 4 == 3 ? 5.0f : 0.0f;
+        tr[k].axis_azimuth = 180.0f;
+        tr[k].gcr          = 0.4f;
+        tr[k].max_angle    = 55.0f;
+        tr[k].cross_tilt   = 0.0f;
+        tr[k].backtrack    = 1;
+        if (k > 0)                        /* 0 号排在平地上 */
+        {
+            S_track_slope(&tr[k], 8.0f * k / ntrack, 360.0f * k * 0.618f);
+
+            /* 横轴方向、按 cross_tilt 向正转角一侧下降的那条线应在坡面内 */
+            w  = tr[k].cross_tilt * RAD;
+            cx = cos(w);
+            cz = -sin(w);
+            e  = 360.0 * k * 0.618 * RAD;
+            d  = 8.0 * k / ntrack * RAD;
+            l  = tr[k].axis_tilt * RAD;
+            res = fabs((cx * cos(tr[k].axis_azimuth * RAD) +
+                        cz * sin(l) * sin(tr[k].axis_azimuth * RAD)) *
+                       sin(d) * sin(e) +
+                       (-cx * sin(tr[k].axis_azimuth * RAD) +
+                        cz * sin(l) * cos(tr[k].axis_azimuth * RAD)) *
+                       sin(d) * cos(e) + cz * cos(l) * cos(d));
+            if (res > rmax) rmax = res;
+        }
+        tt[k] = tr[k];
+        tt[k].backtrack = 0;
+    }
+    printf("%ld 时 x %d 排 = %ld\n\n", NTIME, ntrack, cells);
+
+    /* 一 */
+    t0  = S_rt_now();
+    S_track(&batch, 0, NTIME, ntrack, tr, out[0], out[1], out[2], out[3],
+            out[4]);
+    sec = (S_rt_now() - t0) * 1.0e-9;
+    memset(dmax, 0, sizeof(dmax));
+    t0 = S_rt_now();
+    for (r = 0; r < NTIME; r++)
+        for (k = 0; k < ntrack; k++)
+        {
+            reference(zen[r], azi[r], &tr[k], ref);
+            i = r * ntrack + k;
+            for (f = 0; f < 5; f++)
+            {
+                d = fabs(out[f][i] - ref[f]);
+                if (f == 3)
+                {
+                    if (ref[2] < 0.5) continue;   /* 近于水平时方位无意义 */
+                    d = fmin(d, 360.0 - d);
+                }
+                if (d > dmax[f]) dmax[f] = d;
+            }
+        }
+    rsec = (S_rt_now() - t0) * 1.0e-9;
+    printf("与对照的最大偏差：理想转角 %.2g 度，转角 %.2g 度，倾角 %.2g 度，"
+           "方位 %.2g 度，cosinc %.2g\n", dmax[0], dmax[1], dmax[2], dmax[3],
+           dmax[4]);
+    printf("横轴坡度线与坡面法线的最大点积 %.2g\n", rmax);
+    for (f = 0; f < 4; f++)
+        fail += dmax[f] > 2.5e-4;
+
+    /* 二 */
+    S_track(&batch, 0, NTIME, ntrack, tt, one[0], one[1], NULL, NULL,
+            one[4]);
+    shade[0] = shade[1] = 0;
+    for (r = 0; r < NTIME; r++)
+        for (k = 0; k < ntrack; k++)
+        {
+            if (zen[r] >= 90.0f)
+                continue;
+            i   = r * ntrack + k;
+            wid = out[0][i];
+            l   = 1.0 / (tr[k].gcr * cos(tr[k].cross_tilt * RAD));
+            w   = l * cos((wid - tr[k].cross_tilt) * RAD);
+            if (w <= 0.0)                 /* 太阳在行间地面之下 */
+                continue;
+            shade[0] += cos((out[1][i] - wid) * RAD) > w + 1.0e-4;
+            shade[1] += cos((one[1][i] - wid) * RAD) > w + 1.0e-4;
+        }
+    printf("\n被前排遮挡的 排 x 时：逆跟踪 %ld，真跟踪 %ld\n", shade[0],
+           shade[1]);
+    fail += shade[0] != 0;
+
+    /* 三 */
+    sum[0] = sum[1] = sum[2] = 0.0;
+    for (r = 0; r < NTIME; r++)
+    {
+        e = batch.col[C_ETRN][r];
+        sum[0] += e * fmax(out[4][r * ntrack], 0.0);
+        sum[1] += e * fmax(one[4][r * ntrack], 0.0);
+        sum[2] += e * fmax(cos(zen[r] * RAD), 0.0);
+    }
+    printf("平地一排全年面板上地外直射 kWh/m2：逆跟踪 %.0f，真跟踪 %.0f，"
+           "水平面 %.0f\n", sum[0] / 1000.0, sum[1] / 1000.0, sum[2] / 1000.0);
+
+    /* 四 */
+    printf("\nS_track：%.0f 时排/秒；双精度对照 %.0f 时排/秒\n", cells / sec,
+           cells / rsec);
+    t0 = S_rt_now();
+    for (rep = 0; rep < ntrack; rep++)
+        S_track(&batch, 0, NTIME, 1, tr, one[0] + rep * NTIME,
+                one[1] + rep * NTIME, one[2] + rep * NTIME,
+                one[3] + rep * NTIME, one[4] + rep * NTIME);
+    sec = (S_rt_now() - t0) * 1.0e-9;
+    for (dmax[0] = 0.0, r = 0; r < NTIME; r++)
+        for (f = 0; f < 5; f++)
+        {
+            d = fabs(one[f][r] - out[f][r * ntrack]);
+            if (d > dmax[0]) dmax[0] = d;
+        }
+    printf("只有一排（沿时间方向）：%.0f 时排/秒，与多排时第 0 排最大偏差 "
+           "%.2g\n", cells / sec, dmax[0]);
+    fail += dmax[0] != 0.0;
+
+    free(utc);
+    free(buf);
+    free(tr);
+    printf("\n检查不过 %d 处\n", fail);
+    return fail != 0;
+}
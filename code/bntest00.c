@@ -0,0 +1,197 @@
+/*============================================================================
+*
+*    名称：bntest00.c
+*
+*    目的：测试 'solbin.c' 的二进制批处理文件和 'solposbatch.c'
+*          （solpos-batch 命令行工具）。
+*
+*        一、往返：用 S_bin_create 写一个输入文件（3 个站点模板、逐行的
+*        站点号、逐行的气压、温度、倾角），运行
+*            solpos-batch -t 2 -c azim,zenref,cosinc,etrtilt 输入 输出
+*        再用 S_bin_open 映射输出文件，检查表头（种类、行数、列掩码）、
+*        只有所选的列存在，并把每一行的返回码和各列与直接调用 S_solpos
+*        的结果逐位比较。
+*        二、拒收：把输入文件改坏后，S_bin_open 应返回 1，solpos-batch
+*        应以 1 退出：版本号加一、字节序反过来、魔数不对、表头里的
+*        大小与文件不符、文件截短、站点号越界；输出文件当输入也应拒收。
+*
+*        检查不过时返回 1。
+*
+*    用法：
+*         bntest [solpos-batch 路径]        默认 ./solpos-batch
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+
+#include "solpos00.h"
+#include "solbin.h"
+
+#define NROW   50000L
+#define NSITE  3
+#define NBAD   7
+
+static const char *in  = "/tmp/bntest-in.bin";
+static const char *out = "/tmp/bntest-out.bin";
+static const char *bad = "/tmp/bntest-bad.bin";
+
+/* 运行命令，返回退出码 */
+static int run(const char *cmd)
+{
+    int st = system(cmd);
+
+    return WIFEXITED(st) ? WEXITSTATUS(st) : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *what[NBAD] = { "版本号加一", "字节序反过来",
+                                      "魔数不对", "表头大小不符",
+                                      "文件截短", "站点号越界",
+                                      "输出文件当输入" };
+    static const int   cols[] = { C_AZIM, C_ZENREF, C_COSINC, C_ETRTILT };
+    static const float site_ll[NSITE][3] = { {39.742f, -105.178f, -7.0f},
+                                             {-33.87f, 151.21f, 10.0f},
+                                             {64.8f, -147.7f, -9.0f} };
+    const char     *cli = argc > 1 ? argv[1] : "./solpos-batch";
+    struct solbin   bi, bo;
+    struct posdata  pd;
+    struct solbin_head *h;
+    unsigned        mask;
+    char            cmd[512], *buf;
+    size_t          size, sid;
+    FILE           *f;
+    long            i, miss = 0;
+    int             k, c, e, rc, fail = 0;
+
+    /* 一 */
+    if (S_bin_create(in, S_BIN_INPUT, NROW, NSITE,
+                     ( 1u << I_PRESS ) | ( 1u << I_TEMP ) | ( 1u << I_TILT ),
+                     S_BIN_SITEID, &bi) != 0)
+    {
+        perror(in);
+        return 1;
+    }
+    for (k = 0; k < NSITE; k++)
+    {
+        S_init(&pd);
+        pd.latitude  = site_ll[k][0];
+        pd.longitude = site_ll[k][1];
+        pd.timezone  = site_ll[k][2];
+        pd.aspect    = 90.0f * (k + 1);
+        pd.interval  = k * 60;
+        S_bin_put(&bi.site[k], &pd);
+    }
+    for (i = 0; i < NROW; i++)
+    {
+        bi.utc[i]         = 1672531200LL + i * 631;
+        bi.siteid[i]      = (int) (i % NSITE);
+        bi.in[I_PRESS][i] = 800.0f + i % 250;
+        bi.in[I_TEMP][i]  = -20.0f + i % 60;
+        bi.in[I_TILT][i]  = (float) (i % 91);
+    }
+    S_bin_close(&bi);
+
+    snprintf(cmd, sizeof(cmd), "%s -t 2 -c azim,zenref,cosinc,etrtilt %s %s "
+             "2>/dev/null", cli, in, out);
+    rc = run(cmd);
+    e  = S_bin_open(out, 0, &bo);
+    for (mask = 0, k = 0; k < 4; k++)
+        mask |= S_COL(cols[k]);
+    printf("solpos-batch 退出码 %d；S_bin_open 输出 %d，种类 %u，行数 %lu，"
+           "列掩码 0x%x（应为 0x%x）\n", rc, e, e ? 0 : bo.head->kind,
+           e ? 0 : (unsigned long) bo.head->rows, e ? 0 : bo.head->mask,
+           mask);
+    if (rc != 0 || e != 0 || bo.head->kind != S_BIN_OUTPUT ||
+        bo.head->rows != (uint64_t) NROW || bo.head->mask != mask)
+    {
+        printf("往返失败\n");
+        return 1;
+    }
+    for (c = 0; c < C_NCOL; c++)
+        if ((bo.col[c] != NULL) != ((mask & S_COL(c)) != 0))
+            fail++;
+
+    S_bin_open(in, 0, &bi);
+    for (i = 0; i < NROW; i++)
+    {
+        S_bin_site(&bi.site[bi.siteid[i]], &pd);
+        pd.press = bi.in[I_PRESS][i];
+        pd.temp  = bi.in[I_TEMP][i];
+        pd.tilt  = bi.in[I_TILT][i];
+        S_epoch(&pd, bi.utc[i]);
+        if (S_solpos(&pd) != bo.retval[i] ||
+            memcmp(&bo.col[C_AZIM][i], &pd.azim, sizeof(float)) != 0 ||
+            memcmp(&bo.col[C_ZENREF][i], &pd.zenref, sizeof(float)) != 0 ||
+            memcmp(&bo.col[C_COSINC][i], &pd.cosinc, sizeof(float)) != 0 ||
+            memcmp(&bo.col[C_ETRTILT][i], &pd.etrtilt, sizeof(float)) != 0)
+            miss++;
+    }
+    printf("%ld 行逐位比较：不符 %ld 行；多出或缺少的列 %d 个\n", NROW, miss,
+           fail);
+    fail += miss != 0;
+    size = bi.size;
+    buf  = (char *) malloc(size);
+    if (buf == NULL)
+        return 1;
+    memcpy(buf, bi.base, size);
+    sid = (char *) bi.siteid - (char *) bi.base;    /* 站点号一节的位置 */
+    S_bin_close(&bi);
+    S_bin_close(&bo);
+
+    /* 二 */
+    printf("\n改坏的输入          S_bin_open  solpos-batch 退出码\n");
+    for (k = 0; k < NBAD; k++)
+    {
+        if (k == NBAD - 1)
+        {
+            snprintf(cmd, sizeof(cmd), "cp %s %s", out, bad);
+            run(cmd);
+        }
+        else
+        {
+            h = (struct solbin_head *) buf;
+            if (k == 0) h->version++;
+            if (k == 1) h->endian = 0x04030201u;
+            if (k == 2) h->magic[0] = 'X';
+            if (k == 3) h->size += 64;
+            if (k == 5)
+                ((int32_t *) (buf + sid))[NROW / 2] = NSITE;
+            if ((f = fopen(bad, "wb")) == NULL)
+                return 1;
+            fwrite(buf, 1, k == 4 ? size - 64 : size, f);
+            fclose(f);
+            if (k == 0) h->version--;
+            if (k == 1) h->endian = S_BIN_ENDIAN;
+            if (k == 2) h->magic[0] = S_BIN_MAGIC[0];
+            if (k == 3) h->size -= 64;
+            if (k == 5)
+                ((int32_t *) (buf + sid))[NROW / 2] = NROW / 2 % NSITE;
+        }
+        e = S_bin_open(bad, 0, &bi);
+        if (e == 0)
+        {
+            if (bi.head->kind != S_BIN_INPUT)   /* 打开得了，只是种类不对 */
+                e = 1;
+            S_bin_close(&bi);
+        }
+        snprintf(cmd, sizeof(cmd), "%s %s %s.out 2>/dev/null", cli, bad, bad);
+        rc = run(cmd);
+        printf("%-18s %6d %14d\n", what[k], e, rc);
+        if (e != 1 || rc != 1)
+            fail++;
+    }
+
+    free(buf);
+    remove(in);
+    remove(out);
+    remove(bad);
+    snprintf(cmd, sizeof(cmd), "%s.out", bad);
+    remove(cmd);
+    printf("\n检查不过 %d 处\n", fail);
+    return fail != 0;
+}
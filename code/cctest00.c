@@ -0,0 +1,145 @@
+/*============================================================================
+*
+*    名称：cctest00.c
+*
+*    目的：测试 'solcache.c' 中的并发结果缓存。
+*
+*        若干线程模拟仪表盘查询：从 16 个站点、一年内的 30 天中随机
+*        取（站点, 分钟）反复查询，大部分请求集中在少数“热门”站点上。
+*        先逐条调用 S_solpos 作为对照，再通过缓存查询两轮（首轮含
+*        整日预取，第二轮基本全部命中），比较吞吐量，
+*        并抽查缓存结果与直接计算结果是否一致。最后打印命中/未命中/
+*        整日预取/淘汰计数。
+*
+*        抽查有不一致时返回 1。
+*
+*    用法：
+*         cctest [线程数 [每线程查询次数]]      默认 4 线程，每线程 1000000 次
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "solpos00.h"
+#include "solcache.h"
+#include "solrt.h"
+
+#define NSITE  16
+
+static struct posdata  sites[NSITE];
+static struct solcache cache;
+static long            count = 1000000;
+static int             cached;               /* 0 = 直接计算 */
+static atomic_long     mismatch;
+
+/* 简单的 xorshift 随机数，每个线程一个状态 */
+static unsigned long long next_rand(unsigned long long *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+static void *query(void *arg)
+{
+    unsigned long long s = 0x9E3779B97F4A7C15ULL + (unsigned long) arg;
+    struct posdata pd;
+    float  out[C_NCOL];
+    long long utc;
+    long   i, bad = 0;
+    int    site;
+
+    for (i = 0; i < count; i++)
+    {
+        /* 3/4 的请求落在前 4 个站点 */
+        site = (int) (next_rand(&s) % 4 ? next_rand(&s) % 4 : next_rand(&s) % NSITE);
+        utc  = 1672531200LL + (long long) (next_rand(&s) % 30) * 86400
+                            + (long long) (next_rand(&s) % 1440) * 60;
+
+        if (!cached)
+        {
+            pd = sites[site];
+            S_epoch(&pd, utc);
+            S_solpos(&pd);
+            continue;
+        }
+
+        S_cache_get(&cache, site, utc, S_ALL, out);
+        if (i % 4096 == 0)                       /* 抽查 */
+        {
+            pd = sites[site];
+            S_epoch(&pd, utc);
+            S_solpos(&pd);
+            if (pd.azim != out[C_AZIM] || pd.zenref != out[C_ZENREF] ||
+                pd.etrtilt != out[C_ETRTILT])
+                bad++;
+        }
+    }
+    atomic_fetch_add(&mismatch, bad);
+    return NULL;
+}
+
+static double run(int threads)
+{
+    pthread_t tid[64];
+    long long t0 = S_rt_now();
+    int       t;
+
+    for (t = 0; t < threads; t++)
+        pthread_create(&tid[t], NULL, query, (void *) (long) t);
+    for (t = 0; t < threads; t++)
+        pthread_join(tid[t], NULL);
+    return (double) threads * count / ((S_rt_now() - t0) * 1.0e-9);
+}
+
+int main(int argc, char *argv[])
+{
+    struct solcache_stats st;
+    double direct, cold, hit;
+    int    threads = 4, k;
+
+    if (argc > 1) threads = atoi(argv[1]);
+    if (argc > 2) count   = atol(argv[2]);
+    if (threads < 1)  threads = 1;
+    if (threads > 64) threads = 64;
+
+    for (k = 0; k < NSITE; k++)
+    {
+        S_init(&sites[k]);
+        sites[k].latitude  = -50.0 + 7.0 * k;
+        sites[k].longitude = -170.0 + 21.0 * k;
+        sites[k].timezone  = (float) (int) (sites[k].longitude / 15.0);
+        sites[k].tilt      = sites[k].latitude;
+        sites[k].aspect    = 180.0;
+    }
+
+    /* 16 站点 × 30 天 × 1440 分钟，容量留足以避免淘汰热门条目 */
+    if (S_cache_init(&cache, sites, NSITE, 1L << 21, 60) != 0)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+
+    cached = 0;
+    direct = run(threads);
+    cached = 1;
+    cold   = run(threads);                       /* 含整日预取 */
+    hit    = run(threads);
+
+    S_cache_stats(&cache, &st);
+    printf("%d 线程，每线程 %ld 次查询\n", threads, count);
+    printf("直接计算   %12.0f 次/秒\n", direct);
+    printf("缓存首轮   %12.0f 次/秒  (%.1f 倍)\n", cold, cold / direct);
+    printf("缓存热轮   %12.0f 次/秒  (%.1f 倍)\n", hit, hit / direct);
+    printf("命中 %lu  未命中 %lu  整日预取 %lu  淘汰 %lu  命中率 %.4f\n",
+           st.hits, st.misses, st.fills, st.evictions,
+           (double) st.hits / (st.hits + st.misses));
+    printf("抽查不一致 %ld\n", atomic_load(&mismatch));
+
+    S_cache_free(&cache);
+    return atomic_load(&mismatch) != 0;
+}
@@ -0,0 +1,223 @@
+/*============================================================================
+*
+*    名称：cstest00.c
+*
+*    目的：测试 'solclear.c' 中的晴空辐射模型。
+*
+*        若干站点（0 号为大连，1 号为海拔约 3600 米的拉萨）一年的
+*        逐分钟批量计算，只取 coszen、amass、ampress、etrn 四列，
+*        然后分别用 Ineichen-Perez、Bird 和竞赛 DNI 公式计算晴空
+*        GHI、DNI、DHI：
+*
+*        一、与按公式逐行用双精度 exp/pow 写成的对照计算比较，打印
+*        最大绝对偏差和（100 W/平方米以上的）最大相对偏差。
+*        二、打印各模型与对照计算的速度（行/秒）。
+*        三、打印两个站点夏至日的日总量（当地日超出所算的天数时，
+*        窗口移回批量之内）。
+*
+*        相对偏差超过 2e-5 时返回 1。
+*
+*    用法：
+*         cstest [站点数 [天数]]        默认 16 个站点，365 天
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solpos00.h"
+#include "solclear.h"
+#include "solrt.h"
+
+#define START  1672531200LL          /* 2023-01-01 00:00 UTC */
+
+/* 对照：双精度逐行计算 */
+static void reference(int model, const struct solclear_site *cs, double cz,
+                      double am, double amp, double e, double out[3])
+{
+    double h = cs->altitude, tl = cs->linke, fh1, fh2, g, bn, bn2, d;
+    double taua, tr, to, tum, tw, ta, taa, rs, id, ias, xo, xw, a, b, c;
+
+    out[0] = out[1] = out[2] = 0.0;
+    if (cz <= 0.0 || (model != K_CUMCM && am <= 0.0))
+        return;
+    if (model == K_INEICHEN)
+    {
+        fh1 = exp(-h / 8000.0);
+        fh2 = exp(-h / 1250.0);
+        g   = (5.09e-5 * h + 0.868) * e * cz *
+              exp(-(3.92e-5 * h + 0.0387) * amp * (fh1 + fh2 * (tl - 1.0)));
+        bn  = (0.664 + 0.163 / fh1) * exp(-0.09 * amp * (tl - 1.0)) * e;
+        bn2 = g * (1.0 - (0.1 - 0.2 * exp(-tl)) / (0.1 + 0.882 / fh1)) / cz;
+        d   = fmin(bn, fmax(bn2, 0.0));
+        out[0] = g;
+        out[1] = d;
+        out[2] = g - d * cz;
+    }
+    else if (model == K_BIRD)
+    {
+        taua = 0.2758 * cs->aod380 + 0.35 * cs->aod500;
+        tr   = exp(-0.0903 * pow(amp, 0.84) * (1.0 + amp - pow(amp, 1.01)));
+        xo   = cs->ozone * am;
+        to   = 1.0 - 0.1611 * xo * pow(1.0 + 139.48 * xo, -0.3034) -
+               0.002715 * xo / (1.0 + 0.044 * xo + 0.0003 * xo * xo);
+        tum  = exp(-0.0127 * pow(amp, 0.26));
+        xw   = cs->water * am;
+        tw   = 1.0 - 2.4959 * xw / (pow(1.0 + 79.034 * xw, 0.6828) + 6.385 * xw);
+        ta   = exp(-pow(taua, 0.873) * (1.0 + taua - pow(taua, 0.7088)) *
+                   pow(am, 0.9108));
+        taa  = 1.0 - 0.1 * (1.0 - am + pow(am, 1.06)) * (1.0 - ta);
+        rs   = 0.0685 + (1.0 - 0.84) * (1.0 - ta / taa);
+        id   = 0.9662 * e * tr * to * tum * tw * ta;
+        ias  = e * cz * 0.79 * to * tw * tum * taa *
+               (0.5 * (1.0 - tr) + 0.84 * (1.0 - ta / taa)) /
+               (1.0 - am + pow(am, 1.02));
+        out[0] = (id * cz + ias) / (1.0 - cs->albedo * rs);
+        out[1] = id;
+        out[2] = out[0] - id * cz;
+    }
+    else
+    {
+        h /= 1000.0;
+        a = 0.4237 - 0.00821 * (6.0 - h) * (6.0 - h);
+        b = 0.5055 + 0.00595 * (6.5 - h) * (6.5 - h);
+        c = 0.2711 + 0.01858 * (2.5 - h) * (2.5 - h);
+        out[1] = e * (a + b * exp(-c / cz));
+        out[0] = out[1] * cz;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    struct posdata       *sites;
+    struct solclear_site *cs;
+    struct solbatch       batch;
+    long long *utc, t0;
+    int       *site;
+    float     *buf, *out[3];
+    long       rows, ntime, r, day, first;
+    double     ref[3], sec, rsec, dabs, drel, d, sum[2][3];
+    int        nsite = 16, days = 365, m, k, s, bad = 0;
+
+    if (argc > 1) nsite = atoi(argv[1]);
+    if (argc > 2) days  = atoi(argv[2]);
+    if (nsite < 2) nsite = 2;
+    if (days < 1) days = 1;
+
+    ntime = 1440L * days;
+    rows  = ntime * nsite;
+    sites = (struct posdata *) malloc(nsite * sizeof(*sites));
+    cs    = (struct solclear_site *) malloc(nsite * sizeof(*cs));
+    utc   = (long long *) malloc(rows * sizeof(*utc));
+    site  = (int *) malloc(rows * sizeof(*site));
+    buf   = (float *) malloc(7 * rows * sizeof(float));
+    if (!sites || !cs || !utc || !site || !buf)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    for (k = 0; k < nsite; k++)
+    {
+        S_init(&sites[k]);
+        sites[k].latitude  = -60.0 + 120.0 * k / nsite + 1.0;
+        sites[k].longitude = -180.0 + 360.0 * k / nsite;
+        sites[k].timezone  = (float) (int) (sites[k].longitude / 15.0);
+        sites[k].press     = 1013.0 - 400.0 * k / nsite;
+    }
+    sites[0].latitude  = 38.9;            /* 大连 */
+    sites[0].longitude = 121.6;
+    sites[0].timezone  = 8.0;
+    sites[1].latitude  = 29.65;           /* 拉萨 */
+    sites[1].longitude = 91.13;
+    sites[1].timezone  = 8.0;
+    sites[1].press     = 650.0;
+    for (k = 0; k < nsite; k++)
+        S_clear_site(&cs[k], &sites[k]);
+
+    for (r = 0; r < rows; r++)
+    {
+        site[r] = (int) (r / ntime);
+        utc[r]  = START + (r % ntime) * 60;
+    }
+    memset(&batch, 0, sizeof(batch));
+    batch.count = rows;
+    batch.utc   = utc;
+    batch.site  = site;
+    batch.sites = sites;
+    batch.col[C_COSZEN]  = buf;
+    batch.col[C_AMASS]   = buf + rows;
+    batch.col[C_AMPRESS] = buf + 2 * rows;
+    batch.col[C_ETRN]    = buf + 3 * rows;
+    for (k = 0; k < 3; k++)
+        out[k] = buf + (4 + k) * rows;
+    t0 = S_rt_now();
+    S_batch_parallel(&batch, 4);
+    printf("%d 站点 x %ld 分钟 = %ld 行，太阳位置 %.3f 秒；海拔 大连 %.0f 米，"
+           "拉萨 %.0f 米\n\n", nsite, ntime, rows, (S_rt_now() - t0) * 1.0e-9,
+           cs[0].altitude, cs[1].altitude);
+
+    printf("模型        行/秒        对照 行/秒   最大绝对偏差 W/m2  "
+           "最大相对偏差\n");
+    for (m = 0; m < K_NMODEL; m++)
+    {
+        t0  = S_rt_now();
+        S_clear(m, &batch, cs, NULL, 0, rows, out[0], out[1], out[2]);
+        sec = (S_rt_now() - t0) * 1.0e-9;
+
+        dabs = drel = 0.0;
+        t0 = S_rt_now();
+        for (r = 0; r < rows; r++)
+        {
+            reference(m, &cs[site[r]], batch.col[C_COSZEN][r],
+                      batch.col[C_AMASS][r], batch.col[C_AMPRESS][r],
+                      batch.col[C_ETRN][r], ref);
+            for (k = 0; k < 3; k++)
+            {
+                d = fabs(out[k][r] - ref[k]);
+                if (d > dabs) dabs = d;
+                if (ref[k] > 100.0 && d / ref[k] > drel) drel = d / ref[k];
+            }
+        }
+        rsec = (S_rt_now() - t0) * 1.0e-9;
+        printf("%-10s %12.0f %12.0f   %12.3g       %12.3g\n", S_clear_name(m),
+               rows / sec, rows / rsec, dabs, drel);
+        if (drel > 2.0e-5)
+            bad++;
+    }
+
+    /* 夏至日（第 172 天）的日总量 */
+    day = days > 172 ? 171 : days - 1;
+    printf("\n第 %ld 天日总量 kWh/平方米（GHI / DNI / DHI）\n", day + 1);
+    for (m = 0; m < K_NMODEL; m++)
+    {
+        S_clear(m, &batch, cs, NULL, 0, rows, out[0], out[1], out[2]);
+        for (s = 0; s < 2; s++)
+            for (k = 0; k < 3; k++)
+            {
+                sum[s][k] = 0.0;
+                /* 当地日：从当地 0 时对应的那一分钟起，不出该站点的行 */
+                first = day * 1440 - (long) (sites[s].timezone * 60);
+                if (first < 0)
+                    first = 0;
+                if (first > ntime - 1440)
+                    first = ntime - 1440;
+                first += s * ntime;
+                for (r = first; r < first + 1440; r++)
+                    sum[s][k] += out[k][r] / 60000.0;
+            }
+        printf("  %-10s 大连 %5.2f / %5.2f / %5.2f    拉萨 %5.2f / %5.2f / %5.2f\n",
+               S_clear_name(m), sum[0][0], sum[0][1], sum[0][2],
+               sum[1][0], sum[1][1], sum[1][2]);
+    }
+
+    free(sites);
+    free(cs);
+    free(utc);
+    free(site);
+    free(buf);
+    printf("\n超限 %d 次\n", bad);
+    return bad != 0;
+}
@@ -0,0 +1,218 @@
+/*============================================================================
+*
+*    名称：cvtest00.c
+*
+*    目的：测试 'solcsv.c' 的流式 CSV 读取。
+*
+*        先生成一个气象站导出格式的文件：列的顺序与库的字段顺序不同，
+*        列名也不同，还夹带不需要的列（站号、辐照度），秒和倾斜面参数
+*        没有列（取模板值），中间插入重复的表头和一行乱码。然后按表头
+*        名称映射字段，分块读入并交给 'solbatch.c' 计算。
+*
+*        抽样逐行用 strtod 和 S_solpos 直接重算，核对方位角和折射修正
+*        后的高度角应当完全相同；再去掉逐行的气压和温度重算一遍，打印
+*        二者对折射修正的最大影响。最后打印读取和计算的吞吐量。
+*
+*        抽样有不一致或一行也没有核对时返回 1。
+*
+*    用法：
+*         cvtest [文件 [行数 [线程数]]]   默认 /tmp/cvtest.csv，200 万行，1 个线程
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "solpos00.h"
+#include "solcsv.h"
+#include "solrt.h"
+
+#define NSTATION 8
+
+static const char head[] =
+    "station,Year,Month,Day,Hour,Minute,GHI,Temperature,Pressure,"
+    "Lat,Lon,TZ\n";
+
+/* 第 r 行数据 */
+static int gen(long r, char *line)
+{
+    struct posdata t;
+    int    s = (int) (r % NSTATION);
+    double lon = -120.0 + 7.5 * s;
+
+    S_init(&t);
+    t.timezone = 0.0;                      /* 直接得到当地标准时 */
+    S_epoch(&t, 1672531200LL + (r / NSTATION) * 60);
+    return sprintf(line, "%d,%d,%d,%d,%d,%d,%.1f,%.1f,%.1f,%.4f,%.4f,%d\n",
+                   1000 + s, t.year, t.month, t.day, t.hour, t.minute,
+                   (r * 37 % 10000) / 10.0,
+                   -20.0 + (r * 7 % 600) / 10.0,
+                   820.0 + (r * 13 % 2000) / 10.0,
+                   20.0 + 4.125 * s, lon, (int) floor(lon / 15.0 + 0.5));
+}
+
+/* 用 strtod 和 S_solpos 直接计算第 r 行 */
+static long direct(long r, const struct posdata *site, struct posdata *pd)
+{
+    char   line[160], *p = line;
+    double v[12];
+    int    k;
+
+    gen(r, line);
+    for (k = 0; k < 12; k++)
+    {
+        v[k] = strtod(p, &p);
+        p++;
+    }
+    *pd = *site;
+    pd->function &= ~S_DOY;                 /* 月和日是输入 */
+    pd->year      = (int) v[1];
+    pd->month     = (int) v[2];
+    pd->day       = (int) v[3];
+    pd->hour      = (int) v[4];
+    pd->minute    = (int) v[5];
+    pd->second    = 0;
+    pd->temp      = (float) v[7];
+    pd->press     = (float) v[8];
+    pd->latitude  = (float) v[9];
+    pd->longitude = (float) v[10];
+    pd->timezone  = (float) v[11];
+    return S_solpos(pd);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = "/tmp/cvtest.csv";
+    const char *names[F_NFIELD];
+    struct posdata      site, pd;
+    struct solcsv       csv;
+    struct solcsv_block blk;
+    struct solbatch     batch, dry;
+    FILE      *fp;
+    char      *line;
+    float     *azim, *elev, *elev0;
+    long      *retval;
+    long       rows = 2000000, r, i, n, base = 0, checked = 0, diff = 0;
+    long long  t0, t_read = 0, t_comp = 0;
+    double     dmax = 0.0;
+    int        threads = 1, fd, mapped;
+
+    if (argc > 1) path    = argv[1];
+    if (argc > 2) rows    = atol(argv[2]);
+    if (argc > 3) threads = atoi(argv[3]);
+
+    /* 生成文件 */
+    if ((fp = fopen(path, "w")) == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+    line = (char *) malloc(256);
+    fputs(head, fp);
+    for (r = 0; r < rows; r++)
+    {
+        if (r > 0 && r % 250000 == 0)
+            fputs(head, fp);               /* 拼接文件时常见的重复表头 */
+        if (r == rows / 2)
+            fputs("1003,2023,##,,,\n", fp);
+        fwrite(line, 1, gen(r, line), fp);
+    }
+    fclose(fp);
+
+    /* 模板：倾斜面朝南 30 度；秒没有列 */
+    S_init(&site);
+    site.tilt   = 30.0;
+    site.aspect = 180.0;
+
+    memset(names, 0, sizeof(names));
+    names[F_YEAR]   = "Year";
+    names[F_MONTH]  = "Month";
+    names[F_DAY]    = "Day";
+    names[F_HOUR]   = "Hour";
+    names[F_MINUTE] = "Minute";
+    names[F_INPUT + I_LATITUDE]  = "Lat";
+    names[F_INPUT + I_LONGITUDE] = "Lon";
+    names[F_INPUT + I_TIMEZONE]  = "TZ";
+    names[F_INPUT + I_PRESS]     = "Pressure";
+    names[F_INPUT + I_TEMP]      = "Temperature";
+
+    if ((fd = open(path, O_RDONLY)) < 0 ||
+        S_csv_open(&csv, fd, ',', &site, 0) != 0 ||
+        S_csv_block_init(&blk, 65536) != 0)
+    {
+        printf("无法读取 %s\n", path);
+        return 1;
+    }
+    mapped = S_csv_map_header(&csv, names);
+    printf("按表头映射了 %d 个字段\n", mapped);
+
+    azim   = (float *) malloc(blk.cap * sizeof(float));
+    elev   = (float *) malloc(blk.cap * sizeof(float));
+    elev0  = (float *) malloc(blk.cap * sizeof(float));
+    retval = (long *) malloc(blk.cap * sizeof(long));
+    if (!azim || !elev || !elev0 || !retval)
+        return 1;
+
+    for (;;)
+    {
+        t0 = S_rt_now();
+        n  = S_csv_read(&csv, &blk);
+        t_read += S_rt_now() - t0;
+        if (n <= 0)
+            break;
+
+        memset(&batch, 0, sizeof(batch));
+        S_csv_batch(&csv, &blk, &batch);
+        batch.col[C_AZIM]    = azim;
+        batch.col[C_ELEVREF] = elev;
+        batch.retval         = retval;
+        t0 = S_rt_now();
+        S_batch_parallel(&batch, threads);
+        t_comp += S_rt_now() - t0;
+
+        /* 不用逐行气压和温度（取模板的 1013 毫巴、15 度） */
+        dry = batch;
+        dry.in[I_PRESS] = dry.in[I_TEMP] = NULL;
+        memset(dry.col, 0, sizeof(dry.col));
+        dry.col[C_ELEVREF] = elev0;
+        dry.retval         = NULL;
+        S_batch(&dry, 0, n);
+        for (i = 0; i < n; i++)
+            if (fabs(elev[i] - elev0[i]) > dmax)
+                dmax = fabs(elev[i] - elev0[i]);
+
+        for (i = 0; i < n; i += 997)
+        {
+            if (direct(base + i, &site, &pd) != retval[i] ||
+                pd.azim != azim[i] || pd.elevref != elev[i])
+                diff++;
+            checked++;
+        }
+        base += n;
+    }
+
+    printf("%ld 行，跳过 %ld 行（第一处在第 %ld 行），%.1f MB\n",
+           csv.rows, csv.skipped, csv.firstbad, csv.bytes / 1048576.0);
+    printf("读取  %8.3f 秒  %8.1f MB/秒  %12.0f 行/秒\n", t_read * 1.0e-9,
+           csv.bytes / 1048576.0 / (t_read * 1.0e-9),
+           csv.rows / (t_read * 1.0e-9));
+    printf("计算  %8.3f 秒  %21.0f 行/秒\n", t_comp * 1.0e-9,
+           csv.rows / (t_comp * 1.0e-9));
+    printf("抽样核对 %ld 行，与直接计算不一致 %ld 行\n", checked, diff);
+    printf("逐行气压和温度对折射修正高度角的最大影响 %.4f 度\n", dmax);
+
+    S_csv_block_free(&blk);
+    S_csv_free(&csv);
+    close(fd);
+    free(line);
+    free(azim);
+    free(elev);
+    free(elev0);
+    free(retval);
+    return diff != 0 || checked == 0;
+}
@@ -0,0 +1,343 @@
+/*============================================================================
+*
+*    名称：dctest00.c
+*
+*    目的：测试 'solsplit.c' 中由 GHI 分解 DNI、DHI 的三种模型。
+*
+*        若干站点（0 号为大连）一年的逐时批量计算，用 'solclear.c' 的
+*        Ineichen 晴空辐射乘以云量系数当作“实测”GHI（同时得到“真实”
+*        的 DNI），然后用 Erbs、DISC、DIRINT 分解：
+*
+*        一、Erbs、DISC 与按公式逐行用双精度写成的对照计算比较，打印
+*        最大偏差；打印各模型 DNI 与“真实”值的均方根误差和速度。
+*        二、DIRINT：库中常驻 Perez 等（1992）发表的系数表，落在表中
+*        几格的行应等于 DISC 乘该格发表的系数（下面 pub 中的值，取自
+*        发表的表）；打印 DNI 均方根误差。去掉系数表后应返回 -1；系数
+*        全为 1 时应与 DISC 相同；再把一个每格不同的系数表写入文件、
+*        读回，与对照计算的分箱结果比较。
+*
+*        检查不过时返回 1。
+*
+*    用法：
+*         dctest [站点数]        默认 256 个站点
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solpos00.h"
+#include "solclear.h"
+#include "solrt.h"
+#include "solsplit.h"
+
+#define START  1672531200LL          /* 2023-01-01 00:00 UTC */
+#define NTIME  8760L
+#define COS87  0.0523359562
+#define NPUB   6
+
+static float coef[6][6][7][5];
+
+/* 对照：双精度 Erbs 或 DISC，一行 */
+static double reference(int model, double g, double etr, double etrn,
+                        double am, double cz)
+{
+    double kt, df, a, b, c, knc, kn;
+
+    g = fmax(g, 0.0);
+    if (cz <= COS87 || etr <= 0.0)
+        return 0.0;
+    kt = fmin(g / etr, 1.0);
+    if (model == D_ERBS)
+    {
+        if (kt <= 0.22)
+            df = 1.0 - 0.09 * kt;
+        else if (kt <= 0.8)
+            df = 0.9511 - 0.1604 * kt + 4.388 * kt * kt -
+                 16.638 * pow(kt, 3) + 12.336 * pow(kt, 4);
+        else
+            df = 0.165;
+        return (g - df * g) / cz;
+    }
+    am = fmin(am, 12.0);
+    if (kt <= 0.6)
+    {
+        a = 0.512 - 1.56 * kt + 2.286 * kt * kt - 2.222 * pow(kt, 3);
+        b = 0.37 + 0.962 * kt;
+        c = -0.28 + 0.932 * kt - 2.048 * kt * kt;
+    }
+    else
+    {
+        a = -5.743 + 21.77 * kt - 27.49 * kt * kt + 11.56 * pow(kt, 3);
+        b = 41.4 - 118.5 * kt + 66.05 * kt * kt + 31.9 * pow(kt, 3);
+        c = -47.01 + 184.2 * kt - 222.0 * kt * kt + 73.81 * pow(kt, 3);
+    }
+    knc = 0.866 - 0.122 * am + 0.0121 * am * am - 0.000653 * pow(am, 3) +
+          0.000014 * pow(am, 4);
+    kn  = fmax(knc - (a + b * exp(c * am)), 0.0);
+    return fmin(kn * etrn, g / cz);
+}
+
+/* 对照：DIRINT 的 Kt'，无则 -1；与库中一样用单精度，分箱才一致 */
+static float ktp(const struct solbatch *b, const float *ghi, long r)
+{
+    if (b->col[C_COSZEN][r] <= (float) COS87 || b->col[C_ETR][r] <= 0.0f ||
+        b->col[C_PRIME][r] <= 0.0f)
+        return -1.0f;
+    return fminf(fminf(fmaxf(ghi[r], 0.0f) / b->col[C_ETR][r], 1.0f) *
+                 b->col[C_PRIME][r], 0.82f);
+}
+
+static int bin(float x, const float *edge)
+{
+    int k;
+
+    for (k = 0; k < 5 && x >= edge[k]; k++)
+        ;
+    return k;
+}
+
+/* 对照：第 r 行 DIRINT 的四个分箱，没有 Kt' 时返回 0 */
+static int cell(const struct solbatch *b, const float *ghi,
+                const float *water, long rows, long r, int *cl)
+{
+    static const float ke[5] = { 0.24f, 0.4f, 0.56f, 0.7f, 0.8f };
+    static const float ze[5] = { 25.0f, 40.0f, 55.0f, 70.0f, 80.0f };
+    static const float de[5] = { 0.015f, 0.035f, 0.07f, 0.15f, 0.3f };
+    const int *site = b->site;
+    float k, kp, kn, dk;
+
+    if ((k = ktp(b, ghi, r)) < 0.0f)
+        return 0;
+    kp = r > 0 && site[r - 1] == site[r] ? ktp(b, ghi, r - 1) : -1.0f;
+    kn = r + 1 < rows && site[r + 1] == site[r] ? ktp(b, ghi, r + 1) : -1.0f;
+    if (kp >= 0.0f && kn >= 0.0f)
+        dk = 0.5f * (fabsf(k - kp) + fabsf(k - kn));
+    else
+        dk = kp >= 0.0f ? fabsf(k - kp) : kn >= 0.0f ? fabsf(k - kn) : -1.0f;
+    cl[0] = bin(k, ke);
+    cl[1] = bin(b->col[C_ZENREF][r], ze);
+    cl[2] = dk < 0.0 ? 6 : bin(dk, de);
+    cl[3] = water[r] < 1.0 ? 0 : water[r] < 2.0 ? 1 : water[r] < 3.0 ? 2 : 3;
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    /* 发表的系数表中的几格：Kt'、天顶角、稳定度、水汽分箱（从 0 起）
+       和系数 */
+    static const struct { int cl[4]; double c; } pub[NPUB] = {
+        { {1, 2, 2, 3}, 0.854790 }, { {2, 3, 1, 2}, 0.541990 },
+        { {3, 1, 2, 2}, 0.999940 }, { {3, 2, 4, 1}, 0.881880 },
+        { {4, 2, 2, 1}, 0.934920 }, { {4, 4, 3, 0}, 0.782090 } };
+    static const char *path = "/tmp/dctest-dirint.txt";
+    struct posdata       *sites;
+    struct solclear_site *cs;
+    struct solbatch       batch;
+    long long *utc, t0;
+    int       *site;
+    float     *buf, *ghi, *tdni, *tdhi, *water, *dni, *dhi, *disc;
+    double     sec, d, dmax, rmse, kc, x;
+    long       rows, r, n, hit[NPUB] = { 0 };
+    int        nsite = 256, m, s, a, b, c, w, e, cl[4], bad = 0;
+    FILE      *fp;
+
+    if (argc > 1) nsite = atoi(argv[1]);
+    if (nsite < 1) nsite = 1;
+
+    rows  = NTIME * nsite;
+    sites = (struct posdata *) malloc(nsite * sizeof(*sites));
+    cs    = (struct solclear_site *) malloc(nsite * sizeof(*cs));
+    utc   = (long long *) malloc(rows * sizeof(*utc));
+    site  = (int *) malloc(rows * sizeof(*site));
+    buf   = (float *) malloc(14 * rows * sizeof(float));
+    if (!sites || !cs || !utc || !site || !buf)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    for (s = 0; s < nsite; s++)
+    {
+        S_init(&sites[s]);
+        sites[s].latitude  = -60.0 + 120.0 * s / nsite + 1.0;
+        sites[s].longitude = -180.0 + 360.0 * s / nsite;
+        sites[s].timezone  = (float) (int) (sites[s].longitude / 15.0);
+        sites[s].press     = 1013.0 - 300.0 * s / nsite;
+        sites[s].interval  = 3600;
+        S_clear_site(&cs[s], &sites[s]);
+    }
+    sites[0].latitude  = 38.9;            /* 大连 */
+    sites[0].longitude = 121.6;
+    sites[0].timezone  = 8.0;
+    sites[0].press     = 1013.0;
+
+    for (r = 0; r < rows; r++)
+    {
+        site[r] = (int) (r / NTIME);
+        utc[r]  = START + (r % NTIME + 1) * 3600;
+    }
+    memset(&batch, 0, sizeof(batch));
+    batch.count = rows;
+    batch.utc   = utc;
+    batch.site  = site;
+    batch.sites = sites;
+    batch.col[C_ETR]     = buf;
+    batch.col[C_ETRN]    = buf + rows;
+    batch.col[C_AMPRESS] = buf + 2 * rows;
+    batch.col[C_COSZEN]  = buf + 3 * rows;
+    batch.col[C_PRIME]   = buf + 4 * rows;
+    batch.col[C_ZENREF]  = buf + 5 * rows;
+    batch.col[C_AMASS]   = buf + 6 * rows;
+    ghi   = buf + 7 * rows;
+    tdni  = buf + 8 * rows;
+    tdhi  = buf + 9 * rows;
+    water = buf + 10 * rows;
+    dni   = buf + 11 * rows;
+    dhi   = buf + 12 * rows;
+    disc  = buf + 13 * rows;
+    S_batch_parallel(&batch, 4);
+
+    /* “实测”GHI：晴空值乘 kc，其中直射部分乘 kc 的平方，即云多时散射
+       比例变大；可降水量 0.5 - 3.5 cm */
+    S_clear(K_INEICHEN, &batch, cs, NULL, 0, rows, ghi, tdni, tdhi);
+    for (r = 0; r < rows; r++)
+    {
+        kc       = 0.2 + 0.8 * fabs(sin(r * 0.37) * cos(r * 0.011));
+        ghi[r]   = ghi[r] * kc;
+        tdni[r] *= kc * kc;
+        water[r] = 2.0 + 1.5 * sin(r * 0.0007);
+    }
+    printf("%d 站点 x %ld 时 = %ld 行\n\n", nsite, NTIME, rows);
+
+    /* 一 */
+    printf("模型          行/秒     对照最大偏差 W/m2   DNI 均方根误差 W/m2\n");
+    for (m = 0; m < D_DIRINT; m++)
+    {
+        t0  = S_rt_now();
+        S_split(m, &batch, ghi, NULL, 0, rows, dni, dhi);
+        sec = (S_rt_now() - t0) * 1.0e-9;
+        dmax = rmse = 0.0;
+        for (n = r = 0; r < rows; r++)
+        {
+            d = fabs(dni[r] - reference(m, ghi[r], batch.col[C_ETR][r],
+                                        batch.col[C_ETRN][r],
+                                        batch.col[C_AMPRESS][r],
+                                        batch.col[C_COSZEN][r]));
+            if (d > dmax) dmax = d;
+            if (batch.col[C_COSZEN][r] > COS87)
+            {
+                rmse += (dni[r] - tdni[r]) * (dni[r] - tdni[r]);
+                n++;
+            }
+        }
+        printf("%-8s %12.0f   %14.3g      %14.1f\n", S_split_name(m),
+               rows / sec, dmax, sqrt(rmse / n));
+        if (m == D_DISC)
+            memcpy(disc, dni, rows * sizeof(float));
+    }
+
+    /* 二 */
+    t0  = S_rt_now();
+    S_split(D_DIRINT, &batch, ghi, water, 0, rows, dni, dhi);
+    sec = (S_rt_now() - t0) * 1.0e-9;
+    dmax = rmse = 0.0;
+    for (n = r = 0; r < rows; r++)
+    {
+        if (batch.col[C_COSZEN][r] > COS87)
+        {
+            rmse += (dni[r] - tdni[r]) * (dni[r] - tdni[r]);
+            n++;
+        }
+        if (!cell(&batch, ghi, water, rows, r, cl))
+            continue;
+        for (s = 0; s < NPUB; s++)
+            if (memcmp(cl, pub[s].cl, sizeof(cl)) == 0)
+            {
+                x = fmin(disc[r] * pub[s].c,
+                         fmax(ghi[r], 0.0) / batch.col[C_COSZEN][r]);
+                d = fabs(dni[r] - x);
+                if (d > dmax) dmax = d;
+                hit[s]++;
+            }
+    }
+    printf("\n%-8s %12.0f   %14s      %14.1f（常驻的发表系数表）\n",
+           S_split_name(D_DIRINT), rows / sec, "", sqrt(rmse / n));
+    printf("发表系数表中 %d 格的行数", NPUB);
+    for (s = 0; s < NPUB; s++)
+    {
+        printf(" %ld", hit[s]);
+        if (hit[s] == 0)
+            bad++;
+    }
+    printf("，与 DISC 乘发表系数最大偏差 %.3g W/m2\n", dmax);
+    if (dmax > 1.0e-3)
+        bad++;
+
+    S_split_dirint(NULL);
+    n = S_split(D_DIRINT, &batch, ghi, water, 0, rows, dni, dhi);
+    printf("去掉 DIRINT 系数表：S_split 返回 %ld\n", n);
+    if (n != -1)
+        bad++;
+    for (a = 0; a < 6; a++)
+        for (b = 0; b < 6; b++)
+            for (c = 0; c < 7; c++)
+                for (w = 0; w < 5; w++)
+                    coef[a][b][c][w] = 1.0f;
+    S_split_dirint(&coef[0][0][0][0]);
+    S_split(D_DIRINT, &batch, ghi, water, 0, rows, dni, dhi);
+    for (dmax = 0.0, r = 0; r < rows; r++)
+        if (fabs(dni[r] - disc[r]) > dmax) dmax = fabs(dni[r] - disc[r]);
+    printf("系数全为 1：与 DISC 最大偏差 %.3g W/m2\n", dmax);
+    if (dmax > 1.0e-3)
+        bad++;
+
+    if ((fp = fopen(path, "w")) == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+    for (a = 0; a < 6; a++)
+        for (b = 0; b < 6; b++)
+            for (c = 0; c < 7; c++)
+                for (w = 0; w < 5; w++)
+                {
+                    coef[a][b][c][w] = 0.8f + 0.001f * (((a * 6 + b) * 7 + c) *
+                                                        5 + w) / 3.0f;
+                    fprintf(fp, "%.6f%c", coef[a][b][c][w], w == 4 ? '\n' : ' ');
+                }
+    fclose(fp);
+    if ((e = S_split_load(path)) != 0)
+    {
+        printf("%s 读取出错 %d\n", path, e);
+        return 1;
+    }
+    t0  = S_rt_now();
+    S_split(D_DIRINT, &batch, ghi, water, 0, rows, dni, dhi);
+    sec = (S_rt_now() - t0) * 1.0e-9;
+
+    dmax = 0.0;
+    for (r = 0; r < rows; r++)
+    {
+        x = disc[r];
+        if (cell(&batch, ghi, water, rows, r, cl))
+            x = fmin(x * coef[cl[0]][cl[1]][cl[2]][cl[3]],
+                     fmax(ghi[r], 0.0) / batch.col[C_COSZEN][r]);
+        d = fabs(dni[r] - x);
+        if (d > dmax) dmax = d;
+    }
+    printf("文件中的系数表：%.0f 行/秒，与对照分箱最大偏差 %.3g W/m2\n",
+           rows / sec, dmax);
+    if (dmax > 1.0e-3)
+        bad++;
+
+    free(sites);
+    free(cs);
+    free(utc);
+    free(site);
+    free(buf);
+    printf("\n检查不过 %d 处\n", bad);
+    return bad != 0;
+}
@@ -0,0 +1,226 @@
+/*============================================================================
+*
+*    名称：entest00.c
+*
+*    目的：测试 'solens.c' 的输入不确定度集合传播。
+*
+*        Golden 站，2023 年 6 月 21 日（年中第 172 天）上午，30 度朝南
+*        的面板：
+*
+*        一、逐成员对照：六种集合（只有时钟且取整秒、只有时钟、只有
+*        经纬度、只有气压温度、只有倾角方位、全部一起），每个成员的
+*        azim、zenref、etrtilt 与按该成员扰动后的输入重新完整调用一次
+*        S_solpos 的结果比较。时钟偏差带小数秒时 S_solpos 只收整秒，
+*        对照取前后两个整秒的 S_solpos 按小数部分线性插值。
+*        二、统计量：只有经度偏差（sigma 0.25 度）时 azim 近似等于
+*        nominal + 速率 x 偏差，应服从正态分布；速率由 S_solpos 在
+*        经度 +/- 0.5 度处差分得到。检查均值、方差和五个分位数。
+*        三、计时：经纬度集合与全部集合，S_ens_run 一次（成员按 float
+*        车道计算）与逐成员完整调用 S_solpos 的耗时，只打印不检查。
+*
+*        偏差超出界限时返回 1。
+*
+*----------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "solpos00.h"
+#include "solens.h"
+#include "solrt.h"
+
+#define NMEM   2000
+#define NSTAT  20000
+#define NCASE  6
+
+/* 行号与 struct solens_dist 的字段顺序相同 */
+enum { CLOCK, LAT, LON, PRESS, TEMP, TILT, ASPECT };
+
+static struct posdata nominal;
+static long long      utc0;
+
+/* 对照：成员 i 的输入（ens 为 NULL 时不扰动），整秒 off 处的完整
+   S_solpos */
+static int full(const struct solens *ens, int i, long off, float *v)
+{
+    struct posdata pd;
+    int            n;
+
+    pd = nominal;
+    S_epoch(&pd, utc0 + off);
+    if (ens)
+    {
+        n = ens->members;
+        pd.latitude  += ens->d[LAT * n + i];
+        pd.longitude += ens->d[LON * n + i];
+        pd.press     += ens->d[PRESS * n + i];
+        pd.temp      += ens->d[TEMP * n + i];
+        pd.tilt      += ens->d[TILT * n + i];
+        pd.aspect    += ens->d[ASPECT * n + i];
+    }
+    pd.function = S_TILT | S_ETR;
+    if (S_solpos(&pd) != 0)
+        return -1;
+    v[0] = pd.azim;
+    v[1] = pd.zenref;
+    v[2] = pd.etrtilt;
+    return 0;
+}
+
+int main()
+{
+    static const char *cname[NCASE] = { "时钟整秒", "时钟", "经纬度",
+                                        "气压温度", "倾角方位", "全部" };
+    static const struct solens_dist dist[NCASE] = {
+        { 30.0f, 0, 0, 0, 0, 0, 0 },
+        { 30.0f, 0, 0, 0, 0, 0, 0 },
+        { 0, 0.05f, 0.05f, 0, 0, 0, 0 },
+        { 0, 0, 0, 20.0f, 5.0f, 0, 0 },
+        { 0, 0, 0, 0, 0, 2.0f, 5.0f },
+        { 30.0f, 0.05f, 0.05f, 20.0f, 5.0f, 2.0f, 5.0f } };
+    /* 界限：度，W/m2。S_solpos 的 julday 是 float，约 337 秒一级，
+       赤经每级跳约 0.004 度；小数秒的成员对照是跨级插值，界限放宽 */
+    static const double tol[NCASE][2] = { {1e-4, 1e-3}, {2e-3, 2e-2},
+                                          {1e-4, 1e-3}, {1e-4, 1e-3},
+                                          {1e-4, 1e-3}, {2e-3, 2e-2} };
+    static const double z[S_ENS_NQ] = { -1.6448536, -0.6744898, 0.0,
+                                        0.6744898, 1.6448536 };
+    struct solens     ens;
+    struct solens_out out;
+    struct posdata    pd;
+    float  lo[3], hi[3];
+    double f, w, ref, dmax[3], rate, sig, m, dq;
+    long   retval;
+    int    c, i, k, bad = 0;
+
+    S_init(&nominal);
+    nominal.latitude  = 39.742;
+    nominal.longitude = -105.178;
+    nominal.timezone  = -7.0;
+    nominal.tilt      = 30.0;
+    nominal.aspect    = 180.0;
+    nominal.press     = 835.0;
+    nominal.temp      = 20.0;
+    utc0 = 1687305600LL + 16 * 3600 + 30 * 60 + 17; /* 当地 09:30:17 */
+    S_epoch(&nominal, utc0);
+
+    /* 一 */
+    printf("集合      成员  有效  azim 最大偏差  zenref      etrtilt\n");
+    for (c = 0; c < NCASE; c++)
+    {
+        if (S_ens_init(&ens, &dist[c], NMEM, 1234 + c) != 0)
+        {
+            printf("内存不足\n");
+            return 1;
+        }
+        if (c == 0)                       /* 时钟偏差取整秒 */
+            for (i = 0; i < NMEM; i++)
+                ens.d[CLOCK * NMEM + i] = floor(ens.d[CLOCK * NMEM + i] +
+                                                0.5);
+        pd = nominal;
+        if ((retval = S_ens_run(&ens, &pd, &out)) != 0)
+        {
+            S_decode(retval, &pd);
+            return 1;
+        }
+        if (out.valid != NMEM)
+            bad++;
+
+        dmax[0] = dmax[1] = dmax[2] = 0.0;
+        for (i = 0; i < out.valid; i++)
+        {
+            w = floor(ens.d[CLOCK * NMEM + i]);
+            f = ens.d[CLOCK * NMEM + i] - w;
+            if (full(&ens, i, (long) w, lo) != 0 ||
+                full(&ens, i, (long) w + 1, hi) != 0)
+            {
+                bad++;
+                continue;
+            }
+            for (k = 0; k < 3; k++)
+            {
+                ref = lo[k] + f * (hi[k] - lo[k]);
+                w = fabs((k == 0 ? ens.azim : k == 1 ? ens.zenref :
+                          ens.etrtilt)[i] - ref);
+                if (k == 0)
+                    w = fmin(w, 360.0 - w);
+                if (w > dmax[k]) dmax[k] = w;
+            }
+        }
+        printf("%-10s %5d %5d  %10.2g 度 %8.2g 度 %8.2g W/m2\n", cname[c],
+               NMEM, out.valid, dmax[0], dmax[1], dmax[2]);
+        if (dmax[0] > tol[c][0] || dmax[1] > tol[c][0] ||
+            dmax[2] > tol[c][1])
+            bad++;
+        S_ens_free(&ens);
+    }
+
+    /* 二 */
+    {
+        struct solens_dist lon = { 0, 0, 0.25f, 0, 0, 0, 0 };
+
+        pd = nominal;
+        pd.longitude = nominal.longitude - 0.5f;
+        pd.function  = S_TILT | S_ETR;
+        S_solpos(&pd);
+        lo[0] = pd.azim;
+        pd = nominal;
+        pd.longitude = nominal.longitude + 0.5f;
+        pd.function  = S_TILT | S_ETR;
+        S_solpos(&pd);
+        hi[0] = pd.azim;
+        if (S_ens_init(&ens, &lon, NSTAT, 99) != 0)
+            return 1;
+        rate = hi[0] - lo[0];             /* 度/度（经度相差 1 度） */
+        sig  = fabs(rate) * lon.longitude;
+        pd   = nominal;
+        S_ens_run(&ens, &pd, &out);
+        S_ens_free(&ens);
+    }
+    m = (out.azim.mean - pd.azim) / sig;
+    printf("\n只有经度偏差 0.25 度，%d 个成员：azim 应近于正态，均值 %.4f，"
+           "标准差 %.4f 度\n", NSTAT, pd.azim, sig);
+    printf("  集合：均值 %.4f（偏 %.3f sigma），标准差 %.4f（比值 %.4f）\n",
+           out.azim.mean, m, sqrt(out.azim.var), sqrt(out.azim.var) / sig);
+    if (fabs(m) > 4.0 / sqrt(NSTAT) ||
+        fabs(sqrt(out.azim.var) / sig - 1.0) > 0.03)
+        bad++;
+    printf("  分位数     5%%       25%%       50%%       75%%       95%%\n");
+    printf("  集合 ");
+    for (k = 0; k < S_ENS_NQ; k++)
+        printf(" %9.4f", out.azim.q[k]);
+    printf("\n  正态 ");
+    for (k = 0; k < S_ENS_NQ; k++)
+        printf(" %9.4f", pd.azim + z[k] * sig);
+    printf("\n");
+    for (k = 0; k < S_ENS_NQ; k++)
+    {
+        dq = fabs(out.azim.q[k] - pd.azim - z[k] * sig) / sig;
+        if (dq > 0.05)
+            bad++;
+    }
+
+    /* 三 */
+    printf("\n每个成员的耗时（微秒）  S_ens_run  逐成员 S_solpos\n");
+    for (c = 2; c < NCASE; c += 3)
+    {
+        long long t0, t1, t2;
+
+        if (S_ens_init(&ens, &dist[c], NSTAT, 7) != 0)
+            return 1;
+        pd = nominal;
+        t0 = S_rt_now();
+        S_ens_run(&ens, &pd, &out);
+        t1 = S_rt_now();
+        for (i = 0; i < NSTAT; i++)
+            full(&ens, i, (long) floor(ens.d[CLOCK * NSTAT + i]), lo);
+        t2 = S_rt_now();
+        printf("  %-10s %14.3f %14.3f\n", cname[c],
+               (t1 - t0) * 1.0e-3 / NSTAT, (t2 - t1) * 1.0e-3 / NSTAT);
+        S_ens_free(&ens);
+    }
+
+    printf("\n超限 %d 次\n", bad);
+    return bad != 0;
+}
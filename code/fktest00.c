@@ -0,0 +1,138 @@
+/*============================================================================
+*
+*    名称：fktest00.c
+*
+*    目的：比较 'solfork.c' 的多进程计算与 'solbatch.c' 的单进程多线程
+*          计算。
+*
+*        网格为若干站点 × 若干天（每分钟一个时刻）。最后一个站点故意
+*        给出越界纬度，用来检查各工作进程 validate() 错误计数的合并。
+*        两种方式输出的方位角、天顶角和倾斜面辐射应当逐行完全相同。
+*
+*        结果有不同、有工作进程异常退出、算过的行数或出错行数与
+*        单进程不符时返回 1。
+*
+*    用法：
+*         fktest [进程/线程数 [站点数 [天数]]]    默认 4 个，64 站点，7 天
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solpos00.h"
+#include "solfork.h"
+#include "solrt.h"
+
+int main(int argc, char *argv[])
+{
+    struct posdata      *sites;
+    struct solgrid       grid;
+    struct solarena      arena;
+    struct solfork_stats st;
+    struct solbatch      batch;
+    long long *utc, t0;
+    int       *site;
+    float     *buf;
+    long      *retval, rows, r, diff = 0, nerr = 0;
+    double     t_thread, t_fork;
+    int        workers = 4, nsite = 64, days = 7, k, e;
+
+    if (argc > 1) workers = atoi(argv[1]);
+    if (argc > 2) nsite   = atoi(argv[2]);
+    if (argc > 3) days    = atoi(argv[3]);
+
+    if (nsite < 2) nsite = 2;
+    sites = (struct posdata *) malloc(nsite * sizeof(*sites));
+    if (sites == NULL)
+        return 1;
+    for (k = 0; k < nsite; k++)
+    {
+        S_init(&sites[k]);
+        sites[k].latitude  = -60.0 + 120.0 * k / nsite;
+        sites[k].longitude = -180.0 + 360.0 * k / nsite;
+        sites[k].timezone  = (float) (int) (sites[k].longitude / 15.0);
+        sites[k].tilt      = sites[k].latitude;
+        sites[k].aspect    = 180.0;
+    }
+    sites[nsite - 1].latitude = 95.0;            /* 故意越界 */
+
+    grid.sites = sites;
+    grid.nsite = nsite;
+    grid.start = 1672531200LL;                   /* 2023-01-01 00:00 UTC */
+    grid.step  = 60;
+    grid.ntime = 1440L * days;
+    grid.cols  = S_COL(C_AZIM) | S_COL(C_ZENREF) | S_COL(C_ETRTILT);
+    rows = (long) nsite * grid.ntime;
+
+    /* 单进程多线程：需要完整的时间和站点索引数组 */
+    utc    = (long long *) malloc(rows * sizeof(*utc));
+    site   = (int *) malloc(rows * sizeof(*site));
+    retval = (long *) malloc(rows * sizeof(*retval));
+    buf    = (float *) malloc(3 * rows * sizeof(float));
+    if (!utc || !site || !retval || !buf)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    for (r = 0; r < rows; r++)
+    {
+        site[r] = (int) (r / grid.ntime);
+        utc[r]  = grid.start + (r % grid.ntime) * grid.step;
+    }
+    memset(&batch, 0, sizeof(batch));
+    batch.count  = rows;
+    batch.utc    = utc;
+    batch.site   = site;
+    batch.sites  = sites;
+    batch.retval = retval;
+    batch.col[C_AZIM]    = buf;
+    batch.col[C_ZENREF]  = buf + rows;
+    batch.col[C_ETRTILT] = buf + 2 * rows;
+
+    t0 = S_rt_now();
+    S_batch_parallel(&batch, workers);
+    t_thread = (S_rt_now() - t0) * 1.0e-9;
+
+    /* 多进程，结果直接写入共享内存 */
+    t0 = S_rt_now();
+    if (S_fork_run(&grid, workers, &arena, &st) != 0)
+    {
+        printf("共享内存映射失败\n");
+        return 1;
+    }
+    t_fork = (S_rt_now() - t0) * 1.0e-9;
+
+    for (r = 0; r < rows; r++)
+    {
+        if (retval[r] != 0)
+            nerr++;
+        if (arena.retval[r] != retval[r] ||
+            arena.col[C_AZIM][r]    != batch.col[C_AZIM][r] ||
+            arena.col[C_ZENREF][r]  != batch.col[C_ZENREF][r] ||
+            arena.col[C_ETRTILT][r] != batch.col[C_ETRTILT][r])
+            diff++;
+    }
+
+    printf("%d 站点 × %ld 时刻 = %ld 行，%d 个线程/进程\n",
+           nsite, grid.ntime, rows, workers);
+    printf("多线程  %8.3f 秒  %12.0f 行/秒\n", t_thread, rows / t_thread);
+    printf("多进程  %8.3f 秒  %12.0f 行/秒\n", t_fork, rows / t_fork);
+    printf("计算 %ld 行，出错 %ld 行，异常退出的进程 %d 个\n",
+           st.rows, st.errors, st.failed);
+    for (e = 0; e < S_F_NERR; e++)
+        if (st.code[e])
+            printf("  错误代码 %2d：%ld 行\n", e, st.code[e]);
+    printf("两种方式结果不一致 %ld 行\n", diff);
+
+    S_arena_free(&arena);
+    free(sites);
+    free(utc);
+    free(site);
+    free(retval);
+    free(buf);
+    return diff != 0 || st.failed != 0 || st.rows != rows ||
+           st.errors != nerr;
+}
@@ -0,0 +1,202 @@
+/*============================================================================
+*
+*    名称：fxtest00.c
+*
+*    目的：测试 'solfix.c' 中的定点太阳位置算法，并与 'solpos.c' 中的
+*          S_solpos（浮点）结果比较，输出精度报告。
+*
+*        S_fixpos
+*            输入：     年份，一年中的天数，小时，分钟，秒，间隔，纬度，
+*                        经度，时区，气压，温度（Q16.16 定点数）
+*
+*            输出：    赤纬，时角，天顶角，太阳高度，方位角，
+*                        折射修正后的太阳高度和天顶角（Q16.16 度）
+*
+*        报告内容：每个输出变量相对于 S_solpos 的最大绝对误差和均方根误差
+*        （度），以及两种实现每次调用的平均耗时。方位角只在太阳高于地平线
+*        且不在天顶附近时统计（S_solpos 在这些情况下的方位角本身无效），
+*        另列天顶角 10 度以上的；再把两种实现的方位角一步各自与由同一
+*        赤纬、时角算出的双精度值比较。误差超出 solfix.h 中的界限时
+*        返回 1。
+*
+*    用法：
+*         在调用程序中，除了其他 'include' 语句之外，插入：
+*
+*              #include "solfix.h"
+*
+*----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#include "solpos00.h"
+#include "solfix.h"
+
+/* 统计量：最大绝对误差、平方和、样本数 */
+struct errstat
+{
+    double max;
+    double ss;
+    long   n;
+};
+
+static void accum(struct errstat *st, double d)
+{
+    if (d > 180.0)       /* 角度差绕回 +/- 180 度 */
+        d -= 360.0;
+    else if (d < -180.0)
+        d += 360.0;
+    if (fabs(d) > st->max)
+        st->max = fabs(d);
+    st->ss += d * d;
+    st->n++;
+}
+
+/* 双精度方位角：由同一组赤纬、时角、纬度按东、北分量求 */
+static double azimuth(double declin, double hrang, double lat)
+{
+    const double r = 0.017453292519943295;
+    double a;
+
+    a = atan2(-cos(declin * r) * sin(hrang * r),
+              sin(declin * r) * cos(lat * r) -
+              cos(declin * r) * sin(lat * r) * cos(hrang * r)) / r;
+    return a < 0.0 ? a + 360.0 : a;
+}
+
+static void report(const char *name, const struct errstat *st)
+{
+    printf("%-8s  最大误差 %10.6f 度   均方根误差 %10.6f 度   样本 %ld\n",
+           name, st->max, st->n ? sqrt(st->ss / st->n) : 0.0, st->n);
+}
+
+int main()
+{
+    static const float lats[] = { -66.0, -33.9, 0.0, 21.3, 38.9, 39.4, 64.8 };
+    static const float lons[] = { -157.8, -84.4, -0.1, 77.2, 121.6, 151.2 };
+    static const int   years[] = { 1955, 1999, 2023, 2049 };
+
+    struct posdata pd, *pdat;
+    struct fixdata fd, *fdat;
+    struct errstat e_decl = {0}, e_hrang = {0}, e_zenetr = {0},
+                   e_azim = {0}, e_elevref = {0}, e_zenref = {0},
+                   e_azim10 = {0}, e_fstage = {0}, e_sstage = {0};
+    clock_t t0;
+    double  t_float = 0.0, t_fix = 0.0;
+    long    calls = 0;
+    int     ila, ilo, iy, day, minute;
+
+    pdat = &pd;
+    fdat = &fd;
+
+    S_init(pdat);
+    S_fixinit(fdat);
+
+    pdat->function = (S_SOLAZM | S_REFRAC);
+
+    printf("\n");
+    printf("***** 测试 S_fixpos（定点）与 S_solpos（浮点）: *****\n");
+    printf("\n");
+
+    for (ila = 0; ila < (int) (sizeof(lats) / sizeof(lats[0])); ila++)
+    for (ilo = 0; ilo < (int) (sizeof(lons) / sizeof(lons[0])); ilo++)
+    for (iy = 0; iy < (int) (sizeof(years) / sizeof(years[0])); iy++)
+    for (day = 1; day <= 365; day += 4)
+    for (minute = 0; minute < 1440; minute += 20)
+    {
+        /* 同一组输入分别交给两个实现 */
+        pdat->latitude  = lats[ila];
+        pdat->longitude = lons[ilo];
+        pdat->timezone  = floor(lons[ilo] / 15.0 + 0.5);
+        pdat->year      = years[iy];
+        pdat->daynum    = day;
+        pdat->hour      = minute / 60;
+        pdat->minute    = minute % 60;
+        pdat->second    = 0;
+        pdat->temp      = 20.0;
+        pdat->press     = 1000.0;
+
+        fdat->latitude  = S_FIX(pdat->latitude);
+        fdat->longitude = S_FIX(pdat->longitude);
+        fdat->timezone  = S_FIX(pdat->timezone);
+        fdat->year      = pdat->year;
+        fdat->daynum    = pdat->daynum;
+        fdat->hour      = pdat->hour;
+        fdat->minute    = pdat->minute;
+        fdat->second    = pdat->second;
+        fdat->temp      = S_FIX(20.0);
+        fdat->press     = S_FIX(1000.0);
+
+        t0 = clock();
+        S_decode(S_solpos(pdat), pdat);
+        t_float += clock() - t0;
+
+        t0 = clock();
+        if (S_fixpos(fdat) != 0)
+            printf("S_fixpos 返回错误\n");
+        t_fix += clock() - t0;
+        calls++;
+
+        accum(&e_decl,    S_UNFIX(fdat->declin)  - pdat->declin);
+        accum(&e_hrang,   S_UNFIX(fdat->hrang)   - pdat->hrang);
+        accum(&e_zenetr,  S_UNFIX(fdat->zenetr)  - pdat->zenetr);
+        accum(&e_elevref, S_UNFIX(fdat->elevref) - pdat->elevref);
+        accum(&e_zenref,  S_UNFIX(fdat->zenref)  - pdat->zenref);
+        if (pdat->elevetr > 0.0 && pdat->zenetr > 1.0)
+        {
+            accum(&e_azim, S_UNFIX(fdat->azim) - pdat->azim);
+            if (pdat->zenetr >= 10.0)
+                accum(&e_azim10, S_UNFIX(fdat->azim) - pdat->azim);
+
+            /* 方位角一步本身：各自由自己的赤纬、时角算出的双精度值 */
+            accum(&e_fstage, S_UNFIX(fdat->azim) -
+                  azimuth(S_UNFIX(fdat->declin), S_UNFIX(fdat->hrang),
+                          pdat->latitude));
+            accum(&e_sstage, pdat->azim -
+                  azimuth(pdat->declin, pdat->hrang, pdat->latitude));
+        }
+    }
+
+    report("declin",  &e_decl);
+    report("hrang",   &e_hrang);
+    report("zenetr",  &e_zenetr);
+    report("azim",    &e_azim);
+    report("azim>10", &e_azim10);
+    report("elevref", &e_elevref);
+    report("zenref",  &e_zenref);
+    printf("\n");
+    printf("方位角一步，与由同一赤纬、时角算出的双精度值比较：\n");
+    report("S_fixpos", &e_fstage);
+    report("S_solpos", &e_sstage);
+    printf("（S_solpos 取 arccos，在子午线附近损失精度；上面 azim 的最大\n"
+           "误差主要来自这里，以及天顶角小时赤纬、时角误差的放大）\n");
+    printf("\n");
+    printf("每次调用耗时：S_solpos %.3f 微秒，S_fixpos %.3f 微秒（本机有 FPU，仅供参考）\n",
+           1.0e6 * t_float / CLOCKS_PER_SEC / calls,
+           1.0e6 * t_fix / CLOCKS_PER_SEC / calls);
+
+    /* 单个示例：与 stest00.c 相同的输入 */
+    fdat->latitude  = S_FIX(33.65);
+    fdat->longitude = S_FIX(-84.43);
+    fdat->timezone  = S_FIX(-5.0);
+    fdat->year      = 1999;
+    fdat->daynum    = 203;
+    fdat->hour      = 9;
+    fdat->minute    = 45;
+    fdat->second    = 37;
+    fdat->temp      = S_FIX(27.0);
+    fdat->press     = S_FIX(1006.0);
+    S_fixpos(fdat);
+
+    printf("\n");
+    printf("NREL    -> 方位角 azim 97.032875，太阳高度角 elevref 48.409931，折射的天顶角 zenref 41.590069\n");
+    printf("FXTEST  -> 方位角 azim %f，太阳高度角 elevref %f，折射的天顶角 zenref %f\n",
+           S_UNFIX(fdat->azim), S_UNFIX(fdat->elevref), S_UNFIX(fdat->zenref));
+
+    /* solfix.h 中所述的界限 */
+    return e_decl.max > 0.0035 || e_hrang.max > 0.0035 ||
+           e_zenetr.max > 0.0035 || e_elevref.max > 0.0035 ||
+           e_zenref.max > 0.0035 || e_fstage.max > 0.001 ||
+           e_azim10.max > 0.1 || e_azim.max > 0.6;
+}
@@ -0,0 +1,214 @@
+/*============================================================================
+*
+*    名称：mptest00.c
+*
+*    目的：测试 'solmap.c' 的经纬度栅格太阳资源图。
+*
+*        大连附近 2.56 x 2.56 度、0.01 度的格网（256 x 256 格，64 x 64
+*        的瓦片共 16 块），2023 年逐时，算全年水平面地外辐射量、日照
+*        小时数和最佳倾角：
+*
+*        一、续算：先只算 5 块瓦片后关闭，未算的格子应读出 NaN；再打开
+*        同一文件应剩 11 块，算完；用不同的格网打开该文件应返回 1。
+*        二、抽几个格子，按旧做法逐时调用 S_solpos 求和作对照，最佳
+*        倾角用双精度黄金分割搜索；打印最大偏差，地外辐射的相对偏差
+*        应不超过 2e-6，日照小时数应相同，倾角偏差应不超过 0.001 度。
+*        三、速度：重新算一张整图，打印 格子 x 时 每秒多少，与逐时
+*        S_solpos 比较。
+*
+*        第一、二部分检查不过时返回 1。
+*
+*    用法：
+*         mptest [线程数]        默认 4
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "solpos00.h"
+#include "solmap.h"
+#include "solrt.h"
+
+#define START  1672531200LL          /* 2023-01-01 00:00 UTC */
+#define NTIME  8760L
+#define RAD    0.017453292519943295
+#define NS     6
+
+static const char *path = "/tmp/mptest-map.bin";
+
+static double zen[NTIME], azi[NTIME], etrn[NTIME];
+
+/* 对照：倾角 b（度）朝赤道的面上全年地外直射量 */
+static double onplane(double b, double asp)
+{
+    double s = 0.0, c;
+    long   t;
+
+    for (t = 0; t < NTIME; t++)
+    {
+        c = cos(zen[t] * RAD) * cos(b * RAD) +
+            sin(zen[t] * RAD) * sin(b * RAD) * cos((azi[t] - asp) * RAD);
+        if (c > 0.0)
+            s += etrn[t] * c;
+    }
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    static const long cell[NS][2] = { {0, 0}, {0, 255}, {100, 37},
+                                      {128, 128}, {201, 250}, {255, 3} };
+    struct solmapgrid grid, other;
+    struct posdata    site, pd;
+    struct solmap     map;
+    long long t0;
+    long      n, t, s;
+    double    sec, etr, hrs, a, b, c, d, fa, fb, asp, ref;
+    double    de = 0.0, dh = 0.0, dt = 0.0, rate;
+    int       threads = 4, e, k, fail = 0;
+
+    if (argc > 1) threads = atoi(argv[1]);
+    if (threads < 1) threads = 1;
+
+    S_init(&site);
+    grid.lat0  = 40.0;
+    grid.lon0  = 120.5;
+    grid.step  = 0.01;
+    grid.nrow  = 256;
+    grid.ncol  = 256;
+    grid.tile  = 64;
+    grid.start = START + 3600;            /* 每小时的结束时刻 */
+    grid.tstep = 3600;
+    grid.ntime = NTIME;
+
+    /* 一、续算 */
+    unlink(path);
+    if ((e = S_map_open(path, &grid, &site, &map)) != 0)
+    {
+        printf("%s 打开出错 %d\n", path, e);
+        return 1;
+    }
+    printf("新建：%ld x %ld 块瓦片，待算 %ld 块\n", map.trow, map.tcol,
+           map.pending);
+    n = S_map_run(&map, threads, 5);
+    printf("只算 5 块：算了 %ld 块，待算 %ld 块；(0,0) 的地外辐射 %.1f，"
+           "(255,255) 的 %.1f\n", n, map.pending,
+           S_map_cell(&map, M_ETR, 0, 0), S_map_cell(&map, M_ETR, 255, 255));
+    fail += n != 5 || map.pending != 11 ||
+            isnan(S_map_cell(&map, M_ETR, 0, 0)) ||
+            !isnan(S_map_cell(&map, M_ETR, 255, 255));
+    S_map_close(&map);
+
+    if ((e = S_map_open(path, &grid, &site, &map)) != 0)
+    {
+        printf("%s 再打开出错 %d\n", path, e);
+        return 1;
+    }
+    printf("再打开：待算 %ld 块", map.pending);
+    n = S_map_run(&map, threads, 0);
+    printf("，算了 %ld 块，待算 %ld 块\n", n, map.pending);
+    fail += n != 11 || map.pending != 0;
+
+    other = grid;
+    other.step = 0.02;
+    {
+        struct solmap m2;
+
+        e = S_map_open(path, &other, &site, &m2);
+        printf("用不同格网打开：返回 %d\n", e);
+        fail += e != 1;
+        S_map_close(&m2);
+    }
+
+    /* 二、对照 */
+    printf("\n格子        地外辐射 kWh/m2  日照小时  最佳倾角\n");
+    t0 = S_rt_now();
+    for (s = 0; s < NS; s++)
+    {
+        S_init(&pd);
+        pd.latitude  = grid.lat0 - cell[s][0] * grid.step;
+        pd.longitude = grid.lon0 + cell[s][1] * grid.step;
+        pd.timezone  = 0.0;
+        pd.interval  = 3600;
+        etr = hrs = 0.0;
+        for (t = 0; t < NTIME; t++)
+        {
+            pd.function = S_ETR | S_SOLAZM;
+            S_epoch(&pd, grid.start + t * grid.tstep);
+            S_solpos(&pd);
+            zen[t]  = pd.zenetr;
+            azi[t]  = pd.azim;
+            etrn[t] = pd.etrn;
+            etr    += pd.etr / 1000.0;
+            hrs    += pd.etr > 0.0;
+        }
+
+        /* 黄金分割 */
+        asp = pd.latitude >= 0.0 ? 180.0 : 0.0;
+        a = -30.0;
+        b = 90.0;
+        c = b - (b - a) * 0.618033988749895;
+        d = a + (b - a) * 0.618033988749895;
+        fa = onplane(c, asp);
+        fb = onplane(d, asp);
+        for (k = 0; k < 40; k++)
+            if (fa > fb)
+            {
+                b = d;  d = c;  fb = fa;
+                c = b - (b - a) * 0.618033988749895;
+                fa = onplane(c, asp);
+            }
+            else
+            {
+                a = c;  c = d;  fa = fb;
+                d = a + (b - a) * 0.618033988749895;
+                fb = onplane(d, asp);
+            }
+        ref = 0.5 * (a + b);
+
+        printf("(%3ld,%3ld)  %8.2f %8.2f  %6.0f %6.0f  %6.3f %6.3f\n",
+               cell[s][0], cell[s][1],
+               S_map_cell(&map, M_ETR, cell[s][0], cell[s][1]), etr,
+               S_map_cell(&map, M_SUNHOURS, cell[s][0], cell[s][1]), hrs,
+               S_map_cell(&map, M_TILT, cell[s][0], cell[s][1]), ref);
+        de = fmax(de, fabs(S_map_cell(&map, M_ETR, cell[s][0], cell[s][1]) -
+                           etr) / etr);
+        dh = fmax(dh, fabs(S_map_cell(&map, M_SUNHOURS, cell[s][0],
+                                      cell[s][1]) - hrs));
+        dt = fmax(dt, fabs(S_map_cell(&map, M_TILT, cell[s][0], cell[s][1]) -
+                           ref));
+    }
+    sec  = (S_rt_now() - t0) * 1.0e-9;
+    rate = NS * NTIME / sec;              /* 含黄金分割，只作量级参考 */
+    printf("最大偏差：地外辐射（相对）%.2g，日照 %.0f 小时，倾角 %.4f 度\n",
+           de, dh, dt);
+    fail += de > 2.0e-6 || dh != 0.0 || dt > 0.001;
+    S_map_close(&map);
+
+    /* 三、速度 */
+    unlink(path);
+    S_map_open(path, &grid, &site, &map);
+    t0  = S_rt_now();
+    n   = S_map_run(&map, threads, 0);
+    sec = (S_rt_now() - t0) * 1.0e-9;
+    printf("\n整图 %ld 块，%d 线程：%.2f 秒，%.3g 格时/秒\n", n, threads, sec,
+           grid.nrow * grid.ncol * (double) NTIME / sec);
+    t0 = S_rt_now();
+    for (t = 0; t < NTIME; t++)
+    {
+        pd.function = S_ETR;
+        S_epoch(&pd, grid.start + t * grid.tstep);
+        S_solpos(&pd);
+    }
+    sec = (S_rt_now() - t0) * 1.0e-9;
+    printf("逐时 S_solpos（S_ETR）单线程：%.3g 格时/秒（对照连同搜索 %.3g）\n",
+           NTIME / sec, rate);
+    S_map_close(&map);
+    unlink(path);
+    printf("\n检查不过 %d 处\n", fail);
+    return fail != 0;
+}
@@ -0,0 +1,149 @@
+/*============================================================================
+*
+*    名称：nmtest00.c
+*
+*    目的：比较 'solnuma.c' 的按 NUMA 节点划分的网格计算与
+*          'solbatch.c' 的普通多线程计算。
+*
+*        普通方式的结果缓冲区由主线程分配并首次写入，在多路服务器上
+*        这些页面全部落在主线程所在的节点；按节点方式则由各节点上
+*        绑定的线程各自分配并首次写入自己的结果块，站点模板每个节点
+*        复制一份。打印节点拓扑、两种方式的吞吐量、每个节点的吞吐量，
+*        并逐行核对两种方式的结果。
+*
+*        两种方式结果有不一致时返回 1。
+*
+*    用法：
+*         nmtest [线程数 [站点数 [天数]]]     默认每个 CPU 一个线程，64 站点，7 天
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solpos00.h"
+#include "solnuma.h"
+#include "solrt.h"
+
+static struct solnuma topo;
+
+int main(int argc, char *argv[])
+{
+    struct posdata    *sites;
+    struct solgrid     grid;
+    struct solnuma_run run;
+    struct solbatch    batch;
+    struct solslab    *sl;
+    long long *utc, t0;
+    int       *site;
+    float     *buf;
+    long      *retval, rows, r, i, diff = 0;
+    double     t_plain, t_numa;
+    int        threads = 0, nsite = 64, days = 7, ncpu = 0, k, n;
+
+    if (argc > 1) threads = atoi(argv[1]);
+    if (argc > 2) nsite   = atoi(argv[2]);
+    if (argc > 3) days    = atoi(argv[3]);
+    if (nsite < 1) nsite = 1;
+
+    S_numa_topology(&topo);
+    printf("NUMA 节点 %d 个\n", topo.nnode);
+    for (n = 0; n < topo.nnode; n++)
+    {
+        printf("  节点 %d：%d 个 CPU\n", topo.node[n].id, topo.node[n].ncpu);
+        ncpu += topo.node[n].ncpu;
+    }
+
+    sites = (struct posdata *) malloc(nsite * sizeof(*sites));
+    if (sites == NULL)
+        return 1;
+    for (k = 0; k < nsite; k++)
+    {
+        S_init(&sites[k]);
+        sites[k].latitude  = -60.0 + 120.0 * k / nsite;
+        sites[k].longitude = -180.0 + 360.0 * k / nsite;
+        sites[k].timezone  = (float) (int) (sites[k].longitude / 15.0);
+        sites[k].tilt      = sites[k].latitude;
+        sites[k].aspect    = 180.0;
+    }
+
+    grid.sites = sites;
+    grid.nsite = nsite;
+    grid.start = 1672531200LL;
+    grid.step  = 60;
+    grid.ntime = 1440L * days;
+    grid.cols  = S_COL(C_AZIM) | S_COL(C_ZENREF) | S_COL(C_ETRTILT);
+    rows = (long) nsite * grid.ntime;
+
+    /* 普通方式：主线程分配并首次写入全部缓冲区 */
+    utc    = (long long *) malloc(rows * sizeof(*utc));
+    site   = (int *) malloc(rows * sizeof(*site));
+    retval = (long *) malloc(rows * sizeof(*retval));
+    buf    = (float *) malloc(3 * rows * sizeof(float));
+    if (!utc || !site || !retval || !buf)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    memset(buf, 0, 3 * rows * sizeof(float));
+    for (r = 0; r < rows; r++)
+    {
+        site[r] = (int) (r / grid.ntime);
+        utc[r]  = grid.start + (r % grid.ntime) * grid.step;
+    }
+    memset(&batch, 0, sizeof(batch));
+    batch.count  = rows;
+    batch.utc    = utc;
+    batch.site   = site;
+    batch.sites  = sites;
+    batch.retval = retval;
+    batch.col[C_AZIM]    = buf;
+    batch.col[C_ZENREF]  = buf + rows;
+    batch.col[C_ETRTILT] = buf + 2 * rows;
+
+    t0 = S_rt_now();
+    S_batch_parallel(&batch, threads > 0 ? threads : ncpu);
+    t_plain = (S_rt_now() - t0) * 1.0e-9;
+
+    /* 按节点方式 */
+    t0 = S_rt_now();
+    if (S_numa_grid(&grid, &topo, threads, &run) != 0)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    t_numa = (S_rt_now() - t0) * 1.0e-9;
+
+    for (i = 0; i < run.nslab; i++)
+    {
+        sl = &run.slab[i];
+        for (r = sl->first; r < sl->last; r++)
+            if (sl->retval[r - sl->first] != retval[r] ||
+                sl->col[C_AZIM][r - sl->first]    != batch.col[C_AZIM][r] ||
+                sl->col[C_ZENREF][r - sl->first]  != batch.col[C_ZENREF][r] ||
+                sl->col[C_ETRTILT][r - sl->first] != batch.col[C_ETRTILT][r])
+                diff++;
+    }
+
+    printf("%d 站点 × %ld 时刻 = %ld 行，%d 个线程\n",
+           nsite, grid.ntime, rows, run.nslab);
+    printf("普通多线程  %8.3f 秒  %12.0f 行/秒\n", t_plain, rows / t_plain);
+    printf("按节点划分  %8.3f 秒  %12.0f 行/秒\n", t_numa, rows / t_numa);
+    for (n = 0; n < topo.nnode; n++)
+        printf("  节点 %d：%ld 行  %12.0f 行/秒\n",
+               topo.node[n].id, run.rows[n], run.rate[n]);
+    for (i = 0; i < run.nslab; i++)
+        if (run.slab[i].cpu < 0)
+            printf("  线程 %ld 未能绑定 CPU\n", i);
+    printf("两种方式结果不一致 %ld 行\n", diff);
+
+    S_numa_free(&run);
+    free(sites);
+    free(utc);
+    free(site);
+    free(retval);
+    free(buf);
+    return diff != 0;
+}
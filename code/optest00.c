@@ -0,0 +1,224 @@
+/*============================================================================
+*
+*    名称：optest00.c
+*
+*    目的：测试 'solopt.c' 的最佳固定倾角/方位角搜索。
+*
+*        两个站点（北半球 Golden，南半球悉尼），2023 年逐时：
+*
+*        一、S_sky_etrtilt 与逐时调用 S_solpos（S_TILT）把 etrtilt 相加
+*        的结果比较，6 个朝向 x 5 个月份掩码（全年、DJF、JJA、3 月、
+*        6 + 12 月），打印最大相对偏差。
+*        二、S_sky_optimize 与穷举比较：倾角 0 - 90 度每 1 度、方位角
+*        每 2 度的格网上逐时求和（双精度），再在最佳格点附近每 0.1 度
+*        细化；比较最大能量和所得的朝向。
+*
+*        三、step 不合法（0、481、不整除一天的 7 分钟）时 S_sky_build
+*        应返回 -1。
+*
+*        偏差超出界限时返回 1。
+*
+*----------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "solpos00.h"
+#include "solopt.h"
+
+#define YEAR   2023
+#define NDAY   365
+#define NTIME  ( NDAY * 24 )
+#define NOR    6
+#define NMASK  5
+#define RAD    0.017453292519943295
+
+static double vx[NTIME], vy[NTIME], vz[NTIME];   /* etrn 乘太阳单位矢量 */
+static int    mon[NTIME];
+
+/* 穷举：朝向 (b, g) 的面上所选月份的地外直射量，Wh/m2 */
+static double onplane(int months, double b, double g)
+{
+    double s = 0.0, c, nx, ny, nz;
+    long   t;
+
+    nx = sin(b * RAD) * sin(g * RAD);
+    ny = sin(b * RAD) * cos(g * RAD);
+    nz = cos(b * RAD);
+    for (t = 0; t < NTIME; t++)
+    {
+        if (!(months & S_MONTH(mon[t])))
+            continue;
+        c = vx[t] * nx + vy[t] * ny + vz[t] * nz;
+        if (c > 0.0)
+            s += c;
+    }
+    return s;
+}
+
+/* 穷举搜索：先粗格网，再在最佳格点附近细化 */
+static double search(int months, double *bt, double *bg)
+{
+    double e, best = -1.0, b0, g0, b, g;
+    int    i, j;
+
+    *bt = *bg = 0.0;
+    for (i = 0; i <= 90; i++)
+        for (j = 0; j < 180; j++)
+            if ((e = onplane(months, i, 2.0 * j)) > best)
+            {
+                best = e;
+                *bt  = i;
+                *bg  = 2.0 * j;
+            }
+    b0 = *bt;
+    g0 = *bg;
+    for (i = -10; i <= 10; i++)
+        for (j = -20; j <= 20; j++)
+        {
+            b = b0 + 0.1 * i;
+            g = fmod(g0 + 0.1 * j + 360.0, 360.0);
+            if (b < 0.0 || b > 90.0)
+                continue;
+            if ((e = onplane(months, b, g)) > best)
+            {
+                best = e;
+                *bt  = b;
+                *bg  = g;
+            }
+        }
+    return best;
+}
+
+int main()
+{
+    static const float  orient[NOR][2] = { {0, 180}, {30, 180}, {45, 135},
+                                           {60, 250}, {90, 90}, {20, 0} };
+    static const int    mask[NMASK] = { S_YEAR, S_DJF, S_JJA, S_MONTH(3),
+                                        S_MONTH(6) | S_MONTH(12) };
+    static const char  *mname[NMASK] = { "全年", "DJF", "JJA", "3 月",
+                                         "6+12 月" };
+    static const double site_ll[2][3] = { {39.742, -105.178, -7.0},
+                                          {-33.87, 151.21, 10.0} };
+    static const char  *sname[2] = { "Golden", "悉尼" };
+    struct posdata site, pd;
+    struct solsky  sky;
+    double month_sum[NOR][13], ref, got, d;
+    double dmax = 0.0, emax = 0.0, tmax = 0.0, amax = 0.0;
+    double rt, ra;
+    float  tilt, aspect;
+    long   retval, t;
+    int    s, o, m, k, h, bad = 0;
+
+    for (s = 0; s < 2; s++)
+    {
+        S_init(&site);
+        site.latitude  = site_ll[s][0];
+        site.longitude = site_ll[s][1];
+        site.timezone  = site_ll[s][2];
+
+        if ((retval = S_sky_build(&sky, &site, YEAR, 60)) != 0)
+        {
+            printf("%s：S_sky_build 出错 %ld\n", sname[s], retval);
+            return 1;
+        }
+
+        /* 逐时 S_solpos：与 S_sky_build 一样，每小时的结束时刻、
+           interval 3600，即取每小时中点的太阳位置 */
+        memset(month_sum, 0, sizeof(month_sum));
+        pd          = site;
+        pd.year     = YEAR;
+        pd.interval = 3600;
+        pd.second   = 0;
+        for (t = 0, pd.daynum = 1; pd.daynum <= NDAY; pd.daynum++)
+            for (h = 1; h <= 24; h++, t++)
+            {
+                pd.hour   = h;
+                pd.minute = 0;
+                for (o = 0; o < NOR; o++)
+                {
+                    pd.function = S_TILT | S_ETR;
+                    pd.tilt     = orient[o][0];
+                    pd.aspect   = orient[o][1];
+                    if ((retval = S_solpos(&pd)) != 0)
+                    {
+                        S_decode(retval, &pd);
+                        return 1;
+                    }
+                    month_sum[o][pd.month] += pd.etrtilt;
+                }
+                d = pd.etrn > 0.0 ? pd.etrn : 0.0;
+                vx[t]  = d * sin(pd.zenref * RAD) * sin(pd.azim * RAD);
+                vy[t]  = d * sin(pd.zenref * RAD) * cos(pd.azim * RAD);
+                vz[t]  = d * cos(pd.zenref * RAD);
+                mon[t] = pd.month;
+            }
+
+        /* 一 */
+        printf("%s（纬度 %.2f）\n", sname[s], site.latitude);
+        printf("  倾角 方位  月份      S_sky_etrtilt   逐时 S_solpos   "
+               "相对偏差\n");
+        for (o = 0; o < NOR; o++)
+            for (k = 0; k < NMASK; k++)
+            {
+                for (ref = 0.0, m = 1; m <= 12; m++)
+                    if (mask[k] & S_MONTH(m))
+                        ref += month_sum[o][m];
+                got = S_sky_etrtilt(&sky, mask[k], orient[o][0],
+                                    orient[o][1]);
+                d = fabs(got - ref) / ref;
+                if (d > dmax) dmax = d;
+                if (d > 1.0e-3) bad++;
+                if (k == 0 || k == 3)
+                    printf("  %4.0f %4.0f  %-8s %14.0f %15.0f %10.2g\n",
+                           orient[o][0], orient[o][1], mname[k], got, ref, d);
+            }
+
+        /* 二 */
+        printf("  月份      S_sky_optimize 倾角 方位 能量     "
+               "穷举 倾角 方位 能量\n");
+        for (k = 0; k < NMASK; k++)
+        {
+            got = S_sky_optimize(&sky, mask[k], &tilt, &aspect);
+            ref = search(mask[k], &rt, &ra);
+            printf("  %-8s %11.2f %6.1f %9.0f %11.2f %6.1f %9.0f\n",
+                   mname[k], tilt, aspect, got, rt, ra, ref);
+
+            /* 穷举最优面上的 S_sky_etrtilt 不应高于 S_sky_optimize 的 */
+            d = (S_sky_etrtilt(&sky, mask[k], rt, ra) - got) / ref;
+            if (d > 1.0e-4) bad++;
+            d = fabs(got - ref) / ref;
+            if (d > emax) emax = d;
+            if (d > 1.0e-3) bad++;
+            d = fabs(tilt - rt);
+            if (d > tmax) tmax = d;
+            if (d > 1.0) bad++;
+            d = fabs(aspect - ra);
+            d = fmin(d, 360.0 - d);
+            if (rt > 5.0)                 /* 近于水平时方位无意义 */
+            {
+                if (d > amax) amax = d;
+                if (d > 2.0) bad++;
+            }
+        }
+        printf("\n");
+        S_sky_free(&sky);
+    }
+
+    /* 三 */
+    for (k = 0; k < 3; k++)
+    {
+        h = k == 0 ? 0 : k == 1 ? 481 : 7;
+        retval = S_sky_build(&sky, &site, YEAR, h);
+        printf("step %d：S_sky_build 返回 %ld（应为 -1）\n", h, retval);
+        if (retval != -1)
+            bad++;
+        S_sky_free(&sky);
+    }
+
+    printf("S_sky_etrtilt 最大相对偏差 %.2g；S_sky_optimize 能量最大相对"
+           "偏差 %.2g，倾角 %.2f 度，方位 %.2f 度；超限 %d 次\n", dmax, emax,
+           tmax, amax, bad);
+    return bad != 0;
+}
@@ -0,0 +1,247 @@
+/*============================================================================
+*
+*    名称：patest00.c
+*
+*    目的：测试 'solpoa.c' 中倾斜面（阵列面）辐射的三种换算模型。
+*
+*        大连一年逐时批量计算太阳位置，用 'solclear.c' 的 Ineichen
+*        晴空辐射乘以随时间变化的云量系数当作“实测”的 GHI、DHI；
+*        面板取倾角 0 - 90 度（每 5 度）、朝向 90 - 270 度（每 10 度），
+*        共 19 x 19 = 361 个朝向，按时间 x 朝向一次算完：
+*
+*        一、水平面板（倾角 0）三种模型都应回到 GHI，打印最大偏差。
+*        二、与按公式逐个时刻、逐个朝向用双精度写成的对照计算比较，
+*        打印（100 W/平方米以上的）最大相对偏差。
+*        三、批量计算自带的 cosinc（站点倾角 30 度朝南）与朝向表中
+*        同一朝向的结果比较。
+*        一至三的偏差都按 100 W/平方米以上的相对偏差计，超过 3.5e-6
+*        时返回 1。
+*        四、打印各模型与对照计算的速度（时刻 x 朝向 / 秒），以及
+*        全年最佳朝向和倾角 30 度朝南的年辐照量。
+*
+*    用法：
+*         patest [天数]        默认 365 天
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solpos00.h"
+#include "solclear.h"
+#include "solpoa.h"
+#include "solrt.h"
+#include "soltilt.h"
+
+#define START  1672531200LL          /* 2023-01-01 00:00 UTC */
+#define NTILT  19
+#define NASP   19
+#define NP     (NTILT * NASP)
+#define RAD    0.0174532925199433
+
+/* Perez 1990 全站点系数，与 solpoa.c 相同 */
+static const double F[8][6] = {
+    { -0.0083117,  0.5877285, -0.0620636, -0.0596012,  0.0721249, -0.0220216 },
+    {  0.1299457,  0.6825954, -0.1513752, -0.0189325,  0.0659650, -0.0288748 },
+    {  0.3296958,  0.4868735, -0.2210958,  0.0554140, -0.0639588, -0.0260542 },
+    {  0.5682053,  0.1874525, -0.2951290,  0.1088631, -0.1519229, -0.0139754 },
+    {  0.8730280, -0.3920403, -0.3616149,  0.2255647, -0.4620442,  0.0012448 },
+    {  1.1326077, -1.2367284, -0.4118494,  0.2877813, -0.8230357,  0.0558651 },
+    {  1.0601591, -1.5999137, -0.3589221,  0.2642124, -1.1272340,  0.1310694 },
+    {  0.6777470, -0.3272588, -0.2504286,  0.1561313, -1.3765031,  0.2506212 } };
+
+/* 对照：双精度逐个时刻、逐个朝向计算 */
+static double reference(int model, double ghi, double dhi, double albedo,
+                        double zen, double azim, double am, double etrn,
+                        double tilt, double aspect)
+{
+    static const double edge[7] = { 1.065, 1.23, 1.5, 1.95, 2.8, 4.5, 6.2 };
+    double cz = cos(zen * RAD), ci, a, b, dni, sky, ai, z, eps, delta, f1, f2;
+    int    k;
+
+    ghi = fmax(ghi, 0.0);
+    dhi = fmax(dhi, 0.0);
+    if (cz <= 0.0)
+        return dhi * (1.0 + cos(tilt * RAD)) / 2.0 +
+               ghi * albedo * (1.0 - cos(tilt * RAD)) / 2.0;
+
+    dni = fmin(fmax(ghi - dhi, 0.0) / fmax(cz, cos(89.0 * RAD)), etrn);
+    ci  = cz * cos(tilt * RAD) +
+          sin(zen * RAD) * sin(tilt * RAD) * cos((azim - aspect) * RAD);
+    a   = fmax(ci, 0.0);
+    b   = fmax(cz, cos(85.0 * RAD));
+    sky = dhi * (1.0 + cos(tilt * RAD)) / 2.0;
+    if (model == P_HAYDAVIES && dhi > 0.0)
+    {
+        ai  = fmin(dni / etrn, 1.0);
+        sky = dhi * ((1.0 - ai) * (1.0 + cos(tilt * RAD)) / 2.0 + ai * a / b);
+    }
+    else if (model == P_PEREZ && dhi > 0.0)
+    {
+        z     = acos(cz);
+        eps   = ((dhi + dni) / dhi + 1.041 * z * z * z) /
+                (1.0 + 1.041 * z * z * z);
+        delta = dhi * am / etrn;
+        for (k = 0; k < 7 && eps >= edge[k]; k++)
+            ;
+        f1  = fmax(F[k][0] + F[k][1] * delta + F[k][2] * z, 0.0);
+        f2  = F[k][3] + F[k][4] * delta + F[k][5] * z;
+        sky = dhi * ((1.0 - f1) * (1.0 + cos(tilt * RAD)) / 2.0 +
+                     f1 * a / b + f2 * sin(tilt * RAD));
+    }
+    return dni * a + sky + ghi * albedo * (1.0 - cos(tilt * RAD)) / 2.0;
+}
+
+int main(int argc, char *argv[])
+{
+    struct posdata       site;
+    struct solclear_site cs;
+    struct solbatch      batch;
+    struct solpoa        poa;
+    float      tilt[NP], aspect[NP], nx[NP], ny[NP], nz[NP];
+    float     *buf, *ghi, *dhi, *cdni, *out, *own;
+    long long *utc, t0;
+    long       rows, r;
+    double     sec, rsec, d, dh, dref, down, year[NP], kc, ref;
+    int        days = 365, m, p, best, south, bad = 0;
+
+    if (argc > 1) days = atoi(argv[1]);
+    if (days < 1) days = 1;
+
+    rows = 24L * days;
+    utc  = (long long *) malloc(rows * sizeof(*utc));
+    buf  = (float *) malloc(11 * rows * sizeof(float));
+    out  = (float *) malloc(rows * NP * sizeof(float));
+    if (!utc || !buf || !out)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+
+    S_init(&site);
+    site.latitude  = 38.9;                /* 大连 */
+    site.longitude = 121.6;
+    site.timezone  = 8.0;
+    site.interval  = 3600;                /* 时段中点 */
+    site.tilt      = 30.0;
+    site.aspect    = 180.0;
+    S_clear_site(&cs, &site);
+
+    for (r = 0; r < rows; r++)
+        utc[r] = START + (r + 1) * 3600LL;
+    memset(&batch, 0, sizeof(batch));
+    batch.count = rows;
+    batch.utc   = utc;
+    batch.sites = &site;
+    batch.col[C_COSZEN]  = buf;
+    batch.col[C_AMASS]   = buf + rows;
+    batch.col[C_AMPRESS] = buf + 2 * rows;
+    batch.col[C_ETRN]    = buf + 3 * rows;
+    batch.col[C_ZENREF]  = buf + 4 * rows;
+    batch.col[C_AZIM]    = buf + 5 * rows;
+    batch.col[C_COSINC]  = buf + 6 * rows;
+    ghi  = buf + 7 * rows;
+    dhi  = buf + 8 * rows;
+    cdni = buf + 9 * rows;
+    own  = buf + 10 * rows;
+    S_batch(&batch, 0, rows);
+
+    /* “实测”值：晴空值乘以云量系数 kc，直射部分再乘一次 kc，
+       即云多时散射比例变大 */
+    S_clear(K_INEICHEN, &batch, &cs, NULL, 0, rows, ghi, cdni, dhi);
+    for (r = 0; r < rows; r++)
+    {
+        kc     = 0.25 + 0.75 * fabs(sin(r * 0.37) * cos(r * 0.011));
+        ghi[r] = ghi[r] * kc;
+        dhi[r] = ghi[r] - kc * kc * cdni[r] * batch.col[C_COSZEN][r];
+    }
+
+    for (p = 0; p < NP; p++)
+    {
+        tilt[p]   = 5.0 * (p / NASP);
+        aspect[p] = 90.0 + 10.0 * (p % NASP);
+    }
+    S_tilt_normals(NP, tilt, aspect, nx, ny, nz);
+    south = 6 * NASP + 9;                 /* 倾角 30，朝向 180 */
+
+    memset(out, 0, rows * NP * sizeof(float));
+    memset(&poa, 0, sizeof(poa));
+    poa.ghi    = ghi;
+    poa.dhi    = dhi;
+    poa.albedo = 0.2;
+    poa.nx     = nx;
+    poa.ny     = ny;
+    poa.nz     = nz;
+
+    printf("大连 %ld 时 x %d 个朝向\n\n", rows, NP);
+    printf("模型        时刻x朝向/秒   对照/秒   水平面-GHI   对照偏差    "
+           "自带cosinc   最佳朝向 kWh/m2   30度朝南\n");
+    for (m = 0; m < P_NMODEL; m++)
+    {
+        poa.model  = m;
+        poa.npanel = NP;
+        t0  = S_rt_now();
+        if (S_poa(&poa, &batch, 0, rows, out, NULL) != rows)
+        {
+            printf("S_poa 出错\n");
+            return 1;
+        }
+        sec = (S_rt_now() - t0) * 1.0e-9;
+
+        dh = dref = 0.0;
+        t0 = S_rt_now();
+        for (r = 0; r < rows; r++)
+        {
+            if (batch.col[C_COSZEN][r] > cos(85.0 * RAD) && ghi[r] > 100.0f)
+            {
+                d = fabs(out[r * NP] - ghi[r]) / ghi[r];
+                if (d > dh) dh = d;
+            }
+            for (p = 0; p < NP; p++)
+            {
+                ref = reference(m, ghi[r], dhi[r], poa.albedo,
+                                batch.col[C_ZENREF][r], batch.col[C_AZIM][r],
+                                batch.col[C_AMASS][r], batch.col[C_ETRN][r],
+                                tilt[p], aspect[p]);
+                d = fabs(out[r * NP + p] - ref);
+                if (ref > 100.0 && d / ref > dref) dref = d / ref;
+            }
+        }
+        rsec = (S_rt_now() - t0) * 1.0e-9;
+
+        memset(year, 0, sizeof(year));
+        for (r = 0; r < rows; r++)
+            for (p = 0; p < NP; p++)
+                year[p] += out[r * NP + p] / 1000.0;
+        for (best = 0, p = 1; p < NP; p++)
+            if (year[p] > year[best]) best = p;
+
+        /* 批量计算自带的 cosinc，一行一个朝向 */
+        poa.npanel = 0;
+        S_poa(&poa, &batch, 0, rows, own, NULL);
+        down = 0.0;
+        for (r = 0; r < rows; r++)
+        {
+            d = fabs(own[r] - out[r * NP + south]);
+            if (out[r * NP + south] > 100.0f &&
+                d / out[r * NP + south] > down)
+                down = d / out[r * NP + south];
+        }
+
+        printf("%-10s %12.0f %10.0f   %8.2g   %8.2g   %8.2g     "
+               "%2.0f/%3.0f 度 %6.0f   %6.0f\n", S_poa_name(m),
+               (double) rows * NP / sec, (double) rows * NP / rsec, dh, dref,
+               down, tilt[best], aspect[best], year[best], year[south]);
+        if (dh > 3.5e-6 || dref > 3.5e-6 || down > 3.5e-6)
+            bad++;
+    }
+
+    free(utc);
+    free(buf);
+    free(out);
+    printf("\n超限 %d 次\n", bad);
+    return bad != 0;
+}
@@ -0,0 +1,223 @@
+/*============================================================================
+*
+*    名称：pptest00.c
+*
+*    目的：测试 'solpipe.c'（CSV 流水线命令行工具）。
+*
+*        写一个输入文件：表头（跳过）、NROW 行数据（各地各时刻，每三行
+*        带上气压、温度、倾角、方位角），另外夹进：
+*            一行数据后面补 400 个空格（超过旧的 256 字节行缓冲）
+*            一个空行、一行注释                        -> 跳过
+*            一行只有三个数                            -> 拒收
+*            一行 5 MB（超过读入块）的数字串          -> 拒收
+*
+*        一、运行 solpipe，检查退出码为 0、行数、stderr 中报告的跳过
+*        和拒收行数；输出的每一行与直接调用 S_solpos 的结果比较（输出
+*        文本的小数位数之内）。
+*        二、输入是目录时 read() 出错，solpipe 应报告并以 1 退出。
+*        输出到 /dev/full 时 write() 出错，也应以 1 退出，且流水线
+*        随即停下：报告写出 0 行，读入的块远少于全部输入的块数。
+*        三、速度：solpipe 每秒多少行，与单线程逐行 S_solpos 比较。
+*
+*        检查不过时返回 1。
+*
+*    用法：
+*         pptest [solpipe 路径]        默认 ./solpipe
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+
+#include "solpos00.h"
+#include "solrt.h"
+
+#define NROW    200000L
+#define BIG     ( 5L << 20 )
+
+static const char *in  = "/tmp/pptest-in.csv";
+static const char *out = "/tmp/pptest-out.csv";
+static const char *err = "/tmp/pptest-err.txt";
+
+/* 第 i 行的输入，与写进文件的相同 */
+static void row(long i, struct posdata *pd)
+{
+    S_init(pd);
+    pd->function &= ~S_DOY;
+    pd->year      = 2023;
+    pd->month     = 1 + i % 12;
+    pd->day       = 1 + (i * 7) % 28;
+    pd->hour      = i % 24;
+    pd->minute    = (i * 13) % 60;
+    pd->second    = (i * 31) % 60;
+    pd->latitude  = -60.0 + (i * 37) % 120 + 0.25;
+    pd->longitude = -179.5 + (i * 53) % 359;
+    pd->timezone  = floor(pd->longitude / 15.0 + 0.5);
+    if (i % 3 == 0)
+    {
+        pd->press  = 900.0 + i % 100;
+        pd->temp   = -10.0 + i % 40;
+        pd->tilt   = i % 90;
+        pd->aspect = (i * 11) % 360;
+    }
+}
+
+/* 运行命令，返回退出码 */
+static int run(const char *cmd)
+{
+    int st = system(cmd);
+
+    return WIFEXITED(st) ? WEXITSTATUS(st) : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    const char    *pipe = argc > 1 ? argv[1] : "./solpipe";
+    struct posdata pd;
+    FILE  *f;
+    char   cmd[512], line[512];
+    double v[6], tol[6] = { 1.5e-4, 1.5e-4, 1.5e-4, 1.5e-6, 0.015, 0.015 };
+    double dmax[6] = { 0 }, d, sec, direct;
+    long   i, n, rows = -1, skipped = -1, rejected = -1, retval, nread;
+    long long t0;
+    int    yr, mo, dy, hr, mi, se, k, rc, bad = 0;
+
+    /* 输入文件 */
+    if ((f = fopen(in, "w")) == NULL)
+    {
+        perror(in);
+        return 1;
+    }
+    fprintf(f, "year,month,day,hour,minute,second,latitude,longitude,"
+               "timezone,press,temp,tilt,aspect\n");
+    for (i = 0; i < NROW; i++)
+    {
+        row(i, &pd);
+        fprintf(f, "%d,%d,%d,%d,%d,%d,%.2f,%.2f,%.0f", pd.year, pd.month,
+                pd.day, pd.hour, pd.minute, pd.second, pd.latitude,
+                pd.longitude, pd.timezone);
+        if (i % 3 == 0)
+            fprintf(f, ",%.0f,%.0f,%.0f,%.0f", pd.press, pd.temp, pd.tilt,
+                    pd.aspect);
+        if (i == 1000)
+            fprintf(f, "%400s", "");
+        fprintf(f, "\n");
+        if (i == 2000)
+            fprintf(f, "\n# 注释\n2023,6,21\n");
+        if (i == 3000)
+        {
+            for (n = 0; n < BIG; n++)
+                fputc('0' + n % 10, f);
+            fputc('\n', f);
+        }
+    }
+    fclose(f);
+
+    /* 一 */
+    snprintf(cmd, sizeof(cmd), "%s -i %s -o %s -t 2 -b 1000 2>%s", pipe, in,
+             out, err);
+    t0  = S_rt_now();
+    rc  = run(cmd);
+    sec = (S_rt_now() - t0) * 1.0e-9;
+    if ((f = fopen(err, "r")) != NULL)
+    {
+        while (fgets(line, sizeof(line), f))
+            if (sscanf(line, "solpipe: %ld rows, %ld lines skipped, %ld "
+                       "rejected", &rows, &skipped, &rejected) == 3)
+                break;
+        fclose(f);
+    }
+    printf("solpipe 退出码 %d：%ld 行，跳过 %ld 行，拒收 %ld 行（应为 %ld、"
+           "3、2）\n", rc, rows, skipped, rejected, NROW);
+    if (rc != 0 || rows != NROW || skipped != 3 || rejected != 2)
+        bad++;
+
+    if ((f = fopen(out, "r")) == NULL)
+    {
+        perror(out);
+        return 1;
+    }
+    n = 0;
+    fgets(line, sizeof(line), f);                   /* 表头 */
+    while (fgets(line, sizeof(line), f))
+    {
+        if (sscanf(line, "%d,%d,%d,%d,%d,%d,%ld,%lf,%lf,%lf,%lf,%lf,%lf",
+                   &yr, &mo, &dy, &hr, &mi, &se, &retval, &v[0], &v[1],
+                   &v[2], &v[3], &v[4], &v[5]) != 13 || n >= NROW)
+        {
+            bad++;
+            break;
+        }
+        row(n, &pd);
+        if (S_solpos(&pd) != retval || pd.month != mo || pd.day != dy ||
+            pd.hour != hr || pd.minute != mi || pd.second != se)
+        {
+            printf("第 %ld 行不符：%s", n, line);
+            bad++;
+        }
+        else if (retval == 0)
+            for (k = 0; k < 6; k++)
+            {
+                d = fabs(v[k] - (k == 0 ? pd.azim : k == 1 ? pd.elevref :
+                                 k == 2 ? pd.zenref : k == 3 ? pd.cosinc :
+                                 k == 4 ? pd.etrn : pd.etrtilt));
+                if (d > dmax[k]) dmax[k] = d;
+                if (d > tol[k])
+                    bad++;
+            }
+        n++;
+    }
+    fclose(f);
+    printf("输出 %ld 行；与 S_solpos 的最大偏差：azim %.2g，elevref %.2g，"
+           "zenref %.2g，cosinc %.2g，etrn %.2g，etrtilt %.2g\n", n,
+           dmax[0], dmax[1], dmax[2], dmax[3], dmax[4], dmax[5]);
+    if (n != NROW)
+        bad++;
+
+    /* 二 */
+    snprintf(cmd, sizeof(cmd), "%s -i /tmp -o %s 2>%s", pipe, out, err);
+    rc = run(cmd);
+    printf("输入为目录：退出码 %d（应为 1）\n", rc);
+    if (rc != 1)
+        bad++;
+
+    snprintf(cmd, sizeof(cmd), "%s -i %s -o /dev/full -b 100 -q 1 2>%s", pipe,
+             in, err);
+    rc    = run(cmd);
+    rows  = -1;
+    nread = -1;
+    if ((f = fopen(err, "r")) != NULL)
+    {
+        while (fgets(line, sizeof(line), f))
+        {
+            sscanf(line, "solpipe: %ld rows", &rows);
+            sscanf(line, "  reader %ld", &nread);
+        }
+        fclose(f);
+    }
+    printf("输出到 /dev/full：退出码 %d（应为 1），写出 %ld 行，读入 %ld 块"
+           "（全部 %ld 块）\n", rc, rows, nread, NROW / 100);
+    if (rc != 1 || rows != 0 || nread < 0 || nread > NROW / 100 / 10)
+        bad++;
+
+    /* 三 */
+    t0 = S_rt_now();
+    for (i = 0; i < NROW; i++)
+    {
+        row(i, &pd);
+        S_solpos(&pd);
+    }
+    direct = (S_rt_now() - t0) * 1.0e-9;
+    printf("\nsolpipe（2 个计算线程，含读写文件和 5 MB 的长行）%.0f 行/秒；"
+           "单线程逐行 S_solpos %.0f 行/秒\n", NROW / sec, NROW / direct);
+
+    remove(in);
+    remove(out);
+    remove(err);
+    printf("\n超限 %d 次\n", bad);
+    return bad != 0;
+}
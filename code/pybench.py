@@ -0,0 +1,73 @@
+"""Per-element cost of solpos.compute() against a per-call Python loop.
+
+    python3 pybench.py [rows [threads]]     default 525600 rows (one year
+                                            of minutes), one per CPU
+
+Prints the cost per row of position() called in a loop (on a sample, the
+way per-timestamp Python code does it) and of one compute() over all
+rows; checks that both give the same numbers; and counts how far a
+plain Python thread gets while compute() runs, which is only possible
+because the GIL is released during the call.  Uses NumPy arrays if NumPy
+is installed, else array.array; neither is copied.
+"""
+
+import array
+import sys
+import threading
+import time
+
+import solpos
+
+rows = int(sys.argv[1]) if len(sys.argv) > 1 else 525600
+threads = int(sys.argv[2]) if len(sys.argv) > 2 else 0
+site = {"latitude": 39.74, "longitude": -105.18, "timezone": -7.0,
+        "tilt": 40.0, "aspect": 180.0}
+
+try:
+    import numpy
+    utc = numpy.arange(rows, dtype=numpy.int64) * 60 + 1672531200
+    temp = (numpy.arange(rows) % 400 / 10.0 - 10.0).astype(numpy.float32)
+    kind = "NumPy"
+except ImportError:
+    utc = array.array("q", range(1672531200, 1672531200 + rows * 60, 60))
+    temp = array.array("f", (i % 400 / 10.0 - 10.0 for i in range(rows)))
+    kind = "array.array"
+
+# per call, on a sample
+sample = min(rows, 20000)
+t0 = time.perf_counter()
+one = [solpos.position(utc[i], site["latitude"], site["longitude"],
+                       site["timezone"], tilt=40.0, aspect=180.0)
+       for i in range(sample)]
+t_call = (time.perf_counter() - t0) / sample
+
+# one batch call
+t0 = time.perf_counter()
+ret, col = solpos.compute(utc, site, columns=("azim", "zenref"),
+                          threads=threads)
+t_batch = (time.perf_counter() - t0) / rows
+
+diff = sum(1 for i in range(sample)
+           if (col["azim"][i], col["zenref"][i], ret[i]) != one[i])
+
+# per-row temperature drives the refraction correction
+ret2, col2 = solpos.compute(utc, site, columns=("zenref",), temp=temp,
+                            threads=threads)
+dz = max(abs(col2["zenref"][i] - col["zenref"][i]) for i in range(rows))
+
+# does Python run while the batch does?
+ticks = 0
+busy = threading.Thread(target=solpos.compute, args=(utc, site),
+                        kwargs={"threads": threads})
+busy.start()
+while busy.is_alive():
+    ticks += 1
+busy.join()
+
+print("%d rows (%s)" % (rows, kind))
+print("position() per call  %10.0f ns/row" % (t_call * 1e9))
+print("compute() batch      %10.0f ns/row   %.0fx faster"
+      % (t_batch * 1e9, t_call / t_batch))
+print("rows differing between the two: %d of %d" % (diff, sample))
+print("largest zenref change from per-row temp: %.4f deg" % dz)
+print("Python loop iterations during a compute(): %d" % ticks)
@@ -0,0 +1,52 @@
+"""position() called from several threads at once against one thread.
+
+    python3 pythread.py [calls [threads]]   default 20000 calls on each
+                                            of 8 threads
+
+Each thread walks its own sites and times through position() while the
+others do the same, and every result is compared with that of the same
+call made beforehand on one thread.  Since S_py_batch runs with the GIL
+released, a position() whose scratch arrays were shared between threads
+would mix up inputs and results here.  Exits with status 1 on any
+mismatch.
+"""
+
+import sys
+import threading
+
+import solpos
+
+calls = int(sys.argv[1]) if len(sys.argv) > 1 else 20000
+nthread = int(sys.argv[2]) if len(sys.argv) > 2 else 8
+columns = ("azim", "zenref", "etrtilt")
+
+
+def args(t, i):
+    """Inputs of call i on thread t: a different site for every thread."""
+    return (1672531200 + i * 3607 + t * 61, -60.0 + 15.0 * t + i % 7,
+            -170.0 + 40.0 * t, float(t - 4), 1013.0 - t, 15.0 + i % 20,
+            10.0 * t, 90.0 + 30.0 * t)
+
+
+want = [[solpos.position(*args(t, i), columns=columns) for i in range(calls)]
+        for t in range(nthread)]
+miss = [0] * nthread
+gate = threading.Barrier(nthread)
+
+
+def run(t):
+    gate.wait()                     # start together
+    for i in range(calls):
+        if solpos.position(*args(t, i), columns=columns) != want[t][i]:
+            miss[t] += 1
+
+
+threads = [threading.Thread(target=run, args=(t,)) for t in range(nthread)]
+for th in threads:
+    th.start()
+for th in threads:
+    th.join()
+
+print("%d threads x %d calls: %d results differ from one thread's"
+      % (nthread, calls, sum(miss)))
+sys.exit(1 if sum(miss) else 0)
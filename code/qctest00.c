@@ -0,0 +1,199 @@
+/*============================================================================
+*
+*    名称：qctest00.c
+*
+*    目的：测试 'solqc.c' 的辐射观测数据质量控制。
+*
+*        生成大连一年（或若干年）的逐分钟“观测”记录：GHI、DNI、DHI
+*        取 Ineichen 晴空值，DHI 按阴影带遮挡（除以逐分钟的 sbcf）记录；
+*        再在白天故意放进几类错误：缺测（NaN）、GHI 尖峰、DNI 负值、
+*        DNI 偏大（闭合检验不过）、DHI 大于 GHI；夜间则放进 0.5 W/平方米
+*        的小 DNI（表的零点漂移），这是正常的观测。
+*
+*        一、每次 1000 行分批送入 S_qc，打印各标志的行数和放进的错误
+*        个数（一个错误常同时触发几个标志，如 GHI 尖峰也过不了闭合
+*        检验）、Sa 和 sbcf 的逐日计算次数，以及订正后 DHI 与真值的最大
+*        相对偏差。逐个检查放进错误的行带有该类错误的标志、夜间小 DNI
+*        的行没有标志；漏标、误标或相对偏差超过 5e-4 时返回 1。
+*        二、打印每秒处理的行数、站点年数；与逐行调用 S_solpos
+*        （S_ALL）的旧做法比较。
+*
+*    用法：
+*         qctest [年数]        默认 1 年
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solpos00.h"
+#include "solclear.h"
+#include "solqc.h"
+#include "solrt.h"
+
+#define START  1672531200LL          /* 2023-01-01 00:00 UTC */
+#define CHUNK  1000L
+
+int main(int argc, char *argv[])
+{
+    struct posdata       site, pd;
+    struct solclear_site cs;
+    struct solbatch      batch;
+    struct solqc         qc;
+    long long *utc, t0;
+    float     *buf, *ghi, *dni, *dhi, *truth, *sbcf, *kt, *ktp;
+    unsigned  *flags;
+    long       rows, r, n, bad, injected[Q_NFLAG], *at, nat = 0, miss = 0;
+    long      *night, nnight = 0, wrong = 0;
+    int       *want;
+    double     sec, d, dmax = 0.0;
+    int        years = 1, f;
+
+    if (argc > 1) years = atoi(argv[1]);
+    if (years < 1) years = 1;
+
+    rows  = 525600L * years;
+    utc   = (long long *) malloc(rows * sizeof(*utc));
+    buf   = (float *) malloc(12 * rows * sizeof(float));
+    flags = (unsigned *) malloc(rows * sizeof(*flags));
+    at    = (long *) malloc((rows / 50021 + 1) * sizeof(*at));
+    want  = (int *) malloc((rows / 50021 + 1) * sizeof(*want));
+    night = (long *) malloc((rows / 50021 + 1) * sizeof(*night));
+    if (!utc || !buf || !flags || !at || !want || !night)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    ghi   = buf;
+    dni   = buf + rows;
+    dhi   = buf + 2 * rows;
+    truth = buf + 3 * rows;
+    sbcf  = buf + 4 * rows;
+    kt    = buf + 5 * rows;
+    ktp   = buf + 6 * rows;
+
+    S_init(&site);
+    site.latitude  = 38.9;                /* 大连 */
+    site.longitude = 121.6;
+    site.timezone  = 8.0;
+    site.interval  = 60;                  /* 每分钟的结束时刻 */
+    S_clear_site(&cs, &site);
+
+    /* 生成“观测”记录 */
+    for (r = 0; r < rows; r++)
+        utc[r] = START + (r + 1) * 60;
+    memset(&batch, 0, sizeof(batch));
+    batch.count = rows;
+    batch.utc   = utc;
+    batch.sites = &site;
+    batch.col[C_COSZEN]  = buf + 7 * rows;
+    batch.col[C_AMPRESS] = buf + 8 * rows;
+    batch.col[C_ETRN]    = buf + 9 * rows;
+    batch.col[C_SBCF]    = sbcf;
+    S_batch_parallel(&batch, 4);
+    S_clear(K_INEICHEN, &batch, &cs, NULL, 0, rows, ghi, dni, truth);
+    for (r = 0; r < rows; r++)
+        dhi[r] = truth[r] / sbcf[r];
+
+    memset(injected, 0, sizeof(injected));
+    for (r = 100000, f = 0; r < rows; r += 50021, f++)
+    {
+        while (r < rows && batch.col[C_COSZEN][r] < 0.3f)  /* 放在白天 */
+            r++;
+        if (r >= rows)
+            break;
+        switch (f % 5)
+        {
+        case 0: ghi[r] = NAN;                       injected[Q_MISSING]++; break;
+        case 1: ghi[r] = 2000.0f;                   injected[Q_GHI_PPL]++; break;
+        case 2: dni[r] = -10.0f;                    injected[Q_DNI_PPL]++; break;
+        case 3: dni[r] = dni[r] * 1.5f + 100.0f;    injected[Q_CLOSURE]++; break;
+        case 4: dhi[r] = (ghi[r] + 100.0f) / sbcf[r]; injected[Q_DIFFUSE]++; break;
+        }
+        at[nat]     = r;
+        want[nat++] = f % 5 == 0 ? Q_MISSING : f % 5 == 1 ? Q_GHI_PPL :
+                      f % 5 == 2 ? Q_DNI_PPL : f % 5 == 3 ? Q_CLOSURE :
+                      Q_DIFFUSE;
+    }
+    for (r = 125000; r < rows; r += 50021)
+    {
+        while (r < rows && batch.col[C_COSZEN][r] > -0.1f)  /* 放在夜间 */
+            r++;
+        if (r >= rows)
+            break;
+        dni[r] = 0.5f;
+        night[nnight++] = r;
+    }
+
+    /* 一、分批送入 */
+    if (S_qc_init(&qc, &site, 1) != 0)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    t0  = S_rt_now();
+    for (bad = 0, r = 0; r < rows; r += n)
+    {
+        n = rows - r < CHUNK ? rows - r : CHUNK;
+        bad += S_qc(&qc, n, utc + r, ghi + r, dni + r, dhi + r, flags + r,
+                    kt + r, ktp + r);
+    }
+    sec = (S_rt_now() - t0) * 1.0e-9;
+
+    printf("%ld 行，有标志（不计缺测）%ld 行，Sa 和 sbcf 计算 %ld 次\n\n",
+           qc.rows, bad, qc.days);
+    printf("标志        行数   放进的错误\n");
+    for (f = 0; f < Q_NFLAG; f++)
+        printf("%-10s %6ld   %6ld\n", S_qc_name(f), qc.count[f], injected[f]);
+    for (r = 0; r < rows; r++)
+        if (truth[r] > 10.0 && flags[r] == 0)
+        {
+            d = fabs(dhi[r] - truth[r]) / truth[r];
+            if (d > dmax) dmax = d;
+        }
+    for (n = 0; n < nat; n++)
+        if (!(flags[at[n]] & S_QC(want[n])))
+        {
+            printf("第 %ld 行放进的 %s 错误没有标出（标志 0x%x）\n", at[n],
+                   S_qc_name(want[n]), flags[at[n]]);
+            miss++;
+        }
+    for (n = 0; n < nnight; n++)
+        if (flags[night[n]] != 0)
+        {
+            printf("第 %ld 行夜间 DNI 0.5 被标出（标志 0x%x）\n", night[n],
+                   flags[night[n]]);
+            wrong++;
+        }
+    printf("\n放进错误 %ld 行，漏标 %ld 行\n", nat, miss);
+    printf("夜间小 DNI %ld 行，误标 %ld 行\n", nnight, wrong);
+    printf("按日订正的 DHI 与真值最大相对偏差 %.2g\n", dmax);
+    r = 171 * 1440 + 4 * 60;              /* 夏至日正午（UTC 4 时） */
+    printf("夏至日正午 kt %.3f，kt' %.3f\n", kt[r], ktp[r]);
+    S_qc_free(&qc);
+
+    /* 二、速度 */
+    printf("\nS_qc：%.3f 秒，%.0f 行/秒，%.1f 站点年/秒\n", sec, rows / sec,
+           rows / 525600.0 / sec);
+    n  = rows < 200000 ? rows : 200000;
+    t0 = S_rt_now();
+    for (r = 0; r < n; r++)
+    {
+        pd = site;
+        S_epoch(&pd, utc[r]);
+        S_solpos(&pd);
+    }
+    sec = (S_rt_now() - t0) * 1.0e-9;
+    printf("逐行 S_solpos（S_ALL）：%.0f 行/秒\n", n / sec);
+
+    free(utc);
+    free(buf);
+    free(flags);
+    free(at);
+    free(want);
+    free(night);
+    return miss != 0 || wrong != 0 || dmax > 5.0e-4;
+}
@@ -0,0 +1,162 @@
+/*============================================================================
+*
+*    名称：qtest00.c
+*
+*    目的：在本机用几个进程和一个临时目录模拟集群，测试 'solqueue.c'
+*          的检查点工作队列。
+*
+*        第一轮启动若干工作进程，片刻后强行杀死其中一个（模拟节点
+*        宕机），其余进程算完能领到的块后，会等待被杀进程的租约过期，
+*        再把它留下的块放回队列并算完。随后再启动一轮进程，确认已完成
+*        的块不会被重算。最后把所有块读回，与单进程直接计算的结果逐行
+*        比较。
+*
+*        有块未完成、结果不一致、工作进程出错或第二轮又算了块时返回 1。
+*
+*    用法：
+*         qtest [进程数 [站点数 [天数]]]      默认 3 个进程，24 站点，20 天
+*
+*----------------------------------------------------------------------------*/
+
+#define _DEFAULT_SOURCE
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "solpos00.h"
+#include "solqueue.h"
+#include "solrt.h"
+
+#define LEASE  2                                  /* 秒 */
+
+static char           dir[] = "/tmp/solq.XXXXXX";
+static struct solgrid grid;
+
+/* 启动 n 个工作进程，kill_one 非零时 0.2 秒后杀死第一个。返回未被
+   杀死的进程共算了多少块（退出码，最多记 254），有进程出错时返回 -1 */
+static long round_of(int n, int kill_one)
+{
+    pid_t pid[64];
+    long  done, total = 0;
+    int   k, status;
+
+    fflush(stdout);                              /* 子进程不重复输出 */
+    for (k = 0; k < n; k++)
+        if ((pid[k] = fork()) == 0)
+        {
+            done = S_queue_work(dir, &grid, LEASE);
+            printf("  进程 %ld 计算了 %ld 块\n", (long) getpid(), done);
+            fflush(stdout);
+            _exit(done < 0 ? 255 : done > 254 ? 254 : (int) done);
+        }
+
+    if (kill_one)
+    {
+        usleep(200000);
+        kill(pid[0], SIGKILL);
+        printf("  已杀死进程 %ld\n", (long) pid[0]);
+        fflush(stdout);
+    }
+    for (k = 0; k < n; k++)
+    {
+        if (waitpid(pid[k], &status, 0) != pid[k])
+            total = -1;
+        else if (kill_one && k == 0)
+            continue;
+        else if (!WIFEXITED(status) || WEXITSTATUS(status) == 255)
+            total = -1;
+        else if (total >= 0)
+            total += WEXITSTATUS(status);
+    }
+    return total;
+}
+
+int main(int argc, char *argv[])
+{
+    struct posdata *sites;
+    struct solbatch batch;
+    struct solfork_stats st;
+    float *want[C_NCOL], *got[C_NCOL], *buf;
+    long  *rv_want, *rv_got, rows, r, diff = 0, missing, first, again;
+    long long t0;
+    char   cmd[64];
+    int    workers = 3, nsite = 24, days = 20, k;
+
+    if (argc > 1) workers = atoi(argv[1]);
+    if (argc > 2) nsite   = atoi(argv[2]);
+    if (argc > 3) days    = atoi(argv[3]);
+    if (workers < 2)  workers = 2;
+    if (workers > 64) workers = 64;
+
+    sites = (struct posdata *) malloc(nsite * sizeof(*sites));
+    for (k = 0; k < nsite; k++)
+    {
+        S_init(&sites[k]);
+        sites[k].latitude  = -55.0 + 110.0 * k / nsite;
+        sites[k].longitude = -175.0 + 350.0 * k / nsite;
+        sites[k].timezone  = (float) (int) (sites[k].longitude / 15.0);
+        sites[k].tilt      = sites[k].latitude;
+        sites[k].aspect    = 180.0;
+    }
+
+    grid.sites = sites;
+    grid.nsite = nsite;
+    grid.start = 1672531200LL;
+    grid.step  = 60;
+    grid.ntime = 1440L * days;
+    grid.cols  = S_COL(C_AZIM) | S_COL(C_ZENREF) | S_COL(C_ETRTILT);
+    rows = (long) nsite * grid.ntime;
+
+    if (mkdtemp(dir) == NULL ||
+        S_queue_plan(dir, &grid, 1440L * 2) != 0)          /* 每块两天 */
+    {
+        printf("无法建立队列目录\n");
+        return 1;
+    }
+    printf("队列 %s：%ld 行，%ld 块\n", dir, rows, (rows + 2879) / 2880);
+
+    t0 = S_rt_now();
+    printf("第一轮（%d 个进程，其中一个被杀死）\n", workers);
+    first = round_of(workers, 1);
+    printf("第二轮（已全部完成，不应再计算）\n");
+    again = round_of(2, 0);
+    printf("用时 %.2f 秒（含等待租约过期）\n", (S_rt_now() - t0) * 1.0e-9);
+
+    /* 读回并与直接计算比较 */
+    buf     = (float *) malloc(6 * rows * sizeof(float));
+    rv_want = (long *) malloc(rows * sizeof(long));
+    rv_got  = (long *) malloc(rows * sizeof(long));
+    if (!sites || !buf || !rv_want || !rv_got)
+        return 1;
+    memset(&batch, 0, sizeof(batch));
+    memset(&st, 0, sizeof(st));
+    for (k = 0; k < C_NCOL; k++)
+        want[k] = got[k] = NULL;
+    want[C_AZIM] = buf;            got[C_AZIM]    = buf + 3 * rows;
+    want[C_ZENREF] = buf + rows;   got[C_ZENREF]  = buf + 4 * rows;
+    want[C_ETRTILT] = buf + 2 * rows; got[C_ETRTILT] = buf + 5 * rows;
+    S_grid_run(&grid, 0, rows, want, rv_want, &st);
+
+    missing = S_queue_gather(dir, &grid, got, rv_got);
+    for (r = 0; r < rows; r++)
+        if (rv_got[r] != rv_want[r] ||
+            got[C_AZIM][r] != want[C_AZIM][r] ||
+            got[C_ZENREF][r] != want[C_ZENREF][r] ||
+            got[C_ETRTILT][r] != want[C_ETRTILT][r])
+            diff++;
+    printf("未完成的块 %ld，与直接计算不一致的行 %ld\n", missing, diff);
+    printf("工作进程%s出错，第二轮重算 %ld 块\n", first < 0 || again < 0 ?
+           "有" : "没有", again);
+
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    if (system(cmd) != 0)
+        printf("请手动删除 %s\n", dir);
+    free(sites);
+    free(buf);
+    free(rv_want);
+    free(rv_got);
+    return missing != 0 || diff != 0 || first < 0 || again != 0;
+}
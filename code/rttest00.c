@@ -0,0 +1,134 @@
+/*============================================================================
+*
+*    名称：rttest00.c
+*
+*    目的：测试 'solrt.c' 中的实时跟踪数据流，并给出延迟分布。
+*
+*        生产者线程以固定频率（或尽可能快地）推入 UTC 时间戳，
+*        工作线程调用 S_rt_step 计算太阳位置，主线程用 S_rt_pop 取出结果。
+*        结束后打印服务延迟（出队到结果）和总延迟（入队到结果）的
+*        p50 / p99 / p99.9 / p99.99 / 最大值（纳秒）。
+*
+*    用法：
+*         rttest [次数 [频率Hz]]      默认 1000000 次，频率 0 = 不限速
+*
+*    有结果出错时返回 1。
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "solpos00.h"
+#include "solrt.h"
+
+static struct solrt  feed;
+static long          count = 1000000;
+static double        rate  = 0.0;
+static atomic_int    done;
+
+/* 生产者：从 2023-06-21 00:00 UTC 起每次前进一秒 */
+static void *producer(void *arg)
+{
+    long long start = 1687305600LL;
+    long long next  = S_rt_now();
+    long long period = rate > 0.0 ? (long long) (1.0e9 / rate) : 0;
+    long      i;
+
+    (void) arg;
+    for (i = 0; i < count; i++)
+    {
+        if (period > 0)
+        {
+            next += period;
+            while (S_rt_now() < next)
+                ;
+        }
+        while (S_rt_push(&feed, start + i) != 0)
+            sched_yield();                       /* 输入队列已满 */
+    }
+    return NULL;
+}
+
+/* 工作线程：计算所有已入队的时间戳 */
+static void *worker(void *arg)
+{
+    (void) arg;
+    while (!atomic_load(&done))
+        if (S_rt_step(&feed) == 0)
+            sched_yield();
+    return NULL;
+}
+
+static void report(const char *name, const struct solrt_hist *h)
+{
+    printf("%-8s p50 %8lld  p99 %8lld  p99.9 %8lld  p99.99 %8lld  最大 %8lld ns\n",
+           name,
+           S_rt_hist_quantile(h, 0.50),
+           S_rt_hist_quantile(h, 0.99),
+           S_rt_hist_quantile(h, 0.999),
+           S_rt_hist_quantile(h, 0.9999),
+           h->max);
+}
+
+int main(int argc, char *argv[])
+{
+    struct posdata   pd, *pdat;
+    struct solrt_pos pos;
+    pthread_t        tp, tw;
+    long             got = 0, bad = 0;
+    int              retval;
+
+    if (argc > 1)
+        count = atol(argv[1]);
+    if (argc > 2)
+        rate = atof(argv[2]);
+
+    pdat = &pd;
+    S_init(pdat);
+    pdat->latitude  = 38.9;       /* 大连 */
+    pdat->longitude = 121.6;
+    pdat->timezone  = 8.0;
+    pdat->function  = (S_SOLAZM | S_REFRAC);   /* 跟踪只需要指向角 */
+
+    if ((retval = S_rt_init(&feed, pdat, 4096)) != 0)
+    {
+        fprintf(stderr, "S_rt_init 失败：%d\n", retval);
+        return 1;
+    }
+
+    atomic_init(&done, 0);
+    pthread_create(&tw, NULL, worker, NULL);
+    pthread_create(&tp, NULL, producer, NULL);
+
+    while (got < count)
+    {
+        if (S_rt_pop(&feed, &pos))
+        {
+            if (pos.retval != 0)
+                bad++;
+            got++;
+        }
+        else
+            sched_yield();
+    }
+
+    pthread_join(tp, NULL);
+    atomic_store(&done, 1);
+    pthread_join(tw, NULL);
+
+    printf("\n***** 测试实时数据流 solrt: *****\n\n");
+    printf("结果 %ld 个，错误 %ld 个，频率 %s\n", got, bad,
+           rate > 0.0 ? argv[2] : "不限速");
+    report("服务", &feed.service);
+    report("总计", &feed.total);
+    printf("最后一个：方位角 azim %f，太阳高度角 elevref %f\n",
+           pos.azim, pos.elevref);
+
+    S_rt_free(&feed);
+    return bad != 0;
+}
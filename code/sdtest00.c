@@ -0,0 +1,252 @@
+/*============================================================================
+*
+*    名称：sdtest00.c
+*
+*    目的：测试 'solposd.c'（本机太阳位置守护进程）的客户端往返。
+*
+*        启动 solposd（临时套接字，2 个线程），8 个客户端线程各开一个
+*        连接，每次连发 50 个请求再收 50 个回应，共 4000 个；时刻和
+*        站点（纬度、经度、时区、气压、气温、倾角、方位）逐个变化，
+*        每 97 个里有一个纬度 95 度的坏请求。
+*
+*        一、每个回应的标签应与请求次序相符，返回码和全部 C_NCOL 列
+*        应与直接调用 S_solpos（S_init 的缺省值加请求里的输入，
+*        S_epoch 设时刻）的结果逐位相同；坏请求只比较返回码。
+*        二、发 SIGTERM 后守护进程应以 0 退出；它打印的请求数应为
+*        全部请求数，批数应少于请求数（请求确被合并）。
+*
+*        检查不过时返回 1。
+*
+*    用法：
+*         sdtest [solposd 路径]        默认 ./solposd
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "solpos00.h"
+#include "soldaemon.h"
+
+#define NCLIENT  8
+#define NREQ     4000
+#define DEPTH    50
+
+static const char *sock = "/tmp/sdtest.sock";
+static const char *logpath = "/tmp/sdtest.log";
+
+struct client
+{
+    pthread_t tid;
+    int       id;
+    long      got;        /* 收到的回应 */
+    long      miss;       /* 标签、返回码或列不符的回应 */
+};
+
+/* 第 id 个客户端的第 i 个请求 */
+static void request(int id, long i, struct sold_req *req)
+{
+    long k = id * NREQ + i;
+
+    memset(req, 0, sizeof(*req));
+    req->tag       = (unsigned long long) k;
+    req->utc       = 1672531200LL + k * 7919;
+    req->function  = S_ALL;
+    req->latitude  = k % 97 == 0 ? 95.0f : -60.0f + k % 121;
+    req->longitude = -180.0f + (k * 37) % 360;
+    req->timezone  = (float) ((k % 25) - 12);
+    req->press     = 800.0f + k % 250;
+    req->temp      = -20.0f + k % 60;
+    req->tilt      = (float) (k % 91);
+    req->aspect    = (float) ((k * 13) % 360);
+}
+
+/* posdata 里与输出列 c 对应的字段 */
+static float column(const struct posdata *pd, int c)
+{
+    switch (c)
+    {
+        case C_AMASS:   return pd->amass;
+        case C_AMPRESS: return pd->ampress;
+        case C_AZIM:    return pd->azim;
+        case C_COSINC:  return pd->cosinc;
+        case C_COSZEN:  return pd->coszen;
+        case C_ELEVREF: return pd->elevref;
+        case C_ETR:     return pd->etr;
+        case C_ETRN:    return pd->etrn;
+        case C_ETRTILT: return pd->etrtilt;
+        case C_PRIME:   return pd->prime;
+        case C_SBCF:    return pd->sbcf;
+        case C_SRETR:   return pd->sretr;
+        case C_SSETR:   return pd->ssetr;
+        case C_UNPRIME: return pd->unprime;
+        default:        return pd->zenref;
+    }
+}
+
+/* 读或写满 len 字节；出错返回 -1 */
+static int full_io(int fd, void *buf, size_t len, int writing)
+{
+    char   *p = (char *) buf;
+    ssize_t n;
+
+    while (len > 0)
+    {
+        n = writing ? write(fd, p, len) : read(fd, p, len);
+        if (n <= 0)
+            return -1;
+        p   += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int connect_to(void)
+{
+    struct sockaddr_un addr;
+    struct timespec    nap = { 0, 50000000L };
+    int fd, k;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sock, sizeof(addr.sun_path) - 1);
+    for (k = 0; k < 100; k++)               /* 守护进程可能还没绑定 */
+    {
+        if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+            return -1;
+        if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0)
+            return fd;
+        close(fd);
+        nanosleep(&nap, NULL);
+    }
+    return -1;
+}
+
+static void *client_thread(void *arg)
+{
+    struct client  *cl = (struct client *) arg;
+    struct sold_req req[DEPTH];
+    struct sold_rsp rsp[DEPTH];
+    struct posdata  pd;
+    long   i, j;
+    int    fd, c, n;
+
+    if ((fd = connect_to()) < 0)
+        return NULL;
+    for (i = 0; i < NREQ; i += n)
+    {
+        n = NREQ - i < DEPTH ? (int) (NREQ - i) : DEPTH;
+        for (j = 0; j < n; j++)
+            request(cl->id, i + j, &req[j]);
+        if (full_io(fd, req, n * sizeof(req[0]), 1) != 0 ||
+            full_io(fd, rsp, n * sizeof(rsp[0]), 0) != 0)
+            break;
+        for (j = 0; j < n; j++)
+        {
+            S_init(&pd);
+            pd.function  = req[j].function;
+            pd.latitude  = req[j].latitude;
+            pd.longitude = req[j].longitude;
+            pd.timezone  = req[j].timezone;
+            pd.press     = req[j].press;
+            pd.temp      = req[j].temp;
+            pd.tilt      = req[j].tilt;
+            pd.aspect    = req[j].aspect;
+            S_epoch(&pd, req[j].utc);
+            cl->got++;
+            if (rsp[j].tag != req[j].tag || rsp[j].retval != S_solpos(&pd))
+            {
+                cl->miss++;
+                continue;
+            }
+            if (rsp[j].retval != 0)
+                continue;
+            for (c = 0; c < C_NCOL; c++)
+            {
+                float v = column(&pd, c);
+
+                if (memcmp(&rsp[j].col[c], &v, sizeof(float)) != 0)
+                {
+                    cl->miss++;
+                    break;
+                }
+            }
+        }
+    }
+    close(fd);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    const char   *server = argc > 1 ? argv[1] : "./solposd";
+    struct client cl[NCLIENT];
+    FILE *f;
+    char  line[256];
+    pid_t pid;
+    long  got = 0, miss = 0, nreq = -1, nbatch = -1;
+    int   k, st, fail = 0;
+
+    remove(logpath);
+    if ((pid = fork()) < 0)
+    {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0)
+    {
+        if (freopen(logpath, "w", stderr) == NULL)
+            _exit(127);
+        execl(server, server, "-s", sock, "-t", "2", (char *) NULL);
+        _exit(127);
+    }
+
+    /* 一 */
+    for (k = 0; k < NCLIENT; k++)
+    {
+        memset(&cl[k], 0, sizeof(cl[k]));
+        cl[k].id = k;
+        pthread_create(&cl[k].tid, NULL, client_thread, &cl[k]);
+    }
+    for (k = 0; k < NCLIENT; k++)
+    {
+        pthread_join(cl[k].tid, NULL);
+        got  += cl[k].got;
+        miss += cl[k].miss;
+    }
+    printf("%d 个客户端，各 %d 个请求：收到回应 %ld 个，与 S_solpos 不符 "
+           "%ld 个\n", NCLIENT, NREQ, got, miss);
+    if (got != (long) NCLIENT * NREQ || miss != 0)
+        fail++;
+
+    /* 二 */
+    kill(pid, SIGTERM);
+    if (waitpid(pid, &st, 0) != pid)
+        st = -1;
+    if ((f = fopen(logpath, "r")) != NULL)
+    {
+        while (fgets(line, sizeof(line), f))
+            if (sscanf(line, "solposd: %ld requests in %ld batches", &nreq,
+                       &nbatch) == 2)
+                break;
+        fclose(f);
+    }
+    printf("solposd 退出码 %d；请求 %ld 个，批 %ld 个\n",
+           WIFEXITED(st) ? WEXITSTATUS(st) : -1, nreq, nbatch);
+    if (!WIFEXITED(st) || WEXITSTATUS(st) != 0 ||
+        nreq != (long) NCLIENT * NREQ || nbatch < 1 || nbatch >= nreq)
+        fail++;
+
+    remove(logpath);
+    printf("\n检查不过 %d 处\n", fail);
+    return fail != 0;
+}
@@ -0,0 +1,556 @@
+/*============================================================================
+*    Contains:
+*        S_agg_init   (sets up the accumulators of an aggregation)
+*        S_agg_add    (folds rows of a computed batch in)
+*        S_agg_merge  (adds one aggregation into another)
+*        S_agg_grid   (computes a grid and folds it, on several threads)
+*        S_agg_value  (the result of an operator for a site and period)
+*        S_agg_label  (the local date a period starts on)
+*        S_agg_free   (releases the accumulators)
+*
+*    Periods are numbered from 1970: local days since 1 January 1970, or
+*    months as year * 12 + month - 1.  An aggregation holds the periods
+*    from the earliest local period of start to the latest of end - 1
+*    over its sites' timezones.
+*
+*    S_agg_grid gives each thread a contiguous range of grid rows and its
+*    own aggregation; the thread computes its rows a block at a time into
+*    a small scratch batch and folds each block in.  The partial
+*    aggregations are then merged, which gives the same bits as folding
+*    everything in one thread.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solagg.h"
+*
+*----------------------------------------------------------------------------*/
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "solagg.h"
+
+#define BLOCK   4096              /* rows per scratch batch */
+#define SCALE   4294967296.0      /* 2^32: sum units per unit */
+#define LIMIT   2147483647.0      /* largest |value| summed */
+
+struct aggpart   /* one thread's share of S_agg_grid */
+{
+    const struct solgrid *grid;
+    struct solagg        *agg;
+    long   first, last;
+    long   errors;
+    int    ok;
+};
+
+static long long localday( long long utc, float tz );
+static long      period( const struct solagg *agg, long long days );
+static void      civil( long long days, int *year, int *month, int *day );
+static void      add128( struct solacc *a, long long hi,
+                         unsigned long long lo );
+static long      grid_fold( const struct solgrid *grid, struct solagg *agg,
+                            long first, long last );
+static void     *grid_thread( void *arg );
+
+
+/*============================================================================
+*    Int function S_agg_init
+*
+*    Returns 0, or -1 if out of memory or the spec is unusable
+*----------------------------------------------------------------------------*/
+int S_agg_init (struct solagg *agg, const struct solagg_spec *spec)
+{
+  struct solagg_op *op;
+  long  p0, p1, lo = 0, hi = 0;
+  int   s, k;
+
+    memset( agg, 0, sizeof( *agg ) );
+    agg->spec = *spec;
+    if ( spec->nsite < 1 || spec->nop < 1 || spec->nop > S_AGG_MAXOP ||
+         spec->end <= spec->start )
+        return -1;
+
+    for ( s = 0; s < spec->nsite; s++ ) {
+        p0 = period( agg, localday( spec->start, spec->sites[s].timezone ) );
+        p1 = period( agg, localday( spec->end - 1, spec->sites[s].timezone ) );
+        if ( s == 0 || p0 < lo ) lo = p0;
+        if ( s == 0 || p1 > hi ) hi = p1;
+    }
+    agg->first   = lo;
+    agg->nperiod = hi - lo + 1;
+    agg->ngroup  = spec->nsite * agg->nperiod;
+
+    for ( k = 0; k < spec->nop; k++ ) {
+        op = &agg->spec.op[k];
+        if ( op->col < 0 || op->col >= C_NCOL )
+            return -1;
+        if ( op->kind == A_PCTL ) {
+            if ( op->nbins <= 0 )
+                op->nbins = 1000;
+            if ( !( op->hi > op->lo ) )
+                return -1;
+            agg->hoff[k] = agg->hbins;
+            agg->hbins  += op->nbins;
+        }
+    }
+
+    agg->acc = (struct solacc *) calloc( agg->ngroup * spec->nop,
+                                         sizeof( struct solacc ) );
+    if ( agg->hbins )
+        agg->hist = (unsigned long long *)
+                    calloc( agg->ngroup * agg->hbins,
+                            sizeof( unsigned long long ) );
+    if ( agg->acc == NULL || ( agg->hbins && agg->hist == NULL ) ) {
+        S_agg_free( agg );
+        return -1;
+    }
+    return 0;
+}
+
+
+/*============================================================================
+*    Void function S_agg_add
+*
+*    Folds rows first .. last-1 of a computed batch into agg.  Every
+*    column an operator uses must be in the batch.  A NaN is left out of
+*    its operator (so it cannot stick as a maximum or minimum, or clamp
+*    into a sum) and counted in skipped.
+*----------------------------------------------------------------------------*/
+void S_agg_add (struct solagg *agg, const struct solbatch *batch, long first,
+                long last)
+{
+  const struct solagg_spec *sp = &agg->spec;
+  const struct solagg_op   *op;
+  const float *col[S_AGG_MAXOP], *tzin = batch->in[I_TIMEZONE];
+  struct solacc      *acc, *a;
+  unsigned long long *hist;
+  long long utc, x, days, lday = 0;
+  double    w;
+  float     v, tz;
+  long      i, p = 0, g;
+  int       s, k, b, lsite = -1;
+
+    for ( k = 0; k < sp->nop; k++ )
+        col[k] = batch->col[sp->op[k].col];
+
+    for ( i = first; i < last; i++ ) {
+        utc = batch->utc[i];
+        s   = batch->site ? batch->site[i] : 0;
+        if ( ( batch->retval && batch->retval[i] ) || utc < sp->start ||
+             utc >= sp->end || s < 0 || s >= sp->nsite ) {
+            agg->skipped++;
+            continue;
+        }
+
+        /* the period, looked up again only when the site or day changes */
+        tz   = tzin ? tzin[i] : sp->sites[s].timezone;
+        days = localday( utc, tz );
+        if ( s != lsite || days != lday ) {
+            lsite = s;
+            lday  = days;
+            p     = period( agg, days ) - agg->first;
+        }
+        if ( p < 0 || p >= agg->nperiod ) {
+            agg->skipped++;
+            continue;
+        }
+
+        g    = (long) s * agg->nperiod + p;
+        acc  = agg->acc + g * sp->nop;
+        hist = agg->hist ? agg->hist + g * agg->hbins : NULL;
+        agg->rows++;
+
+        for ( k = 0; k < sp->nop; k++ ) {
+            op = &sp->op[k];
+            a  = &acc[k];
+            v  = col[k][i];
+            if ( v != v ) {                   /* NaN: not a value */
+                agg->skipped++;
+                continue;
+            }
+            switch ( op->kind ) {
+            case A_SUM:
+            case A_MEAN:
+            case A_INTEG:
+                w = v * SCALE;
+                if ( !( fabs( (double) v ) <= LIMIT ) )
+                    w = v < 0.0 ? -LIMIT * SCALE : LIMIT * SCALE;
+                x = (long long) w;
+                add128( a, x < 0 ? -1 : 0, (unsigned long long) x );
+                a->n++;
+                break;
+            case A_MAX:
+                if ( a->n == 0 || v > a->max ||
+                     ( v == a->max && utc < a->tmax ) ) {
+                    a->max  = v;
+                    a->tmax = utc;
+                }
+                a->n++;
+                break;
+            case A_MIN:
+                if ( a->n == 0 || v < a->min ||
+                     ( v == a->min && utc < a->tmin ) ) {
+                    a->min  = v;
+                    a->tmin = utc;
+                }
+                a->n++;
+                break;
+            case A_HOURS:
+                if ( v > op->arg )
+                    a->n++;
+                break;
+            case A_PCTL:
+                w = ( v - op->lo ) / ( op->hi - op->lo ) * op->nbins;
+                b = w < 0.0 ? 0 :
+                    w >= op->nbins ? op->nbins - 1 : (int) w;
+                hist[agg->hoff[k] + b]++;
+                a->n++;
+                break;
+            }
+        }
+    }
+}
+
+
+/*============================================================================
+*    Int function S_agg_merge
+*
+*    Adds src into dst, which must have been set up from the same spec.
+*    Returns 0, or -1 if their shapes differ.
+*----------------------------------------------------------------------------*/
+int S_agg_merge (struct solagg *dst, const struct solagg *src)
+{
+  const struct solacc *b;
+  struct solacc *a;
+  long  g, n = dst->ngroup * dst->spec.nop;
+  int   k;
+
+    if ( src->ngroup != dst->ngroup || src->spec.nop != dst->spec.nop ||
+         src->hbins != dst->hbins || src->first != dst->first )
+        return -1;
+
+    for ( g = 0; g < n; g++ ) {
+        a = &dst->acc[g];
+        b = &src->acc[g];
+        k = (int) ( g % dst->spec.nop );
+        switch ( dst->spec.op[k].kind ) {
+        case A_MAX:
+            if ( b->n && ( a->n == 0 || b->max > a->max ||
+                           ( b->max == a->max && b->tmax < a->tmax ) ) ) {
+                a->max  = b->max;
+                a->tmax = b->tmax;
+            }
+            break;
+        case A_MIN:
+            if ( b->n && ( a->n == 0 || b->min < a->min ||
+                           ( b->min == a->min && b->tmin < a->tmin ) ) ) {
+                a->min  = b->min;
+                a->tmin = b->tmin;
+            }
+            break;
+        default:
+            add128( a, b->hi, b->lo );
+        }
+        a->n += b->n;
+    }
+    for ( g = 0; g < dst->ngroup * dst->hbins; g++ )
+        dst->hist[g] += src->hist[g];
+    dst->rows    += src->rows;
+    dst->skipped += src->skipped;
+    return 0;
+}
+
+
+/*============================================================================
+*    Long integer function S_agg_grid
+*
+*    Computes every row of grid (its cols are ignored; the operators'
+*    columns are computed) and folds it into agg, on up to threads
+*    threads.  Returns the number of rows with errors, or -1 if out of
+*    memory.
+*----------------------------------------------------------------------------*/
+long S_agg_grid (const struct solgrid *grid, struct solagg *agg, int threads)
+{
+  struct aggpart *part;
+  pthread_t      *tid;
+  long   rows = (long) grid->nsite * grid->ntime, errors = 0;
+  int    t, bad = 0;
+
+    if ( threads > rows / BLOCK )
+        threads = (int) ( rows / BLOCK );
+    if ( threads <= 1 )
+        return grid_fold( grid, agg, 0, rows );
+
+    part = (struct aggpart *) calloc( threads, sizeof( *part ) );
+    tid  = (pthread_t *) calloc( threads, sizeof( *tid ) );
+    if ( part == NULL || tid == NULL ) {
+        free( part );
+        free( tid );
+        return grid_fold( grid, agg, 0, rows );
+    }
+
+    for ( t = 0; t < threads; t++ ) {
+        part[t].grid  = grid;
+        part[t].first = rows * t / threads;
+        part[t].last  = rows * ( t + 1 ) / threads;
+        part[t].agg   = (struct solagg *) malloc( sizeof( struct solagg ) );
+        if ( part[t].agg && S_agg_init( part[t].agg, &agg->spec ) == 0 &&
+             pthread_create( &tid[t], NULL, grid_thread, &part[t] ) == 0 )
+            part[t].ok = 1;
+    }
+
+    /* merge in thread order; a range whose thread never ran is done here */
+    for ( t = 0; t < threads; t++ ) {
+        if ( part[t].ok ) {
+            pthread_join( tid[t], NULL );
+            if ( part[t].errors < 0 || S_agg_merge( agg, part[t].agg ) != 0 )
+                bad = 1;
+            else
+                errors += part[t].errors;
+        }
+        else if ( (part[t].errors = grid_fold( grid, agg, part[t].first,
+                                               part[t].last )) < 0 )
+            bad = 1;
+        else
+            errors += part[t].errors;
+        if ( part[t].agg )
+            S_agg_free( part[t].agg );
+        free( part[t].agg );
+    }
+
+    free( part );
+    free( tid );
+    return bad ? -1 : errors;
+}
+
+
+/*============================================================================
+*    Double function S_agg_value
+*
+*    Result of operator op for site and period (0 .. nperiod-1); NAN for
+*    a mean, extreme or percentile of no rows.  For A_MAX and A_MIN, *when
+*    (if not NULL) gets the UTC time of the extreme.
+*----------------------------------------------------------------------------*/
+double S_agg_value (const struct solagg *agg, int site, long period, int op,
+                    long long *when)
+{
+  const struct solagg_op *o = &agg->spec.op[op];
+  const struct solacc    *a;
+  const unsigned long long *h;
+  double sum, target, cum = 0.0;
+  long   g = (long) site * agg->nperiod + period;
+  int    b;
+
+    a   = &agg->acc[g * agg->spec.nop + op];
+    sum = ( (double) a->hi * 18446744073709551616.0 + (double) a->lo ) / SCALE;
+
+    switch ( o->kind ) {
+    case A_SUM:
+        return sum;
+    case A_MEAN:
+        return a->n ? sum / a->n : NAN;
+    case A_INTEG:
+        return sum * agg->spec.step / 3600.0;
+    case A_MAX:
+        if ( when ) *when = a->tmax;
+        return a->n ? a->max : NAN;
+    case A_MIN:
+        if ( when ) *when = a->tmin;
+        return a->n ? a->min : NAN;
+    case A_HOURS:
+        return a->n * (double) agg->spec.step / 3600.0;
+    case A_PCTL:
+        if ( a->n == 0 )
+            return NAN;
+        h = agg->hist + g * agg->hbins + agg->hoff[op];
+        target = o->arg / 100.0 * a->n;
+        for ( b = 0; b < o->nbins - 1; b++ ) {
+            if ( h[b] && cum + h[b] >= target )
+                break;
+            cum += h[b];
+        }
+        return o->lo + ( b + ( h[b] ? ( target - cum ) / h[b] : 0.0 ) ) *
+                       ( o->hi - o->lo ) / o->nbins;
+    }
+    return NAN;
+}
+
+
+/*============================================================================
+*    Void function S_agg_label
+*
+*    Local date on which period (0 .. nperiod-1) starts; for S_AGG_ALL,
+*    the earliest local date of start
+*----------------------------------------------------------------------------*/
+void S_agg_label (const struct solagg *agg, long period, int *year,
+                  int *month, int *day)
+{
+  long long d;
+  long p = agg->first + period;
+  int  s;
+
+    if ( agg->spec.by == S_AGG_MONTH ) {
+        *year  = (int) ( p / 12 );
+        *month = (int) ( p % 12 ) + 1;
+        *day   = 1;
+    }
+    else if ( agg->spec.by == S_AGG_DAY )
+        civil( p, year, month, day );
+    else {
+        for ( s = 0; s < agg->spec.nsite; s++ ) {
+            d = localday( agg->spec.start, agg->spec.sites[s].timezone );
+            if ( s == 0 || d < p )
+                p = (long) d;
+        }
+        civil( p, year, month, day );
+    }
+}
+
+
+/*============================================================================
+*    Void function S_agg_free
+*----------------------------------------------------------------------------*/
+void S_agg_free (struct solagg *agg)
+{
+    free( agg->acc );
+    free( agg->hist );
+    agg->acc  = NULL;
+    agg->hist = NULL;
+}
+
+
+/*============================================================================
+*    Local Long long integer function localday
+*
+*    Local standard day (since 1 January 1970) of a UTC time at timezone
+*    tz, rounding the offset to the second as S_epoch does
+*----------------------------------------------------------------------------*/
+static long long localday( long long utc, float tz )
+{
+  long long t = utc + (long long) floor( tz * 3600.0 + 0.5 );
+
+    return t >= 0 ? t / 86400 : -( ( -t + 86399 ) / 86400 );
+}
+
+
+/*============================================================================
+*    Local Long integer function period
+*
+*    Period number of a local day
+*----------------------------------------------------------------------------*/
+static long period( const struct solagg *agg, long long days )
+{
+  int y, m, d;
+
+    if ( agg->spec.by == S_AGG_ALL )
+        return 0;
+    if ( agg->spec.by == S_AGG_DAY )
+        return (long) days;
+    civil( days, &y, &m, &d );
+    return y * 12L + m - 1;
+}
+
+
+/*============================================================================
+*    Local Void function civil
+*
+*    Gregorian date of a day number since 1 January 1970 (as S_epoch)
+*----------------------------------------------------------------------------*/
+static void civil( long long days, int *year, int *month, int *day )
+{
+  long era, doe, yoe, doy, mp;
+
+    days += 719468;
+    era   = (long) ( ( days >= 0 ? days : days - 146096 ) / 146097 );
+    doe   = (long) ( days - (long long) era * 146097 );
+    yoe   = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+    doy   = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+    mp    = ( 5 * doy + 2 ) / 153;
+    *day   = (int) ( doy - ( 153 * mp + 2 ) / 5 + 1 );
+    *month = (int) ( mp < 10 ? mp + 3 : mp - 9 );
+    *year  = (int) ( yoe + (long) era * 400 + ( *month <= 2 ) );
+}
+
+
+/*============================================================================
+*    Local Void function add128
+*
+*    Adds hi * 2^64 + lo to a's sum
+*----------------------------------------------------------------------------*/
+static void add128( struct solacc *a, long long hi, unsigned long long lo )
+{
+  unsigned long long old = a->lo;
+
+    a->lo += lo;
+    a->hi += hi + ( a->lo < old );
+}
+
+
+/*============================================================================
+*    Local Long integer function grid_fold
+*
+*    Computes grid rows first .. last-1 a block at a time and folds them
+*    into agg.  Returns the rows with errors, or -1 if out of memory.
+*----------------------------------------------------------------------------*/
+static long grid_fold( const struct solgrid *grid, struct solagg *agg,
+                       long first, long last )
+{
+  struct solbatch batch;
+  long long *utc;
+  float     *buf;
+  long      *retval, r0, n, i, r, errors = 0;
+  int       *site, k, ncol = 0;
+
+    utc    = (long long *) malloc( BLOCK * sizeof( long long ) );
+    site   = (int *) malloc( BLOCK * sizeof( int ) );
+    retval = (long *) malloc( BLOCK * sizeof( long ) );
+    buf    = (float *) malloc( C_NCOL * BLOCK * sizeof( float ) );
+    if ( !utc || !site || !retval || !buf ) {
+        free( utc );
+        free( site );
+        free( retval );
+        free( buf );
+        return -1;
+    }
+
+    memset( &batch, 0, sizeof( batch ) );
+    batch.utc    = utc;
+    batch.site   = site;
+    batch.sites  = grid->sites;
+    batch.retval = retval;
+    for ( k = 0; k < agg->spec.nop; k++ )
+        if ( batch.col[agg->spec.op[k].col] == NULL )
+            batch.col[agg->spec.op[k].col] = buf + BLOCK * ncol++;
+
+    for ( r0 = first; r0 < last; r0 += n ) {
+        n = last - r0 < BLOCK ? last - r0 : BLOCK;
+        for ( i = 0; i < n; i++ ) {
+            r = r0 + i;
+            site[i] = (int) ( r / grid->ntime );
+            utc[i]  = grid->start + ( r % grid->ntime ) * grid->step;
+        }
+        batch.count = n;
+        errors += S_batch( &batch, 0, n );
+        S_agg_add( agg, &batch, 0, n );
+    }
+
+    free( utc );
+    free( site );
+    free( retval );
+    free( buf );
+    return errors;
+}
+
+
+/*============================================================================
+*    Local void pointer function grid_thread
+*----------------------------------------------------------------------------*/
+static void *grid_thread( void *arg )
+{
+  struct aggpart *part = (struct aggpart *) arg;
+
+    part->errors = grid_fold( part->grid, part->agg, part->first,
+                              part->last );
+    return NULL;
+}
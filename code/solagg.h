@@ -0,0 +1,115 @@
+/*============================================================================
+*
+*    NAME:  solagg.h
+*
+*    Contains:
+*        S_agg_init   (sets up the accumulators of an aggregation)
+*        S_agg_add    (folds rows of a computed batch in)
+*        S_agg_merge  (adds one aggregation into another)
+*        S_agg_grid   (computes a grid and folds it, on several threads)
+*        S_agg_value  (the result of an operator for a site and period)
+*        S_agg_label  (the local date a period starts on)
+*        S_agg_free   (releases the accumulators)
+*
+*    Reductions of computed series, folded block by block as the rows
+*    are computed, so the series itself is never stored: memory is one
+*    accumulator per site, period and operator (plus a histogram for
+*    percentiles), whatever the number of rows.
+*
+*    Rows are grouped by site and by local standard day or month (with
+*    the site's timezone, as S_epoch does) or over the whole range.  The
+*    operators, each on one output column of solbatch.h, are
+*
+*        A_SUM      sum of the values
+*        A_MEAN     mean of the values
+*        A_INTEG    sum times step / 3600: W/sq m samples to Wh/sq m
+*        A_MAX      largest value (and the UTC time of its first row)
+*        A_MIN      smallest value (and likewise)
+*        A_HOURS    hours with the value above arg (rows times step)
+*        A_PCTL     arg-th percentile, from a histogram of nbins bins
+*                   over lo .. hi (values outside count in the end bins)
+*
+*    Sums are kept exactly, as integer multiples of 2^-32 in a 128-bit
+*    accumulator (values need |v| < 2^31, finer detail is cut off).
+*    Integer addition does not depend on order, and neither do maxima,
+*    minima or histogram counts, so every result is the same to the
+*    last bit however the rows were split between blocks or threads and
+*    in whatever order partial aggregations are merged.
+*
+*    Rows with a nonzero return code (if the batch has retval) and rows
+*    outside start .. end are left out.  A NaN value is left out of the
+*    operator it would go to, and the rest of its row still counts; each
+*    is counted in skipped as well.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solagg.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLAGG_H
+#define SOLAGG_H
+
+#include "solfork.h"
+
+#define S_AGG_MAXOP  16
+
+enum { A_SUM, A_MEAN, A_INTEG, A_MAX, A_MIN, A_HOURS, A_PCTL };
+enum { S_AGG_ALL, S_AGG_DAY, S_AGG_MONTH };            /* by */
+
+struct solagg_op
+{
+    int   col;                  /* C_ column */
+    int   kind;                 /* A_ operator */
+    float arg;                  /* A_HOURS threshold, A_PCTL percentile */
+    float lo, hi;               /* A_PCTL histogram range */
+    int   nbins;                /* A_PCTL bins; 0 means 1000 */
+};
+
+struct solagg_spec
+{
+    const struct posdata *sites;     /* timezones for the local dates */
+    int        nsite;
+    long long  start, end;           /* UTC range, end excluded */
+    long       step;                 /* seconds each row stands for */
+    int        by;                   /* S_AGG_ALL, S_AGG_DAY, S_AGG_MONTH */
+    int        nop;
+    struct solagg_op op[S_AGG_MAXOP];
+};
+
+struct solacc                        /* one site, period and operator */
+{
+    long long          hi;           /* sum, in 2^-32 units: hi * 2^64 */
+    unsigned long long lo;           /*                      + lo */
+    long               n;            /* rows (A_HOURS: rows above arg) */
+    float              max, min;
+    long long          tmax, tmin;
+};
+
+struct solagg
+{
+    struct solagg_spec spec;
+    long       first;               /* period number of start */
+    long       nperiod;
+    long       ngroup;              /* nsite * nperiod */
+    struct solacc      *acc;        /* [ngroup][nop] */
+    unsigned long long *hist;       /* [ngroup][bins of all A_PCTL ops] */
+    long       hbins;               /* bins per group */
+    long       hoff[S_AGG_MAXOP];   /* op's first bin within a group */
+    long       rows;                /* rows folded in */
+    long       skipped;             /* rows left out, plus NaN values */
+};
+
+extern int    S_agg_init (struct solagg *agg, const struct solagg_spec *spec);
+extern void   S_agg_add (struct solagg *agg, const struct solbatch *batch,
+                         long first, long last);
+extern int    S_agg_merge (struct solagg *dst, const struct solagg *src);
+extern long   S_agg_grid (const struct solgrid *grid, struct solagg *agg,
+                          int threads);
+extern double S_agg_value (const struct solagg *agg, int site, long period,
+                           int op, long long *when);
+extern void   S_agg_label (const struct solagg *agg, long period, int *year,
+                           int *month, int *day);
+extern void   S_agg_free (struct solagg *agg);
+
+#endif /* SOLAGG_H */
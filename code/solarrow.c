@@ -0,0 +1,212 @@
+/*============================================================================
+*    Contains:
+*        S_arrow_export  (exposes a batch's columns as Arrow C Data)
+*
+*    The array and the schema are each backed by one allocation holding
+*    the children and their buffer lists, with a count of the structs
+*    still unreleased (the parent and every child).  A child's release
+*    only drops the count, so a child moved out by the consumer keeps
+*    the allocation alive; the last release frees it, and for the array
+*    calls the owner's done.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solarrow.h"
+*
+*----------------------------------------------------------------------------*/
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "solarrow.h"
+
+#define MAXFIELD  ( C_NCOL + 3 )
+
+struct arrays      /* private data of an exported array */
+{
+    atomic_int          refs;
+    void              (*done)( void * );
+    void               *owner;
+    const void         *nobuf[1];             /* the struct's validity */
+    const void         *buf[MAXFIELD][2];     /* validity, data */
+    struct ArrowArray   child[MAXFIELD];
+    struct ArrowArray  *ptr[MAXFIELD];
+};
+
+struct schemas     /* private data of an exported schema */
+{
+    atomic_int          refs;
+    struct ArrowSchema  child[MAXFIELD];
+    struct ArrowSchema *ptr[MAXFIELD];
+};
+
+static void array_release( struct ArrowArray *a );
+static void array_child_release( struct ArrowArray *a );
+static void array_unref( struct arrays *p );
+static void schema_release( struct ArrowSchema *s );
+static void schema_child_release( struct ArrowSchema *s );
+static void schema_unref( struct schemas *p );
+
+
+/*============================================================================
+*    Int function S_arrow_export
+*
+*    Fills array and schema (either may be NULL) for the batch as it
+*    is now.  done may be NULL.  Returns 0, or -1 if out of memory
+*    (nothing is then exported and done is not called).
+*----------------------------------------------------------------------------*/
+int S_arrow_export (const struct solbatch *batch, struct ArrowArray *array,
+                    struct ArrowSchema *schema,
+                    void (*done)( void *owner ), void *owner)
+{
+  struct arrays  *pa = NULL;
+  struct schemas *ps = NULL;
+  const char *name[MAXFIELD], *format[MAXFIELD];
+  const void *data[MAXFIELD];
+  int  n = 0, k;
+
+    name[n] = "utc";     format[n] = "tss:UTC";  data[n++] = batch->utc;
+    if ( batch->site ) {
+        name[n] = "site";    format[n] = "i";    data[n++] = batch->site;
+    }
+    if ( batch->retval ) {
+        name[n]   = "retval";
+        format[n] = sizeof( long ) == 8 ? "l" : "i";
+        data[n++] = batch->retval;
+    }
+    for ( k = 0; k < C_NCOL; k++ )
+        if ( batch->col[k] ) {
+            name[n] = S_batch_column( k );  format[n] = "f";
+            data[n++] = batch->col[k];
+        }
+
+    if ( ( array  && (pa = (struct arrays *) calloc( 1, sizeof( *pa ) ))
+                     == NULL ) ||
+         ( schema && (ps = (struct schemas *) calloc( 1, sizeof( *ps ) ))
+                     == NULL ) ) {
+        free( pa );
+        return -1;
+    }
+
+    if ( array ) {
+        atomic_init( &pa->refs, n + 1 );
+        pa->done  = done;
+        pa->owner = owner;
+        for ( k = 0; k < n; k++ ) {
+            pa->buf[k][0] = NULL;                 /* no nulls */
+            pa->buf[k][1] = data[k];
+            pa->child[k].length       = batch->count;
+            pa->child[k].n_buffers    = 2;
+            pa->child[k].buffers      = pa->buf[k];
+            pa->child[k].release      = array_child_release;
+            pa->child[k].private_data = pa;
+            pa->ptr[k] = &pa->child[k];
+        }
+        memset( array, 0, sizeof( *array ) );
+        array->length       = batch->count;
+        array->n_buffers    = 1;
+        array->buffers      = pa->nobuf;
+        array->n_children   = n;
+        array->children     = pa->ptr;
+        array->release      = array_release;
+        array->private_data = pa;
+    }
+
+    if ( schema ) {
+        atomic_init( &ps->refs, n + 1 );
+        for ( k = 0; k < n; k++ ) {
+            ps->child[k].format       = format[k];
+            ps->child[k].name         = name[k];
+            ps->child[k].release      = schema_child_release;
+            ps->child[k].private_data = ps;
+            ps->ptr[k] = &ps->child[k];
+        }
+        memset( schema, 0, sizeof( *schema ) );
+        schema->format       = "+s";
+        schema->name         = "";
+        schema->n_children   = n;
+        schema->children     = ps->ptr;
+        schema->release      = schema_release;
+        schema->private_data = ps;
+    }
+    return 0;
+}
+
+
+/*============================================================================
+*    Local void function array_release
+*----------------------------------------------------------------------------*/
+static void array_release( struct ArrowArray *a )
+{
+  struct arrays *p = (struct arrays *) a->private_data;
+  int k;
+
+    for ( k = 0; k < a->n_children; k++ )      /* those not moved away */
+        if ( a->children[k]->release )
+            a->children[k]->release( a->children[k] );
+    a->release = NULL;
+    array_unref( p );
+}
+
+
+/*============================================================================
+*    Local void function array_child_release
+*----------------------------------------------------------------------------*/
+static void array_child_release( struct ArrowArray *a )
+{
+  struct arrays *p = (struct arrays *) a->private_data;
+
+    a->release = NULL;
+    array_unref( p );
+}
+
+
+/*============================================================================
+*    Local void function array_unref
+*----------------------------------------------------------------------------*/
+static void array_unref( struct arrays *p )
+{
+    if ( atomic_fetch_sub( &p->refs, 1 ) == 1 ) {
+        if ( p->done )
+            p->done( p->owner );
+        free( p );
+    }
+}
+
+
+/*============================================================================
+*    Local void function schema_release
+*----------------------------------------------------------------------------*/
+static void schema_release( struct ArrowSchema *s )
+{
+  struct schemas *p = (struct schemas *) s->private_data;
+  int k;
+
+    for ( k = 0; k < s->n_children; k++ )
+        if ( s->children[k]->release )
+            s->children[k]->release( s->children[k] );
+    s->release = NULL;
+    schema_unref( p );
+}
+
+
+/*============================================================================
+*    Local void function schema_child_release
+*----------------------------------------------------------------------------*/
+static void schema_child_release( struct ArrowSchema *s )
+{
+  struct schemas *p = (struct schemas *) s->private_data;
+
+    s->release = NULL;
+    schema_unref( p );
+}
+
+
+/*============================================================================
+*    Local void function schema_unref
+*----------------------------------------------------------------------------*/
+static void schema_unref( struct schemas *p )
+{
+    if ( atomic_fetch_sub( &p->refs, 1 ) == 1 )
+        free( p );
+}
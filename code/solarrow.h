@@ -0,0 +1,91 @@
+/*============================================================================
+*
+*    NAME:  solarrow.h
+*
+*    Contains:
+*        S_arrow_export  (exposes a batch's columns as Arrow C Data)
+*
+*    Hands the columns of a computed batch (solbatch.h) to any Apache
+*    Arrow consumer (pyarrow, polars, DuckDB, nanoarrow ...) through the
+*    Arrow C Data Interface, without copying them and without linking
+*    an Arrow library.  The export is one struct array ("record batch")
+*    with, in this order,
+*
+*        utc      timestamp[s, UTC]   batch->utc
+*        site     int32               batch->site, if given
+*        retval   int64               batch->retval, if given
+*        <col>    float32             every non-NULL batch->col[k], named
+*                                     as by S_batch_column
+*
+*    The children's data buffers are the batch arrays themselves, so
+*    they must stay put until the consumer is finished.  The consumer
+*    says so by calling the release callbacks, which it may do in any
+*    order and from any thread, after moving any children out as the
+*    interface allows; when the array and every child have been
+*    released, done( owner ) is called once, where the caller frees
+*    the columns (or unmaps a solbin.h output file).  The schema has its
+*    own release and owns nothing of the caller's.
+*
+*    The struct definitions are the interface's own and may also come
+*    from arrow/c/abi.h.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solarrow.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLARROW_H
+#define SOLARROW_H
+
+#include <stdint.h>
+#include "solbatch.h"
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  // Array type description
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray {
+  // Array data description
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+extern int S_arrow_export (const struct solbatch *batch,
+                           struct ArrowArray *array,
+                           struct ArrowSchema *schema,
+                           void (*done)( void *owner ), void *owner);
+
+#endif /* SOLARROW_H */
@@ -0,0 +1,180 @@
+/*============================================================================
+*    Contains:
+*        S_batch           (computes a range of rows of a batch)
+*        S_batch_parallel  (computes a whole batch on several threads)
+*        S_batch_column    (name of an output column)
+*        S_batch_input     (name of an input column)
+*
+*    Rows are independent, so S_batch_parallel cuts the batch into one
+*    contiguous range per thread; each thread writes only its own slice
+*    of every column and no locking is needed.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solbatch.h"
+*
+*----------------------------------------------------------------------------*/
+#include <pthread.h>
+#include <stdlib.h>
+#include "solbatch.h"
+
+struct batchpart   /* one thread's share of a batch */
+{
+    const struct solbatch *batch;
+    long   first;
+    long   last;
+    long   errors;
+};
+
+static const char *colname[C_NCOL] = {
+    "amass", "ampress", "azim", "cosinc", "coszen", "elevref", "etr",
+    "etrn", "etrtilt", "prime", "sbcf", "sretr", "ssetr", "unprime",
+    "zenref" };
+
+static const char *inname[I_NIN] = {
+    "latitude", "longitude", "timezone", "press", "temp", "tilt",
+    "aspect" };
+
+static void *batch_thread( void *arg );
+
+
+/*============================================================================
+*    Long integer function S_batch
+*
+*    Computes rows first .. last-1.  Returns the number of rows for which
+*    S_solpos returned an error.
+*----------------------------------------------------------------------------*/
+long S_batch (const struct solbatch *batch, long first, long last)
+{
+  struct posdata pd;
+  float * const *col = batch->col;
+  const float * const *in = batch->in;
+  long   errors = 0;
+  long   retval;
+  long   i;
+
+    for ( i = first; i < last; i++ ) {
+        pd = batch->sites[batch->site ? batch->site[i] : 0];
+        if ( in[I_LATITUDE]  ) pd.latitude  = in[I_LATITUDE][i];
+        if ( in[I_LONGITUDE] ) pd.longitude = in[I_LONGITUDE][i];
+        if ( in[I_TIMEZONE]  ) pd.timezone  = in[I_TIMEZONE][i];
+        if ( in[I_PRESS]     ) pd.press     = in[I_PRESS][i];
+        if ( in[I_TEMP]      ) pd.temp      = in[I_TEMP][i];
+        if ( in[I_TILT]      ) pd.tilt      = in[I_TILT][i];
+        if ( in[I_ASPECT]    ) pd.aspect    = in[I_ASPECT][i];
+        S_epoch( &pd, batch->utc[i] );
+
+        if ( (retval = S_solpos( &pd )) != 0 )
+            errors++;
+        if ( batch->retval )
+            batch->retval[i] = retval;
+
+        if ( col[C_AMASS]   ) col[C_AMASS][i]   = pd.amass;
+        if ( col[C_AMPRESS] ) col[C_AMPRESS][i] = pd.ampress;
+        if ( col[C_AZIM]    ) col[C_AZIM][i]    = pd.azim;
+        if ( col[C_COSINC]  ) col[C_COSINC][i]  = pd.cosinc;
+        if ( col[C_COSZEN]  ) col[C_COSZEN][i]  = pd.coszen;
+        if ( col[C_ELEVREF] ) col[C_ELEVREF][i] = pd.elevref;
+        if ( col[C_ETR]     ) col[C_ETR][i]     = pd.etr;
+        if ( col[C_ETRN]    ) col[C_ETRN][i]    = pd.etrn;
+        if ( col[C_ETRTILT] ) col[C_ETRTILT][i] = pd.etrtilt;
+        if ( col[C_PRIME]   ) col[C_PRIME][i]   = pd.prime;
+        if ( col[C_SBCF]    ) col[C_SBCF][i]    = pd.sbcf;
+        if ( col[C_SRETR]   ) col[C_SRETR][i]   = pd.sretr;
+        if ( col[C_SSETR]   ) col[C_SSETR][i]   = pd.ssetr;
+        if ( col[C_UNPRIME] ) col[C_UNPRIME][i] = pd.unprime;
+        if ( col[C_ZENREF]  ) col[C_ZENREF][i]  = pd.zenref;
+    }
+
+    return errors;
+}
+
+
+/*============================================================================
+*    Long integer function S_batch_parallel
+*
+*    Computes the whole batch on up to threads threads (the calling thread
+*    takes the first range).  Returns the number of rows with errors, or
+*    -1 if a thread could not be started (the batch is then incomplete).
+*----------------------------------------------------------------------------*/
+long S_batch_parallel (const struct solbatch *batch, int threads)
+{
+  struct batchpart *part;
+  pthread_t        *tid;
+  long   errors;
+  int    started, t;
+
+    if ( threads > batch->count / 64 )      /* keep ranges worthwhile */
+        threads = (int) ( batch->count / 64 );
+    if ( threads <= 1 )
+        return S_batch( batch, 0, batch->count );
+
+    part = (struct batchpart *) malloc( threads * sizeof( *part ) );
+    tid  = (pthread_t *) malloc( threads * sizeof( *tid ) );
+    if ( part == NULL || tid == NULL ) {
+        free( part );
+        free( tid );
+        return S_batch( batch, 0, batch->count );
+    }
+
+    for ( t = 0; t < threads; t++ ) {
+        part[t].batch  = batch;
+        part[t].first  = batch->count * t / threads;
+        part[t].last   = batch->count * ( t + 1 ) / threads;
+        part[t].errors = 0;
+    }
+
+    for ( started = 1; started < threads; started++ )
+        if ( pthread_create( &tid[started], NULL, batch_thread,
+                             &part[started] ) != 0 )
+            break;
+
+    batch_thread( &part[0] );
+
+    errors = part[0].errors;
+    for ( t = 1; t < started; t++ ) {
+        pthread_join( tid[t], NULL );
+        errors += part[t].errors;
+    }
+    if ( started < threads )
+        errors = -1;
+
+    free( part );
+    free( tid );
+    return errors;
+}
+
+
+/*============================================================================
+*    Const char pointer function S_batch_column
+*
+*    Name of an output column (the posdata member), or NULL
+*----------------------------------------------------------------------------*/
+const char *S_batch_column (int col)
+{
+    return ( col >= 0 && col < C_NCOL ) ? colname[col] : NULL;
+}
+
+
+/*============================================================================
+*    Const char pointer function S_batch_input
+*
+*    Name of an input column (the posdata member), or NULL
+*----------------------------------------------------------------------------*/
+const char *S_batch_input (int in)
+{
+    return ( in >= 0 && in < I_NIN ) ? inname[in] : NULL;
+}
+
+
+/*============================================================================
+*    Local void pointer function batch_thread
+*----------------------------------------------------------------------------*/
+static void *batch_thread( void *arg )
+{
+  struct batchpart *part = (struct batchpart *) arg;
+
+    part->errors = S_batch( part->batch, part->first, part->last );
+    return NULL;
+}
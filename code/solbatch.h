@@ -0,0 +1,66 @@
+/*============================================================================
+*
+*    NAME:  solbatch.h
+*
+*    Contains:
+*        S_batch           (computes a range of rows of a batch)
+*        S_batch_parallel  (computes a whole batch on several threads)
+*        S_batch_column    (name of an output column)
+*        S_batch_input     (name of an input column)
+*
+*    A batch is a set of rows, each a UTC time and a site index.  Sites
+*    are posdata templates (S_init, then latitude, longitude, timezone and
+*    any optional inputs, including the function mask); the date and time
+*    fields of a template are ignored.  Each row is run through S_solpos
+*    and the selected outputs are written to float columns, one array per
+*    posdata output, indexed by row.
+*
+*    Columns left NULL are not written.  The retval array, if given,
+*    receives the S_solpos return code of each row.
+*
+*    Inputs that vary from row to row (a weather file's pressure and
+*    temperature, a moving site) may be given as per-row input columns;
+*    a non-NULL in[k] replaces the template's value for every row, so
+*    per-row press and temp reach the refraction correction.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solbatch.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLBATCH_H
+#define SOLBATCH_H
+
+#include "solpos00.h"
+
+/* output columns (posdata outputs) */
+enum { C_AMASS, C_AMPRESS, C_AZIM, C_COSINC, C_COSZEN, C_ELEVREF, C_ETR,
+       C_ETRN, C_ETRTILT, C_PRIME, C_SBCF, C_SRETR, C_SSETR, C_UNPRIME,
+       C_ZENREF, C_NCOL };
+
+#define S_COL(c)  ( 1 << (c) )
+
+/* per-row input columns (posdata inputs) */
+enum { I_LATITUDE, I_LONGITUDE, I_TIMEZONE, I_PRESS, I_TEMP, I_TILT,
+       I_ASPECT, I_NIN };
+
+struct solbatch
+{
+    long                  count;     /* number of rows */
+    const long long      *utc;       /* UTC seconds since 1970, per row */
+    const int            *site;      /* site index per row; NULL = all 0 */
+    const struct posdata *sites;     /* site templates */
+    float                *col[C_NCOL]; /* output columns, NULL = skip */
+    long                 *retval;    /* per-row return codes, may be NULL */
+    const float          *in[I_NIN]; /* per-row inputs, NULL = template */
+};
+
+extern long        S_batch (const struct solbatch *batch, long first,
+                            long last);
+extern long        S_batch_parallel (const struct solbatch *batch,
+                                     int threads);
+extern const char *S_batch_column (int col);
+extern const char *S_batch_input (int in);
+
+#endif /* SOLBATCH_H */
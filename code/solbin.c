@@ -0,0 +1,282 @@
+/*============================================================================
+*    Contains:
+*        S_bin_create  (creates and maps a batch file of a given shape)
+*        S_bin_open    (maps an existing batch file)
+*        S_bin_close   (unmaps a batch file)
+*        S_bin_put     (stores a posdata template as a site record)
+*        S_bin_site    (expands a site record into a posdata template)
+*        S_bin_batch   (points a batch at an input and an output file)
+*
+*    The section offsets are not stored; they follow from the header
+*    (layout), so a file whose size disagrees with its header is
+*    rejected rather than read past its end.  S_bin_create sizes the
+*    file with ftruncate, so its pages are allocated only as they are
+*    written.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solbin.h"
+*
+*----------------------------------------------------------------------------*/
+#define _DEFAULT_SOURCE
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "solbin.h"
+
+#define ALIGN( n )  ( ( (n) + 63 ) & ~(uint64_t) 63 )
+
+static uint64_t layout( const struct solbin_head *h, struct solbin *bin );
+
+
+/*============================================================================
+*    Int function S_bin_create
+*
+*    Creates (or truncates) path for rows rows and maps it read-write
+*    with the header filled in and every array zero.  mask and flags are
+*    as in struct solbin_head; nsite is ignored for output files.
+*    Returns 0, or -1 (errno set by the failing call).
+*----------------------------------------------------------------------------*/
+int S_bin_create (const char *path, int kind, long rows, int nsite,
+                  unsigned mask, unsigned flags, struct solbin *bin)
+{
+  struct solbin_head h;
+  uint64_t size;
+
+    memset( bin, 0, sizeof( *bin ) );
+    bin->fd = -1;
+    if ( sizeof( long ) != 8 || sizeof( int ) != 4 || rows < 0 ||
+         ( kind != S_BIN_INPUT && kind != S_BIN_OUTPUT ) ||
+         ( kind == S_BIN_INPUT && nsite < 1 ) )
+        return -1;
+
+    memset( &h, 0, sizeof( h ) );
+    memcpy( h.magic, S_BIN_MAGIC, sizeof( S_BIN_MAGIC ) );
+    h.version = S_BIN_VERSION;
+    h.endian  = S_BIN_ENDIAN;
+    h.kind    = kind;
+    h.nsite   = kind == S_BIN_INPUT ? nsite : 0;
+    h.mask    = mask & ( kind == S_BIN_INPUT ? ( 1u << I_NIN ) - 1
+                                             : ( 1u << C_NCOL ) - 1 );
+    h.flags   = kind == S_BIN_INPUT ? ( flags & S_BIN_SITEID ) : 0;
+    h.rows    = rows;
+    h.size    = size = layout( &h, NULL );
+
+    if ( (bin->fd = open( path, O_RDWR | O_CREAT | O_TRUNC, 0666 )) < 0 )
+        return -1;
+    if ( ftruncate( bin->fd, (off_t) size ) != 0 )
+        goto fail;
+    bin->size = size;
+    bin->base = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      bin->fd, 0 );
+    if ( bin->base == MAP_FAILED ) {
+        bin->base = NULL;
+        goto fail;
+    }
+    memcpy( bin->base, &h, sizeof( h ) );
+    layout( &h, bin );
+    return 0;
+
+fail:
+    S_bin_close( bin );
+    return -1;
+}
+
+
+/*============================================================================
+*    Int function S_bin_open
+*
+*    Maps path, read-only unless writable.  Returns 0; -1 if the file
+*    cannot be mapped; or 1 if it is not a batch file this code can read
+*    (magic, version, byte order, size, or a site index out of range).
+*----------------------------------------------------------------------------*/
+int S_bin_open (const char *path, int writable, struct solbin *bin)
+{
+  struct solbin_head *h;
+  struct stat st;
+  uint64_t i;
+
+    memset( bin, 0, sizeof( *bin ) );
+    bin->fd = -1;
+    if ( sizeof( long ) != 8 || sizeof( int ) != 4 )
+        return 1;
+    if ( (bin->fd = open( path, writable ? O_RDWR : O_RDONLY )) < 0 )
+        return -1;
+    if ( fstat( bin->fd, &st ) != 0 ) {
+        S_bin_close( bin );
+        return -1;
+    }
+    if ( (size_t) st.st_size < sizeof( *h ) ) {
+        S_bin_close( bin );
+        return 1;
+    }
+
+    bin->size = st.st_size;
+    bin->base = mmap( NULL, bin->size,
+                      writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                      MAP_SHARED, bin->fd, 0 );
+    if ( bin->base == MAP_FAILED ) {
+        bin->base = NULL;
+        S_bin_close( bin );
+        return -1;
+    }
+
+    h = (struct solbin_head *) bin->base;
+    if ( memcmp( h->magic, S_BIN_MAGIC, sizeof( S_BIN_MAGIC ) ) != 0 ||
+         h->version < 1 || h->version > S_BIN_VERSION ||
+         h->endian != S_BIN_ENDIAN ||
+         ( h->kind != S_BIN_INPUT && h->kind != S_BIN_OUTPUT ) ||
+         ( h->kind == S_BIN_INPUT && h->nsite < 1 ) ||
+         h->rows > (uint64_t) LONG_MAX / 64 ||
+         h->size != bin->size || layout( h, NULL ) != h->size ) {
+        S_bin_close( bin );
+        return 1;
+    }
+    layout( h, bin );
+
+    /* a bad site index would read past the templates */
+    for ( i = 0; bin->siteid && i < h->rows; i++ )
+        if ( (uint32_t) bin->siteid[i] >= h->nsite ) {
+            S_bin_close( bin );
+            return 1;
+        }
+
+    madvise( bin->base, bin->size, MADV_SEQUENTIAL );
+    return 0;
+}
+
+
+/*============================================================================
+*    Void function S_bin_close
+*
+*    Unmaps and closes; what was written through the map stays in the
+*    file.
+*----------------------------------------------------------------------------*/
+void S_bin_close (struct solbin *bin)
+{
+    if ( bin->base )
+        munmap( bin->base, bin->size );
+    if ( bin->fd >= 0 )
+        close( bin->fd );
+    memset( bin, 0, sizeof( *bin ) );
+    bin->fd = -1;
+}
+
+
+/*============================================================================
+*    Void function S_bin_put
+*----------------------------------------------------------------------------*/
+void S_bin_put (struct solbin_site *rec, const struct posdata *pd)
+{
+    memset( rec, 0, sizeof( *rec ) );
+    rec->in[I_LATITUDE]  = pd->latitude;
+    rec->in[I_LONGITUDE] = pd->longitude;
+    rec->in[I_TIMEZONE]  = pd->timezone;
+    rec->in[I_PRESS]     = pd->press;
+    rec->in[I_TEMP]      = pd->temp;
+    rec->in[I_TILT]      = pd->tilt;
+    rec->in[I_ASPECT]    = pd->aspect;
+    rec->function        = pd->function;
+    rec->interval        = pd->interval;
+    rec->sbwid           = pd->sbwid;
+    rec->sbrad           = pd->sbrad;
+    rec->sbsky           = pd->sbsky;
+    rec->solcon          = pd->solcon;
+}
+
+
+/*============================================================================
+*    Void function S_bin_site
+*
+*    pd gets the S_init defaults and then the record's values
+*----------------------------------------------------------------------------*/
+void S_bin_site (const struct solbin_site *rec, struct posdata *pd)
+{
+    S_init( pd );
+    pd->latitude  = rec->in[I_LATITUDE];
+    pd->longitude = rec->in[I_LONGITUDE];
+    pd->timezone  = rec->in[I_TIMEZONE];
+    pd->press     = rec->in[I_PRESS];
+    pd->temp      = rec->in[I_TEMP];
+    pd->tilt      = rec->in[I_TILT];
+    pd->aspect    = rec->in[I_ASPECT];
+    pd->function  = rec->function;
+    pd->interval  = rec->interval;
+    pd->sbwid     = rec->sbwid;
+    pd->sbrad     = rec->sbrad;
+    pd->sbsky     = rec->sbsky;
+    pd->solcon    = rec->solcon;
+}
+
+
+/*============================================================================
+*    Void function S_bin_batch
+*
+*    Points batch at the rows and inputs of in and the return codes and
+*    columns of out (either may be NULL); sites are in's site records
+*    expanded with S_bin_site.
+*----------------------------------------------------------------------------*/
+void S_bin_batch (const struct solbin *in, const struct solbin *out,
+                  const struct posdata *sites, struct solbatch *batch)
+{
+    memset( batch, 0, sizeof( *batch ) );
+    batch->sites = sites;
+    if ( in ) {
+        batch->count = (long) in->head->rows;
+        batch->utc   = in->utc;
+        batch->site  = in->siteid;
+        memcpy( batch->in, in->in, sizeof( batch->in ) );
+    }
+    if ( out ) {
+        batch->retval = out->retval;
+        memcpy( batch->col, out->col, sizeof( batch->col ) );
+    }
+}
+
+
+/*============================================================================
+*    Local uint64 function layout
+*
+*    Size of the file described by h; if bin is given, also sets its
+*    section pointers
+*----------------------------------------------------------------------------*/
+static uint64_t layout( const struct solbin_head *h, struct solbin *bin )
+{
+  uint64_t off = ALIGN( sizeof( *h ) );
+  uint64_t rows = h->rows;
+  char    *p = bin ? (char *) bin->base : NULL;
+  int      k;
+
+    if ( bin )
+        bin->head = (struct solbin_head *) p;
+
+    if ( h->kind == S_BIN_INPUT ) {
+        if ( bin ) bin->site = (struct solbin_site *) ( p + off );
+        off += ALIGN( h->nsite * (uint64_t) sizeof( struct solbin_site ) );
+        if ( bin ) bin->utc = (long long *) ( p + off );
+        off += ALIGN( rows * 8 );
+        if ( h->flags & S_BIN_SITEID ) {
+            if ( bin ) bin->siteid = (int *) ( p + off );
+            off += ALIGN( rows * 4 );
+        }
+        for ( k = 0; k < I_NIN; k++ )
+            if ( h->mask & ( 1u << k ) ) {
+                if ( bin ) bin->in[k] = (float *) ( p + off );
+                off += ALIGN( rows * 4 );
+            }
+    }
+    else {
+        if ( bin ) bin->retval = (long *) ( p + off );
+        off += ALIGN( rows * 8 );
+        for ( k = 0; k < C_NCOL; k++ )
+            if ( h->mask & ( 1u << k ) ) {
+                if ( bin ) bin->col[k] = (float *) ( p + off );
+                off += ALIGN( rows * 4 );
+            }
+    }
+    return off;
+}
@@ -0,0 +1,106 @@
+/*============================================================================
+*
+*    NAME:  solbin.h
+*
+*    Contains:
+*        S_bin_create  (creates and maps a batch file of a given shape)
+*        S_bin_open    (maps an existing batch file)
+*        S_bin_close   (unmaps a batch file)
+*        S_bin_put     (stores a posdata template as a site record)
+*        S_bin_site    (expands a site record into a posdata template)
+*        S_bin_batch   (points a batch at an input and an output file)
+*
+*    Binary columnar batch files, read and written through mmap with no
+*    parsing or formatting.  Every number is stored in the byte order
+*    of the machine that wrote it (checked on open), each section
+*    starts on a 64-byte boundary, and the sections follow the header
+*    in this order:
+*
+*      input file (S_BIN_INPUT)
+*        struct solbin_site [nsite]    site templates
+*        int64  [rows]                 UTC seconds since 1970
+*        int32  [rows]                 site index, if S_BIN_SITEID
+*        float  [rows]                 per input column in mask (I_*)
+*
+*      output file (S_BIN_OUTPUT)
+*        int64  [rows]                 S_solpos return codes
+*        float  [rows]                 per output column in mask (C_*)
+*
+*    The arrays are used in place as the columns of a struct solbatch,
+*    so the output can be computed straight into the mapped file.  The
+*    format assumes an LP64 machine (long is int64, int is int32);
+*    S_bin_open and S_bin_create refuse to work elsewhere.
+*
+*    Version 1.  A reader must reject a larger version; fields may only
+*    be added in the header's reserved space or as new sections after
+*    the existing ones, with a new version number.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solbin.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLBIN_H
+#define SOLBIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "solbatch.h"
+
+#define S_BIN_MAGIC    "SOLPOSB"
+#define S_BIN_VERSION  1
+#define S_BIN_ENDIAN   0x01020304u
+
+enum { S_BIN_INPUT = 1, S_BIN_OUTPUT = 2 };   /* kind */
+
+#define S_BIN_SITEID   1                      /* flags: site index present */
+
+struct solbin_head                  /* 64 bytes */
+{
+    char     magic[8];              /* S_BIN_MAGIC */
+    uint32_t version;
+    uint32_t endian;                /* S_BIN_ENDIAN as written */
+    uint32_t kind;
+    uint32_t nsite;                 /* input: site records */
+    uint32_t mask;                  /* input: I_ bits; output: S_COL bits */
+    uint32_t flags;
+    uint64_t rows;
+    uint64_t size;                  /* whole file, bytes */
+    uint8_t  reserved[16];
+};
+
+struct solbin_site                  /* 48 bytes */
+{
+    float    in[I_NIN];             /* latitude .. aspect */
+    int32_t  function;
+    int32_t  interval;
+    float    sbwid, sbrad, sbsky;
+    float    solcon;
+};
+
+struct solbin
+{
+    int                  fd;
+    void                *base;
+    size_t               size;
+    struct solbin_head  *head;
+    struct solbin_site  *site;      /* input only */
+    long long           *utc;       /* input only */
+    int                 *siteid;    /* input with S_BIN_SITEID, else NULL */
+    float               *in[I_NIN]; /* input columns in mask, else NULL */
+    long                *retval;    /* output only */
+    float               *col[C_NCOL]; /* output columns in mask, else NULL */
+};
+
+extern int  S_bin_create (const char *path, int kind, long rows, int nsite,
+                          unsigned mask, unsigned flags, struct solbin *bin);
+extern int  S_bin_open (const char *path, int writable, struct solbin *bin);
+extern void S_bin_close (struct solbin *bin);
+extern void S_bin_put (struct solbin_site *rec, const struct posdata *pd);
+extern void S_bin_site (const struct solbin_site *rec, struct posdata *pd);
+extern void S_bin_batch (const struct solbin *in, const struct solbin *out,
+                         const struct posdata *sites,
+                         struct solbatch *batch);
+
+#endif /* SOLBIN_H */
@@ -0,0 +1,417 @@
+/*============================================================================
+*    Contains:
+*        S_cache_init      (allocates a result cache over a set of sites)
+*        S_cache_get       (looks up one position, computing it on a miss)
+*        S_cache_put       (stores one computed position)
+*        S_cache_fill_day  (default miss hook: computes a whole site day)
+*        S_cache_stats     (hit, miss, fill and eviction counters)
+*        S_cache_free      (releases the memory held by a solcache)
+*
+*    Entries are seqlocks over relaxed atomics: a writer makes the
+*    sequence odd, stores the fields, and makes it even again; a reader
+*    accepts what it read only if it saw the same even sequence before
+*    and after.  Floats are kept as their bit patterns.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solcache.h"
+*
+*----------------------------------------------------------------------------*/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "solcache.h"
+
+#define RETRIES  4     /* seqlock re-reads before giving up on a way */
+
+static unsigned long long hash( int site, long long tq, int mask );
+static int  lookup( struct solcache *cache, int site, long long tq,
+                    int mask, float *out, long *retval );
+static long compute( struct solcache *cache, int site, long long tq,
+                     int mask, float *out );
+static long long local_day( const struct posdata *pd, long long utc );
+
+
+/*============================================================================
+*    Int function S_cache_init
+*
+*    Room for at least capacity positions; quantum in seconds.  Returns 0,
+*    or -1 if memory ran out (nothing is left allocated).
+*----------------------------------------------------------------------------*/
+int S_cache_init (struct solcache *cache, const struct posdata *sites,
+                  int nsite, long capacity, int quantum)
+{
+  struct solcache_shard *sh;
+  unsigned long slots, i;
+  int   s, k;
+
+    memset( cache, 0, sizeof( *cache ) );
+    cache->sites   = sites;
+    cache->nsite   = nsite;
+    cache->quantum = quantum > 0 ? quantum : 1;
+    cache->fill    = S_cache_fill_day;
+
+    cache->sets = 1;
+    while ( (long) ( cache->sets * S_C_SHARDS * S_C_WAYS ) < capacity )
+        cache->sets *= 2;
+    slots = cache->sets * S_C_WAYS;
+
+    for ( s = 0; s < S_C_SHARDS; s++ ) {
+        sh = &cache->shard[s];
+        sh->entry = (struct solcache_entry *) malloc( slots *
+                                                      sizeof( *sh->entry ) );
+        sh->hand  = (unsigned char *) calloc( cache->sets, 1 );
+        if ( sh->entry == NULL || sh->hand == NULL ) {
+            free( sh->entry );
+            free( sh->hand );
+            sh->entry = NULL;
+            sh->hand  = NULL;
+            S_cache_free( cache );
+            return -1;
+        }
+        pthread_mutex_init( &sh->lock, NULL );
+        for ( i = 0; i < slots; i++ ) {
+            atomic_init( &sh->entry[i].seq,  0 );
+            atomic_init( &sh->entry[i].site, -1 );
+            atomic_init( &sh->entry[i].mask, 0 );
+            atomic_init( &sh->entry[i].tq,   0 );
+            atomic_init( &sh->entry[i].ref,  0 );
+            for ( k = 0; k <= C_NCOL; k++ )
+                atomic_init( &sh->entry[i].val[k], 0 );
+        }
+        atomic_init( &sh->hits, 0 );
+        atomic_init( &sh->misses, 0 );
+        atomic_init( &sh->fills, 0 );
+        atomic_init( &sh->evictions, 0 );
+    }
+    for ( i = 0; i < S_C_DAYS; i++ )
+        atomic_init( &cache->filled[i], 0 );
+
+    return 0;
+}
+
+
+/*============================================================================
+*    Long integer function S_cache_get
+*
+*    Position of site at utc (quantized) for the function mask, written to
+*    out[C_NCOL] (columns the mask does not compute are left as S_solpos
+*    left them).  Returns the S_solpos return code, or -1 for a bad site
+*    index or if memory ran out.
+*----------------------------------------------------------------------------*/
+long S_cache_get (struct solcache *cache, int site, long long utc, int mask,
+                  float out[C_NCOL])
+{
+  struct solcache_shard *sh;
+  unsigned long long day;
+  long long tq;
+  long      retval;
+
+    if ( site < 0 || site >= cache->nsite )
+        return -1;
+
+    tq = utc / cache->quantum;
+    if ( utc < 0 && utc % cache->quantum )      /* round down */
+        tq--;
+    sh = &cache->shard[hash( site, tq, mask ) >> 58];
+
+    if ( lookup( cache, site, tq, mask, out, &retval ) ) {
+        atomic_fetch_add_explicit( &sh->hits, 1, memory_order_relaxed );
+        return retval;
+    }
+    atomic_fetch_add_explicit( &sh->misses, 1, memory_order_relaxed );
+
+    /* first miss of the site day: let the hook fill it.  The record is
+       direct mapped, so a collision only costs a repeated fill. */
+    day = hash( site, local_day( &cache->sites[site], tq * cache->quantum ),
+                mask ) | 1;
+    if ( cache->fill &&
+         atomic_exchange_explicit( &cache->filled[day % S_C_DAYS], day,
+                                   memory_order_relaxed ) != day ) {
+        atomic_fetch_add_explicit( &sh->fills, 1, memory_order_relaxed );
+        if ( cache->fill( cache, site, tq, mask ) >= 0 &&
+             lookup( cache, site, tq, mask, out, &retval ) )
+            return retval;
+    }
+
+    /* no hook, or the hook's entry was already displaced */
+    return compute( cache, site, tq, mask, out );
+}
+
+
+/*============================================================================
+*    Void function S_cache_put
+*
+*    Stores val[C_NCOL] and retval under (site, tq, mask), replacing an
+*    existing entry for the same key, an empty way, or the CLOCK victim of
+*    the set.  New entries start unreferenced, so prefetched positions
+*    nobody asks for are the first to go.
+*----------------------------------------------------------------------------*/
+void S_cache_put (struct solcache *cache, int site, long long tq, int mask,
+                  const float val[C_NCOL], long retval)
+{
+  unsigned long long h = hash( site, tq, mask );
+  struct solcache_shard *sh = &cache->shard[h >> 58];
+  struct solcache_entry *set, *e = NULL;
+  unsigned long sn = h & ( cache->sets - 1 );
+  unsigned int  seq, bits;
+  int   w, k;
+
+    pthread_mutex_lock( &sh->lock );
+    set = sh->entry + sn * S_C_WAYS;
+
+    for ( w = 0; w < S_C_WAYS && e == NULL; w++ ) {
+        k = atomic_load_explicit( &set[w].site, memory_order_relaxed );
+        if ( k < 0 ||
+             ( k == site &&
+               atomic_load_explicit( &set[w].tq, memory_order_relaxed ) == tq &&
+               atomic_load_explicit( &set[w].mask, memory_order_relaxed ) == mask ) )
+            e = &set[w];
+    }
+
+    while ( e == NULL ) {                       /* CLOCK sweep */
+        w = sh->hand[sn];
+        sh->hand[sn] = (unsigned char) ( ( w + 1 ) % S_C_WAYS );
+        if ( atomic_load_explicit( &set[w].ref, memory_order_relaxed ) )
+            atomic_store_explicit( &set[w].ref, 0, memory_order_relaxed );
+        else {
+            e = &set[w];
+            atomic_fetch_add_explicit( &sh->evictions, 1,
+                                       memory_order_relaxed );
+        }
+    }
+
+    seq = atomic_load_explicit( &e->seq, memory_order_relaxed );
+    atomic_store_explicit( &e->seq, seq + 1, memory_order_relaxed );
+    atomic_thread_fence( memory_order_release );
+
+    atomic_store_explicit( &e->site, site, memory_order_relaxed );
+    atomic_store_explicit( &e->tq,   tq,   memory_order_relaxed );
+    atomic_store_explicit( &e->mask, mask, memory_order_relaxed );
+    for ( k = 0; k < C_NCOL; k++ ) {
+        memcpy( &bits, &val[k], sizeof( bits ) );
+        atomic_store_explicit( &e->val[k], bits, memory_order_relaxed );
+    }
+    atomic_store_explicit( &e->val[C_NCOL], (unsigned int) retval,
+                           memory_order_relaxed );
+    atomic_store_explicit( &e->ref, 0, memory_order_relaxed );
+
+    atomic_store_explicit( &e->seq, seq + 2, memory_order_release );
+    pthread_mutex_unlock( &sh->lock );
+}
+
+
+/*============================================================================
+*    Long integer function S_cache_fill_day
+*
+*    Default miss hook.  Computes every quantum of the site's local
+*    standard day containing tq in one batch and stores them all.
+*    Returns the number of positions stored, or -1 if memory ran out.
+*----------------------------------------------------------------------------*/
+long S_cache_fill_day (struct solcache *cache, int site, long long tq,
+                       int mask)
+{
+  struct solbatch batch;
+  struct posdata  pd;
+  long long *utc, day, off, t0;
+  float     *colbuf, val[C_NCOL];
+  long      *retval;
+  long       n, i;
+  int        q = cache->quantum, k;
+
+    pd = cache->sites[site];
+    pd.function = mask;
+
+    /* local standard day containing the quantum's start */
+    off = (long long) floor( pd.timezone * 3600.0 + 0.5 );
+    day = local_day( &pd, tq * q ) * 86400 - off;
+    t0  = day >= 0 ? ( day + q - 1 ) / q : day / q;     /* first quantum */
+    n   = (long) ( ( day + 86400 - t0 * q + q - 1 ) / q );
+
+    utc    = (long long *) malloc( n * sizeof( *utc ) );
+    retval = (long *) malloc( n * sizeof( *retval ) );
+    colbuf = (float *) malloc( n * C_NCOL * sizeof( float ) );
+    if ( utc == NULL || retval == NULL || colbuf == NULL ) {
+        free( utc );
+        free( retval );
+        free( colbuf );
+        return -1;
+    }
+
+    memset( &batch, 0, sizeof( batch ) );
+    batch.count  = n;
+    batch.utc    = utc;
+    batch.sites  = &pd;
+    batch.retval = retval;
+    for ( k = 0; k < C_NCOL; k++ )
+        batch.col[k] = colbuf + k * n;
+    for ( i = 0; i < n; i++ )
+        utc[i] = ( t0 + i ) * q;
+
+    S_batch( &batch, 0, n );
+
+    for ( i = 0; i < n; i++ ) {
+        for ( k = 0; k < C_NCOL; k++ )
+            val[k] = batch.col[k][i];
+        S_cache_put( cache, site, t0 + i, mask, val, retval[i] );
+    }
+
+    free( utc );
+    free( retval );
+    free( colbuf );
+    return n;
+}
+
+
+/*============================================================================
+*    Void function S_cache_stats
+*
+*    Counter totals over all shards.  Taken while other threads run, the
+*    counters are each exact but not a consistent snapshot.
+*----------------------------------------------------------------------------*/
+void S_cache_stats (struct solcache *cache, struct solcache_stats *stats)
+{
+  struct solcache_shard *sh;
+  int s;
+
+    memset( stats, 0, sizeof( *stats ) );
+    for ( s = 0; s < S_C_SHARDS; s++ ) {
+        sh = &cache->shard[s];
+        stats->hits      += atomic_load( &sh->hits );
+        stats->misses    += atomic_load( &sh->misses );
+        stats->fills     += atomic_load( &sh->fills );
+        stats->evictions += atomic_load( &sh->evictions );
+    }
+}
+
+
+/*============================================================================
+*    Void function S_cache_free
+*----------------------------------------------------------------------------*/
+void S_cache_free (struct solcache *cache)
+{
+  int s;
+
+    for ( s = 0; s < S_C_SHARDS; s++ ) {
+        if ( cache->shard[s].entry == NULL )
+            continue;
+        pthread_mutex_destroy( &cache->shard[s].lock );
+        free( cache->shard[s].entry );
+        free( cache->shard[s].hand );
+        cache->shard[s].entry = NULL;
+        cache->shard[s].hand  = NULL;
+    }
+}
+
+
+/*============================================================================
+*    Local unsigned long long function hash
+*
+*    Top 6 bits pick the shard, low bits the set
+*----------------------------------------------------------------------------*/
+static unsigned long long hash( int site, long long tq, int mask )
+{
+  unsigned long long h;
+
+    h  = (unsigned long long) tq * 0x9E3779B97F4A7C15ULL;
+    h ^= (unsigned long long) (unsigned int) site * 0xC2B2AE3D27D4EB4FULL;
+    h ^= (unsigned long long) (unsigned int) mask * 0x165667B19E3779F9ULL;
+    h ^= h >> 31;                         /* splitmix64 finalizer */
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h;
+}
+
+
+/*============================================================================
+*    Local Int function lookup
+*
+*    Lock-free probe of the key's set.  Returns 1 and fills out and
+*    retval on a hit, 0 otherwise.
+*----------------------------------------------------------------------------*/
+static int lookup( struct solcache *cache, int site, long long tq, int mask,
+                   float *out, long *retval )
+{
+  unsigned long long h = hash( site, tq, mask );
+  struct solcache_entry *set, *e;
+  unsigned int s1, s2, bits[C_NCOL + 1];
+  int   w, k, r, hit;
+
+    set = cache->shard[h >> 58].entry + ( h & ( cache->sets - 1 ) ) * S_C_WAYS;
+
+    for ( w = 0; w < S_C_WAYS; w++ ) {
+        e = &set[w];
+        for ( r = 0; r < RETRIES; r++ ) {
+            s1 = atomic_load_explicit( &e->seq, memory_order_acquire );
+            if ( s1 & 1 )
+                continue;
+            hit = atomic_load_explicit( &e->site, memory_order_relaxed ) == site &&
+                  atomic_load_explicit( &e->tq, memory_order_relaxed ) == tq &&
+                  atomic_load_explicit( &e->mask, memory_order_relaxed ) == mask;
+            if ( hit )
+                for ( k = 0; k <= C_NCOL; k++ )
+                    bits[k] = atomic_load_explicit( &e->val[k],
+                                                    memory_order_relaxed );
+            atomic_thread_fence( memory_order_acquire );
+            s2 = atomic_load_explicit( &e->seq, memory_order_relaxed );
+            if ( s1 != s2 )
+                continue;
+            if ( !hit )
+                break;
+
+            memcpy( out, bits, C_NCOL * sizeof( float ) );
+            *retval = (long) bits[C_NCOL];
+            if ( !atomic_load_explicit( &e->ref, memory_order_relaxed ) )
+                atomic_store_explicit( &e->ref, 1, memory_order_relaxed );
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/*============================================================================
+*    Local Long integer function compute
+*
+*    Computes and stores a single position (one-row batch)
+*----------------------------------------------------------------------------*/
+static long compute( struct solcache *cache, int site, long long tq,
+                     int mask, float *out )
+{
+  struct solbatch batch;
+  struct posdata  pd;
+  long long utc = tq * cache->quantum;
+  long      retval;
+  int       k;
+
+    pd = cache->sites[site];
+    pd.function = mask;
+
+    memset( &batch, 0, sizeof( batch ) );
+    batch.count  = 1;
+    batch.utc    = &utc;
+    batch.sites  = &pd;
+    batch.retval = &retval;
+    for ( k = 0; k < C_NCOL; k++ )
+        batch.col[k] = &out[k];
+
+    S_batch( &batch, 0, 1 );
+    S_cache_put( cache, site, tq, mask, out, retval );
+    return retval;
+}
+
+
+/*============================================================================
+*    Local long long function local_day
+*
+*    Days since 1970 of the local standard date at utc
+*----------------------------------------------------------------------------*/
+static long long local_day( const struct posdata *pd, long long utc )
+{
+  long long t = utc + (long long) floor( pd->timezone * 3600.0 + 0.5 );
+
+    return t >= 0 ? t / 86400 : ( t - 86399 ) / 86400;
+}
@@ -0,0 +1,114 @@
+/*============================================================================
+*
+*    NAME:  solcache.h
+*
+*    Contains:
+*        S_cache_init      (allocates a result cache over a set of sites)
+*        S_cache_get       (looks up one position, computing it on a miss)
+*        S_cache_put       (stores one computed position)
+*        S_cache_fill_day  (default miss hook: computes a whole site day)
+*        S_cache_stats     (hit, miss, fill and eviction counters)
+*        S_cache_free      (releases the memory held by a solcache)
+*
+*    A concurrent cache of S_solpos results keyed by (site index,
+*    quantized time, function mask).  Time is UTC seconds quantized down
+*    to a multiple of quantum; a cached position is the one computed at
+*    the start of its quantum.  Sites are posdata templates as in
+*    solbatch.h; the function mask of a query replaces the template's.
+*
+*    The cache is split into S_C_SHARDS shards, each a table of sets of
+*    S_C_WAYS entries.  Lookups take no locks: each entry is guarded by a
+*    sequence counter and a reader simply retries (or misses) if it sees
+*    a write in progress.  Stores lock only their shard.  When a set is
+*    full, the entry to replace is chosen by CLOCK (second chance): every
+*    hit sets the entry's reference bit, and the set's hand clears bits
+*    until it finds an entry not used since its last pass.
+*
+*    On the first miss for a site day (local standard day, per function
+*    mask) S_cache_get calls the cache's fill hook, if any; later misses
+*    that day, e.g. for positions the hook's entries lost to eviction,
+*    compute just the one position.  The default hook,
+*    S_cache_fill_day, computes the site's whole local standard day at
+*    quantum spacing with the batch engine, so a dashboard asking for one
+*    minute pays once for the day.  Any function with the same signature
+*    may be installed in fill; it should store through S_cache_put.
+*
+*    S_cache_get, S_cache_put and S_cache_stats may be called from any
+*    number of threads.  S_cache_init and S_cache_free may not overlap
+*    other calls.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solcache.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLCACHE_H
+#define SOLCACHE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "solbatch.h"
+
+#define S_C_SHARDS  64
+#define S_C_WAYS    8
+#define S_C_DAYS    4096     /* remembered (site, day, mask) fills */
+
+struct solcache;
+
+typedef long (*S_cache_fill_fn) (struct solcache *cache, int site,
+                                 long long tq, int mask);
+
+struct solcache_entry
+{
+    atomic_uint       seq;            /* odd while being written */
+    atomic_int        site;           /* -1 if empty */
+    atomic_int        mask;
+    atomic_llong      tq;             /* utc / quantum */
+    atomic_uint       val[C_NCOL + 1];/* column bits, then retval */
+    atomic_uchar      ref;            /* CLOCK reference bit */
+};
+
+struct solcache_shard
+{
+    _Alignas(64) pthread_mutex_t lock;    /* writers only */
+    struct solcache_entry *entry;         /* sets * S_C_WAYS */
+    unsigned char *hand;                  /* CLOCK hand per set */
+    atomic_ulong   hits;
+    atomic_ulong   misses;
+    atomic_ulong   fills;                 /* fill hook calls */
+    atomic_ulong   evictions;
+};
+
+struct solcache
+{
+    const struct posdata *sites;   /* site templates */
+    int            nsite;
+    int            quantum;        /* seconds */
+    unsigned long  sets;           /* per shard, a power of 2 */
+    S_cache_fill_fn fill;          /* miss hook, NULL = none */
+    atomic_ullong  filled[S_C_DAYS];   /* day keys the hook has run for */
+    struct solcache_shard shard[S_C_SHARDS];
+};
+
+struct solcache_stats
+{
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long fills;
+    unsigned long evictions;
+};
+
+extern int  S_cache_init (struct solcache *cache, const struct posdata *sites,
+                          int nsite, long capacity, int quantum);
+extern long S_cache_get (struct solcache *cache, int site, long long utc,
+                         int mask, float out[C_NCOL]);
+extern void S_cache_put (struct solcache *cache, int site, long long tq,
+                         int mask, const float val[C_NCOL], long retval);
+extern long S_cache_fill_day (struct solcache *cache, int site,
+                              long long tq, int mask);
+extern void S_cache_stats (struct solcache *cache,
+                           struct solcache_stats *stats);
+extern void S_cache_free (struct solcache *cache);
+
+#endif /* SOLCACHE_H */
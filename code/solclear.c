@@ -0,0 +1,295 @@
+/*============================================================================
+*    Contains:
+*        S_clear_site  (clear-sky parameters of a site, with defaults)
+*        S_clear       (clear-sky GHI, DNI and DHI for rows of a batch)
+*        S_clear_name  (name of a model)
+*
+*    Each model is a kernel over a run of rows of one site.  The sun
+*    being down is handled by selects, not branches: the formulas are
+*    evaluated with harmless stand-in values (coszen and air mass 1) and
+*    the result replaced by 0, so every loop body is straight-line code.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solclear.h"
+*
+*----------------------------------------------------------------------------*/
+#include <math.h>
+#include <stddef.h>
+#include "solclear.h"
+#include "solvec.h"
+
+static const char *modelname[K_NMODEL] = { "ineichen", "bird", "cumcm" };
+
+static void ineichen( const struct solclear_site *cs, long n,
+                      const float *restrict coszen,
+                      const float *restrict ampress,
+                      const float *restrict etrn,
+                      const float *restrict linke,
+                      float *restrict ghi, float *restrict dni,
+                      float *restrict dhi );
+static void bird( const struct solclear_site *cs, long n,
+                  const float *restrict coszen,
+                  const float *restrict amass,
+                  const float *restrict ampress,
+                  const float *restrict etrn,
+                  float *restrict ghi, float *restrict dni,
+                  float *restrict dhi );
+static void cumcm( const struct solclear_site *cs, long n,
+                   const float *restrict coszen,
+                   const float *restrict etrn,
+                   float *restrict ghi, float *restrict dni,
+                   float *restrict dhi );
+
+
+/*============================================================================
+*    Void function S_clear_site
+*
+*    Linke turbidity 3, ozone 0.3 cm, precipitable water 1.5 cm, aerosol
+*    optical depth 0.15 at 380 nm and 0.1 at 500 nm, albedo 0.2, and the
+*    altitude of the standard atmosphere at the site's press (sea level
+*    if site is NULL)
+*----------------------------------------------------------------------------*/
+void S_clear_site (struct solclear_site *cs, const struct posdata *site)
+{
+  double press = site ? site->press : 1013.25;
+
+    cs->linke    = 3.0;
+    cs->altitude = 44331.5 * ( 1.0 - pow( press / 1013.25, 0.190263 ) );
+    cs->ozone    = 0.3;
+    cs->water    = 1.5;
+    cs->aod380   = 0.15;
+    cs->aod500   = 0.1;
+    cs->albedo   = 0.2;
+}
+
+
+/*============================================================================
+*    Long integer function S_clear
+*
+*    Clear-sky irradiance (W/sq m) of rows first .. last-1 of a computed
+*    batch, with cs[site] the parameters of each of the batch's sites.
+*    linke, if not NULL, gives K_INEICHEN a Linke turbidity per row
+*    (from a monthly table, say) in place of the site's.  The batch must
+*    have the columns the model reads.  Returns the rows computed, or -1
+*    for an unknown model or a missing column.
+*----------------------------------------------------------------------------*/
+long S_clear (int model, const struct solbatch *batch,
+              const struct solclear_site *cs, const float *linke,
+              long first, long last, float *ghi, float *dni, float *dhi)
+{
+  float * const *col = batch->col;
+  long  i, j;
+  int   s;
+
+    if ( model < 0 || model >= K_NMODEL || !col[C_COSZEN] || !col[C_ETRN] ||
+         ( model == K_INEICHEN && !col[C_AMPRESS] ) ||
+         ( model == K_BIRD && ( !col[C_AMASS] || !col[C_AMPRESS] ) ) )
+        return -1;
+
+    for ( i = first; i < last; i = j ) {
+        s = batch->site ? batch->site[i] : 0;
+        for ( j = i + 1; j < last && batch->site && batch->site[j] == s; j++ )
+            ;
+        if ( !batch->site )
+            j = last;
+
+        switch ( model ) {
+        case K_INEICHEN:
+            ineichen( &cs[s], j - i, col[C_COSZEN] + i, col[C_AMPRESS] + i,
+                      col[C_ETRN] + i, linke ? linke + i : NULL, ghi + i,
+                      dni + i, dhi + i );
+            break;
+        case K_BIRD:
+            bird( &cs[s], j - i, col[C_COSZEN] + i, col[C_AMASS] + i,
+                  col[C_AMPRESS] + i, col[C_ETRN] + i, ghi + i, dni + i,
+                  dhi + i );
+            break;
+        case K_CUMCM:
+            cumcm( &cs[s], j - i, col[C_COSZEN] + i, col[C_ETRN] + i,
+                   ghi + i, dni + i, dhi + i );
+            break;
+        }
+    }
+    return last - first;
+}
+
+
+/*============================================================================
+*    Const char pointer function S_clear_name
+*----------------------------------------------------------------------------*/
+const char *S_clear_name (int model)
+{
+    return model >= 0 && model < K_NMODEL ? modelname[model] : NULL;
+}
+
+
+/*============================================================================
+*    Local Void function ineichen
+*
+*    Ineichen, P., and R. Perez.  2002.  A new airmass independent
+*    formulation for the Linke turbidity coefficient.  Solar Energy 73
+*    (3), pp. 151-157, with the altitude terms as in pvlib.  One row is
+*    ineichen1; the loop is written twice so that neither copy asks
+*    whether there is a per-row turbidity (which stops vectorizing).
+*----------------------------------------------------------------------------*/
+struct clear3 { float ghi, dni, dhi; };
+
+static inline struct clear3 ineichen1( float fh1, float fh2, float cg1,
+                                       float cg2, float b, float k2,
+                                       float coszen, float ampress,
+                                       float etrn, float tl )
+{
+  struct clear3 r;
+  int32_t up = -( ( coszen > 0.0f ) & ( ampress > 0.0f ) );
+  float   cz = vsel( up, coszen, 1.0f );
+  float   am = vsel( up, ampress, 1.0f );
+  float   g, bn, bn2, d;
+
+    g   = cg1 * etrn * cz *
+          vexp( -cg2 * am * ( fh1 + fh2 * ( tl - 1.0f ) ) );
+    bn  = b * etrn * vexp( -0.09f * am * ( tl - 1.0f ) );
+    bn2 = g * ( 1.0f - ( 0.1f - 0.2f * vexp( -tl ) ) / k2 ) / cz;
+    d   = vsel( -( bn < bn2 ), bn, bn2 );
+    d   = vsel( -( d > 0.0f ) & up, d, 0.0f );
+    r.ghi = vsel( up, g, 0.0f );
+    r.dni = d;
+    r.dhi = vsel( up, g - d * cz, 0.0f );
+    return r;
+}
+
+static void ineichen( const struct solclear_site *cs, long n,
+                      const float *restrict coszen,
+                      const float *restrict ampress,
+                      const float *restrict etrn,
+                      const float *restrict linke,
+                      float *restrict ghi, float *restrict dni,
+                      float *restrict dhi )
+{
+  float h   = cs->altitude, tl = cs->linke;
+  float fh1 = exp( -h / 8000.0 );
+  float fh2 = exp( -h / 1250.0 );
+  float cg1 = 5.09e-5 * h + 0.868;
+  float cg2 = 3.92e-5 * h + 0.0387;
+  float b   = 0.664 + 0.163 / fh1;
+  float k2  = 0.1 + 0.882 / fh1;
+  struct clear3 r;
+  long  i;
+
+    if ( linke )
+        for ( i = 0; i < n; i++ ) {
+            r = ineichen1( fh1, fh2, cg1, cg2, b, k2, coszen[i], ampress[i],
+                           etrn[i], linke[i] );
+            ghi[i] = r.ghi;
+            dni[i] = r.dni;
+            dhi[i] = r.dhi;
+        }
+    else
+        for ( i = 0; i < n; i++ ) {
+            r = ineichen1( fh1, fh2, cg1, cg2, b, k2, coszen[i], ampress[i],
+                           etrn[i], tl );
+            ghi[i] = r.ghi;
+            dni[i] = r.dni;
+            dhi[i] = r.dhi;
+        }
+}
+
+
+/*============================================================================
+*    Local Void function bird
+*
+*    Bird, R. E., and R. L. Hulstrom.  1981.  A simplified clear sky
+*    model for direct and diffuse insolation on horizontal surfaces.
+*    SERI/TR-642-761.  Relative air mass for ozone, water and aerosol,
+*    pressure-corrected for Rayleigh scattering and the mixed gases.
+*
+*    The terms m - m^k (k = 1.01, 1.02, 1.06) nearly cancel at low sun,
+*    so they are taken as -m expm1( (k - 1) ln m ), by xm1 below.
+*----------------------------------------------------------------------------*/
+static inline float xm1( float u )     /* expm1( u ) for |u| < 0.25 */
+{
+    return u * ( 1.0f + u * ( 0.5f + u * ( 1.6666667e-1f + u *
+           ( 4.1666668e-2f + u * ( 8.3333338e-3f + u * 1.3888889e-3f ) ) ) ) );
+}
+
+static void bird( const struct solclear_site *cs, long n,
+                  const float *restrict coszen,
+                  const float *restrict amass,
+                  const float *restrict ampress,
+                  const float *restrict etrn,
+                  float *restrict ghi, float *restrict dni,
+                  float *restrict dhi )
+{
+  const float ba = 0.84;                  /* forward scattered fraction */
+  float taua = 0.2758 * cs->aod380 + 0.35 * cs->aod500;
+  float tak  = pow( taua, 0.873 ) * ( 1.0 + taua - pow( taua, 0.7088 ) );
+  float uo = cs->ozone, w = cs->water, rho = cs->albedo;
+  float cz, am, amp, lm, lp, tr, to, tum, tw, ta, taa, rs, id, ias, xo, xw,
+        g;
+  int32_t up;
+  long  i;
+
+    for ( i = 0; i < n; i++ ) {
+        up  = -( ( coszen[i] > 0.0f ) & ( amass[i] > 0.0f ) );
+        cz  = vsel( up, coszen[i], 1.0f );
+        am  = vsel( up, amass[i], 1.0f );
+        amp = vsel( up, ampress[i], 1.0f );
+
+        lm  = vlog( am );
+        lp  = vlog( amp );
+        tr  = vexp( -0.0903f * vexp( 0.84f * lp ) *
+                    ( 1.0f - amp * xm1( 0.01f * lp ) ) );
+        xo  = uo * am;
+        to  = 1.0f - 0.1611f * xo * vpow( 1.0f + 139.48f * xo, -0.3034f ) -
+              0.002715f * xo / ( 1.0f + 0.044f * xo + 0.0003f * xo * xo );
+        tum = vexp( -0.0127f * vexp( 0.26f * lp ) );
+        xw  = w * am;
+        tw  = 1.0f - 2.4959f * xw /
+              ( vpow( 1.0f + 79.034f * xw, 0.6828f ) + 6.385f * xw );
+        ta  = vexp( -tak * vexp( 0.9108f * lm ) );
+        taa = 1.0f - 0.1f * ( 1.0f + am * xm1( 0.06f * lm ) ) * ( 1.0f - ta );
+        rs  = 0.0685f + ( 1.0f - ba ) * ( 1.0f - ta / taa );
+
+        id  = 0.9662f * etrn[i] * tr * to * tum * tw * ta;
+        ias = etrn[i] * cz * 0.79f * to * tw * tum * taa *
+              ( 0.5f * ( 1.0f - tr ) + ba * ( 1.0f - ta / taa ) ) /
+              ( 1.0f + am * xm1( 0.02f * lm ) );
+        g   = ( id * cz + ias ) / ( 1.0f - rho * rs );
+
+        ghi[i] = vsel( up, g, 0.0f );
+        dni[i] = vsel( up, id, 0.0f );
+        dhi[i] = vsel( up, g - id * cz, 0.0f );
+    }
+}
+
+
+/*============================================================================
+*    Local Void function cumcm
+*
+*    DNI = G0 [a + b exp( -c / sin(alpha) )], the coefficients from the
+*    altitude in km
+*----------------------------------------------------------------------------*/
+static void cumcm( const struct solclear_site *cs, long n,
+                   const float *restrict coszen,
+                   const float *restrict etrn,
+                   float *restrict ghi, float *restrict dni,
+                   float *restrict dhi )
+{
+  float h = cs->altitude / 1000.0;
+  float a = 0.4237 - 0.00821 * ( 6.0 - h ) * ( 6.0 - h );
+  float b = 0.5055 + 0.00595 * ( 6.5 - h ) * ( 6.5 - h );
+  float c = 0.2711 + 0.01858 * ( 2.5 - h ) * ( 2.5 - h );
+  float cz, d;
+  int32_t up;
+  long  i;
+
+    for ( i = 0; i < n; i++ ) {
+        up = -( coszen[i] > 0.0f );
+        cz = vsel( up, coszen[i], 1.0f );
+        d  = etrn[i] * ( a + b * vexp( -c / cz ) );
+        dni[i] = vsel( up, d, 0.0f );
+        ghi[i] = vsel( up, d * cz, 0.0f );
+        dhi[i] = 0.0f;
+    }
+}
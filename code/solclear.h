@@ -0,0 +1,67 @@
+/*============================================================================
+*
+*    NAME:  solclear.h
+*
+*    Contains:
+*        S_clear_site  (clear-sky parameters of a site, with defaults)
+*        S_clear       (clear-sky GHI, DNI and DHI for rows of a batch)
+*        S_clear_name  (name of a model)
+*
+*    Clear-sky irradiance computed from the outputs of a batch
+*    (solbatch.h) that has already been run: the models read the coszen,
+*    amass, ampress and etrn columns and never call S_solpos again.
+*
+*        K_INEICHEN  Ineichen and Perez (2002), with the Linke turbidity
+*                    at air mass 2 and the site altitude; uses ampress,
+*                    coszen and etrn
+*        K_BIRD      Bird and Hulstrom (1981), with ozone, precipitable
+*                    water, aerosol optical depth at 380 and 500 nm and
+*                    ground albedo; uses amass, ampress, coszen and etrn
+*        K_CUMCM     the altitude-dependent DNI of the national modeling
+*                    competition, G0 [a + b exp( -c / sin(alpha) )] with
+*                        a = 0.4237 - 0.00821 (6.0 - H)^2
+*                        b = 0.5055 + 0.00595 (6.5 - H)^2
+*                        c = 0.2711 + 0.01858 (2.5 - H)^2
+*                    for H the altitude in km, alpha the refracted solar
+*                    elevation (sin alpha = coszen) and G0 = etrn; GHI
+*                    is the beam on the horizontal and DHI 0
+*
+*    All three give 0 while the sun is below the horizon.  Rows are
+*    taken in runs of one site, so the site's parameters are constants
+*    inside the loops; the loops are branch-free with restrict pointers
+*    and the float exp and log of solvec.h, and vectorize (at -O3, or -O2
+*    -ftree-vectorize) the way soltilt.c's sweep does.  The kernels
+*    agree with double-precision libm formulas to a few float ulps.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solclear.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLCLEAR_H
+#define SOLCLEAR_H
+
+#include "solbatch.h"
+
+enum { K_INEICHEN, K_BIRD, K_CUMCM, K_NMODEL };      /* model */
+
+struct solclear_site
+{
+    float linke;          /* Linke turbidity, air mass 2 (K_INEICHEN) */
+    float altitude;       /* m (K_INEICHEN, K_CUMCM) */
+    float ozone;          /* cm (K_BIRD) */
+    float water;          /* precipitable water, cm (K_BIRD) */
+    float aod380, aod500; /* aerosol optical depth (K_BIRD) */
+    float albedo;         /* ground (K_BIRD) */
+};
+
+extern void        S_clear_site (struct solclear_site *cs,
+                                 const struct posdata *site);
+extern long        S_clear (int model, const struct solbatch *batch,
+                            const struct solclear_site *cs,
+                            const float *linke, long first, long last,
+                            float *ghi, float *dni, float *dhi);
+extern const char *S_clear_name (int model);
+
+#endif /* SOLCLEAR_H */
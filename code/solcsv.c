@@ -0,0 +1,502 @@
+/*============================================================================
+*    Contains:
+*        S_csv_open        (starts reading a delimited text file)
+*        S_csv_map         (maps a field to a column number)
+*        S_csv_map_header  (maps fields by the names in the header line)
+*        S_csv_block_init  (allocates a block of rows)
+*        S_csv_read        (reads the next block of rows)
+*        S_csv_batch       (points a batch at a block)
+*        S_csv_block_free  (releases a block)
+*        S_csv_free        (releases the reader's buffer)
+*        S_csv_field       (default header name of a field)
+*
+*    Lines are taken from the read buffer in place; only the partial
+*    line at the end of the buffer is moved, when the buffer is refilled.
+*    A line longer than the whole buffer is skipped.  Only the columns
+*    up to the last mapped one are looked at, and only mapped cells are
+*    converted.
+*
+*    Numbers of up to 19 significant digits with a decimal exponent
+*    within 10^+-22 are converted with one integer pass and one exact
+*    power-of-ten multiply or divide, which rounds once; everything
+*    else goes to strtod.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solcsv.h"
+*
+*----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include "solcsv.h"
+
+static const char *fieldname[F_NFIELD] = {
+    "year", "month", "day", "hour", "minute", "second",
+    "latitude", "longitude", "timezone", "press", "temp", "tilt",
+    "aspect" };
+
+static const double p10[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static int       nextline( struct solcsv *csv, const char **s, const char **e );
+static int       number( const char *p, const char *q, double *v );
+static int       row( struct solcsv *csv, const char *s, const char *e,
+                      struct solcsv_block *blk, const float *def );
+static long long civil( long year, int month, int day );
+
+
+/*============================================================================
+*    Int function S_csv_open
+*
+*    site is the template for unmapped fields (S_init defaults if NULL);
+*    bufsize 0 means S_CSV_BUF.  Returns 0, or -1 if out of memory.
+*----------------------------------------------------------------------------*/
+int S_csv_open (struct solcsv *csv, int fd, char delim,
+                const struct posdata *site, size_t bufsize)
+{
+    memset( csv, 0, sizeof( *csv ) );
+    memset( csv->field, -1, sizeof( csv->field ) );
+    csv->fd    = fd;
+    csv->delim = delim;
+    if ( site )
+        csv->site = *site;
+    else
+        S_init( &csv->site );
+
+    csv->cap = bufsize ? bufsize : S_CSV_BUF;
+    if ( (csv->buf = (char *) malloc( csv->cap )) == NULL )
+        return -1;
+    return 0;
+}
+
+
+/*============================================================================
+*    Int function S_csv_map
+*
+*    Maps field to column (0 is the first); column -1 unmaps it.
+*    Returns 0, or -1 for a bad field or column.
+*----------------------------------------------------------------------------*/
+int S_csv_map (struct solcsv *csv, int field, int column)
+{
+  int c;
+
+    if ( field < 0 || field >= F_NFIELD || column >= S_CSV_MAXCOL )
+        return -1;
+
+    for ( c = 0; c < S_CSV_MAXCOL; c++ )
+        if ( csv->field[c] == field )
+            csv->field[c] = -1;
+    csv->mapped &= ~( 1u << field );
+    if ( column >= 0 ) {
+        csv->field[column] = (signed char) field;
+        csv->mapped |= 1u << field;
+    }
+
+    for ( csv->ncol = 0, c = 0; c < S_CSV_MAXCOL; c++ )
+        if ( csv->field[c] >= 0 )
+            csv->ncol = c + 1;
+    return 0;
+}
+
+
+/*============================================================================
+*    Int function S_csv_map_header
+*
+*    Reads the next line as a header and maps every field whose name
+*    (names[field], or S_csv_field if names is NULL; NULL entries are
+*    left alone) matches a cell, ignoring case, blanks and quotes.
+*    Returns the number of fields mapped, or -1 if there is no line.
+*----------------------------------------------------------------------------*/
+int S_csv_map_header (struct solcsv *csv, const char * const *names)
+{
+  const char *s, *e, *p, *q, *name;
+  size_t len;
+  int    col, f, n = 0;
+
+    if ( nextline( csv, &s, &e ) <= 0 )
+        return -1;
+
+    for ( col = 0, p = s; col < S_CSV_MAXCOL; col++ ) {
+        if ( (q = (const char *) memchr( p, csv->delim, e - p )) == NULL )
+            q = e;
+
+        /* the cell, trimmed of blanks and one pair of quotes */
+        while ( p < q && ( *p == ' ' || *p == '\t' ) )
+            p++;
+        len = q - p;
+        while ( len > 0 && ( p[len - 1] == ' ' || p[len - 1] == '\t' ) )
+            len--;
+        if ( len >= 2 && *p == '"' && p[len - 1] == '"' ) {
+            p++;
+            len -= 2;
+        }
+
+        for ( f = 0; f < F_NFIELD; f++ ) {
+            name = names ? names[f] : fieldname[f];
+            if ( name && strlen( name ) == len &&
+                 strncasecmp( name, p, len ) == 0 &&
+                 !( csv->mapped & ( 1u << f ) ) ) {
+                S_csv_map( csv, f, col );
+                n++;
+                break;
+            }
+        }
+
+        if ( q == e )
+            break;
+        p = q + 1;
+    }
+    return n;
+}
+
+
+/*============================================================================
+*    Int function S_csv_block_init
+*
+*    Returns 0, or -1 if out of memory
+*----------------------------------------------------------------------------*/
+int S_csv_block_init (struct solcsv_block *blk, long cap)
+{
+  int k;
+
+    memset( blk, 0, sizeof( *blk ) );
+    blk->cap = cap > 0 ? cap : 1;
+    blk->utc = (long long *) malloc( blk->cap * sizeof( long long ) );
+    if ( blk->utc == NULL )
+        return -1;
+    for ( k = 0; k < I_NIN; k++ )
+        if ( (blk->in[k] = (float *) malloc( blk->cap * sizeof( float ) ))
+             == NULL ) {
+            S_csv_block_free( blk );
+            return -1;
+        }
+    return 0;
+}
+
+
+/*============================================================================
+*    Long integer function S_csv_read
+*
+*    Fills blk with up to blk->cap rows.  Returns the number of rows, 0
+*    at the end of the file, or -1 if read() failed before any row.
+*----------------------------------------------------------------------------*/
+long S_csv_read (struct solcsv *csv, struct solcsv_block *blk)
+{
+  const struct posdata *t = &csv->site;
+  const char *s, *e;
+  float def[I_NIN];
+  int   got = 0;
+
+    def[I_LATITUDE]  = t->latitude;
+    def[I_LONGITUDE] = t->longitude;
+    def[I_TIMEZONE]  = t->timezone;
+    def[I_PRESS]     = t->press;
+    def[I_TEMP]      = t->temp;
+    def[I_TILT]      = t->tilt;
+    def[I_ASPECT]    = t->aspect;
+
+    for ( blk->n = 0; blk->n < blk->cap; ) {
+        if ( (got = nextline( csv, &s, &e )) <= 0 )
+            break;
+        if ( s == e )                         /* blank line */
+            continue;
+        if ( row( csv, s, e, blk, def ) )
+            blk->n++;
+        else {
+            csv->skipped++;
+            if ( csv->firstbad == 0 )
+                csv->firstbad = csv->line;
+        }
+    }
+
+    csv->rows += blk->n;
+    return ( got < 0 && blk->n == 0 ) ? -1 : blk->n;
+}
+
+
+/*============================================================================
+*    Void function S_csv_batch
+*
+*    Sets the rows, times, site and input columns of batch to those of
+*    blk; the output columns and retval are left to the caller.
+*----------------------------------------------------------------------------*/
+void S_csv_batch (const struct solcsv *csv, const struct solcsv_block *blk,
+                  struct solbatch *batch)
+{
+  int k;
+
+    batch->count = blk->n;
+    batch->utc   = blk->utc;
+    batch->site  = NULL;
+    batch->sites = &csv->site;
+    for ( k = 0; k < I_NIN; k++ )
+        batch->in[k] = ( csv->mapped & ( 1u << ( F_INPUT + k ) ) )
+                       ? blk->in[k] : NULL;
+}
+
+
+/*============================================================================
+*    Void function S_csv_block_free
+*----------------------------------------------------------------------------*/
+void S_csv_block_free (struct solcsv_block *blk)
+{
+  int k;
+
+    free( blk->utc );
+    for ( k = 0; k < I_NIN; k++ )
+        free( blk->in[k] );
+    memset( blk, 0, sizeof( *blk ) );
+}
+
+
+/*============================================================================
+*    Void function S_csv_free
+*
+*    Releases the buffer; the file descriptor is the caller's.
+*----------------------------------------------------------------------------*/
+void S_csv_free (struct solcsv *csv)
+{
+    free( csv->buf );
+    csv->buf = NULL;
+}
+
+
+/*============================================================================
+*    Const char pointer function S_csv_field
+*
+*    Default header name of a field, or NULL
+*----------------------------------------------------------------------------*/
+const char *S_csv_field (int field)
+{
+    return ( field >= 0 && field < F_NFIELD ) ? fieldname[field] : NULL;
+}
+
+
+/*============================================================================
+*    Local Int function nextline
+*
+*    Sets [*s, *e) to the next line without its end of line.  Returns 1,
+*    0 at the end of the file, or -1 if read() failed.
+*----------------------------------------------------------------------------*/
+static int nextline( struct solcsv *csv, const char **s, const char **e )
+{
+  char   *nl;
+  ssize_t got;
+  int     drop = 0;
+
+    for ( ;; ) {
+        nl = (char *) memchr( csv->buf + csv->pos, '\n', csv->len - csv->pos );
+        if ( nl && drop ) {                  /* end of an overlong line */
+            csv->pos = nl - csv->buf + 1;
+            drop = 0;
+            continue;
+        }
+        if ( nl || ( csv->eof && csv->pos < csv->len && !drop ) ) {
+            *s = csv->buf + csv->pos;
+            *e = nl ? nl : csv->buf + csv->len;
+            csv->pos = *e - csv->buf + ( nl != NULL );
+            if ( *e > *s && (*e)[-1] == '\r' )
+                (*e)--;
+            csv->line++;
+            return 1;
+        }
+        if ( csv->eof )
+            return 0;
+
+        /* keep the partial line, then refill */
+        if ( drop )
+            csv->len = csv->pos = 0;
+        else if ( csv->pos > 0 ) {
+            memmove( csv->buf, csv->buf + csv->pos, csv->len - csv->pos );
+            csv->len -= csv->pos;
+            csv->pos  = 0;
+        }
+        if ( csv->len == csv->cap ) {        /* line longer than the buffer */
+            csv->line++;
+            csv->skipped++;
+            if ( csv->firstbad == 0 )
+                csv->firstbad = csv->line;
+            csv->len = 0;
+            drop = 1;
+        }
+
+        do
+            got = read( csv->fd, csv->buf + csv->len, csv->cap - csv->len );
+        while ( got < 0 && errno == EINTR );
+        if ( got < 0 )
+            return -1;
+        if ( got == 0 )
+            csv->eof = 1;
+        csv->len   += got;
+        csv->bytes += got;
+    }
+}
+
+
+/*============================================================================
+*    Local Int function number
+*
+*    Converts the cell [p, q).  Returns 1, 0 if it is blank, or -1 if it
+*    is not a number.
+*----------------------------------------------------------------------------*/
+static int number( const char *p, const char *q, double *v )
+{
+  unsigned long long mant = 0;
+  char   tmp[64], *end;
+  double d;
+  long   ex = 0;
+  int    exp10 = 0, nd = 0, any = 0, neg = 0, eneg = 0;
+
+    while ( p < q && ( *p == ' ' || *p == '\t' ) )
+        p++;
+    while ( q > p && ( q[-1] == ' ' || q[-1] == '\t' ) )
+        q--;
+    if ( p == q )
+        return 0;
+
+    end = (char *) p;
+    if ( *p == '-' || *p == '+' )
+        neg = *p++ == '-';
+    for ( ; p < q && *p >= '0' && *p <= '9'; p++, any = 1 )
+        if ( nd < 19 ) {
+            mant = mant * 10 + ( *p - '0' );
+            nd  += mant != 0;
+        }
+        else
+            exp10++;
+    if ( p < q && *p == '.' )
+        for ( p++; p < q && *p >= '0' && *p <= '9'; p++, any = 1 )
+            if ( nd < 19 ) {
+                mant = mant * 10 + ( *p - '0' );
+                nd  += mant != 0;
+                exp10--;
+            }
+    if ( any && p < q && ( *p == 'e' || *p == 'E' ) ) {
+        p++;
+        if ( p < q && ( *p == '-' || *p == '+' ) )
+            eneg = *p++ == '-';
+        if ( p == q || *p < '0' || *p > '9' )
+            any = 0;
+        for ( ; p < q && *p >= '0' && *p <= '9'; p++ )
+            if ( ex < 10000 )
+                ex = ex * 10 + ( *p - '0' );
+        exp10 += (int) ( eneg ? -ex : ex );
+    }
+
+    if ( any && p == q && exp10 >= -22 && exp10 <= 22 ) {
+        d  = (double) mant;
+        d  = exp10 < 0 ? d / p10[-exp10] : d * p10[exp10];
+        *v = neg ? -d : d;
+        return 1;
+    }
+
+    /* nan, inf, hex, extreme exponents, or not a number */
+    p = end;
+    if ( (size_t) ( q - p ) >= sizeof( tmp ) )
+        return -1;
+    memcpy( tmp, p, q - p );
+    tmp[q - p] = 0;
+    *v = strtod( tmp, &end );
+    return ( end == tmp + ( q - p ) ) ? 1 : -1;
+}
+
+
+/*============================================================================
+*    Local Int function row
+*
+*    Parses line [s, e) into row blk->n.  Returns 1, or 0 if the line is
+*    not a valid row.
+*----------------------------------------------------------------------------*/
+static int row( struct solcsv *csv, const char *s, const char *e,
+                struct solcsv_block *blk, const float *def )
+{
+  static const int mdays[13] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30,
+                                 31, 30, 31 };
+  const char *p = s, *q;
+  double v[F_NFIELD];
+  unsigned seen = 0;
+  long   year, n = blk->n;
+  int    month, day, hour, minute, second, leap, col, f, k, r;
+  float  tz;
+
+    for ( col = 0; col < csv->ncol; col++ ) {
+        if ( (q = (const char *) memchr( p, csv->delim, e - p )) == NULL )
+            q = e;
+        if ( (f = csv->field[col]) >= 0 ) {
+            if ( (r = number( p, q, &v[f] )) < 0 )
+                return 0;
+            if ( r > 0 )
+                seen |= 1u << f;
+        }
+        if ( q == e )
+            break;
+        p = q + 1;
+    }
+
+    /* the date must be in the line (or, unmapped, in the template) */
+    for ( f = F_YEAR; f <= F_SECOND; f++ )
+        if ( csv->mapped & ( 1u << f ) ) {
+            if ( !( seen & ( 1u << f ) ) )
+                return 0;
+        }
+        else
+            v[f] = f == F_YEAR  ? csv->site.year :
+                   f == F_MONTH ? csv->site.month :
+                   f == F_DAY   ? csv->site.day : 0.0;
+    for ( f = F_YEAR; f <= F_SECOND; f++ )
+        if ( !( v[f] > -1.0e9 && v[f] < 1.0e9 ) )
+            return 0;
+
+    year   = (long) v[F_YEAR];
+    month  = (int) v[F_MONTH];
+    day    = (int) v[F_DAY];
+    hour   = (int) v[F_HOUR];
+    minute = (int) v[F_MINUTE];
+    second = (int) v[F_SECOND];
+    leap   = ( year % 4 == 0 && year % 100 != 0 ) || year % 400 == 0;
+    if ( month < 1 || month > 12 || day < 1 ||
+         day > mdays[month] + ( month == 2 && leap ) ||
+         hour < 0 || hour > 24 || minute < 0 || minute > 59 ||
+         second < 0 || second > 59 ||
+         ( hour == 24 && ( minute > 0 || second > 0 ) ) )
+        return 0;
+
+    for ( k = 0; k < I_NIN; k++ ) {
+        f = F_INPUT + k;
+        if ( csv->mapped & ( 1u << f ) )
+            blk->in[k][n] = ( seen & ( 1u << f ) ) ? (float) v[f] : def[k];
+    }
+
+    /* local standard time to UTC, the inverse of S_epoch */
+    tz = ( csv->mapped & ( 1u << ( F_INPUT + I_TIMEZONE ) ) )
+         ? blk->in[I_TIMEZONE][n] : def[I_TIMEZONE];
+    blk->utc[n] = civil( year, month, day ) * 86400
+                  + hour * 3600L + minute * 60L + second
+                  - (long long) floor( tz * 3600.0 + 0.5 );
+    return 1;
+}
+
+
+/*============================================================================
+*    Local Long long function civil
+*
+*    Days since 1 January 1970 of a Gregorian date
+*----------------------------------------------------------------------------*/
+static long long civil( long year, int month, int day )
+{
+  long era, yoe, doy, doe;
+
+    year -= month <= 2;
+    era   = ( year >= 0 ? year : year - 399 ) / 400;
+    yoe   = year - era * 400;
+    doy   = ( 153L * ( month + ( month > 2 ? -3 : 9 ) ) + 2 ) / 5 + day - 1;
+    doe   = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return (long long) era * 146097 + doe - 719468;
+}
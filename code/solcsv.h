@@ -0,0 +1,103 @@
+/*============================================================================
+*
+*    NAME:  solcsv.h
+*
+*    Contains:
+*        S_csv_open        (starts reading a delimited text file)
+*        S_csv_map         (maps a field to a column number)
+*        S_csv_map_header  (maps fields by the names in the header line)
+*        S_csv_block_init  (allocates a block of rows)
+*        S_csv_read        (reads the next block of rows)
+*        S_csv_batch       (points a batch at a block)
+*        S_csv_block_free  (releases a block)
+*        S_csv_free        (releases the reader's buffer)
+*        S_csv_field       (default header name of a field)
+*
+*    Streams a CSV (or other single-character delimited) file of local
+*    standard times and site and weather values into the batch engine
+*    (solbatch.h).  Any column may hold any field: the year, month, day,
+*    hour, minute and second of local standard time, and the per-row
+*    inputs of solbatch.h (latitude, longitude, timezone, press, temp,
+*    tilt, aspect).  Other columns are skipped unparsed.
+*
+*    Fields that are not mapped, and empty cells of mapped input fields,
+*    take their value from the site template given to S_csv_open; an
+*    unmapped hour, minute or second is 0.  Each row's local time is
+*    converted to UTC with that row's timezone, exactly inverting
+*    S_epoch, so the batch sees the same date and time as the file.
+*
+*    The file is read in blocks of bufsize bytes with read(), and lines
+*    are parsed in place with a fast decimal parser (plain and
+*    exponent notation; anything else falls back to strtod).  A block
+*    of rows is allocated once and refilled by every S_csv_read, so
+*    nothing is allocated per row.  Lines that do not parse (a second
+*    header, a bad number, an impossible date) are counted and skipped;
+*    quoted cells are not supported.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solcsv.h"
+*
+*         struct solcsv csv;  struct solcsv_block blk;  struct solbatch b;
+*         S_csv_open( &csv, fd, ',', &site, 0 );
+*         S_csv_map_header( &csv, NULL );
+*         S_csv_block_init( &blk, 65536 );
+*         while ( S_csv_read( &csv, &blk ) > 0 ) {
+*             S_csv_batch( &csv, &blk, &b );   ... set b.col, b.retval
+*             S_batch_parallel( &b, threads );
+*         }
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLCSV_H
+#define SOLCSV_H
+
+#include "solbatch.h"
+
+/* fields: the local standard time, then the solbatch.h input columns */
+enum { F_YEAR, F_MONTH, F_DAY, F_HOUR, F_MINUTE, F_SECOND, F_INPUT,
+       F_NFIELD = F_INPUT + I_NIN };
+
+#define S_CSV_MAXCOL  256          /* columns beyond are ignored */
+#define S_CSV_BUF     ( 8 << 20 )  /* default read block, bytes */
+
+struct solcsv
+{
+    int            fd;
+    char           delim;
+    signed char    field[S_CSV_MAXCOL]; /* column -> field, -1 = skip */
+    int            ncol;        /* last mapped column + 1 */
+    unsigned       mapped;      /* bit per mapped field */
+    struct posdata site;        /* template for unmapped fields */
+    char          *buf;
+    size_t         cap, pos, len;
+    int            eof;
+    long           line;        /* lines read, including skipped ones */
+    long           rows;        /* rows delivered */
+    long           skipped;     /* lines that did not parse */
+    long           firstbad;    /* line number of the first, or 0 */
+    long long      bytes;       /* bytes read */
+};
+
+struct solcsv_block
+{
+    long       cap, n;          /* rows allocated, rows filled */
+    long long *utc;
+    float     *in[I_NIN];
+};
+
+extern int         S_csv_open (struct solcsv *csv, int fd, char delim,
+                               const struct posdata *site, size_t bufsize);
+extern int         S_csv_map (struct solcsv *csv, int field, int column);
+extern int         S_csv_map_header (struct solcsv *csv,
+                                     const char * const *names);
+extern int         S_csv_block_init (struct solcsv_block *blk, long cap);
+extern long        S_csv_read (struct solcsv *csv, struct solcsv_block *blk);
+extern void        S_csv_batch (const struct solcsv *csv,
+                                const struct solcsv_block *blk,
+                                struct solbatch *batch);
+extern void        S_csv_block_free (struct solcsv_block *blk);
+extern void        S_csv_free (struct solcsv *csv);
+extern const char *S_csv_field (int field);
+
+#endif /* SOLCSV_H */
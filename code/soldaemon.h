@@ -0,0 +1,44 @@
+/*============================================================================
+*
+*    NAME:  soldaemon.h
+*
+*    Wire format of the local solar position daemon (solposd) and its load
+*    generator (solload).  Both ends run on the same host, so messages are
+*    fixed-size structs in native byte order on a Unix domain stream
+*    socket.  A client may pipeline any number of requests; responses come
+*    back in request order and carry the request tag.
+*
+*    latency in a response is the time the request spent in the daemon,
+*    from being read off the socket to its result being computed.
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLDAEMON_H
+#define SOLDAEMON_H
+
+#include "solbatch.h"
+
+#define S_D_SOCKET  "/tmp/solposd.sock"
+
+struct sold_req
+{
+    unsigned long long tag;        /* echoed in the response */
+    long long          utc;        /* UTC seconds since 1970 */
+    int                function;   /* S_solpos function mask */
+    float              latitude;
+    float              longitude;
+    float              timezone;
+    float              press;
+    float              temp;
+    float              tilt;
+    float              aspect;
+};
+
+struct sold_rsp
+{
+    unsigned long long tag;
+    long long          latency;    /* nanoseconds inside the daemon */
+    long               retval;     /* S_solpos return code */
+    float              col[C_NCOL];/* outputs, indexed by C_ column */
+};
+
+#endif /* SOLDAEMON_H */
@@ -0,0 +1,484 @@
+/*============================================================================
+*    Contains:
+*        S_ens_init   (draws the ensemble members)
+*        S_ens_run    (propagates the ensemble for one timestamp)
+*        S_ens_free   (releases the memory held by a solens)
+*
+*    The nominal posdata goes through S_solpos once per timestamp.  The
+*    members then go in two passes:
+*
+*        gather  a scalar pass that checks each member's inputs against
+*                the S_solpos limits, drops those out of range, and lays
+*                the rest out as one float array per input.  geometry()
+*                is shared unless the clock is perturbed: then S_GEOM
+*                runs per member for the whole seconds of the offset,
+*                and the fraction left moves the hour angle.  Otherwise
+*                a longitude change only shifts the hour angle.
+*        lanes   the stages after geometry() -- zen_no_ref, sazm,
+*                refrac, etr and tilt of S_solpos, with the same limits
+*                and branches turned into selects -- in straight-line
+*                float code over the members, which vectorizes at -O3,
+*                or -O2 -ftree-vectorize (the trig is that of solvec.h,
+*                as in solmap.c).
+*
+*    The lanes agree with S_solpos run on each member's inputs to float
+*    rounding (a few 1e-5 degrees and 1e-3 W/sq m), except that the
+*    arccos azimuth of S_solpos is itself ill-conditioned within a few
+*    tenths of a degree of the meridian.
+*
+*    Member outputs are kept in flat arrays and reduced to mean, variance
+*    and quantiles after all members have run.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solens.h"
+*
+*----------------------------------------------------------------------------*/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "solens.h"
+#include "solvec.h"
+
+/* rows of the perturbation table */
+enum { E_CLOCK, E_LAT, E_LON, E_PRESS, E_TEMP, E_TILT, E_ASPECT, E_NROW };
+
+/* rows of the member inputs gathered for the lanes */
+enum { M_LAT, M_HRANG, M_SD, M_CD, M_ETRN, M_PRESS, M_TEMP, M_TILT,
+       M_ASPECT, M_NROW };
+
+static double raddeg = 0.0174532925199433; /* degrees to radians */
+
+/* hour angle turned per second of clock, degrees: the sidereal rate less
+   the drift of the right ascension, i.e. the mean solar rate */
+static double hrrate = 15.0 / 3600.0;
+
+static float quant[S_ENS_NQ] = { 0.05, 0.25, 0.50, 0.75, 0.95 };
+
+static double uniform( unsigned long long *state );
+static double gauss( unsigned long long *state );
+static void   shift_clock( struct posdata *pdat, int offset );
+static void   lanes( int n, const float *m, float *restrict azim,
+                     float *restrict zenref, float *restrict etrtilt );
+static void   stats( const float *x, int n, float nominal, int wrap,
+                     float *work, struct solens_stat *st );
+static void   nth( float *a, int lo, int hi, int k );
+
+
+/*============================================================================
+*    Int function S_ens_init
+*
+*    Allocates the ensemble and draws members standard-normal deviates
+*    scaled by the sigmas in dist.  The same seed gives the same members.
+*
+*    Returns 0, or -1 if memory could not be allocated.
+*----------------------------------------------------------------------------*/
+int S_ens_init (struct solens *ens, const struct solens_dist *dist,
+                int members, unsigned long seed)
+{
+  unsigned long long state;
+  float sigma[E_NROW];
+  int   i, r;
+
+    memset( ens, 0, sizeof( *ens ) );
+    if ( members < 1 )
+        members = 1;
+    ens->members = members;
+    ens->dist    = *dist;
+
+    ens->d       = (float *) malloc( E_NROW * members * sizeof( float ) );
+    ens->azim    = (float *) malloc( members * sizeof( float ) );
+    ens->zenref  = (float *) malloc( members * sizeof( float ) );
+    ens->etrtilt = (float *) malloc( members * sizeof( float ) );
+    ens->work    = (float *) malloc( members * sizeof( float ) );
+    ens->lane    = (float *) malloc( M_NROW * members * sizeof( float ) );
+    if ( !ens->d || !ens->azim || !ens->zenref || !ens->etrtilt ||
+         !ens->work || !ens->lane ) {
+        S_ens_free( ens );
+        return -1;
+    }
+
+    state = 0x9E3779B97F4A7C15ULL ^ (unsigned long long) seed;
+    sigma[E_CLOCK]  = dist->clock;
+    sigma[E_LAT]    = dist->latitude;
+    sigma[E_LON]    = dist->longitude;
+    sigma[E_PRESS]  = dist->press;
+    sigma[E_TEMP]   = dist->temp;
+    sigma[E_TILT]   = dist->tilt;
+    sigma[E_ASPECT] = dist->aspect;
+    for ( r = 0; r < E_NROW; r++ )
+        for ( i = 0; i < members; i++ )
+            ens->d[r * members + i] = sigma[r] * gauss( &state );
+
+    return 0;
+}
+
+
+/*============================================================================
+*    Long integer function S_ens_run
+*
+*    Propagates the ensemble for the date, time, site and panel in pdat.
+*    pdat is run through S_solpos (function S_TILT | S_ETR, keeping the
+*    caller's S_DOY setting) and holds the nominal solution on return.
+*
+*    Returns the nominal S_solpos error code; members whose perturbed
+*    inputs go out of range are dropped and not counted in out->valid.
+*----------------------------------------------------------------------------*/
+long S_ens_run (struct solens *ens, struct posdata *pdat,
+                struct solens_out *out)
+{
+  struct posdata pd;   /* one member */
+  const struct solens_dist *s = &ens->dist;
+  const float *d = ens->d;
+  float *m = ens->lane;
+  int    n = ens->members;
+  int    clock;        /* the clock carries uncertainty */
+  int    valid;
+  int    i;
+  long   retval;
+  double whole;        /* whole seconds of a member's clock offset */
+  double hrang, sd, cd, etrn;
+
+    pdat->function = ( S_TILT | S_ETR ) | ( pdat->function & S_DOY );
+    if ( (retval = S_solpos( pdat )) != 0 )
+        return retval;
+
+    clock = s->clock != 0.0;
+    sd    = sin( raddeg * pdat->declin );
+    cd    = cos( raddeg * pdat->declin );
+    etrn  = pdat->solcon * pdat->erv;
+
+    /* gather */
+    valid = 0;
+    for ( i = 0; i < n; i++ ) {
+        pd           = *pdat;
+        pd.latitude  += d[E_LAT * n + i];
+        pd.longitude += d[E_LON * n + i];
+        pd.press     += d[E_PRESS  * n + i];
+        pd.temp      += d[E_TEMP   * n + i];
+        pd.tilt      += d[E_TILT   * n + i];
+        pd.aspect    += d[E_ASPECT * n + i];
+
+        /* the limits S_solpos would apply to the member */
+        if ( fabs ( pd.latitude ) > 90.0 || fabs ( pd.longitude ) > 180.0 ||
+             fabs ( pd.temp ) > 100.0 || pd.press < 0.0 ||
+             pd.press > 2000.0 || fabs ( pd.tilt ) > 180.0 ||
+             fabs ( pd.aspect ) > 360.0 )
+            continue;
+
+        if ( clock ) {
+            /* whole seconds through the date and time, then geometry();
+               the fraction of a second left only turns the hour angle */
+            whole = floor ( d[E_CLOCK * n + i] );
+            shift_clock( &pd, (int) whole );
+            pd.function = S_GEOM;
+            if ( S_solpos( &pd ) != 0 )
+                continue;
+            hrang = pd.hrang + ( d[E_CLOCK * n + i] - whole ) * hrrate;
+            m[M_SD * n + valid]   = sin( raddeg * pd.declin );
+            m[M_CD * n + valid]   = cos( raddeg * pd.declin );
+            m[M_ETRN * n + valid] = pd.solcon * pd.erv;
+        }
+        else {
+            /* lmst, and so the hour angle, moves with the longitude */
+            hrang = pd.hrang + d[E_LON * n + i];
+            m[M_SD * n + valid]   = sd;
+            m[M_CD * n + valid]   = cd;
+            m[M_ETRN * n + valid] = etrn;
+        }
+        if ( hrang < -180.0 )
+            hrang += 360.0;
+        else if ( hrang > 180.0 )
+            hrang -= 360.0;
+
+        m[M_LAT * n + valid]    = pd.latitude;
+        m[M_HRANG * n + valid]  = hrang;
+        m[M_PRESS * n + valid]  = pd.press;
+        m[M_TEMP * n + valid]   = pd.temp;
+        m[M_TILT * n + valid]   = pd.tilt;
+        m[M_ASPECT * n + valid] = pd.aspect;
+        valid++;
+    }
+
+    lanes( valid, m, ens->azim, ens->zenref, ens->etrtilt );
+
+    out->valid = valid;
+    stats( ens->azim,    valid, pdat->azim,    1, ens->work, &out->azim );
+    stats( ens->zenref,  valid, pdat->zenref,  0, ens->work, &out->zenref );
+    stats( ens->etrtilt, valid, pdat->etrtilt, 0, ens->work, &out->etrtilt );
+
+    return 0;
+}
+
+
+/*============================================================================
+*    Void function S_ens_free
+*----------------------------------------------------------------------------*/
+void S_ens_free (struct solens *ens)
+{
+    free( ens->d );
+    free( ens->azim );
+    free( ens->zenref );
+    free( ens->etrtilt );
+    free( ens->work );
+    free( ens->lane );
+    memset( ens, 0, sizeof( *ens ) );
+}
+
+
+/*============================================================================
+*    Local Void function lanes
+*
+*    azim, zenref and etrtilt of n gathered members (m holds M_NROW rows
+*    of n): zen_no_ref, sazm, refrac, etr and tilt of S_solpos with the
+*    elevation as an arctangent and the branches as selects.  Angles in
+*    degrees.
+*----------------------------------------------------------------------------*/
+static void lanes( int n, const float *m, float *restrict azim,
+                   float *restrict zenref, float *restrict etrtilt )
+{
+  const float *restrict lat = m + M_LAT * n, *restrict hr = m + M_HRANG * n,
+              *restrict sdec = m + M_SD * n, *restrict cdec = m + M_CD * n,
+              *restrict en = m + M_ETRN * n, *restrict pr = m + M_PRESS * n,
+              *restrict te = m + M_TEMP * n, *restrict ti = m + M_TILT * n,
+              *restrict as = m + M_ASPECT * n;
+  const float rad = 0.0174532925f, deg = 57.2957795f;
+  float   sl, cl, sh, ch, cz, ce, el, cecl, ca, az, tn, ref, er, cs, sz,
+          e, sa, cb, st, ct, sp, cp, ci;
+  int32_t low;
+  int     i;
+
+    for ( i = 0; i < n; i++ ) {
+        /* zen_no_ref: elevetr, no lower than -9 */
+        vsincos( lat[i] * rad, &sl, &cl );
+        vsincos( hr[i] * rad, &sh, &ch );
+        cz  = sdec[i] * sl + cdec[i] * cl * ch;
+        cz  = vsel( -( cz > 1.0f ), 1.0f, vsel( -( cz < -1.0f ), -1.0f, cz ) );
+        ce  = vsqrt( 1.0f - cz * cz );
+        el  = vatan2( cz, ce ) * deg;
+        low = -( el < -9.0f );
+        el  = vsel( low, -9.0f, el );
+        cz  = vsel( low, -0.156434465f, cz );
+        ce  = vsel( low, 0.987688341f, ce );
+
+        /* sazm */
+        cecl = ce * cl;
+        ca   = ( cz * sl - sdec[i] ) /
+               vsel( -( fabsf( cecl ) >= 0.001f ), cecl, 1.0f );
+        ca   = vsel( -( ca > 1.0f ), 1.0f, vsel( -( ca < -1.0f ), -1.0f, ca ) );
+        az   = 180.0f - vatan2( vsqrt( 1.0f - ca * ca ), ca ) * deg;
+        az   = vsel( -( hr[i] > 0.0f ), 360.0f - az, az );
+        az   = vsel( -( fabsf( cecl ) >= 0.001f ), az, 180.0f );
+
+        /* refrac, with 1 / tan of the elevation */
+        tn  = ce / vsel( -( cz != 0.0f ), cz, 1.0f );
+        ref = vsel( -( el >= 5.0f ),
+                    tn * ( 58.1f + tn * tn * ( -0.07f + tn * tn * 0.000086f ) ),
+              vsel( -( el >= -0.575f ),
+                    1735.0f + el * ( -518.2f + el * ( 103.4f + el * ( -12.79f +
+                    el * 0.711f ) ) ),
+                    -20.774f * tn ) );
+        ref = vsel( -( el > 85.0f ), 0.0f,
+                    ref * ( pr[i] * 283.0f ) / ( 1013.0f * ( 273.0f + te[i] ) ) /
+                    3600.0f );
+        er  = el + ref;
+        er  = vsel( -( er < -9.0f ), -9.0f, er );
+        vsincos( er * rad, &cs, &sz );          /* coszen, sin zenref */
+
+        /* etr and tilt */
+        e  = vsel( -( cs > 0.0f ), en[i], 0.0f );
+        vsincos( az * rad, &sa, &cb );
+        vsincos( ti[i] * rad, &st, &ct );
+        vsincos( as[i] * rad, &sp, &cp );
+        ci = cs * ct + sz * st * ( cb * cp + sa * sp );
+
+        azim[i]    = az;
+        zenref[i]  = 90.0f - er;
+        etrtilt[i] = vsel( -( ci > 0.0f ), e * ci, 0.0f );
+    }
+}
+
+
+/*============================================================================
+*    Local Double function uniform
+*
+*    Uniform deviate in [0, 1) from an xorshift64* generator
+*----------------------------------------------------------------------------*/
+static double uniform( unsigned long long *state )
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return ( ( *state * 0x2545F4914F6CDD1DULL ) >> 11 ) *
+           ( 1.0 / 9007199254740992.0 );
+}
+
+
+/*============================================================================
+*    Local Double function gauss
+*
+*    Standard normal deviate (Box-Muller)
+*----------------------------------------------------------------------------*/
+static double gauss( unsigned long long *state )
+{
+  double u1, u2;
+
+    u1 = uniform( state );
+    u2 = uniform( state );
+    if ( u1 < 1.0e-300 )
+        u1 = 1.0e-300;
+
+    return sqrt ( -2.0 * log ( u1 ) ) * cos ( 6.283185307179586 * u2 );
+}
+
+
+/*============================================================================
+*    Local Void function shift_clock
+*
+*    Moves the (day number) date and time by offset seconds, carrying into
+*    the day number and year
+*----------------------------------------------------------------------------*/
+static void shift_clock( struct posdata *pdat, int offset )
+{
+  long t;            /* seconds from midnight */
+  int  days;         /* days in the current year */
+
+    t = pdat->hour * 3600L + pdat->minute * 60L + pdat->second + offset;
+
+    while ( t < 0 ) {
+        t += 86400L;
+        if ( --pdat->daynum < 1 ) {
+            pdat->year--;
+            pdat->daynum = ( ((pdat->year % 4) == 0) &&
+                ( ((pdat->year % 100) != 0) || ((pdat->year % 400) == 0) ) )
+                ? 366 : 365;
+        }
+    }
+    while ( t >= 86400L ) {
+        t -= 86400L;
+        days = ( ((pdat->year % 4) == 0) &&
+            ( ((pdat->year % 100) != 0) || ((pdat->year % 400) == 0) ) )
+            ? 366 : 365;
+        if ( ++pdat->daynum > days ) {
+            pdat->year++;
+            pdat->daynum = 1;
+        }
+    }
+
+    pdat->hour   = (int) ( t / 3600L );
+    pdat->minute = (int) ( ( t / 60L ) % 60L );
+    pdat->second = (int) ( t % 60L );
+}
+
+
+/*============================================================================
+*    Local Void function stats
+*
+*    Mean, variance and quantiles of n member values.  With wrap set, the
+*    values are angles and are taken as deviations from nominal wrapped
+*    to +/- 180 degrees.
+*----------------------------------------------------------------------------*/
+static void stats( const float *x, int n, float nominal, int wrap,
+                   float *work, struct solens_stat *st )
+{
+  double sum, ss, dev;
+  float  pos;        /* fractional index of a quantile */
+  float  next;       /* the value after work[lo] in order */
+  int    i, k, lo, from;
+
+    if ( n < 1 ) {
+        st->mean = nominal;
+        st->var  = 0.0;
+        for ( k = 0; k < S_ENS_NQ; k++ )
+            st->q[k] = nominal;
+        return;
+    }
+
+    for ( i = 0; i < n; i++ ) {
+        work[i] = x[i] - nominal;
+        if ( wrap ) {
+            if ( work[i] > 180.0f )
+                work[i] -= 360.0f;
+            else if ( work[i] < -180.0f )
+                work[i] += 360.0f;
+        }
+    }
+
+    sum = 0.0;
+    for ( i = 0; i < n; i++ )
+        sum += work[i];
+    sum /= n;
+
+    ss = 0.0;
+    for ( i = 0; i < n; i++ ) {
+        dev = work[i] - sum;
+        ss += dev * dev;
+    }
+
+    st->mean = nominal + sum;
+    st->var  = ( n > 1 ) ? ss / ( n - 1 ) : 0.0;
+
+    /* the quantiles rise, so each selection leaves the next one only
+       the part of work above it */
+    from = 0;
+    for ( k = 0; k < S_ENS_NQ; k++ ) {
+        pos = quant[k] * ( n - 1 );
+        lo  = (int) pos;
+        if ( lo >= n - 1 ) {
+            nth( work, from, n - 1, n - 1 );
+            st->q[k] = nominal + work[n - 1];
+            continue;
+        }
+        nth( work, from, n - 1, lo );
+        next = work[lo + 1];
+        for ( i = lo + 2; i < n; i++ )
+            if ( work[i] < next )
+                next = work[i];
+        st->q[k] = nominal + work[lo] + ( pos - lo ) * ( next - work[lo] );
+        from = lo;
+    }
+
+    if ( wrap ) {   /* back to 0 - 360 */
+        st->mean -= 360.0 * floor ( st->mean / 360.0 );
+        for ( k = 0; k < S_ENS_NQ; k++ )
+            st->q[k] -= 360.0 * floor ( st->q[k] / 360.0 );
+    }
+}
+
+
+/*============================================================================
+*    Local Void function nth
+*
+*    Reorders a[lo..hi] so that a[k] is the value that would be there if
+*    it were sorted, with nothing larger before it and nothing smaller
+*    after it (Hoare's FIND).
+*----------------------------------------------------------------------------*/
+static void nth( float *a, int lo, int hi, int k )
+{
+  float x, t;
+  int   i, j;
+
+    while ( lo < hi ) {
+        x = a[k];
+        i = lo;
+        j = hi;
+        do {
+            while ( a[i] < x )
+                i++;
+            while ( x < a[j] )
+                j--;
+            if ( i <= j ) {
+                t    = a[i];
+                a[i] = a[j];
+                a[j] = t;
+                i++;
+                j--;
+            }
+        } while ( i <= j );
+        if ( j < k )
+            lo = i;
+        if ( k < i )
+            hi = j;
+    }
+}
@@ -0,0 +1,79 @@
+/*============================================================================
+*
+*    NAME:  solens.h
+*
+*    Contains:
+*        S_ens_init   (draws the ensemble members for a set of input
+*                      uncertainties)
+*        S_ens_run    (propagates the ensemble through S_solpos for one
+*                      timestamp and returns output statistics)
+*        S_ens_free   (releases the memory held by a solens)
+*
+*    Each input uncertainty is a 1-sigma Gaussian around the value in the
+*    posdata passed to S_ens_run; a zero sigma leaves that input exact.
+*    The same members (random draws) are reused for every timestamp, so
+*    the bands of a time series are smooth.
+*
+*    Output statistics are given for azim, zenref and etrtilt.  Azimuth
+*    deviations are wrapped to +/- 180 degrees around the nominal value
+*    before averaging, so the statistics stay sane near north.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solens.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLENS_H
+#define SOLENS_H
+
+#include "solpos00.h"
+
+#define S_ENS_NQ 5   /* quantiles reported: 5%, 25%, 50%, 75%, 95% */
+
+struct solens_dist   /* 1-sigma input uncertainties */
+{
+    float clock;      /* clock offset, seconds */
+    float latitude;   /* degrees */
+    float longitude;  /* degrees */
+    float press;      /* millibars */
+    float temp;       /* degrees C */
+    float tilt;       /* degrees */
+    float aspect;     /* degrees */
+};
+
+struct solens_stat
+{
+    float mean;
+    float var;
+    float q[S_ENS_NQ];
+};
+
+struct solens_out
+{
+    int   valid;      /* members with in-range inputs */
+    struct solens_stat azim;
+    struct solens_stat zenref;
+    struct solens_stat etrtilt;
+};
+
+struct solens
+{
+    int    members;
+    struct solens_dist dist;
+    float *d;         /* 7 x members perturbations, one row per input
+                         in the order of struct solens_dist */
+    float *azim;      /* per-member outputs of the last S_ens_run */
+    float *zenref;
+    float *etrtilt;
+    float *work;      /* deviations, reordered for the quantiles */
+    float *lane;      /* member inputs gathered by S_ens_run */
+};
+
+extern int  S_ens_init (struct solens *ens, const struct solens_dist *dist,
+                        int members, unsigned long seed);
+extern long S_ens_run (struct solens *ens, struct posdata *pdat,
+                       struct solens_out *out);
+extern void S_ens_free (struct solens *ens);
+
+#endif /* SOLENS_H */
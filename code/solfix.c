@@ -0,0 +1,414 @@
+/*============================================================================
+*    Contains:
+*        S_fixpos     (fixed-point solar position)
+*        S_fixinit    (optional initialization of the fixdata inputs)
+*
+*    This is the float algorithm of solpos.c (geometry, zen_no_ref, sazm
+*    and refrac, with the same references) carried out in integers, for
+*    tracker controllers without an FPU.  Conventions used below:
+*
+*        BAM    binary angle: a full turn is 2^32, so uint32_t arithmetic
+*               wraps angles for free; read as int32_t it is -180..180
+*        Q30    ratios (sines, cosines): 1.0 = 2^30
+*        Q16    Q16.16 degrees, arc seconds, millibars or deg C
+*
+*    Sine, cosine and arctangent come from a 30-step CORDIC; arcsine and
+*    arccosine are arctangents with an integer square root.  Long time
+*    spans (ectime) are int64 seconds, and the angular rates are scaled so
+*    that rate * seconds stays in range for 1950 - 2050.  Every constant
+*    below is the solpos.c coefficient in one of these scalings.
+*
+*    Compiled with only 32/64-bit integer operations (no float, no libm);
+*    S_UNFIX in solfix.h is for the host side.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solfix.h"
+*
+*----------------------------------------------------------------------------*/
+#include "solfix.h"
+
+#define BAM_90     0x40000000L          /*  90 degrees */
+#define Q30_ONE    ( 1L << 30 )
+
+/* binary angle of d degrees, for the constants below */
+#define BAM(d)     ( (int32_t) ( (d) * 11930464.7111111 ) )
+/* Q16.16 of a constant */
+#define Q16(d)     ( (int64_t) ( (d) * 65536.0 ) )
+
+/* CORDIC arctangents, atan(2^-i) in BAM */
+static const int32_t atantab[30] = {
+     536870912,  316933406,  167458907,   85004756,
+      42667331,   21354465,   10679838,    5340245,
+       2670163,    1335087,     667544,     333772,
+        166886,      83443,      41722,      20861,
+         10430,       5215,       2608,       1304,
+           652,        326,        163,         81,
+            41,         20,         10,          5,
+             3,          1 };
+
+static const int32_t cordic_k = 652032874;  /* CORDIC gain 0.607253, Q30 */
+
+/* Michalsky (1988) ephemeris: base angle in BAM, rate in BAM/s * 2^24 */
+static const uint32_t mnlong_0  = 3346018133u;  /* 280.460 degrees */
+static const int64_t  mnlong_r  = 2283416288LL; /* 0.9856474 deg/day */
+static const uint32_t mnanom_0  = 4265475187u;  /* 357.528 degrees */
+static const int64_t  mnanom_r  = 2283307173LL; /* 0.9856003 deg/day */
+static const uint32_t gmst_0    = 1198541941u;  /* 6.697375 hours */
+static const int64_t  gmst_r    = 2283416202LL; /* 0.0657098242 h/day */
+static const int64_t  utime_r   = 833999930995LL; /* 24 h/day, per s */
+static const int32_t  ecobli_0  = 279638162;    /* 23.439 degrees */
+static const int64_t  ecobli_r  = 60730022LL;   /* 4.0e-07 deg/day, * 2^40 */
+static const int32_t  eclong_1  = 22846840;     /* 1.915 degrees */
+static const int32_t  eclong_2  = 238609;       /* 0.020 degrees */
+
+/* Spencer (1971) earth radius vector, Q30 */
+static const int64_t  erv_c[5] = { 1073859936LL, 36744519LL, 1374390LL,
+                                   772020LL, 82678LL };
+
+/* Zimmerman (1981) refraction: Q32 coefficients of cot(elev), Q16
+   coefficients of the low-sun polynomial, arc seconds */
+static const int64_t  ref_c1  = 249537599898LL;  /*  58.1     */
+static const int64_t  ref_c3  = 300647711LL;     /*   0.07    */
+static const int64_t  ref_c5  = 369367LL;        /*   0.000086 */
+static const int64_t  ref_cn  = 89223650607LL;   /*  20.774   */
+static const int64_t  ref_p[5] = { 113704960LL, -33960755LL, 6776422LL,
+                                   -838205LL, 46596LL };
+
+/*============================================================================
+*    Local function prototypes
+============================================================================*/
+static long    fixvalidate( struct fixdata *fdat );
+static void    cordic_sincos( int32_t a, int32_t *s, int32_t *c );
+static int32_t cordic_atan2( int64_t y, int64_t x );
+static int32_t cosine_of( int32_t s );
+static int32_t bam2q16( int32_t a );
+static int32_t q30mul( int32_t a, int32_t b );
+
+
+/*============================================================================
+*    Long integer function S_fixpos
+*
+*    Requires (from the struct fixdata parameter):
+*            year, daynum, hour, minute, second, interval, latitude,
+*            longitude, timezone, press, temp
+*
+*    Returns (via the struct fixdata parameter):
+*            erv, declin, hrang, zenetr, elevetr, azim, elevref, zenref
+*----------------------------------------------------------------------------*/
+long S_fixpos (struct fixdata *fdat)
+{
+  int64_t  utime;    /* universal time, seconds from local midnight */
+  int64_t  ect;      /* ectime, seconds from noon 1 Jan 2000 */
+  int64_t  num, den; /* temporaries for divisions */
+  int64_t  refcor;   /* refraction correction, Q16 arc seconds */
+  int64_t  u, u3, u5;/* cot(elevation) and its powers, Q16 */
+  int64_t  e;        /* elevation, Q16 degrees */
+  int32_t  dayang, mnanom, eclong, ecobli, rascen, declin, hrang;
+  int32_t  lat, zenetr, elevetr;
+  int32_t  s1, c1, s2, c2;
+  int32_t  sd, cd, sl, cl, ch, se, ce;
+  int32_t  cz, cecl;
+  uint32_t mnlong, gmst, lmst, azim;
+  int      delta, leap, k;
+  long     retval;
+
+    if ( (retval = fixvalidate( fdat )) != 0 )
+        return retval;
+
+    /* Day angle and earth radius vector (Spencer 1971) */
+    dayang = (int32_t) (uint32_t)
+             ( ( (int64_t) ( fdat->daynum - 1 ) << 32 ) / 365 );
+    cordic_sincos( dayang, &s1, &c1 );
+    cordic_sincos( (int32_t) ( (uint32_t) dayang * 2u ), &s2, &c2 );
+    fdat->erv = (int32_t) ( erv_c[0] + ( ( erv_c[1] * c1 + erv_c[2] * s1 +
+                            erv_c[3] * c2 + erv_c[4] * s2 ) >> 30 ) );
+
+    /* Universal time and ectime (Michalsky 1988); julday - 51545 days is
+       (delta*365 + leap + daynum - 18628.5) days + utime */
+    utime  = fdat->hour * 3600L + fdat->minute * 60L + fdat->second -
+             fdat->interval / 2 -
+             ( ( (int64_t) fdat->timezone * 3600 + 32768 ) >> 16 );
+    delta  = fdat->year - 1949;
+    leap   = delta / 4;
+    ect    = ( (int64_t) delta * 365 + leap + fdat->daynum - 18628 ) *
+             86400 - 43200 + utime;
+
+    /* Mean longitude, mean anomaly, ecliptic longitude */
+    mnlong = mnlong_0 + (uint32_t) ( ( mnlong_r * ect ) >> 24 );
+    mnanom = (int32_t) ( mnanom_0 + (uint32_t) ( ( mnanom_r * ect ) >> 24 ) );
+    cordic_sincos( mnanom, &s1, &c1 );
+    cordic_sincos( (int32_t) ( (uint32_t) mnanom * 2u ), &s2, &c2 );
+    eclong = (int32_t) ( mnlong +
+             (uint32_t) ( ( (int64_t) eclong_1 * s1 +
+                            (int64_t) eclong_2 * s2 ) >> 30 ) );
+
+    /* Obliquity of the ecliptic (with the 2001 sign correction) */
+    ecobli = ecobli_0 - (int32_t) ( ( ecobli_r * ect ) >> 40 );
+
+    /* Declination and right ascension */
+    cordic_sincos( ecobli, &s1, &c1 );
+    cordic_sincos( eclong, &s2, &c2 );
+    sd     = q30mul( s1, s2 );
+    declin = cordic_atan2( sd, cosine_of( sd ) );
+    rascen = cordic_atan2( q30mul( c1, s2 ), c2 );
+
+    /* Greenwich and local mean sidereal time as angles, hour angle */
+    gmst   = gmst_0 + (uint32_t) ( ( gmst_r * ect ) >> 24 ) +
+             (uint32_t) ( ( utime_r * utime ) >> 24 );
+    lat    = (int32_t) ( ( (int64_t) fdat->latitude * 11930465 ) >> 16 );
+    lmst   = gmst + (uint32_t) (int32_t)
+             ( ( (int64_t) fdat->longitude * 11930465 ) >> 16 );
+    hrang  = (int32_t) ( lmst - (uint32_t) rascen );
+
+    /* ETR zenith angle (Iqbal 1983), limited to 99 degrees */
+    cordic_sincos( declin, &sd, &cd );
+    cordic_sincos( lat,    &sl, &cl );
+    cordic_sincos( hrang,  &s1, &ch );
+    cz = q30mul( sd, sl ) + q30mul( q30mul( cd, cl ), ch );
+    if ( cz >  Q30_ONE ) cz =  Q30_ONE;
+    if ( cz < -Q30_ONE ) cz = -Q30_ONE;
+    zenetr = cordic_atan2( cosine_of( cz ), cz );
+    if ( zenetr > BAM(99.0) )
+        zenetr = BAM(99.0);
+    elevetr = BAM_90 - zenetr;
+
+    /* Solar azimuth (Iqbal 1983).  solpos.c takes the arccosine of
+       ( se sl - sd ) / ( ce cl ), which near the meridian loses half the
+       bits of the quotient; here the same angle is the arctangent of
+       the sun's east and north components, - cd sin(hrang) and
+       sd cl - cd sl cos(hrang), which keeps them all.  The cutoff where
+       the azimuth is left at 180 is the one of solpos.c. */
+    cordic_sincos( elevetr, &se, &ce );
+    azim = 0x80000000u;                       /* 180 degrees */
+    cecl = q30mul( ce, cl );
+    if ( cecl >= 1073742 || cecl <= -1073742 )     /* |cecl| >= 0.001 */
+        azim = (uint32_t) cordic_atan2(
+                   -(int64_t) q30mul( cd, s1 ),
+                   (int64_t) q30mul( sd, cl ) -
+                   q30mul( q30mul( cd, sl ), ch ) );
+
+    /* Refraction correction (Zimmerman 1981), arc seconds */
+    e = bam2q16( elevetr );
+    if ( e > Q16(85.0) )
+        refcor = 0;
+    else {
+        if ( e >= Q16(5.0) ) {
+            u  = ( (int64_t) ce << 16 ) / se;
+            u3 = ( ( ( u * u ) >> 16 ) * u ) >> 16;
+            u5 = ( ( ( u3 * u ) >> 16 ) * u ) >> 16;
+            refcor = ( ref_c1 * u - ref_c3 * u3 + ref_c5 * u5 ) >> 32;
+        }
+        else if ( e >= -Q16(0.575) ) {
+            refcor = ref_p[4];
+            for ( k = 3; k >= 0; k-- )
+                refcor = ref_p[k] + ( ( e * refcor ) >> 16 );
+        }
+        else {
+            u      = ( (int64_t) ce << 16 ) / se;
+            refcor = -( ( ref_cn * u ) >> 32 );
+        }
+
+        /* pressure/temperature correction, then to degrees */
+        num    = (int64_t) fdat->press * 283;
+        den    = 1013 * ( Q16(273.0) + fdat->temp );
+        refcor = refcor * ( ( num << 16 ) / den ) >> 16;
+        refcor = refcor / 3600;
+    }
+
+    fdat->declin  = bam2q16( declin );
+    fdat->hrang   = bam2q16( hrang );
+    fdat->zenetr  = bam2q16( zenetr );
+    fdat->elevetr = (int32_t) e;
+    fdat->azim    = (int32_t) ( ( (uint64_t) azim * 360 ) >> 16 );
+    fdat->elevref = (int32_t) ( e + refcor );
+    if ( fdat->elevref < (int32_t) Q16(-9.0) )
+        fdat->elevref = (int32_t) Q16(-9.0);
+    fdat->zenref  = (int32_t) Q16(90.0) - fdat->elevref;
+
+    return 0;
+}
+
+
+/*============================================================================
+*    Void function S_fixinit
+*
+*    Same defaults as S_init: required inputs out of range, optional ones
+*    nominal.
+*----------------------------------------------------------------------------*/
+void S_fixinit (struct fixdata *fdat)
+{
+    fdat->year      =   -99;
+    fdat->daynum    =  -999;
+    fdat->hour      =   -99;
+    fdat->minute    =   -99;
+    fdat->second    =   -99;
+    fdat->interval  =     0;
+    fdat->latitude  = (int32_t) Q16(-99.0);
+    fdat->longitude = (int32_t) Q16(-999.0);
+    fdat->timezone  = (int32_t) Q16(-99.0);
+    fdat->press     = (int32_t) Q16(1013.0);
+    fdat->temp      = (int32_t) Q16(15.0);
+}
+
+
+/*============================================================================
+*    Local long int function fixvalidate
+*
+*    Same ranges (and error bits) as validate() in solpos.c
+*----------------------------------------------------------------------------*/
+static long fixvalidate( struct fixdata *fdat )
+{
+  long retval = 0;
+
+    if ( (fdat->year < 1950) || (fdat->year > 2050) )
+        retval |= (1L << S_YEAR_ERROR);
+    if ( (fdat->daynum < 1) || (fdat->daynum > 366) )
+        retval |= (1L << S_DOY_ERROR);
+    if ( (fdat->hour < 0) || (fdat->hour > 24) )
+        retval |= (1L << S_HOUR_ERROR);
+    if ( (fdat->minute < 0) || (fdat->minute > 59) )
+        retval |= (1L << S_MINUTE_ERROR);
+    if ( (fdat->second < 0) || (fdat->second > 59) )
+        retval |= (1L << S_SECOND_ERROR);
+    if ( (fdat->hour == 24) && (fdat->minute > 0) )
+        retval |= ( (1L << S_HOUR_ERROR) | (1L << S_MINUTE_ERROR) );
+    if ( (fdat->hour == 24) && (fdat->second > 0) )
+        retval |= ( (1L << S_HOUR_ERROR) | (1L << S_SECOND_ERROR) );
+    if ( (fdat->timezone > Q16(12.0)) || (fdat->timezone < -Q16(12.0)) )
+        retval |= (1L << S_TZONE_ERROR);
+    if ( (fdat->interval < 0) || (fdat->interval > 28800) )
+        retval |= (1L << S_INTRVL_ERROR);
+    if ( (fdat->longitude > Q16(180.0)) || (fdat->longitude < -Q16(180.0)) )
+        retval |= (1L << S_LON_ERROR);
+    if ( (fdat->latitude > Q16(90.0)) || (fdat->latitude < -Q16(90.0)) )
+        retval |= (1L << S_LAT_ERROR);
+    if ( (fdat->temp > Q16(100.0)) || (fdat->temp < -Q16(100.0)) )
+        retval |= (1L << S_TEMP_ERROR);
+    if ( (fdat->press < 0) || (fdat->press > Q16(2000.0)) )
+        retval |= (1L << S_PRESS_ERROR);
+
+    return retval;
+}
+
+
+/*============================================================================
+*    Local Void function cordic_sincos
+*
+*    CORDIC rotation: sine and cosine (Q30) of a binary angle
+*----------------------------------------------------------------------------*/
+static void cordic_sincos( int32_t a, int32_t *s, int32_t *c )
+{
+  int32_t x, y, z, t;
+  int     neg, i;
+
+    /* fold into -90..90 degrees */
+    neg = 0;
+    if ( a > BAM_90 || a < -BAM_90 ) {      /* turn by 180 degrees */
+        a   = (int32_t) ( (uint32_t) a + 0x80000000u );
+        neg = 1;
+    }
+
+    x = cordic_k;
+    y = 0;
+    z = a;
+    for ( i = 0; i < 30; i++ ) {
+        t = x;
+        if ( z >= 0 ) {
+            x -= y >> i;
+            y += t >> i;
+            z -= atantab[i];
+        }
+        else {
+            x += y >> i;
+            y -= t >> i;
+            z += atantab[i];
+        }
+    }
+
+    *c = neg ? -x : x;
+    *s = neg ? -y : y;
+}
+
+
+/*============================================================================
+*    Local int32 function cordic_atan2
+*
+*    CORDIC vectoring: binary angle of (x, y), any common scaling
+*----------------------------------------------------------------------------*/
+static int32_t cordic_atan2( int64_t y, int64_t x )
+{
+  int64_t  t;
+  uint32_t z;
+  int      i;
+
+    z = 0;
+    if ( x < 0 ) {          /* rotate into the right half plane */
+        x = -x;
+        y = -y;
+        z = 0x80000000u;
+    }
+
+    for ( i = 0; i < 30; i++ ) {
+        t = x;
+        if ( y > 0 ) {
+            x += y >> i;
+            y -= t >> i;
+            z += (uint32_t) atantab[i];
+        }
+        else {
+            x -= y >> i;
+            y += t >> i;
+            z -= (uint32_t) atantab[i];
+        }
+    }
+
+    return (int32_t) z;
+}
+
+
+/*============================================================================
+*    Local int32 function cosine_of
+*
+*    sqrt ( 1 - s^2 ) in Q30 by bitwise integer square root
+*----------------------------------------------------------------------------*/
+static int32_t cosine_of( int32_t s )
+{
+  uint64_t v, r, b;
+
+    v = ( (uint64_t) 1 << 60 ) - (uint64_t) ( (int64_t) s * s );
+    r = 0;
+    for ( b = (uint64_t) 1 << 62; b > v; b >>= 2 )
+        ;
+    for ( ; b != 0; b >>= 2 ) {
+        if ( v >= r + b ) {
+            v -= r + b;
+            r  = ( r >> 1 ) + b;
+        }
+        else
+            r >>= 1;
+    }
+
+    return (int32_t) r;
+}
+
+
+/*============================================================================
+*    Local int32 function bam2q16
+*
+*    Signed binary angle to Q16.16 degrees
+*----------------------------------------------------------------------------*/
+static int32_t bam2q16( int32_t a )
+{
+    return (int32_t) ( ( (int64_t) a * 360 ) >> 16 );
+}
+
+
+/*============================================================================
+*    Local int32 function q30mul
+*----------------------------------------------------------------------------*/
+static int32_t q30mul( int32_t a, int32_t b )
+{
+    return (int32_t) ( ( (int64_t) a * b ) >> 30 );
+}
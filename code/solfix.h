@@ -0,0 +1,76 @@
+/*============================================================================
+*
+*    NAME:  solfix.h
+*
+*    Contains:
+*        S_fixpos     (fixed-point solar position for processors without
+*                      floating point hardware)
+*        S_fixinit    (optional initialization of the fixdata inputs)
+*
+*    S_fixpos follows the geometry -> zen_no_ref -> sazm -> refrac path of
+*    S_solpos (the S_SOLAZM | S_REFRAC functions) using only integer
+*    arithmetic: angles are 32-bit binary angles internally, trig is done
+*    by CORDIC, and inputs and outputs are Q16.16 fixed-point numbers.
+*
+*        S_FIX(x)     converts a constant to Q16.16 (1.0 = 65536)
+*        S_UNFIX(x)   converts Q16.16 back to float (host side only)
+*
+*    The date is always given as year and day number (the S_DOY input
+*    form of S_solpos).  The return value uses the error bits of S_solpos.
+*
+*    Accuracy against S_solpos, 1955 - 2049, latitudes -66 to 65: declin,
+*    hrang, zenetr, elevref and zenref within 0.0035 degree.  The azimuth
+*    is the arctangent of the sun's east and north components, within
+*    0.001 degree of double precision on the same declination and hour
+*    angle.  Against S_solpos it differs by up to 0.1 degree for zenith
+*    angles over 10 degrees and 0.6 degree from 1 to 10: S_solpos takes
+*    an arccosine that loses precision near the meridian, and the small
+*    declin and hrang differences grow as 1 / sin( zenetr ).
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solfix.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLFIX_H
+#define SOLFIX_H
+
+#include <stdint.h>
+#include "solpos00.h"
+
+#define S_FIX(x)    ( (int32_t) ( (x) * 65536.0 + ( (x) < 0 ? -0.5 : 0.5 ) ) )
+#define S_UNFIX(x)  ( (float) (x) / 65536.0f )
+
+struct fixdata
+{
+    /* Variable        I/O  Description */
+    /* -------------  ----  ---------------------------------------*/
+
+    int     year;      /* I:  4-digit year */
+    int     daynum;    /* I:  day of year (Feb 1 = 32) */
+    int     hour;      /* I:  hour of day, 0 - 24 */
+    int     minute;    /* I:  minute of hour, 0 - 59 */
+    int     second;    /* I:  second of minute, 0 - 59 */
+    int     interval;  /* I:  measurement interval, seconds (as posdata) */
+
+    int32_t latitude;  /* I:  Q16.16 degrees north (south negative) */
+    int32_t longitude; /* I:  Q16.16 degrees east (west negative) */
+    int32_t timezone;  /* I:  Q16.16 hours east (west negative) */
+    int32_t press;     /* I:  Q16.16 surface pressure, millibars */
+    int32_t temp;      /* I:  Q16.16 ambient dry-bulb temperature, deg C */
+
+    int32_t erv;       /* O:  Q2.30 earth radius vector (* solar const) */
+    int32_t declin;    /* O:  Q16.16 declination, degrees north */
+    int32_t hrang;     /* O:  Q16.16 hour angle, degrees west */
+    int32_t zenetr;    /* O:  Q16.16 zenith angle, no refraction */
+    int32_t elevetr;   /* O:  Q16.16 elevation, no refraction */
+    int32_t azim;      /* O:  Q16.16 azimuth, N=0, E=90, S=180, W=270 */
+    int32_t elevref;   /* O:  Q16.16 refracted elevation */
+    int32_t zenref;    /* O:  Q16.16 refracted zenith angle */
+};
+
+extern long S_fixpos (struct fixdata *fdat);
+extern void S_fixinit (struct fixdata *fdat);
+
+#endif /* SOLFIX_H */
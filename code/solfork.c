@@ -0,0 +1,175 @@
+/*============================================================================
+*    Contains:
+*        S_fork_run    (computes a site x time grid in worker processes)
+*        S_arena_free  (unmaps a result arena)
+*        S_grid_run    (computes a range of grid rows in this process)
+*
+*    Arena layout, each part starting on a 64-byte boundary:
+*
+*        struct solfork_stats [workers]   counters, one block per worker
+*        long  [rows]                     return codes
+*        float [rows]                     one array per selected column
+*
+*    Workers update their counter block after every block of rows, so
+*    the counts of a worker that dies are still good up to its last
+*    complete block.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solfork.h"
+*
+*----------------------------------------------------------------------------*/
+#define _DEFAULT_SOURCE
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "solfork.h"
+
+#define BLOCK  4096    /* rows per batch call inside a worker */
+#define ALIGN( n )  ( ( (n) + 63 ) & ~(size_t) 63 )
+
+
+/*============================================================================
+*    Int function S_fork_run
+*
+*    Computes the grid in workers processes.  Returns 0 (check
+*    stats->failed for workers that died), or -1 if the arena could not
+*    be mapped.  The arena stays mapped until S_arena_free.
+*----------------------------------------------------------------------------*/
+int S_fork_run (const struct solgrid *grid, int workers,
+                struct solarena *arena, struct solfork_stats *stats)
+{
+  struct solfork_stats *part;
+  pid_t   pid[64];
+  float  *col[C_NCOL];
+  size_t  off;
+  long    first, last;
+  char   *p;
+  int     status, w, k, e;
+
+    if ( workers < 1 )
+        workers = 1;
+    if ( workers > 64 )
+        workers = 64;
+
+    memset( arena, 0, sizeof( *arena ) );
+    arena->rows = (long) grid->nsite * grid->ntime;
+
+    arena->size = ALIGN( workers * sizeof( *part ) ) +
+                  ALIGN( arena->rows * sizeof( long ) );
+    for ( k = 0; k < C_NCOL; k++ )
+        if ( grid->cols & S_COL( k ) )
+            arena->size += ALIGN( arena->rows * sizeof( float ) );
+
+    p = (char *) mmap( NULL, arena->size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    if ( p == MAP_FAILED ) {
+        memset( arena, 0, sizeof( *arena ) );
+        return -1;
+    }
+    arena->base = p;
+
+    part = (struct solfork_stats *) p;
+    off  = ALIGN( workers * sizeof( *part ) );
+    arena->retval = (long *) ( p + off );
+    off += ALIGN( arena->rows * sizeof( long ) );
+    for ( k = 0; k < C_NCOL; k++ )
+        if ( grid->cols & S_COL( k ) ) {
+            arena->col[k] = (float *) ( p + off );
+            off += ALIGN( arena->rows * sizeof( float ) );
+        }
+
+    memset( arena->retval, 0xFF, arena->rows * sizeof( long ) );  /* -1 */
+
+    for ( w = 0; w < workers; w++ ) {
+        first = arena->rows * w / workers;
+        last  = arena->rows * ( w + 1 ) / workers;
+        pid[w] = fork();
+        for ( k = 0; k < C_NCOL; k++ )
+            col[k] = arena->col[k] ? arena->col[k] + first : NULL;
+        if ( pid[w] == 0 ) {
+            S_grid_run( grid, first, last, col, arena->retval + first,
+                        &part[w] );
+            _exit( 0 );
+        }
+        if ( pid[w] < 0 )                  /* no process: do it here */
+            S_grid_run( grid, first, last, col, arena->retval + first,
+                        &part[w] );
+    }
+
+    memset( stats, 0, sizeof( *stats ) );
+    stats->workers = workers;
+    for ( w = 0; w < workers; w++ ) {
+        if ( pid[w] > 0 &&
+             ( waitpid( pid[w], &status, 0 ) != pid[w] ||
+               !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 ) )
+            stats->failed++;
+        stats->rows   += part[w].rows;
+        stats->errors += part[w].errors;
+        for ( e = 0; e < S_F_NERR; e++ )
+            stats->code[e] += part[w].code[e];
+    }
+
+    return 0;
+}
+
+
+/*============================================================================
+*    Void function S_arena_free
+*----------------------------------------------------------------------------*/
+void S_arena_free (struct solarena *arena)
+{
+    if ( arena->base )
+        munmap( arena->base, arena->size );
+    memset( arena, 0, sizeof( *arena ) );
+}
+
+
+/*============================================================================
+*    Void function S_grid_run
+*
+*    Rows first .. last-1 in blocks of BLOCK.  col[k] and retval point at
+*    row first; NULL columns are skipped.  Counts are added to stats after
+*    every block.
+*----------------------------------------------------------------------------*/
+void S_grid_run (const struct solgrid *grid, long first, long last,
+                 float * const col[C_NCOL], long *retval,
+                 struct solfork_stats *stats)
+{
+  struct solbatch batch;
+  long long utc[BLOCK];
+  int       site[BLOCK];
+  long      r0, n, i, r, errors;
+  int       k, e;
+
+    memset( &batch, 0, sizeof( batch ) );
+    batch.utc   = utc;
+    batch.site  = site;
+    batch.sites = grid->sites;
+
+    for ( r0 = first; r0 < last; r0 += n ) {
+        n = last - r0 < BLOCK ? last - r0 : BLOCK;
+        for ( i = 0; i < n; i++ ) {
+            r = r0 + i;
+            site[i] = (int) ( r / grid->ntime );
+            utc[i]  = grid->start + ( r % grid->ntime ) * grid->step;
+        }
+
+        /* columns point at this block's rows */
+        batch.count  = n;
+        batch.retval = retval + ( r0 - first );
+        for ( k = 0; k < C_NCOL; k++ )
+            batch.col[k] = col[k] ? col[k] + ( r0 - first ) : NULL;
+
+        errors = S_batch( &batch, 0, n );
+        if ( errors )
+            for ( i = 0; i < n; i++ )
+                for ( e = 0; e < S_F_NERR; e++ )
+                    if ( batch.retval[i] & ( 1L << e ) )
+                        stats->code[e]++;
+        stats->errors += errors;
+        stats->rows   += n;
+    }
+}
@@ -0,0 +1,80 @@
+/*============================================================================
+*
+*    NAME:  solfork.h
+*
+*    Contains:
+*        S_fork_run    (computes a site x time grid in worker processes)
+*        S_arena_free  (unmaps a result arena)
+*        S_grid_run    (computes a range of grid rows in this process)
+*
+*    A grid is every site at every one of ntime evenly spaced UTC times.
+*    Row r of the result is site r / ntime at time start + (r % ntime) *
+*    step, so each site's series is contiguous.
+*
+*    S_fork_run maps one shared anonymous result arena holding all the
+*    selected output columns (float, as in solbatch.h), a per-row return
+*    code, and one counter block per worker.  It then forks the workers;
+*    each takes a contiguous range of rows and runs the batch engine with
+*    its columns pointing straight into the arena, so results are never
+*    copied.  The parent waits for all workers and merges their counters:
+*    rows computed, rows with errors, and how many rows raised each
+*    S_solpos error code.
+*
+*    S_grid_run is the worker loop on its own, for other runners: it
+*    computes rows first .. last-1 into columns (and retval) whose element
+*    0 is row first, adding to the error counters in stats.
+*
+*    A worker that crashes or exits abnormally affects only its own
+*    rows: it is counted in failed, and its range is left as -1 in the
+*    return codes (rows never reached) or as far as it got.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solfork.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLFORK_H
+#define SOLFORK_H
+
+#include <stddef.h>
+#include "solbatch.h"
+
+#define S_F_NERR  ( S_SBSKY_ERROR + 1 )   /* S_solpos error codes */
+
+struct solgrid
+{
+    const struct posdata *sites;     /* site templates, as in solbatch.h */
+    int        nsite;
+    long long  start;                /* UTC seconds of the first time */
+    long       step;                 /* seconds between times */
+    long       ntime;                /* times per site */
+    int        cols;                 /* S_COL() mask of outputs to keep */
+};
+
+struct solfork_stats
+{
+    long rows;                       /* rows computed */
+    long errors;                     /* rows with a nonzero return code */
+    long code[S_F_NERR];             /* rows raising each error code */
+    int  workers;
+    int  failed;                     /* workers that did not exit cleanly */
+};
+
+struct solarena
+{
+    long   rows;                     /* nsite * ntime */
+    float *col[C_NCOL];              /* selected columns, others NULL */
+    long  *retval;                   /* per-row return codes */
+    void  *base;                     /* the mapping */
+    size_t size;
+};
+
+extern int  S_fork_run (const struct solgrid *grid, int workers,
+                        struct solarena *arena, struct solfork_stats *stats);
+extern void S_arena_free (struct solarena *arena);
+extern void S_grid_run (const struct solgrid *grid, long first, long last,
+                        float * const col[C_NCOL], long *retval,
+                        struct solfork_stats *stats);
+
+#endif /* SOLFORK_H */
@@ -0,0 +1,220 @@
+/*============================================================================
+*
+*    NAME:  solload.c
+*
+*    Load generator for solposd.  Opens one connection per client thread,
+*    keeps depth requests in flight on each, and reports throughput and
+*    the round-trip and in-daemon latency distributions (solrt.h
+*    histograms, nanoseconds).
+*
+*    Requests walk through a year of 1-minute timestamps at a spread of
+*    sites, so the daemon sees realistic mixed batches.
+*
+*    Usage:
+*         solload [-s socket] [-c clients] [-n requests per client]
+*                 [-d depth]
+*
+*----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "soldaemon.h"
+#include "solrt.h"
+
+struct loader
+{
+    pthread_t         tid;
+    int               id;
+    long              errors;
+    struct solrt_hist rtt;      /* round trip */
+    struct solrt_hist inside;   /* reported by the daemon */
+};
+
+static const char *path  = S_D_SOCKET;
+static long        count = 100000;
+static int         depth = 32;
+
+static void *load_thread( void *arg );
+static int   full_io( int fd, void *buf, size_t len, int writing );
+static void  merge( struct solrt_hist *to, const struct solrt_hist *from );
+static void  report( const char *name, const struct solrt_hist *h );
+
+
+int main( int argc, char *argv[] )
+{
+  struct loader    *ld;
+  struct solrt_hist rtt, inside;
+  long long t0, t1;
+  long      errors = 0;
+  int       clients = 4, k;
+
+    for ( k = 1; k < argc - 1; k += 2 ) {
+        if ( strcmp( argv[k], "-s" ) == 0 )
+            path = argv[k + 1];
+        else if ( strcmp( argv[k], "-c" ) == 0 )
+            clients = atoi( argv[k + 1] );
+        else if ( strcmp( argv[k], "-n" ) == 0 )
+            count = atol( argv[k + 1] );
+        else if ( strcmp( argv[k], "-d" ) == 0 )
+            depth = atoi( argv[k + 1] );
+    }
+    if ( clients < 1 ) clients = 1;
+    if ( depth < 1 )   depth = 1;
+
+    if ( (ld = (struct loader *) calloc( clients, sizeof( *ld ) )) == NULL )
+        return 1;
+
+    t0 = S_rt_now();
+    for ( k = 0; k < clients; k++ ) {
+        ld[k].id = k;
+        ld[k].rtt.min = ld[k].inside.min = 0x7FFFFFFFFFFFFFFFLL;
+        pthread_create( &ld[k].tid, NULL, load_thread, &ld[k] );
+    }
+
+    memset( &rtt, 0, sizeof( rtt ) );
+    memset( &inside, 0, sizeof( inside ) );
+    rtt.min = inside.min = 0x7FFFFFFFFFFFFFFFLL;
+    for ( k = 0; k < clients; k++ ) {
+        pthread_join( ld[k].tid, NULL );
+        merge( &rtt, &ld[k].rtt );
+        merge( &inside, &ld[k].inside );
+        errors += ld[k].errors;
+    }
+    t1 = S_rt_now();
+
+    printf( "solload: %d clients x %ld requests, depth %d\n",
+            clients, count, depth );
+    printf( "  %llu responses, %ld errors, %.0f requests/s\n",
+            rtt.total, errors, rtt.total / ( ( t1 - t0 ) * 1.0e-9 ) );
+    report( "round trip", &rtt );
+    report( "in daemon",  &inside );
+
+    free( ld );
+    return 0;
+}
+
+
+/*============================================================================
+*    Local void pointer function load_thread
+*----------------------------------------------------------------------------*/
+static void *load_thread( void *arg )
+{
+  struct loader *ld = (struct loader *) arg;
+  struct sockaddr_un addr;
+  struct sold_req  req;
+  struct sold_rsp  rsp;
+  long long *sent;              /* send time by tag */
+  long       nsent, nrecv;
+  int        fd;
+
+    if ( (sent = (long long *) malloc( count * sizeof( *sent ) )) == NULL ) {
+        ld->errors = count;
+        return NULL;
+    }
+
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    strncpy( addr.sun_path, path, sizeof( addr.sun_path ) - 1 );
+    if ( (fd = socket( AF_UNIX, SOCK_STREAM, 0 )) < 0 ||
+         connect( fd, (struct sockaddr *) &addr, sizeof( addr ) ) != 0 ) {
+        perror( "solload: connect" );
+        ld->errors = count;
+        free( sent );
+        return NULL;
+    }
+
+    memset( &req, 0, sizeof( req ) );
+    req.function = S_ALL;
+    req.press    = 1013.0;
+    req.temp     = 15.0;
+    req.aspect   = 180.0;
+
+    for ( nsent = nrecv = 0; nrecv < count; ) {
+        while ( nsent < count && nsent - nrecv < depth ) {
+            req.tag       = (unsigned long long) nsent;
+            req.utc       = 1672531200LL + ( nsent * 60 ) % 31536000LL;
+            req.latitude  = -60.0 + ( ( ld->id * 7 + nsent ) % 121 );
+            req.longitude = -180.0 + ( ( ld->id * 13 + nsent ) % 361 );
+            req.timezone  = (float) (int) ( req.longitude / 15.0 );
+            req.tilt      = fabsf( req.latitude );
+            sent[nsent]   = S_rt_now();
+            if ( full_io( fd, &req, sizeof( req ), 1 ) != 0 )
+                goto done;
+            nsent++;
+        }
+
+        if ( full_io( fd, &rsp, sizeof( rsp ), 0 ) != 0 )
+            goto done;
+        if ( rsp.tag < (unsigned long long) count )
+            S_rt_hist_add( &ld->rtt, S_rt_now() - sent[rsp.tag] );
+        S_rt_hist_add( &ld->inside, rsp.latency );
+        if ( rsp.retval != 0 )
+            ld->errors++;
+        nrecv++;
+    }
+
+done:
+    ld->errors += count - nrecv;
+    close( fd );
+    free( sent );
+    return NULL;
+}
+
+
+/*============================================================================
+*    Local Int function full_io
+*
+*    Reads or writes exactly len bytes; -1 on error or end of file
+*----------------------------------------------------------------------------*/
+static int full_io( int fd, void *buf, size_t len, int writing )
+{
+  char   *p = (char *) buf;
+  ssize_t n;
+
+    while ( len > 0 ) {
+        n = writing ? write( fd, p, len ) : read( fd, p, len );
+        if ( n <= 0 )
+            return -1;
+        p   += n;
+        len -= n;
+    }
+    return 0;
+}
+
+
+/*============================================================================
+*    Local Void function merge
+*----------------------------------------------------------------------------*/
+static void merge( struct solrt_hist *to, const struct solrt_hist *from )
+{
+  int i;
+
+    for ( i = 0; i < S_RT_NBUCKET; i++ )
+        to->count[i] += from->count[i];
+    to->total += from->total;
+    if ( from->total && from->min < to->min )
+        to->min = from->min;
+    if ( from->max > to->max )
+        to->max = from->max;
+}
+
+
+/*============================================================================
+*    Local Void function report
+*----------------------------------------------------------------------------*/
+static void report( const char *name, const struct solrt_hist *h )
+{
+    printf( "  %-10s p50 %9lld  p99 %9lld  p99.9 %9lld  max %9lld ns\n",
+            name,
+            S_rt_hist_quantile( h, 0.50 ),
+            S_rt_hist_quantile( h, 0.99 ),
+            S_rt_hist_quantile( h, 0.999 ),
+            h->max );
+}
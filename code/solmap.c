@@ -0,0 +1,508 @@
+/*============================================================================
+*    Contains:
+*        S_map_open   (creates a raster map file, or reopens one to resume)
+*        S_map_run    (computes the tiles not yet done)
+*        S_map_cell   (reads one cell of a band)
+*        S_map_close  (unmaps a raster map)
+*
+*    The per-time values (eph) are five planes of ntime floats: sin and
+*    cos of the declination, cos and sin of the hour angle at longitude
+*    0, and etrn.  The column loop adds, for each cell, into float sums
+*    over CHUNK times, which are then added into double sums, so a year
+*    of hours keeps float rounding out of the totals without slowing the
+*    vector loop.
+*
+*    Threads claim tiles in file order under a mutex; each has its own
+*    row sums and column trig.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solmap.h"
+*
+*----------------------------------------------------------------------------*/
+#define _DEFAULT_SOURCE
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "solmap.h"
+#include "solvec.h"
+
+#define ALIGN( n )  ( ( (n) + 4095 ) & ~(uint64_t) 4095 )
+#define CHUNK       64
+
+enum { E_SD, E_CD, E_CH, E_SH, E_ETRN, E_N };   /* eph planes */
+enum { A_ETR, A_HOURS, A_CZ, A_B, A_N };        /* sums */
+
+static double raddeg = 0.0174532925199433; /* degrees to radians */
+static double degrad = 57.2957795130823;   /* radians to degrees */
+
+static float sin85   = 0.996194698;     /* coszen at the refraction limits */
+static float sin5    = 0.0871557427;
+static float sin0575 = -0.0100354747;
+
+struct work
+{
+    struct solmap   *map;
+    pthread_mutex_t *lock;
+    long            *next;       /* first tile not yet claimed */
+    long            *budget;     /* tiles still allowed */
+    long             tiles;      /* tiles this thread computed */
+    int              error;
+};
+
+static uint64_t layout( const struct solmap_head *h, struct solmap *map );
+static int      ephemeris( struct solmap *map );
+static void    *worker( void *arg );
+static int      tile( struct solmap *map, long k, float *buf );
+static void     sweep( const struct solmap *map, long n, const float *clon,
+                       const float *slon, double sp, double cp, double g,
+                       double beta, float *fsum, double *sum );
+static void     hours( long n, const float *restrict clon,
+                       const float *restrict slon, float ch, float sh,
+                       float a0, float a1, float b0, float b1, float e,
+                       float pt, float cb, float sb, float *restrict fe,
+                       float *restrict fh, float *restrict fa,
+                       float *restrict fb );
+static int      flush( void *addr, size_t len );
+
+
+/*============================================================================
+*    Int function S_map_open
+*
+*    Opens path to resume if it holds a map of this grid, else creates
+*    it.  press, temp and solcon are taken from site.
+*----------------------------------------------------------------------------*/
+int S_map_open (const char *path, const struct solmapgrid *grid,
+                const struct posdata *site, struct solmap *map)
+{
+  struct solmap_head h, *o;
+  struct stat st;
+  uint64_t size;
+  long     k;
+
+    memset( map, 0, sizeof( *map ) );
+    map->fd = -1;
+    if ( grid->nrow < 1 || grid->ncol < 1 || grid->ntime < 1 ||
+         grid->tstep < 1 || !( grid->step > 0.0 ) || grid->tile < 0 ||
+         grid->tile % 32 != 0 )
+        return -1;
+
+    memset( &h, 0, sizeof( h ) );
+    memcpy( h.magic, S_MAP_MAGIC, sizeof( S_MAP_MAGIC ) );
+    h.version = S_MAP_VERSION;
+    h.endian  = S_MAP_ENDIAN;
+    h.lat0    = grid->lat0;
+    h.lon0    = grid->lon0;
+    h.step    = grid->step;
+    h.nrow    = grid->nrow;
+    h.ncol    = grid->ncol;
+    h.start   = grid->start;
+    h.tstep   = grid->tstep;
+    h.ntime   = grid->ntime;
+    h.tile    = grid->tile ? grid->tile : S_MAP_TILE;
+    h.nband   = M_NBAND;
+    h.press   = site->press;
+    h.temp    = site->temp;
+    h.solcon  = site->solcon;
+    h.size    = size = layout( &h, map );
+
+    if ( (map->fd = open( path, O_RDWR | O_CREAT, 0666 )) < 0 ||
+         fstat( map->fd, &st ) != 0 ) {
+        S_map_close( map );
+        return -1;
+    }
+    if ( st.st_size == 0 && ftruncate( map->fd, (off_t) size ) != 0 ) {
+        S_map_close( map );
+        return -1;
+    }
+    if ( st.st_size != 0 && (uint64_t) st.st_size != size ) {
+        S_map_close( map );
+        return 1;
+    }
+
+    map->size = size;
+    map->base = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      map->fd, 0 );
+    if ( map->base == MAP_FAILED ) {
+        map->base = NULL;
+        S_map_close( map );
+        return -1;
+    }
+    o = (struct solmap_head *) map->base;
+    if ( st.st_size == 0 )
+        memcpy( o, &h, sizeof( h ) );
+    else if ( memcmp( o, &h, sizeof( h ) ) != 0 ) {
+        S_map_close( map );
+        return 1;
+    }
+    layout( o, map );
+
+    for ( k = 0; k < map->trow * map->tcol; k++ )
+        map->pending += !map->done[k];
+    if ( ephemeris( map ) != 0 ) {
+        S_map_close( map );
+        return -1;
+    }
+    return 0;
+}
+
+
+/*============================================================================
+*    Long integer function S_map_run
+*
+*    Computes at most maxtiles tiles (all if maxtiles <= 0) on threads
+*    threads, in file order
+*----------------------------------------------------------------------------*/
+long S_map_run (struct solmap *map, int threads, long maxtiles)
+{
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  pthread_t *tid;
+  struct work *w;
+  long   next = 0, budget = maxtiles > 0 ? maxtiles : map->pending, n = 0;
+  int    started, t, error = 0;
+
+    if ( threads > budget )
+        threads = (int) budget;
+    if ( threads < 1 )
+        threads = 1;
+    w   = (struct work *) malloc( threads * sizeof( *w ) );
+    tid = (pthread_t *) malloc( threads * sizeof( *tid ) );
+    if ( w == NULL || tid == NULL ) {
+        free( w );
+        free( tid );
+        return -1;
+    }
+    for ( t = 0; t < threads; t++ ) {
+        w[t].map    = map;
+        w[t].lock   = &lock;
+        w[t].next   = &next;
+        w[t].budget = &budget;
+        w[t].tiles  = 0;
+        w[t].error  = 0;
+    }
+
+    for ( started = 1; started < threads; started++ )
+        if ( pthread_create( &tid[started], NULL, worker, &w[started] ) != 0 )
+            break;
+    worker( &w[0] );
+    for ( t = 1; t < started; t++ )
+        pthread_join( tid[t], NULL );
+
+    for ( t = 0; t < started; t++ ) {
+        n     += w[t].tiles;
+        error |= w[t].error;
+    }
+    free( w );
+    free( tid );
+    return error ? -1 : n;
+}
+
+
+/*============================================================================
+*    Float function S_map_cell
+*
+*    NaN if the cell is outside the grid or its tile is not done
+*----------------------------------------------------------------------------*/
+float S_map_cell (const struct solmap *map, int band, long row, long col)
+{
+  long t = map->head->tile, k;
+
+    if ( band < 0 || band >= M_NBAND || row < 0 || row >= map->head->nrow ||
+         col < 0 || col >= map->head->ncol )
+        return NAN;
+    k = ( row / t ) * map->tcol + col / t;
+    if ( !map->done[k] )
+        return NAN;
+    return map->data[( ( k * M_NBAND + band ) * t + row % t ) * t + col % t];
+}
+
+
+/*============================================================================
+*    Void function S_map_close
+*----------------------------------------------------------------------------*/
+void S_map_close (struct solmap *map)
+{
+    if ( map->base )
+        munmap( map->base, map->size );
+    if ( map->fd >= 0 )
+        close( map->fd );
+    free( map->eph );
+    memset( map, 0, sizeof( *map ) );
+    map->fd = -1;
+}
+
+
+/*============================================================================
+*    Local uint64_t function layout
+*
+*    Size of the file of header h; sets the tile counts and, if the map
+*    is mapped, the section pointers
+*----------------------------------------------------------------------------*/
+static uint64_t layout( const struct solmap_head *h, struct solmap *map )
+{
+  uint64_t t = h->tile, tiles, off;
+
+    map->trow = (long) ( ( h->nrow + t - 1 ) / t );
+    map->tcol = (long) ( ( h->ncol + t - 1 ) / t );
+    tiles     = (uint64_t) map->trow * map->tcol;
+    off       = ALIGN( sizeof( *h ) + tiles );
+    if ( map->base ) {
+        map->head = (struct solmap_head *) map->base;
+        map->done = (uint8_t *) map->base + sizeof( *h );
+        map->data = (float *) ( (char *) map->base + off );
+    }
+    return off + tiles * t * t * h->nband * sizeof( float );
+}
+
+
+/*============================================================================
+*    Local Int function ephemeris
+*
+*    The per-time values, from S_solpos at longitude 0; -1 if out of
+*    memory or S_solpos rejects a time
+*----------------------------------------------------------------------------*/
+static int ephemeris( struct solmap *map )
+{
+  const struct solmap_head *h = map->head;
+  struct posdata pd;
+  float *e;
+  double ha;
+  long   t, n = (long) h->ntime;
+
+    if ( (e = map->eph = (float *) malloc( E_N * n * sizeof( float ) ))
+         == NULL )
+        return -1;
+    S_init( &pd );
+    pd.latitude  = 0.0;
+    pd.longitude = 0.0;
+    pd.timezone  = 0.0;
+    pd.interval  = 0;
+    pd.solcon    = h->solcon;
+    for ( t = 0; t < n; t++ ) {
+        pd.function = S_GEOM;
+        S_epoch( &pd, h->start + t * h->tstep - h->tstep / 2 );
+        if ( S_solpos( &pd ) != 0 )
+            return -1;
+        ha = raddeg * ( pd.gmst * 15.0 - pd.rascen );
+        e[E_SD * n + t]   = sin( raddeg * pd.declin );
+        e[E_CD * n + t]   = cos( raddeg * pd.declin );
+        e[E_CH * n + t]   = cos( ha );
+        e[E_SH * n + t]   = sin( ha );
+        e[E_ETRN * n + t] = pd.solcon * pd.erv;
+    }
+    return 0;
+}
+
+
+/*============================================================================
+*    Local void pointer function worker
+*----------------------------------------------------------------------------*/
+static void *worker( void *arg )
+{
+  struct work   *w = (struct work *) arg;
+  struct solmap *map = w->map;
+  long   tiles = map->trow * map->tcol, k, t = map->head->tile;
+  float *buf = (float *) malloc( ( 6 * t + 4 * t * 2 ) * sizeof( float ) );
+
+    if ( buf == NULL ) {
+        w->error = 1;
+        return NULL;
+    }
+    for ( ;; ) {
+        pthread_mutex_lock( w->lock );
+        while ( *w->next < tiles && map->done[*w->next] )
+            ( *w->next )++;
+        k = *w->budget > 0 && *w->next < tiles ? ( *w->next )++ : -1;
+        if ( k >= 0 )
+            ( *w->budget )--;
+        pthread_mutex_unlock( w->lock );
+        if ( k < 0 )
+            break;
+
+        if ( tile( map, k, buf ) != 0 ) {
+            w->error = 1;
+            break;
+        }
+        pthread_mutex_lock( w->lock );
+        map->pending--;
+        pthread_mutex_unlock( w->lock );
+        w->tiles++;
+    }
+    free( buf );
+    return NULL;
+}
+
+
+/*============================================================================
+*    Local Int function tile
+*
+*    Computes tile k into the file, writes it through and marks it done.
+*    buf holds 6 tile edges of floats and 4 of doubles.
+*----------------------------------------------------------------------------*/
+static int tile( struct solmap *map, long k, float *buf )
+{
+  const struct solmap_head *h = map->head;
+  long    t = h->tile, r0 = ( k / map->tcol ) * t, c0 = ( k % map->tcol ) * t;
+  long    nr = h->nrow - r0 < t ? h->nrow - r0 : t;
+  long    nc = h->ncol - c0 < t ? h->ncol - c0 : t;
+  float  *out = map->data + k * M_NBAND * t * t, *clon = buf, *slon = buf + t;
+  double *sum = (double *) ( buf + 6 * t ), lat, sp, cp, g, beta = 0.0, b;
+  double  dt = h->tstep / 3600.0;
+  long    r, c, m = nc / 2;
+  int     it;
+
+    for ( c = 0; c < nc; c++ ) {
+        clon[c] = cos( raddeg * ( h->lon0 + ( c0 + c ) * h->step ) );
+        slon[c] = sin( raddeg * ( h->lon0 + ( c0 + c ) * h->step ) );
+    }
+
+    for ( r = 0; r < nr; r++ ) {
+        lat = h->lat0 - ( r0 + r ) * h->step;
+        sp  = sin( raddeg * lat );
+        cp  = cos( raddeg * lat );
+        g   = lat >= 0.0 ? 1.0 : -1.0;
+
+        /* the row's tilt: iterate at the middle cell, from the last row's */
+        if ( r == 0 )
+            beta = raddeg * fabs( lat );
+        for ( it = 0; it < 20; it++ ) {
+            sweep( map, 1, clon + m, slon + m, sp, cp, g, beta, buf + 2 * t,
+                   sum );
+            b = sum[A_CZ] > 0.0 || sum[A_B] != 0.0 ?
+                atan2( sum[A_B], sum[A_CZ] ) : 0.0;
+            if ( fabs( b - beta ) < 1.0e-6 )
+                break;
+            beta = b;
+        }
+
+        sweep( map, nc, clon, slon, sp, cp, g, beta, buf + 2 * t, sum );
+        for ( c = 0; c < nc; c++ ) {
+            out[( M_ETR * t + r ) * t + c]      = sum[A_ETR * t + c] * dt /
+                                                  1000.0;
+            out[( M_SUNHOURS * t + r ) * t + c] = sum[A_HOURS * t + c] * dt;
+            out[( M_TILT * t + r ) * t + c]     =
+                sum[A_CZ * t + c] > 0.0 || sum[A_B * t + c] != 0.0 ?
+                degrad * atan2( sum[A_B * t + c], sum[A_CZ * t + c] ) : 0.0;
+        }
+    }
+
+    if ( flush( out, M_NBAND * t * t * sizeof( float ) ) != 0 )
+        return -1;
+    map->done[k] = 1;
+    return flush( map->done + k, 1 );
+}
+
+
+/*============================================================================
+*    Local Void function sweep
+*
+*    The sums of n cells of one row (latitude sine sp, cosine cp, g 1
+*    north of the equator and -1 south) with the plane at tilt beta
+*    radians; sum holds A_N planes of n (of the tile edge when n is 1,
+*    as only element 0 of each is used then).  fsum is 4 tile edges.
+*----------------------------------------------------------------------------*/
+static void sweep( const struct solmap *map, long n, const float *clon,
+                   const float *slon, double sp, double cp, double g,
+                   double beta, float *fsum, double *sum )
+{
+  const struct solmap_head *h = map->head;
+  const float *e = map->eph;
+  long   nt = (long) h->ntime, t, t1, c, s = n > 1 ? h->tile : 1, f;
+  float  pt = h->press * 283.0 / ( 1013.0 * ( 273.0 + h->temp ) ) / 3600.0 *
+              raddeg;
+  float  cb = cos( beta ), sb = sin( beta ), sd, cd;
+
+    for ( f = 0; f < A_N; f++ )
+        for ( c = 0; c < n; c++ )
+            sum[f * s + c] = 0.0;
+
+    for ( t1 = 0; t1 < nt; t1 += CHUNK ) {
+        memset( fsum, 0, 4 * h->tile * sizeof( float ) );
+        for ( t = t1; t < t1 + CHUNK && t < nt; t++ ) {
+            sd = e[E_SD * nt + t];
+            cd = e[E_CD * nt + t];
+            hours( n, clon, slon, e[E_CH * nt + t], e[E_SH * nt + t],
+                   sd * sp, cd * cp, g * sd * cp, g * cd * sp,
+                   e[E_ETRN * nt + t], pt, cb, sb, fsum, fsum + h->tile,
+                   fsum + 2 * h->tile, fsum + 3 * h->tile );
+        }
+        for ( f = 0; f < A_N; f++ )
+            for ( c = 0; c < n; c++ )
+                sum[f * s + c] += fsum[f * h->tile + c];
+    }
+}
+
+
+/*============================================================================
+*    Local Void function hours
+*
+*    One time, n cells of a row.  With cos h = ch clon - sh slon the
+*    cosine of the hour angle, coszen (unrefracted) is a0 + a1 cos h and
+*    the sun's component toward the equator B = b1 cos h - b0.  The
+*    refraction correction is that of S_solpos (Zimmerman 1981) from
+*    the elevation, applied by the angle sum with its sine and cosine to
+*    second order (it is under 0.01 rad); pt is its pressure and
+*    temperature factor over 3600, in radians.  The elevation limits
+*    are compared as sines, and the elevation itself is only needed
+*    below 5 degrees, where asin is x + x^3 / 6 to 4e-7 rad.
+*----------------------------------------------------------------------------*/
+static void hours( long n, const float *restrict clon,
+                   const float *restrict slon, float ch, float sh,
+                   float a0, float a1, float b0, float b1, float e,
+                   float pt, float cb, float sb, float *restrict fe,
+                   float *restrict fh, float *restrict fa,
+                   float *restrict fb )
+{
+  float   c, cz, bb, ce, el, ti, ref, d, czr, ci;
+  int32_t up, lit;
+  long    i;
+
+    for ( i = 0; i < n; i++ ) {
+        c   = ch * clon[i] - sh * slon[i];
+        cz  = a0 + a1 * c;
+        cz  = vsel( -( cz > 1.0f ), 1.0f, vsel( -( cz < -1.0f ), -1.0f, cz ) );
+        bb  = b1 * c - b0;
+        ce  = vsqrt( 1.0f - cz * cz );
+        ti  = ce / vsel( -( cz != 0.0f ), cz, 1.0f );   /* 1 / tan el */
+        el  = 57.2957795f * cz * ( 1.0f + 1.66666667e-1f * cz * cz );
+        ref = vsel( -( cz >= sin5 ),
+                    ti * ( 58.1f + ti * ti * ( -0.07f + ti * ti * 0.000086f ) ),
+              vsel( -( cz >= sin0575 ),
+                    1735.0f + el * ( -518.2f + el * ( 103.4f + el * ( -12.79f +
+                    el * 0.711f ) ) ),
+                    -20.774f * ti ) );
+        ref = vsel( -( cz > sin85 ), 0.0f, ref );
+        d   = ref * pt;
+        czr = cz * ( 1.0f - 0.5f * d * d ) +
+              ce * d * ( 1.0f - 1.66666667e-1f * d * d );
+        up  = -( czr > 0.0f );
+        fe[i] += vsel( up, e * czr, 0.0f );
+        fh[i] += vsel( up, 1.0f, 0.0f );
+
+        ci  = cz * cb + bb * sb;
+        lit = up & -( ci > 0.0f );
+        fa[i] += vsel( lit, e * cz, 0.0f );
+        fb[i] += vsel( lit, e * bb, 0.0f );
+    }
+}
+
+
+/*============================================================================
+*    Local Int function flush
+*
+*    Writes len bytes at addr through to the file (msync wants a page
+*    boundary)
+*----------------------------------------------------------------------------*/
+static int flush( void *addr, size_t len )
+{
+  uintptr_t a = (uintptr_t) addr, p = (uintptr_t) sysconf( _SC_PAGESIZE );
+
+    return msync( (void *) ( a & ~( p - 1 ) ), len + ( a & ( p - 1 ) ),
+                  MS_SYNC );
+}
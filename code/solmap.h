@@ -0,0 +1,126 @@
+/*============================================================================
+*
+*    NAME:  solmap.h
+*
+*    Contains:
+*        S_map_open   (creates a raster map file, or reopens one to resume)
+*        S_map_run    (computes the tiles not yet done)
+*        S_map_cell   (reads one cell of a band)
+*        S_map_close  (unmaps a raster map)
+*
+*    Solar-resource rasters over a latitude/longitude grid, summed over
+*    ntime evenly spaced times (a year of hours, typically):
+*
+*        M_ETR       extraterrestrial horizontal irradiation, kWh/m2 (the
+*                    sum of etr times the time step)
+*        M_SUNHOURS  hours with the sun up (coszen > 0, refracted)
+*        M_TILT      tilt, degrees, of the equator-facing plane that gets
+*                    the most extraterrestrial beam, etrn max( cosinc, 0 );
+*                    negative if the plane should face the pole
+*
+*    Cell ( row, col ) is centred at latitude lat0 - row * step and
+*    longitude lon0 + col * step: row 0 is the north edge.  Each time is
+*    the end of an interval of tstep seconds, as with a site's interval
+*    in S_solpos, so the sun is taken at the middle of each step.
+*
+*    Nothing of the solar position depends on the cell but the hour
+*    angle and the latitude: the declination, right ascension, sidereal
+*    time and earth radius vector of each time are computed once, by
+*    S_solpos, when the map is opened; the cosine and sine of the
+*    longitude once per column and of the latitude once per row.  The
+*    coszen of a cell is then a few multiplies, and the refraction
+*    correction is that of S_solpos done with the float functions of
+*    solvec.h, so the sums agree with S_solpos row by row.
+*
+*    The file is the header, one done byte per tile, and the tiles,
+*    each tile x tile cells of every band ( band, row, col within the
+*    tile, edge tiles padded), mapped with mmap and written in place.
+*    Within a tile the work goes row by row, and for each row time by
+*    time over a vector of columns, so the per-time values are read in
+*    order and the row's sums stay in cache.  A tile is written through
+*    to the file before its done byte is set, so a map that was stopped,
+*    killed or given a tile budget (S_map_run's maxtiles) can be reopened
+*    with the same grid and times and continued; tiles done are never
+*    computed twice.
+*
+*    The optimal tilt is the fixed point of tilt = atan2( sum of etrn
+*    B, sum of etrn coszen ) over the hours when the plane is lit (B is
+*    the sun's component toward the equator): it is found by iteration
+*    at the middle cell of each tile row, then every cell of the row
+*    takes one step from there.
+*
+*    S_map_open returns 0; -1 if the file cannot be created or mapped, or
+*    the grid is empty; or 1 if the file exists but is not a map of the
+*    same grid, times and site constants (it is then left untouched).
+*    S_map_run returns the number of tiles computed, or -1 if out of
+*    memory or a tile could not be written through.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solmap.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLMAP_H
+#define SOLMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "solpos00.h"
+
+#define S_MAP_MAGIC    "SOLMAP1"
+#define S_MAP_VERSION  1
+#define S_MAP_ENDIAN   0x01020304u
+#define S_MAP_TILE     128            /* default tile edge, cells */
+
+enum { M_ETR, M_SUNHOURS, M_TILT, M_NBAND };   /* band */
+
+struct solmapgrid
+{
+    double     lat0, lon0;       /* centre of cell ( 0, 0 ), degrees */
+    double     step;             /* cell size, degrees */
+    long       nrow, ncol;
+    int        tile;             /* tile edge, cells (a multiple of 32);
+                                    0 = S_MAP_TILE */
+    long long  start;            /* UTC seconds of the first time */
+    long       tstep;            /* seconds between times */
+    long       ntime;
+};
+
+struct solmap_head               /* 128 bytes */
+{
+    char     magic[8];           /* S_MAP_MAGIC */
+    uint32_t version;
+    uint32_t endian;             /* S_MAP_ENDIAN as written */
+    double   lat0, lon0, step;
+    int64_t  nrow, ncol;
+    int64_t  start, tstep, ntime;
+    uint32_t tile;
+    uint32_t nband;
+    float    press, temp, solcon; /* from the site template */
+    uint32_t reserved0;
+    uint64_t size;               /* whole file, bytes */
+    uint8_t  reserved[16];
+};
+
+struct solmap
+{
+    int                  fd;
+    void                *base;
+    size_t               size;
+    struct solmap_head  *head;
+    uint8_t             *done;   /* per tile, row-major over the tiles */
+    float               *data;   /* the tiles */
+    long                 trow, tcol;  /* tiles down and across */
+    long                 pending;     /* tiles not done */
+    float               *eph;    /* per-time values, from S_map_open */
+};
+
+extern int   S_map_open (const char *path, const struct solmapgrid *grid,
+                         const struct posdata *site, struct solmap *map);
+extern long  S_map_run (struct solmap *map, int threads, long maxtiles);
+extern float S_map_cell (const struct solmap *map, int band, long row,
+                         long col);
+extern void  S_map_close (struct solmap *map);
+
+#endif /* SOLMAP_H */
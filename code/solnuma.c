@@ -0,0 +1,322 @@
+/*============================================================================
+*    Contains:
+*        S_numa_topology  (reads the NUMA nodes and their CPUs)
+*        S_numa_grid      (computes a grid with node-local threads and slabs)
+*        S_numa_free      (releases the slabs of a run)
+*
+*    Threads are spread over the nodes in proportion to their CPU
+*    counts (at least one per node), and over each node's CPUs in turn.
+*    The calling thread starts one thread per node; that thread pins
+*    itself, copies the site templates, starts the node's other threads
+*    and computes the node's first slab.  A slab whose thread could not
+*    be started is computed by its node thread afterwards, still on the
+*    right node.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solnuma.h"
+*
+*----------------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "solnuma.h"
+#include "solrt.h"
+
+struct nodework      /* one node's share of a run */
+{
+    const struct solgrid *grid;      /* the caller's */
+    struct solgrid        local;     /* sites pointing at the node's copy */
+    struct posdata       *sites;
+    struct solslab       *slab;      /* the node's slabs */
+    int                   nslab;
+};
+
+struct slabwork
+{
+    const struct solgrid *grid;
+    struct solslab       *slab;
+};
+
+static int   cpulist( const char *path, int *cpu, int max );
+static void *node_thread( void *arg );
+static void *slab_thread( void *arg );
+
+
+/*============================================================================
+*    Int function S_numa_topology
+*
+*    Returns the number of nodes (at least 1)
+*----------------------------------------------------------------------------*/
+int S_numa_topology (struct solnuma *topo)
+{
+  struct solnuma_node *nd;
+  char  path[96];
+  int   id[S_NUMA_MAXNODE], nid, i, k;
+
+    memset( topo, 0, sizeof( *topo ) );
+    nid = cpulist( "/sys/devices/system/node/online", id, S_NUMA_MAXNODE );
+    for ( i = 0; i < nid; i++ ) {
+        snprintf( path, sizeof( path ),
+                  "/sys/devices/system/node/node%d/cpulist", id[i] );
+        nd = &topo->node[topo->nnode];
+        nd->ncpu = cpulist( path, nd->cpu, S_NUMA_MAXCPU );
+        if ( nd->ncpu > 0 ) {                    /* memory-only nodes skipped */
+            nd->id = id[i];
+            topo->nnode++;
+        }
+    }
+
+    if ( topo->nnode == 0 ) {                   /* no sysfs: one node */
+        nd = &topo->node[0];
+        nd->ncpu = (int) sysconf( _SC_NPROCESSORS_ONLN );
+        if ( nd->ncpu < 1 )
+            nd->ncpu = 1;
+        if ( nd->ncpu > S_NUMA_MAXCPU )
+            nd->ncpu = S_NUMA_MAXCPU;
+        for ( k = 0; k < nd->ncpu; k++ )
+            nd->cpu[k] = k;
+        topo->nnode = 1;
+    }
+    return topo->nnode;
+}
+
+
+/*============================================================================
+*    Int function S_numa_grid
+*
+*    threads 0 means one per CPU.  Returns 0, or -1 if memory for a slab
+*    ran out (the run is then freed).
+*----------------------------------------------------------------------------*/
+int S_numa_grid (const struct solgrid *grid, const struct solnuma *topo,
+                 int threads, struct solnuma_run *run)
+{
+  struct nodework *nw;
+  pthread_t *tid;
+  long   rows = (long) grid->nsite * grid->ntime;
+  int    ncpu = 0, per[S_NUMA_MAXNODE], n, i, k, t, fail = 0;
+
+    memset( run, 0, sizeof( *run ) );
+    for ( n = 0; n < topo->nnode; n++ )
+        ncpu += topo->node[n].ncpu;
+    if ( threads <= 0 )
+        threads = ncpu;
+    if ( threads < topo->nnode )
+        threads = topo->nnode;
+
+    /* threads per node, in proportion to its CPUs */
+    for ( t = 0, n = 0; n < topo->nnode; n++ ) {
+        per[n] = (int) ( (long) threads * topo->node[n].ncpu / ncpu );
+        if ( per[n] < 1 )
+            per[n] = 1;
+        t += per[n];
+    }
+    for ( n = 0; t < threads; n = ( n + 1 ) % topo->nnode, t++ )
+        per[n]++;
+    threads = t;
+
+    run->nslab = threads;
+    run->slab  = (struct solslab *) calloc( threads, sizeof( *run->slab ) );
+    nw  = (struct nodework *) calloc( topo->nnode, sizeof( *nw ) );
+    tid = (pthread_t *) calloc( topo->nnode, sizeof( *tid ) );
+    if ( !run->slab || !nw || !tid ) {
+        free( nw );
+        free( tid );
+        S_numa_free( run );
+        return -1;
+    }
+
+    /* rows in proportion to threads, contiguous per thread */
+    for ( i = 0, n = 0; n < topo->nnode; n++ ) {
+        nw[n].grid  = grid;
+        nw[n].slab  = &run->slab[i];
+        nw[n].nslab = per[n];
+        for ( k = 0; k < per[n]; k++, i++ ) {
+            run->slab[i].node  = n;
+            run->slab[i].cpu   = topo->node[n].cpu[k % topo->node[n].ncpu];
+            run->slab[i].first = rows * i / threads;
+            run->slab[i].last  = rows * ( i + 1 ) / threads;
+        }
+    }
+
+    for ( n = 0; n < topo->nnode; n++ )
+        if ( pthread_create( &tid[n], NULL, node_thread, &nw[n] ) != 0 ) {
+            node_thread( &nw[n] );       /* here, unpinned, but complete */
+            tid[n] = pthread_self();
+        }
+    for ( n = 0; n < topo->nnode; n++ )
+        if ( !pthread_equal( tid[n], pthread_self() ) )
+            pthread_join( tid[n], NULL );
+
+    for ( i = 0; i < threads; i++ ) {
+        n = run->slab[i].node;
+        run->rows[n] += run->slab[i].stats.rows;
+        if ( run->slab[i].ns > run->ns[n] )
+            run->ns[n] = run->slab[i].ns;
+        run->errors += run->slab[i].stats.errors;
+        if ( run->slab[i].stats.rows < run->slab[i].last - run->slab[i].first )
+            fail = 1;                        /* a slab could not be had */
+    }
+    for ( n = 0; n < topo->nnode; n++ )
+        run->rate[n] = run->ns[n] > 0 ? run->rows[n] / ( run->ns[n] * 1.0e-9 )
+                                      : 0.0;
+
+    free( nw );
+    free( tid );
+    if ( fail ) {
+        S_numa_free( run );
+        return -1;
+    }
+    return 0;
+}
+
+
+/*============================================================================
+*    Void function S_numa_free
+*----------------------------------------------------------------------------*/
+void S_numa_free (struct solnuma_run *run)
+{
+  int i, k;
+
+    for ( i = 0; run->slab && i < run->nslab; i++ ) {
+        for ( k = 0; k < C_NCOL; k++ )
+            free( run->slab[i].col[k] );
+        free( run->slab[i].retval );
+    }
+    free( run->slab );
+    memset( run, 0, sizeof( *run ) );
+}
+
+
+/*============================================================================
+*    Local Int function cpulist
+*
+*    Parses a sysfs list such as "0-7,16-23" (CPUs or nodes); returns the
+*    count, or 0
+*----------------------------------------------------------------------------*/
+static int cpulist( const char *path, int *cpu, int max )
+{
+  FILE *fp;
+  char  buf[4096], *p, *q;
+  long  a, b;
+  int   n = 0;
+
+    if ( (fp = fopen( path, "r" )) == NULL )
+        return 0;
+    if ( fgets( buf, sizeof( buf ), fp ) == NULL )
+        buf[0] = 0;
+    fclose( fp );
+
+    for ( p = buf; *p && *p != '\n'; ) {
+        a = strtol( p, &q, 10 );
+        if ( q == p )
+            break;
+        b = a;
+        if ( *q == '-' ) {
+            p = q + 1;
+            b = strtol( p, &q, 10 );
+        }
+        for ( ; a <= b && n < max; a++ )
+            cpu[n++] = (int) a;
+        p = ( *q == ',' ) ? q + 1 : q;
+    }
+    return n;
+}
+
+
+/*============================================================================
+*    Local void pointer function node_thread
+*----------------------------------------------------------------------------*/
+static void *node_thread( void *arg )
+{
+  struct nodework *nw = (struct nodework *) arg;
+  struct slabwork *sw;
+  pthread_t *tid;
+  cpu_set_t  set;
+  int       *up, k;
+
+    /* pin to the node's first slab CPU, so the copy is node-local */
+    CPU_ZERO( &set );
+    CPU_SET( nw->slab[0].cpu, &set );
+    pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+
+    nw->local = *nw->grid;
+    nw->sites = (struct posdata *) malloc( nw->grid->nsite *
+                                           sizeof( struct posdata ) );
+    if ( nw->sites ) {
+        memcpy( nw->sites, nw->grid->sites,
+                nw->grid->nsite * sizeof( struct posdata ) );
+        nw->local.sites = nw->sites;
+    }
+
+    sw  = (struct slabwork *) malloc( nw->nslab * sizeof( *sw ) );
+    tid = (pthread_t *) malloc( nw->nslab * sizeof( *tid ) );
+    up  = (int *) calloc( nw->nslab, sizeof( int ) );
+    if ( sw && tid && up ) {
+        for ( k = 0; k < nw->nslab; k++ ) {
+            sw[k].grid = &nw->local;
+            sw[k].slab = &nw->slab[k];
+        }
+        for ( k = 1; k < nw->nslab; k++ )
+            up[k] = pthread_create( &tid[k], NULL, slab_thread, &sw[k] ) == 0;
+        slab_thread( &sw[0] );
+        for ( k = 1; k < nw->nslab; k++ )
+            if ( up[k] )
+                pthread_join( tid[k], NULL );
+            else
+                slab_thread( &sw[k] );       /* on this node, just later */
+    }
+
+    free( sw );
+    free( tid );
+    free( up );
+    free( nw->sites );
+    nw->sites = NULL;
+    return NULL;
+}
+
+
+/*============================================================================
+*    Local void pointer function slab_thread
+*----------------------------------------------------------------------------*/
+static void *slab_thread( void *arg )
+{
+  struct slabwork *sw = (struct slabwork *) arg;
+  struct solslab  *sl = sw->slab;
+  cpu_set_t set;
+  long      n = sl->last - sl->first;
+  long long t0;
+  int       k, ok;
+
+    /* pin first, so every allocation below is local */
+    CPU_ZERO( &set );
+    CPU_SET( sl->cpu, &set );
+    if ( pthread_setaffinity_np( pthread_self(), sizeof( set ), &set ) != 0 )
+        sl->cpu = -1;
+
+    /* allocate and first-touch this thread's slab */
+    sl->retval = (long *) malloc( n * sizeof( long ) );
+    ok = sl->retval != NULL;
+    if ( ok )
+        memset( sl->retval, 0xFF, n * sizeof( long ) );
+    for ( k = 0; ok && k < C_NCOL; k++ )
+        if ( sw->grid->cols & S_COL( k ) ) {
+            if ( (sl->col[k] = (float *) malloc( n * sizeof( float ) )) )
+                memset( sl->col[k], 0, n * sizeof( float ) );
+            else
+                ok = 0;
+        }
+    if ( !ok )
+        return NULL;
+
+    t0 = S_rt_now();
+    S_grid_run( sw->grid, sl->first, sl->last, sl->col, sl->retval,
+                &sl->stats );
+    sl->ns = S_rt_now() - t0;
+    return NULL;
+}
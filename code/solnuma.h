@@ -0,0 +1,82 @@
+/*============================================================================
+*
+*    NAME:  solnuma.h
+*
+*    Contains:
+*        S_numa_topology  (reads the NUMA nodes and their CPUs)
+*        S_numa_grid      (computes a grid with node-local threads and slabs)
+*        S_numa_free      (releases the slabs of a run)
+*
+*    On a multi-socket machine memory is fastest from the node that owns
+*    it, and Linux places a page on the node of the thread that first
+*    touches it.  S_numa_grid therefore splits a grid (solfork.h) between
+*    the nodes in proportion to their threads, pins every thread to a CPU
+*    of its node, and has each thread allocate and first-touch its own
+*    output slab before computing into it.  The site templates are
+*    copied once per node, by the node's first thread, and that node's
+*    threads read only their copy.
+*
+*    Results stay where they were computed: slab i holds grid rows
+*    first .. last-1, with the grid's selected columns and the return
+*    codes, indexed from 0.  Per-node rows, wall time and throughput are
+*    reported in the run.
+*
+*    The topology comes from /sys/devices/system/node; without it, or
+*    with a single node, everything runs as node 0 and the only change
+*    from S_batch_parallel is the pinning and thread-local slabs.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solnuma.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLNUMA_H
+#define SOLNUMA_H
+
+#include "solfork.h"
+
+#define S_NUMA_MAXNODE  64
+#define S_NUMA_MAXCPU   1024
+
+struct solnuma_node
+{
+    int id;                      /* node number */
+    int ncpu;
+    int cpu[S_NUMA_MAXCPU];
+};
+
+struct solnuma
+{
+    int                 nnode;
+    struct solnuma_node node[S_NUMA_MAXNODE];
+};
+
+struct solslab
+{
+    int        node;             /* index into the topology */
+    int        cpu;              /* pinned to; -1 if pinning failed */
+    long       first, last;      /* grid rows */
+    float     *col[C_NCOL];      /* selected columns, others NULL */
+    long      *retval;
+    long long  ns;               /* thread's compute time */
+    struct solfork_stats stats;
+};
+
+struct solnuma_run
+{
+    int             nslab;
+    struct solslab *slab;
+    long            rows[S_NUMA_MAXNODE];   /* per node */
+    long long       ns[S_NUMA_MAXNODE];     /* slowest thread of the node */
+    double          rate[S_NUMA_MAXNODE];   /* rows per second */
+    long            errors;                 /* rows with errors, all nodes */
+};
+
+extern int  S_numa_topology (struct solnuma *topo);
+extern int  S_numa_grid (const struct solgrid *grid,
+                         const struct solnuma *topo, int threads,
+                         struct solnuma_run *run);
+extern void S_numa_free (struct solnuma_run *run);
+
+#endif /* SOLNUMA_H */
@@ -0,0 +1,333 @@
+/*============================================================================
+*    Contains:
+*        S_sky_build     (reduces a year of sun positions at one site to a
+*                         compact set of irradiance-weighted sun vectors)
+*        S_sky_etrtilt   (ETR on a fixed tilted surface, summed over the
+*                         selected months)
+*        S_sky_optimize  (tilt/aspect maximizing S_sky_etrtilt)
+*        S_sky_free      (releases the memory held by a solsky)
+*
+*    The energy received by a fixed plane with unit normal n is
+*
+*        E(n) = sum over samples of  dt * etrn * max ( 0, s . n )
+*
+*    where s is the unit sun vector.  Without the max() this is the linear
+*    form n . m, m being the ETRN-weighted first moment of the sun vectors,
+*    and the best plane faces m.  The max() (sun behind the plane, e.g.
+*    summer mornings on a south-facing panel) breaks that, so the samples
+*    are instead summed into small sky cells (1 degree of zenith by 2 of
+*    azimuth, per month).  Within a cell the sun vectors are nearly
+*    parallel, so
+*
+*        E(n) ~= sum over cells of  max ( 0, V . n ),   V = sum dt*etrn*s
+*
+*    which is exact for every cell entirely in front of or behind the
+*    plane.  A year of 1-minute samples collapses to a few thousand cells,
+*    and E(n) becomes a short dot-product loop.
+*
+*    S_sky_optimize starts from the first-moment direction m/|m| and
+*    refines tilt and aspect with a shrinking pattern search.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solopt.h"
+*
+*----------------------------------------------------------------------------*/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "solopt.h"
+
+#define NZEN   90          /* 1 degree zenith cells, sun above the horizon */
+#define NAZM  180          /* 2 degree azimuth cells */
+#define NCELL ( NZEN * NAZM )
+
+static float degrad = 57.295779513; /* converts from radians to degrees */
+static float raddeg = 0.0174532925; /* converts from degrees to radians */
+
+static int  month_days[2][13] = { { 0,   0,  31,  59,  90, 120, 151,
+                                     181, 212, 243, 273, 304, 334 },
+                                  { 0,   0,  31,  60,  91, 121, 152,
+                                     182, 213, 244, 274, 305, 335 } };
+
+static int  flush_month( struct solsky *sky, double *cell, int *cap );
+static void normal( float tilt, float aspect, float *nx, float *ny,
+                    float *nz );
+
+
+/*============================================================================
+*    Long integer function S_sky_build
+*
+*    Sweeps the year through S_solpos at step-minute intervals (each sample
+*    is the midpoint of its interval, using the posdata interval semantics)
+*    and reduces the daylight samples to sky cells.
+*
+*    Requires:
+*        site    latitude, longitude, timezone, press, temp
+*        year    1950 - 2050
+*        step    minutes between samples, 1 - 480 and a divisor of 1440
+*                (60 is typical)
+*
+*    Returns:
+*        0 on success, the S_solpos error code if the site or year is out of
+*        range, or -1 if step is invalid or memory could not be allocated.
+*----------------------------------------------------------------------------*/
+long S_sky_build (struct solsky *sky, const struct posdata *site,
+                  int year, int step)
+{
+  struct posdata pd;
+  double *cell;      /* per-cell sums: vx, vy, vz, w */
+  double  dt;        /* sample length, hours */
+  float   s;         /* sine of the refracted zenith angle */
+  int     cap;       /* allocated entries */
+  int     leap;      /* leap year switch */
+  int     month;     /* month of the day being swept */
+  int     t;         /* minutes from midnight at the end of the interval */
+  int     ic;        /* cell index */
+  int     iz, ia;    /* zenith and azimuth cell numbers */
+  long    retval;
+
+    memset( sky, 0, sizeof( *sky ) );
+    sky->year = year;
+
+    if ( step < 1 || step > 480 || 1440 % step != 0 )
+        return -1;
+    dt = step / 60.0;
+
+    pd           = *site;
+    pd.year      = year;
+    pd.function  = S_SOLAZM | S_ETR;
+    pd.interval  = step * 60;
+
+    leap = ( ((year % 4) == 0) &&
+             ( ((year % 100) != 0) || ((year % 400) == 0) ) ) ? 1 : 0;
+
+    cell = (double *) calloc( 4 * NCELL, sizeof( double ) );
+    cap  = 0;
+    if ( cell == NULL )
+        return -1;
+
+    month = 1;
+    sky->first[0] = 0;
+    for ( pd.daynum = 1; pd.daynum <= 365 + leap; pd.daynum++ ) {
+        while ( month < 12 && pd.daynum > month_days[leap][month + 1] ) {
+            if ( flush_month( sky, cell, &cap ) != 0 ) {
+                free( cell );
+                S_sky_free( sky );
+                return -1;
+            }
+            sky->first[month++] = sky->count;
+        }
+
+        for ( t = step; t <= 1440; t += step ) {
+            pd.hour   = t / 60;
+            pd.minute = t % 60;
+            pd.second = 0;
+
+            if ( (retval = S_solpos( &pd )) != 0 ) {
+                free( cell );
+                S_sky_free( sky );
+                return retval;
+            }
+            if ( pd.etrn <= 0.0 )
+                continue;
+
+            iz = (int) pd.zenref;
+            ia = (int) ( pd.azim * 0.5 );
+            if ( iz >= NZEN ) iz = NZEN - 1;
+            if ( ia >= NAZM ) ia = NAZM - 1;
+            if ( ia < 0 )     ia = 0;
+            ic = 4 * ( iz * NAZM + ia );
+
+            s = sin ( raddeg * pd.zenref );
+            cell[ic]     += dt * pd.etrn * s * sin ( raddeg * pd.azim );
+            cell[ic + 1] += dt * pd.etrn * s * cos ( raddeg * pd.azim );
+            cell[ic + 2] += dt * pd.etrn * pd.coszen;
+            cell[ic + 3] += dt * pd.etrn;
+        }
+    }
+
+    if ( flush_month( sky, cell, &cap ) != 0 ) {
+        free( cell );
+        S_sky_free( sky );
+        return -1;
+    }
+    while ( month <= 12 )
+        sky->first[month++] = sky->count;
+
+    free( cell );
+    return 0;
+}
+
+
+/*============================================================================
+*    Float function S_sky_etrtilt
+*
+*    ETR on a plane of the given tilt and aspect (degrees, posdata
+*    conventions), summed over the months selected in the mask, Wh/sq m.
+*----------------------------------------------------------------------------*/
+float S_sky_etrtilt (const struct solsky *sky, int months,
+                     float tilt, float aspect)
+{
+  double energy;
+  float  nx, ny, nz; /* panel normal */
+  float  d;          /* V . n for one cell */
+  int    m, i;
+
+    normal( tilt, aspect, &nx, &ny, &nz );
+
+    energy = 0.0;
+    for ( m = 1; m <= 12; m++ ) {
+        if ( !(months & S_MONTH(m)) )
+            continue;
+        for ( i = sky->first[m - 1]; i < sky->first[m]; i++ ) {
+            d = sky->sx[i] * nx + sky->sy[i] * ny + sky->sz[i] * nz;
+            energy += ( d > 0.0f ) ? d : 0.0f;
+        }
+    }
+    return (float) energy;
+}
+
+
+/*============================================================================
+*    Float function S_sky_optimize
+*
+*    Finds the tilt (0 - 90) and aspect (0 - 360) receiving the most ETR
+*    over the selected months.  Returns that energy (Wh/sq m) and the
+*    orientation via tilt and aspect.
+*----------------------------------------------------------------------------*/
+float S_sky_optimize (const struct solsky *sky, int months,
+                      float *tilt, float *aspect)
+{
+  double mx, my, mz; /* first moment of the selected cells */
+  float  best;       /* best energy so far */
+  float  e;          /* trial energy */
+  float  t, a;       /* trial tilt and aspect */
+  float  step;       /* pattern search step, degrees */
+  int    m, i, k, moved;
+
+    mx = my = mz = 0.0;
+    for ( m = 1; m <= 12; m++ ) {
+        if ( !(months & S_MONTH(m)) )
+            continue;
+        for ( i = sky->first[m - 1]; i < sky->first[m]; i++ ) {
+            mx += sky->sx[i];
+            my += sky->sy[i];
+            mz += sky->sz[i];
+        }
+    }
+
+    /* starting point: face the first moment */
+    if ( mx * mx + my * my + mz * mz > 0.0 ) {
+        *tilt   = degrad * atan2 ( sqrt ( mx * mx + my * my ), mz );
+        *aspect = degrad * atan2 ( mx, my );
+    }
+    else {
+        *tilt   = 0.0;
+        *aspect = 180.0;
+    }
+    if ( *tilt > 90.0 )
+        *tilt = 90.0;
+    if ( *aspect < 0.0 )
+        *aspect += 360.0;
+
+    best = S_sky_etrtilt( sky, months, *tilt, *aspect );
+
+    for ( step = 4.0; step >= 0.01; ) {
+        moved = 0;
+        for ( k = 0; k < 4; k++ ) {
+            t = *tilt   + ( k == 0 ? step : k == 1 ? -step : 0.0f );
+            a = *aspect + ( k == 2 ? step : k == 3 ? -step : 0.0f );
+            if ( t < 0.0 || t > 90.0 )
+                continue;
+            if ( a <  0.0 )   a += 360.0;
+            if ( a >= 360.0 ) a -= 360.0;
+
+            e = S_sky_etrtilt( sky, months, t, a );
+            if ( e > best ) {
+                best    = e;
+                *tilt   = t;
+                *aspect = a;
+                moved   = 1;
+            }
+        }
+        if ( !moved )
+            step *= 0.5;
+    }
+
+    return best;
+}
+
+
+/*============================================================================
+*    Void function S_sky_free
+*----------------------------------------------------------------------------*/
+void S_sky_free (struct solsky *sky)
+{
+    free( sky->sx );
+    free( sky->sy );
+    free( sky->sz );
+    free( sky->w );
+    sky->sx = sky->sy = sky->sz = sky->w = NULL;
+    sky->count = 0;
+}
+
+
+/*============================================================================
+*    Local Int function flush_month
+*
+*    Appends the non-empty cells to the entry arrays and clears the grid
+*----------------------------------------------------------------------------*/
+static int flush_month( struct solsky *sky, double *cell, int *cap )
+{
+  float *p;
+  int    ic;
+
+    for ( ic = 0; ic < NCELL; ic++ ) {
+        if ( cell[4 * ic + 3] <= 0.0 )
+            continue;
+
+        if ( sky->count == *cap ) {
+            *cap = *cap ? 2 * *cap : 1024;
+            if ( (p = realloc( sky->sx, *cap * sizeof( float ) )) == NULL )
+                return -1;
+            sky->sx = p;
+            if ( (p = realloc( sky->sy, *cap * sizeof( float ) )) == NULL )
+                return -1;
+            sky->sy = p;
+            if ( (p = realloc( sky->sz, *cap * sizeof( float ) )) == NULL )
+                return -1;
+            sky->sz = p;
+            if ( (p = realloc( sky->w,  *cap * sizeof( float ) )) == NULL )
+                return -1;
+            sky->w = p;
+        }
+
+        sky->sx[sky->count] = (float) cell[4 * ic];
+        sky->sy[sky->count] = (float) cell[4 * ic + 1];
+        sky->sz[sky->count] = (float) cell[4 * ic + 2];
+        sky->w [sky->count] = (float) cell[4 * ic + 3];
+        sky->count++;
+    }
+
+    memset( cell, 0, 4 * NCELL * sizeof( double ) );
+    return 0;
+}
+
+
+/*============================================================================
+*    Local Void function normal
+*
+*    Unit panel normal (east, north, up) from tilt and aspect
+*----------------------------------------------------------------------------*/
+static void normal( float tilt, float aspect, float *nx, float *ny,
+                    float *nz )
+{
+  float st;          /* sine of the panel tilt */
+
+    st  = sin ( raddeg * tilt );
+    *nx = st * sin ( raddeg * aspect );
+    *ny = st * cos ( raddeg * aspect );
+    *nz = cos ( raddeg * tilt );
+}
@@ -0,0 +1,59 @@
+/*============================================================================
+*
+*    NAME:  solopt.h
+*
+*    Contains:
+*        S_sky_build     (reduces a year of sun positions at one site to a
+*                         compact set of irradiance-weighted sun vectors)
+*        S_sky_etrtilt   (ETR on a fixed tilted surface, summed over the
+*                         selected months, Wh/sq m)
+*        S_sky_optimize  (tilt/aspect maximizing S_sky_etrtilt)
+*        S_sky_free      (releases the memory held by a solsky)
+*
+*    The site is given as a struct posdata with latitude, longitude,
+*    timezone, press and temp set (S_init defaults are fine for the
+*    optional ones).  The year is swept once through S_solpos; after that
+*    every orientation is evaluated without calling S_solpos again.
+*
+*    Months are selected with a bit mask, S_MONTH(1) = January, etc.
+*    S_YEAR and the seasonal masks below are the common combinations.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solopt.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLOPT_H
+#define SOLOPT_H
+
+#include "solpos00.h"
+
+#define S_MONTH(m)  ( 1 << ( (m) - 1 ) )
+#define S_YEAR      0x0FFF
+#define S_DJF       ( S_MONTH(12) | S_MONTH(1) | S_MONTH(2)  )
+#define S_MAM       ( S_MONTH(3)  | S_MONTH(4) | S_MONTH(5)  )
+#define S_JJA       ( S_MONTH(6)  | S_MONTH(7) | S_MONTH(8)  )
+#define S_SON       ( S_MONTH(9)  | S_MONTH(10)| S_MONTH(11) )
+
+struct solsky
+{
+    int    year;       /* year that was swept */
+    int    count;      /* number of sky entries over all months */
+    int    first[13];  /* entries of month m are [first[m-1], first[m]) */
+    float *sx;         /* east component of the ETRN-weighted sun vector
+                          sum, Wh/sq m */
+    float *sy;         /* north component of the same */
+    float *sz;         /* up component of the same */
+    float *w;          /* ETRN energy in the entry, Wh/sq m */
+};
+
+extern long  S_sky_build (struct solsky *sky, const struct posdata *site,
+                          int year, int step);
+extern float S_sky_etrtilt (const struct solsky *sky, int months,
+                            float tilt, float aspect);
+extern float S_sky_optimize (const struct solsky *sky, int months,
+                             float *tilt, float *aspect);
+extern void  S_sky_free (struct solsky *sky);
+
+#endif /* SOLOPT_H */
@@ -0,0 +1,427 @@
+/*============================================================================
+*
+*    NAME:  solpipe.c
+*
+*    Pipelined S_solpos over a CSV file.  Three kinds of stage run on
+*    their own threads and pass blocks of records through bounded
+*    lock-free queues (solring.h), so reading, computing and writing
+*    overlap:
+*
+*        reader     read()s the input in large chunks, parses whole lines
+*                   into the posdata rows of a free block
+*        compute    runs S_solpos on every row of a block (-t threads,
+*                   fed round robin, so block order is kept)
+*        writer     formats a block's results (soltext.h, no printf) and
+*                   write()s them at once
+*
+*    Blocks are recycled from the writer back to the reader; there are
+*    only threads x depth of them, so when any stage falls behind the
+*    ones before it wait (backpressure) and memory stays fixed.  At the
+*    end each stage's wall time is split into busy, waiting for input
+*    and waiting for output; for the reader input is the read() calls,
+*    for the writer output is the write() calls.
+*
+*    Input lines:   year,month,day,hour,minute,second,latitude,longitude,
+*                   timezone[,press,temp,tilt,aspect]
+*    (lines not starting with a number, such as a header, are skipped;
+*    lines that start with a number but have fewer than 9 fields, or are
+*    longer than the reader chunk, are rejected and counted)
+*
+*    Output lines:  year,month,day,hour,minute,second,retval,azim,
+*                   elevref,zenref,cosinc,etrn,etrtilt
+*
+*    A read or write error is reported and stops the pipeline: the reader
+*    reads no more and closes its queues, the compute threads pass the
+*    blocks still in flight on without computing them, and the writer
+*    recycles them unwritten, so every stage finishes within a few
+*    blocks.  solpipe then exits with status 1.
+*
+*    Usage:
+*         solpipe [-i input] [-o output] [-t compute threads]
+*                 [-b rows per block] [-q blocks per thread]
+*
+*----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "solpos00.h"
+#include "solring.h"
+#include "soltext.h"
+
+#define RAW      ( 4 << 20 )    /* reader chunk, bytes */
+#define LINEOUT  ( 13 * S_TEXT_FIELD )  /* room per formatted row */
+#define MAXTHR   64
+
+struct block
+{
+    long            n;          /* rows in use */
+    struct posdata *pd;
+    long           *retval;     /* S_solpos return codes */
+    char           *text;       /* formatted output */
+};
+
+struct stage
+{
+    const char *name;
+    long long   start, end;
+    long long   wait_in;
+    long long   wait_out;
+    long        blocks;
+    long        rows;
+};
+
+static struct solring freeq;              /* writer -> reader */
+static struct solring work[MAXTHR];       /* reader -> compute k */
+static struct solring done[MAXTHR];       /* compute k -> writer */
+static struct stage   st_read, st_write, st_comp[MAXTHR];
+static struct posdata deflt;
+static int   in_fd = 0, out_fd = 1, threads = 1;
+static long  rows_per_block = 4096;
+static long  skipped, rejected;
+static int   read_failed, write_failed;
+static atomic_int stop;                   /* an I/O error: wind down */
+
+static void *reader( void *arg );
+static void *compute( void *arg );
+static void *writer( void *arg );
+static int   parse( char *s, char *end, struct posdata *pd );
+static void  report( const struct stage *s );
+
+
+int main( int argc, char *argv[] )
+{
+  pthread_t     tid[MAXTHR + 2];
+  struct block *blk;
+  long          nblk, depth = 4, i;
+  int           k;
+
+    for ( k = 1; k < argc - 1; k += 2 ) {
+        if ( strcmp( argv[k], "-i" ) == 0 )
+            in_fd = open( argv[k + 1], O_RDONLY );
+        else if ( strcmp( argv[k], "-o" ) == 0 )
+            out_fd = open( argv[k + 1], O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+        else if ( strcmp( argv[k], "-t" ) == 0 )
+            threads = atoi( argv[k + 1] );
+        else if ( strcmp( argv[k], "-b" ) == 0 )
+            rows_per_block = atol( argv[k + 1] );
+        else if ( strcmp( argv[k], "-q" ) == 0 )
+            depth = atol( argv[k + 1] );
+    }
+    if ( in_fd < 0 || out_fd < 0 ) {
+        perror( "solpipe" );
+        return 1;
+    }
+    if ( threads < 1 )      threads = 1;
+    if ( threads > MAXTHR ) threads = MAXTHR;
+    if ( rows_per_block < 1 ) rows_per_block = 1;
+    if ( depth < 1 )        depth = 1;
+
+    S_init( &deflt );
+
+    /* every block in flight is allocated here, once */
+    nblk = threads * depth + 1;
+    blk  = (struct block *) calloc( nblk, sizeof( *blk ) );
+    if ( blk == NULL || S_ring_init( &freeq, nblk ) != 0 )
+        goto nomem;
+    for ( k = 0; k < threads; k++ )
+        if ( S_ring_init( &work[k], nblk ) != 0 ||
+             S_ring_init( &done[k], nblk ) != 0 )
+            goto nomem;
+    for ( i = 0; i < nblk; i++ ) {
+        blk[i].pd     = (struct posdata *) malloc( rows_per_block *
+                                                   sizeof( struct posdata ) );
+        blk[i].retval = (long *) malloc( rows_per_block * sizeof( long ) );
+        blk[i].text   = (char *) malloc( rows_per_block * LINEOUT );
+        if ( !blk[i].pd || !blk[i].retval || !blk[i].text )
+            goto nomem;
+        S_ring_put( &freeq, &blk[i], NULL );
+    }
+
+    st_read.name  = "reader";
+    st_write.name = "writer";
+    pthread_create( &tid[0], NULL, reader, NULL );
+    for ( k = 0; k < threads; k++ ) {
+        st_comp[k].name = "compute";
+        pthread_create( &tid[k + 1], NULL, compute, (void *) (long) k );
+    }
+    pthread_create( &tid[threads + 1], NULL, writer, NULL );
+    for ( k = 0; k < threads + 2; k++ )
+        pthread_join( tid[k], NULL );
+
+    fprintf( stderr, "solpipe: %ld rows, %ld lines skipped, %ld rejected, "
+             "%ld blocks of %ld\n", st_write.rows, skipped, rejected, nblk,
+             rows_per_block );
+    fprintf( stderr, "  %-8s %8s %7s %9s %10s %8s\n", "stage", "blocks",
+             "busy", "wait in", "wait out", "seconds" );
+    report( &st_read );
+    for ( k = 0; k < threads; k++ )
+        report( &st_comp[k] );
+    report( &st_write );
+    return read_failed || write_failed;
+
+nomem:
+    fprintf( stderr, "solpipe: out of memory\n" );
+    return 1;
+}
+
+
+/*============================================================================
+*    Local void pointer function reader
+*----------------------------------------------------------------------------*/
+static void *reader( void *arg )
+{
+  struct block *b = NULL;
+  char     *raw, *p, *nl, *end;
+  size_t    have = 0;
+  ssize_t   got;
+  long long t0;
+  int       k = 0, eof = 0, toolong = 0, ok;
+
+    (void) arg;
+    st_read.start = S_rt_now();
+    if ( (raw = (char *) malloc( RAW + 1 )) == NULL )
+        eof = 1;
+
+    while ( !eof && !atomic_load( &stop ) ) {
+        t0 = S_rt_now();
+        while ( (got = read( in_fd, raw + have, RAW - have )) < 0 &&
+                errno == EINTR )
+            ;
+        st_read.wait_in += S_rt_now() - t0;
+        if ( got < 0 ) {
+            perror( "solpipe: read" );
+            read_failed = 1;
+            atomic_store( &stop, 1 );
+            break;
+        }
+        if ( got == 0 ) {
+            eof = 1;
+            if ( have == 0 )
+                break;
+            raw[have++] = '\n';              /* last line, unterminated */
+        }
+        else
+            have += got;
+
+        p   = raw;
+        end = raw + have;
+        while ( p < end && (nl = (char *) memchr( p, '\n', end - p )) ) {
+            if ( b == NULL ) {
+                if ( atomic_load( &stop ) )
+                    break;
+                b = (struct block *) S_ring_take( &freeq, &st_read.wait_out );
+                b->n = 0;
+            }
+            if ( toolong )                   /* the rest of a long line */
+                toolong = 0;
+            else if ( (ok = parse( p, nl, &b->pd[b->n] )) > 0 )
+                b->n++;
+            else if ( ok == 0 )
+                skipped++;
+            else
+                rejected++;
+            p = nl + 1;
+
+            if ( b->n == rows_per_block ) {
+                st_read.rows += b->n;
+                st_read.blocks++;
+                S_ring_put( &work[k], b, &st_read.wait_out );
+                k = ( k + 1 ) % threads;
+                b = NULL;
+            }
+        }
+
+        /* keep the partial line; a line longer than RAW is rejected and
+           the rest of it, up to its newline, passed over */
+        have = end - p;
+        if ( have == RAW ) {
+            if ( !toolong )
+                rejected++;
+            toolong = 1;
+            have    = 0;
+        }
+        memmove( raw, p, have );
+    }
+
+    if ( b != NULL && b->n > 0 ) {
+        st_read.rows += b->n;
+        st_read.blocks++;
+        S_ring_put( &work[k], b, &st_read.wait_out );
+    }
+    for ( k = 0; k < threads; k++ )
+        S_ring_close( &work[k] );
+    free( raw );
+    st_read.end = S_rt_now();
+    return NULL;
+}
+
+
+/*============================================================================
+*    Local void pointer function compute
+*----------------------------------------------------------------------------*/
+static void *compute( void *arg )
+{
+  struct stage *st = &st_comp[(long) arg];
+  struct block *b;
+  int  k = (int) (long) arg;
+  long i;
+
+    st->start = S_rt_now();
+    while ( (b = (struct block *) S_ring_take( &work[k], &st->wait_in )) ) {
+        if ( !atomic_load( &stop ) ) {
+            for ( i = 0; i < b->n; i++ )
+                b->retval[i] = S_solpos( &b->pd[i] );
+            st->rows += b->n;
+            st->blocks++;
+        }
+        S_ring_put( &done[k], b, &st->wait_out );
+    }
+    S_ring_close( &done[k] );
+    st->end = S_rt_now();
+    return NULL;
+}
+
+
+/*============================================================================
+*    Local void pointer function writer
+*----------------------------------------------------------------------------*/
+static void *writer( void *arg )
+{
+  static const char head[] = "year,month,day,hour,minute,second,retval,"
+                             "azim,elevref,zenref,cosinc,etrn,etrtilt\n";
+  struct posdata *pd;
+  struct block   *b;
+  char     *p;
+  size_t    len, off;
+  ssize_t   put;
+  long long t0;
+  long      i;
+  int       k = 0;
+
+    (void) arg;
+    st_write.start = S_rt_now();
+    if ( write( out_fd, head, sizeof( head ) - 1 ) < 0 ) {
+        perror( "solpipe: write" );
+        write_failed = 1;
+        atomic_store( &stop, 1 );
+    }
+
+    while ( (b = (struct block *) S_ring_take( &done[k], &st_write.wait_in )) ) {
+        if ( atomic_load( &stop ) ) {           /* drain, unwritten */
+            S_ring_put( &freeq, b, NULL );
+            k = ( k + 1 ) % threads;
+            continue;
+        }
+        for ( p = b->text, i = 0; i < b->n; i++ ) {
+            pd = &b->pd[i];
+            p += S_text_int( p, pd->year );         *p++ = ',';
+            p += S_text_int( p, pd->month );        *p++ = ',';
+            p += S_text_int( p, pd->day );          *p++ = ',';
+            p += S_text_int( p, pd->hour );         *p++ = ',';
+            p += S_text_int( p, pd->minute );       *p++ = ',';
+            p += S_text_int( p, pd->second );       *p++ = ',';
+            p += S_text_int( p, b->retval[i] );     *p++ = ',';
+            p += S_text_float( p, pd->azim, 4 );    *p++ = ',';
+            p += S_text_float( p, pd->elevref, 4 ); *p++ = ',';
+            p += S_text_float( p, pd->zenref, 4 );  *p++ = ',';
+            p += S_text_float( p, pd->cosinc, 6 );  *p++ = ',';
+            p += S_text_float( p, pd->etrn, 2 );    *p++ = ',';
+            p += S_text_float( p, pd->etrtilt, 2 ); *p++ = '\n';
+        }
+        len = p - b->text;
+
+        t0 = S_rt_now();
+        for ( off = 0; off < len && !write_failed; off += put )
+            if ( (put = write( out_fd, b->text + off, len - off )) < 0 ) {
+                put = 0;
+                if ( errno != EINTR ) {
+                    perror( "solpipe: write" );
+                    write_failed = 1;
+                    atomic_store( &stop, 1 );
+                }
+            }
+        st_write.wait_out += S_rt_now() - t0;
+
+        if ( !write_failed ) {
+            st_write.rows += b->n;
+            st_write.blocks++;
+        }
+        S_ring_put( &freeq, b, &st_write.wait_out );
+        k = ( k + 1 ) % threads;
+    }
+    st_write.end = S_rt_now();
+    return NULL;
+}
+
+
+/*============================================================================
+*    Local Int function parse
+*
+*    One CSV line, s up to the newline at end, into a posdata from the
+*    S_init defaults.  The line is parsed in place (the newline becomes
+*    the terminator), so there is no limit on its length.  Returns 1; 0
+*    if the line is not a data line; -1 if it starts with a number but
+*    has fewer than 9 fields.
+*----------------------------------------------------------------------------*/
+static int parse( char *s, char *end, struct posdata *pd )
+{
+  double v[13];
+  char  *p, *q;
+  int    n;
+
+    *end = 0;
+    for ( p = s, n = 0; n < 13; n++ ) {
+        v[n] = strtod( p, &q );
+        if ( q == p )
+            break;
+        p = q;
+        while ( *p == ' ' || *p == '\t' || *p == '\r' )
+            p++;
+        if ( *p != ',' ) {
+            n++;
+            break;
+        }
+        p++;
+    }
+    if ( n < 9 )
+        return n > 0 ? -1 : 0;
+
+    *pd = deflt;
+    pd->function &= ~S_DOY;                  /* month and day are inputs */
+    pd->year      = (int) v[0];
+    pd->month     = (int) v[1];
+    pd->day       = (int) v[2];
+    pd->hour      = (int) v[3];
+    pd->minute    = (int) v[4];
+    pd->second    = (int) v[5];
+    pd->latitude  = (float) v[6];
+    pd->longitude = (float) v[7];
+    pd->timezone  = (float) v[8];
+    if ( n > 9 )  pd->press  = (float) v[9];
+    if ( n > 10 ) pd->temp   = (float) v[10];
+    if ( n > 11 ) pd->tilt   = (float) v[11];
+    if ( n > 12 ) pd->aspect = (float) v[12];
+    return 1;
+}
+
+
+/*============================================================================
+*    Local Void function report
+*----------------------------------------------------------------------------*/
+static void report( const struct stage *s )
+{
+  double wall = ( s->end - s->start ) * 1.0e-9;
+  double in   = s->wait_in * 1.0e-9, out = s->wait_out * 1.0e-9;
+
+    if ( wall <= 0.0 )
+        wall = 1.0e-9;
+    fprintf( stderr, "  %-8s %8ld %6.1f%% %8.1f%% %9.1f%% %8.3f\n",
+             s->name, s->blocks, 100.0 * ( wall - in - out ) / wall,
+             100.0 * in / wall, 100.0 * out / wall, wall );
+}
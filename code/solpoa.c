@@ -0,0 +1,260 @@
+/*============================================================================
+*    Contains:
+*        S_poa       (plane-of-array irradiance from measured GHI and DHI,
+*                     for rows of a batch times panel orientations)
+*        S_poa_name  (name of a model)
+*
+*    The sky diffuse of all three models is
+*        iso (1 + cos tilt) / 2 + cir max( cosinc, 0 ) + hor sin tilt
+*    with iso, cir and hor depending only on the row, so each row costs
+*    one call of rowcoef and then the same loop over the panels.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solpoa.h"
+*
+*----------------------------------------------------------------------------*/
+#include <math.h>
+#include <stdlib.h>
+#include "solpoa.h"
+
+static const char *modelname[P_NMODEL] = { "isotropic", "haydavies",
+                                           "perez" };
+
+static float raddeg = 0.0174532925; /* converts from degrees to radians */
+static float cos85  = 0.0871557427; /* floor of coszen in circumsolar ratios */
+static float cos89  = 0.0174524064; /* floor of coszen in DNI from GHI - DHI */
+
+/* Perez, Ineichen, Seals, Michalsky and Stewart 1990, all-sites composite:
+   F11 F12 F13 F21 F22 F23 for each sky clearness bin */
+static const float perez[8][6] = {
+    { -0.0083117f,  0.5877285f, -0.0620636f, -0.0596012f,  0.0721249f,
+      -0.0220216f },
+    {  0.1299457f,  0.6825954f, -0.1513752f, -0.0189325f,  0.0659650f,
+      -0.0288748f },
+    {  0.3296958f,  0.4868735f, -0.2210958f,  0.0554140f, -0.0639588f,
+      -0.0260542f },
+    {  0.5682053f,  0.1874525f, -0.2951290f,  0.1088631f, -0.1519229f,
+      -0.0139754f },
+    {  0.8730280f, -0.3920403f, -0.3616149f,  0.2255647f, -0.4620442f,
+       0.0012448f },
+    {  1.1326077f, -1.2367284f, -0.4118494f,  0.2877813f, -0.8230357f,
+       0.0558651f },
+    {  1.0601591f, -1.5999137f, -0.3589221f,  0.2642124f, -1.1272340f,
+       0.1310694f },
+    {  0.6777470f, -0.3272588f, -0.2504286f,  0.1561313f, -1.3765031f,
+       0.2506212f } };
+static const float epsbin[7] = { 1.065f, 1.23f, 1.5f, 1.95f, 2.8f, 4.5f,
+                                 6.2f };
+
+struct rowcoef
+{
+    float dni;      /* beam normal */
+    float iso;      /* isotropic sky coefficient */
+    float cir;      /* circumsolar coefficient of max( cosinc, 0 ) */
+    float hor;      /* horizon band coefficient of sin tilt */
+    float gnd;      /* GHI albedo */
+};
+
+static struct rowcoef rowcoef( const struct solpoa *poa,
+                               const struct solbatch *batch, long i );
+static void panels( struct rowcoef c, float sx, float sy, float sz, int n,
+                    const float *restrict nx, const float *restrict ny,
+                    const float *restrict nz, const float *restrict fiso,
+                    const float *restrict fgnd, const float *restrict sinb,
+                    float *restrict global );
+static void panels3( struct rowcoef c, float sx, float sy, float sz, int n,
+                     const float *restrict nx, const float *restrict ny,
+                     const float *restrict nz, const float *restrict fiso,
+                     const float *restrict fgnd, const float *restrict sinb,
+                     float *restrict global, float *restrict beam,
+                     float *restrict sky, float *restrict ground );
+
+
+/*============================================================================
+*    Long integer function S_poa
+*
+*    Plane-of-array irradiance for rows first .. last - 1 of batch; see
+*    solpoa.h for the layout of global and parts.
+*----------------------------------------------------------------------------*/
+long S_poa (const struct solpoa *poa, const struct solbatch *batch,
+            long first, long last, float *global, float *parts)
+{
+  float * const *col = batch->col;
+  struct rowcoef c;
+  float *view;       /* per panel: (1 + cos tilt)/2, (1 - cos tilt)/2, sin */
+  float  sz, sx, sy, ci, ct, a, pb, ps, pg;
+  long   i, k, n;
+  int    p, np = poa->npanel, s;
+
+    if ( poa->model < 0 || poa->model >= P_NMODEL || !poa->ghi ||
+         !poa->dhi || !global || !col[C_COSZEN] || !col[C_ETRN] ||
+         ( poa->model == P_PEREZ && !col[C_AMASS] ) ||
+         ( np > 0 && ( !col[C_ZENREF] || !col[C_AZIM] || !poa->nx ||
+                       !poa->ny || !poa->nz ) ) ||
+         ( np <= 0 && !col[C_COSINC] ) )
+        return -1;
+
+    /* the batch's own panel: one orientation per row, given by cosinc */
+    if ( np <= 0 ) {
+        n = last - first;
+        for ( i = first; i < last; i++ ) {
+            s  = batch->site ? batch->site[i] : 0;
+            ct = cos ( raddeg * ( batch->in[I_TILT] ? batch->in[I_TILT][i]
+                                                    : batch->sites[s].tilt ) );
+            c  = rowcoef( poa, batch, i );
+            ci = col[C_COSINC][i];
+            a  = ci > 0.0f ? ci : 0.0f;
+            k  = i - first;
+            pb = c.dni * a;
+            ps = c.cir * a + c.iso * 0.5f * ( 1.0f + ct ) +
+                 c.hor * sqrtf( fmaxf( 1.0f - ct * ct, 0.0f ) );
+            pg = c.gnd * 0.5f * ( 1.0f - ct );
+            global[k] = pb + ps + pg;
+            if ( parts ) {
+                parts[k]         = pb;
+                parts[n + k]     = ps;
+                parts[2 * n + k] = pg;
+            }
+        }
+        return last - first;
+    }
+
+    view = (float *) malloc( 3 * (size_t) np * sizeof( float ) );
+    if ( !view )
+        return -1;
+    for ( p = 0; p < np; p++ ) {
+        ct                = poa->nz[p];
+        view[p]           = 0.5f * ( 1.0f + ct );
+        view[np + p]      = 0.5f * ( 1.0f - ct );
+        view[2 * np + p]  = sqrtf( fmaxf( 1.0f - ct * ct, 0.0f ) );
+    }
+
+    n = ( last - first ) * np;
+    for ( i = first; i < last; i++ ) {
+        c  = rowcoef( poa, batch, i );
+        sz = sin ( raddeg * col[C_ZENREF][i] );
+        sx = sz * sin ( raddeg * col[C_AZIM][i] );
+        sy = sz * cos ( raddeg * col[C_AZIM][i] );
+        k  = ( i - first ) * np;
+        if ( parts )
+            panels3( c, sx, sy, col[C_COSZEN][i], np, poa->nx, poa->ny,
+                     poa->nz, view, view + np, view + 2 * np, global + k,
+                     parts + k, parts + n + k, parts + 2 * n + k );
+        else
+            panels( c, sx, sy, col[C_COSZEN][i], np, poa->nx, poa->ny,
+                    poa->nz, view, view + np, view + 2 * np, global + k );
+    }
+    free( view );
+    return last - first;
+}
+
+
+/*============================================================================
+*    Const char pointer function S_poa_name
+*----------------------------------------------------------------------------*/
+const char *S_poa_name (int model)
+{
+    return model >= 0 && model < P_NMODEL ? modelname[model] : NULL;
+}
+
+
+/*============================================================================
+*    Local struct function rowcoef
+*
+*    The five coefficients of one row.  With the sun down there is no
+*    beam and the diffuse (twilight, if any) is isotropic.
+*----------------------------------------------------------------------------*/
+static struct rowcoef rowcoef( const struct solpoa *poa,
+                               const struct solbatch *batch, long i )
+{
+  struct rowcoef c;
+  const float *f;
+  float cz   = batch->col[C_COSZEN][i];
+  float etrn = batch->col[C_ETRN][i];
+  float ghi  = fmaxf( poa->ghi[i], 0.0f );
+  float dhi  = fmaxf( poa->dhi[i], 0.0f );
+  float b, ai, z, kz3, eps, delta, f1;
+  int   k;
+
+    c.dni = 0.0f;
+    c.iso = dhi;
+    c.cir = 0.0f;
+    c.hor = 0.0f;
+    c.gnd = ghi * poa->albedo;
+    if ( cz <= 0.0f || etrn <= 0.0f )
+        return c;
+
+    if ( poa->dni )
+        c.dni = fmaxf( poa->dni[i], 0.0f );
+    else
+        c.dni = fminf( fmaxf( ghi - dhi, 0.0f ) / fmaxf( cz, cos89 ), etrn );
+    if ( dhi <= 0.0f || poa->model == P_ISOTROPIC )
+        return c;
+
+    b = fmaxf( cz, cos85 );
+    if ( poa->model == P_HAYDAVIES ) {
+        ai    = fminf( c.dni / etrn, 1.0f );
+        c.iso = dhi * ( 1.0f - ai );
+        c.cir = dhi * ai / b;
+        return c;
+    }
+
+    /* Perez: clearness with the zenith angle in radians, kappa 1.041 */
+    z     = acosf( fminf( cz, 1.0f ) );
+    kz3   = 1.041f * z * z * z;
+    eps   = ( ( dhi + c.dni ) / dhi + kz3 ) / ( 1.0f + kz3 );
+    delta = dhi * fmaxf( batch->col[C_AMASS][i], 0.0f ) / etrn;
+    for ( k = 0; k < 7 && eps >= epsbin[k]; k++ )
+        ;
+    f     = perez[k];
+    f1    = fmaxf( f[0] + f[1] * delta + f[2] * z, 0.0f );
+    c.iso = dhi * ( 1.0f - f1 );
+    c.cir = dhi * f1 / b;
+    c.hor = dhi * ( f[3] + f[4] * delta + f[5] * z );
+    return c;
+}
+
+
+/*============================================================================
+*    Local Void functions panels and panels3
+*
+*    One row over n panels: global only, or global with its three parts.
+*    max( cosinc, 0 ) is ( ci + |ci| ) / 2, so the loops have no selects.
+*----------------------------------------------------------------------------*/
+static void panels( struct rowcoef c, float sx, float sy, float sz, int n,
+                    const float *restrict nx, const float *restrict ny,
+                    const float *restrict nz, const float *restrict fiso,
+                    const float *restrict fgnd, const float *restrict sinb,
+                    float *restrict global )
+{
+  float bc = c.dni + c.cir, ci;
+  int   p;
+
+    for ( p = 0; p < n; p++ ) {
+        ci        = sx * nx[p] + sy * ny[p] + sz * nz[p];
+        global[p] = bc * 0.5f * ( ci + fabsf( ci ) ) + c.iso * fiso[p] +
+                    c.hor * sinb[p] + c.gnd * fgnd[p];
+    }
+}
+
+static void panels3( struct rowcoef c, float sx, float sy, float sz, int n,
+                     const float *restrict nx, const float *restrict ny,
+                     const float *restrict nz, const float *restrict fiso,
+                     const float *restrict fgnd, const float *restrict sinb,
+                     float *restrict global, float *restrict beam,
+                     float *restrict sky, float *restrict ground )
+{
+  float ci, a;
+  int   p;
+
+    for ( p = 0; p < n; p++ ) {
+        ci        = sx * nx[p] + sy * ny[p] + sz * nz[p];
+        a         = 0.5f * ( ci + fabsf( ci ) );
+        beam[p]   = c.dni * a;
+        sky[p]    = c.cir * a + c.iso * fiso[p] + c.hor * sinb[p];
+        ground[p] = c.gnd * fgnd[p];
+        global[p] = beam[p] + sky[p] + ground[p];
+    }
+}
@@ -0,0 +1,75 @@
+/*============================================================================
+*
+*    NAME:  solpoa.h
+*
+*    Contains:
+*        S_poa       (plane-of-array irradiance from measured GHI and DHI,
+*                     for rows of a batch times panel orientations)
+*        S_poa_name  (name of a model)
+*
+*    Transposition of measured horizontal irradiance to tilted planes,
+*    using the outputs of a batch (solbatch.h) that has already been run:
+*    coszen, etrn and amass, and either cosinc (the batch's own panel) or
+*    zenref and azim (to get cosinc for any set of panel normals).
+*
+*        P_ISOTROPIC  sky diffuse DHI (1 + cos tilt) / 2
+*        P_HAYDAVIES  Hay and Davies (1980): the anisotropy index
+*                     DNI / etrn of the diffuse is circumsolar, the rest
+*                     isotropic
+*        P_PEREZ      Perez et al. (1990), with the all-sites composite
+*                     coefficients: circumsolar F1 and horizon F2 from
+*                     eight bins of the sky clearness epsilon and the sky
+*                     brightness DHI amass / etrn
+*
+*    All three add the beam DNI max( cosinc, 0 ) and ground reflection
+*    GHI albedo (1 - cos tilt) / 2.  Negative (missing) GHI and DHI are
+*    taken as 0.  The circumsolar ratio uses max( coszen, cos 85 deg ).
+*
+*    Each model reduces, for one row, to five numbers (beam, isotropic,
+*    circumsolar, horizon and ground coefficients), so the loop over the
+*    orientations is the same short straight-line loop for every model,
+*    and vectorizes the way soltilt.c's sweep does.  The Perez table and
+*    the per-panel view factors are computed once per call.
+*
+*    The output is row-major: global[( i - first ) * npanel + p] for row
+*    i and panel p (npanel 1 when the batch's cosinc is used).  The
+*    optional parts array holds three such planes one after another:
+*    beam, sky diffuse and ground reflected.
+*
+*    S_poa returns the number of rows done, or -1 for an unknown model,
+*    missing inputs or columns, or no memory.  It does not start
+*    threads: callers split the rows, as S_batch_parallel does.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solpoa.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLPOA_H
+#define SOLPOA_H
+
+#include "solbatch.h"
+
+enum { P_ISOTROPIC, P_HAYDAVIES, P_PEREZ, P_NMODEL };  /* model */
+
+struct solpoa
+{
+    int          model;     /* P_ISOTROPIC, P_HAYDAVIES or P_PEREZ */
+    const float *ghi;       /* measured global horizontal, per batch row */
+    const float *dhi;       /* measured diffuse horizontal, per batch row */
+    const float *dni;       /* beam normal per row; NULL = (ghi-dhi)/coszen */
+    float        albedo;    /* ground reflectance */
+    int          npanel;    /* orientations; 0 = the batch's own cosinc,
+                               with tilt from in[I_TILT] or the site */
+    const float *nx;        /* panel normals, as from S_tilt_normals */
+    const float *ny;
+    const float *nz;
+};
+
+extern long        S_poa (const struct solpoa *poa,
+                          const struct solbatch *batch, long first,
+                          long last, float *global, float *parts);
+extern const char *S_poa_name (int model);
+
+#endif /* SOLPOA_H */
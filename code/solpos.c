@@ -50,6 +50,11 @@
 *                      supply the parameters; initializes the OPTIONAL
 *                      S_solpos inputs above to nominal values.)
 *
+*       S_epoch       (optional utility setting the date and time inputs
+*                      from a UTC time in seconds since 1970)
+*           INPUTS:     struct posdata* (timezone set), long long UTC seconds
+*           OUTPUTS:    struct posdata*
+*
 *       S_decode      (optional utility for decoding the S_solpos return code)
 *           INPUTS:     long integer S_solpos return value, struct posdata*
 *           OUTPUTS:    text to stderr
@@ -281,6 +286,58 @@ void S_init(struct posdata *pdat)
 }
 
 
+/*============================================================================
+*    Void function S_epoch
+*
+*    Sets the date and time inputs of the struct posdata from a UTC time
+*    in seconds since 1 January 1970, converted to local standard time
+*    with pdat->timezone (which must be set first).  Both the day number
+*    and the month/day are filled in, and the S_DOY switch is set.
+*
+*    Requires: Pointer to a posdata structure with timezone set, and the
+*           UTC time.
+*
+*    Returns: Void
+*----------------------------------------------------------------------------*/
+void S_epoch(struct posdata *pdat, long long utc)
+{
+  long long t;     /* local standard time, seconds since 1970 */
+  long long days;  /* days since 1970 */
+  long      secs;  /* seconds into the day */
+  long      era, doe, yoe, doy, mp;
+  int       leap;
+
+  t    = utc + (long long) floor ( pdat->timezone * 3600.0 + 0.5 );
+  days = t / 86400;
+  secs = (long) ( t % 86400 );
+  if ( secs < 0 ) {
+    secs += 86400;
+    days -= 1;
+  }
+
+  /* civil date from a day count (March-based years, 400-year eras) */
+  days += 719468;
+  era   = (long) ( ( days >= 0 ? days : days - 146096 ) / 146097 );
+  doe   = (long) ( days - (long long) era * 146097 );
+  yoe   = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+  doy   = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+  mp    = ( 5 * doy + 2 ) / 153;
+
+  pdat->day   = (int) ( doy - ( 153 * mp + 2 ) / 5 + 1 );
+  pdat->month = (int) ( mp < 10 ? mp + 3 : mp - 9 );
+  pdat->year  = (int) ( yoe + era * 400 + ( pdat->month <= 2 ) );
+
+  leap = ( ((pdat->year % 4) == 0) &&
+           ( ((pdat->year % 100) != 0) || ((pdat->year % 400) == 0) ) );
+  pdat->daynum = pdat->day + month_days[leap][pdat->month];
+
+  pdat->hour     = (int) ( secs / 3600 );
+  pdat->minute   = (int) ( ( secs / 60 ) % 60 );
+  pdat->second   = (int) ( secs % 60 );
+  pdat->function |= S_DOY;
+}
+
+
 /*============================================================================
 *    Local long int function validate
 *
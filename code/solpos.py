@@ -0,0 +1,185 @@
+"""Batch solar position from Python, through libsolpy (solpy.h).
+
+The arrays given to compute() are handed to the C batch engine in place:
+NumPy arrays of the right dtype (and C order), or any other writable
+buffer such as array.array, are not copied.  The call runs with the GIL
+released (ctypes does that for every foreign call) and on several
+threads, so a single compute() over a million rows costs about what the
+C code does, while position() -- one row per call, the way a Python loop
+would use it -- pays the wrapper's overhead for every row.
+
+    import numpy as np, solpos
+    utc = np.arange(1672531200, 1672531200 + 86400 * 365, 60, dtype=np.int64)
+    ret, col = solpos.compute(utc, {"latitude": 39.74, "longitude": -105.18,
+                                    "timezone": -7.0},
+                              columns=("azim", "zenref"))
+
+The library is found through $SOLPOS_LIB, else next to this file or in
+its build directories.
+"""
+
+import array
+import ctypes
+import os
+import threading
+
+__all__ = ["COLUMNS", "INPUTS", "compute", "position"]
+
+# solbatch.h column orders, and the S_init defaults of the inputs
+COLUMNS = ("amass", "ampress", "azim", "cosinc", "coszen", "elevref", "etr",
+           "etrn", "etrtilt", "prime", "sbcf", "sretr", "ssetr", "unprime",
+           "zenref")
+INPUTS = ("latitude", "longitude", "timezone", "press", "temp", "tilt",
+          "aspect")
+DEFAULTS = (-99.0, -999.0, -99.0, 1013.0, 15.0, 0.0, 180.0)
+
+_FORMAT = {"q": ("<i8", "q", "l"), "i": ("<i4", "i"), "f": ("<f4", "f")}
+_SIZE = {"q": 8, "i": 4, "f": 4}
+
+
+def _load():
+    here = os.path.dirname(os.path.abspath(__file__))
+    paths = [os.environ.get("SOLPOS_LIB")]
+    for d in ("", "build", "cmake-build-debug", "cmake-build-release"):
+        paths.append(os.path.join(here, d, "libsolpy.so"))
+    for p in paths:
+        if p and os.path.exists(p):
+            lib = ctypes.CDLL(p)
+            break
+    else:
+        raise OSError("libsolpy.so not found; build it or set SOLPOS_LIB")
+
+    lib.S_py_batch.restype = ctypes.c_long
+    lib.S_py_batch.argtypes = [ctypes.c_long, ctypes.c_void_p,
+                               ctypes.c_void_p, ctypes.c_int,
+                               ctypes.c_void_p, ctypes.c_int,
+                               ctypes.c_void_p, ctypes.c_void_p,
+                               ctypes.c_void_p, ctypes.c_int]
+    lib.S_py_version.restype = ctypes.c_int
+    if lib.S_py_version() != 1:
+        raise OSError("libsolpy.so has interface version %d, expected 1"
+                      % lib.S_py_version())
+    return lib
+
+
+_lib = _load()
+
+
+def _addr(a, code, n, name):
+    """Address of the data of a (n items of type code), without copying."""
+    ai = getattr(a, "__array_interface__", None)
+    if ai is not None:                       # NumPy, without importing it
+        if ai["typestr"] not in _FORMAT[code][:1] or \
+                (ai.get("strides") is not None and len(a) > 1):
+            raise TypeError("%s: need a C-contiguous %s array"
+                            % (name, _FORMAT[code][0]))
+        if ai["shape"] != (n,):
+            raise ValueError("%s: need %d items" % (name, n))
+        return ai["data"][0]
+
+    m = memoryview(a)
+    if m.format not in _FORMAT[code] or m.itemsize != _SIZE[code] or \
+            not m.c_contiguous:
+        raise TypeError("%s: need a contiguous buffer of %s"
+                        % (name, _FORMAT[code][0]))
+    if m.nbytes != n * _SIZE[code]:
+        raise ValueError("%s: need %d items" % (name, n))
+    if n == 0:
+        return None
+    return ctypes.addressof((ctypes.c_char * m.nbytes).from_buffer(a))
+
+
+def _empty(code, n):
+    try:
+        import numpy
+        return numpy.empty(n, dtype=_FORMAT[code][0])
+    except ImportError:
+        return array.array(code, bytes(n * _SIZE[code]))
+
+
+def compute(utc, sites, site=None, columns=("azim", "zenref"), threads=0,
+            function=0, out=None, **inputs):
+    """Solar position for every row of utc (int64 UTC seconds).
+
+    sites    a dict of site inputs (latitude, longitude, timezone, and
+             optionally press, temp, tilt, aspect), or a list of them;
+             missing ones take the S_init defaults
+    site     int32 site index per row, needed with several sites
+    inputs   per-row float32 inputs by name, e.g. press=..., temp=...,
+             overriding the site's value in every row
+    columns  output names from COLUMNS
+    out      optional dict of preallocated float32 outputs by name
+    threads  0 for one per CPU
+    function S_solpos function mask for every site, 0 for S_ALL
+
+    Returns (retval, {name: column}); retval is int64, one S_solpos
+    return code per row.  Raises RuntimeError if the engine failed.
+    """
+    n = len(utc)
+    if isinstance(sites, dict):
+        sites = [sites]
+    table = (ctypes.c_float * (len(sites) * len(INPUTS)))()
+    for k, s in enumerate(sites):
+        for j, name in enumerate(INPUTS):
+            table[k * len(INPUTS) + j] = s.get(name, DEFAULTS[j])
+
+    keep = []                               # what the pointers point into
+    inp = (ctypes.c_void_p * len(INPUTS))()
+    for name, a in inputs.items():
+        if name not in INPUTS:
+            raise TypeError("unknown input %r" % name)
+        inp[INPUTS.index(name)] = _addr(a, "f", n, name)
+        keep.append(a)
+
+    out = dict(out or {})
+    col = (ctypes.c_void_p * len(COLUMNS))()
+    for name in columns:
+        if name not in COLUMNS:
+            raise ValueError("unknown column %r" % name)
+        if name not in out:
+            out[name] = _empty("f", n)
+        col[COLUMNS.index(name)] = _addr(out[name], "f", n, name)
+    retval = _empty("q", n)
+
+    e = _lib.S_py_batch(n, _addr(utc, "q", n, "utc"),
+                        None if site is None else _addr(site, "i", n, "site"),
+                        len(sites), table, function, inp, col,
+                        _addr(retval, "q", n, "retval"),
+                        threads if threads > 0 else (os.cpu_count() or 1))
+    if e == -2:
+        raise ValueError("site index out of range")
+    if e < 0:
+        raise RuntimeError("batch engine could not start its threads")
+    return retval, {name: out[name] for name in columns}
+
+
+class _One(threading.local):
+    """Scratch arrays reused by position(), one set per thread: the GIL is
+    released while S_py_batch runs, so threads must not share them."""
+
+    def __init__(self):
+        self.utc = (ctypes.c_longlong * 1)()
+        self.ret = (ctypes.c_long * 1)()
+        self.table = (ctypes.c_float * len(INPUTS))()
+        self.val = (ctypes.c_float * len(COLUMNS))()
+        self.col = (ctypes.c_void_p * len(COLUMNS))()
+
+
+_one = _One()
+
+
+def position(utc, latitude, longitude, timezone, press=1013.0, temp=15.0,
+             tilt=0.0, aspect=180.0, columns=("azim", "zenref")):
+    """One row: a tuple of the columns, then the S_solpos return code.
+
+    Convenient in a loop but each call goes through ctypes; prefer
+    compute() for many rows.  Safe to call from several threads.
+    """
+    o = _one
+    o.utc[0] = utc
+    o.table[:] = [latitude, longitude, timezone, press, temp, tilt, aspect]
+    base = ctypes.addressof(o.val)
+    for k in range(len(COLUMNS)):
+        o.col[k] = base + 4 * k if COLUMNS[k] in columns else None
+    _lib.S_py_batch(1, o.utc, None, 1, o.table, 0, None, o.col, o.ret, 1)
+    return tuple(o.val[COLUMNS.index(c)] for c in columns) + (o.ret[0],)
@@ -33,6 +33,9 @@
 *    1998年3月25日
 *----------------------------------------------------------------------------*/
 
+#ifndef SOLPOS00_H
+#define SOLPOS00_H
+
 /*============================================================================
 *
 *     定义函数代码
@@ -328,3 +331,9 @@ VARIABLE      Mask       Required Variables
 *            zenref    太阳高度角，从顶点度，折射
 *
 *----------------------------------------------------------------------------*/
+extern long S_solpos (struct posdata *pdat);
+extern void S_init (struct posdata *pdat);
+extern void S_epoch (struct posdata *pdat, long long utc);
+extern void S_decode (long code, struct posdata *pdat);
+
+#endif /* SOLPOS00_H */
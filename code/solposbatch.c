@@ -0,0 +1,393 @@
+/*============================================================================
+*
+*    NAME:  solposbatch.c   (built as solpos-batch)
+*
+*    Runs a binary batch job (solbin.h): the input file is mapped, the
+*    output file is created at its final size and mapped, and the batch
+*    engine computes straight from one into the other on several
+*    threads.  Nothing is parsed or formatted on the way.
+*
+*    Besides the computation, input files can be made from a CSV file
+*    (solcsv.h; columns named as by S_csv_field, one site), from EPW or
+*    TMY3 weather files (soltmy.h; one site per file, hourly pressure
+*    and temperature, interval-midpoint positions) or as a synthetic
+*    site x minute grid, and any batch file can be listed.
+*
+*    Usage:
+*         solpos-batch [-t threads] [-c column,...] input output
+*                      default one thread per CPU and the columns
+*                      azim,elevref,zenref,cosinc,etrn,etrtilt
+*         solpos-batch -C file.csv input       CSV to input file
+*         solpos-batch -W year file... input   weather files to input
+*                                              file (year 0 takes each
+*                                              file's first year)
+*         solpos-batch -G sites days input     per-minute grid from
+*                                              1 January 2023
+*         solpos-batch -p file [rows]          header and first rows
+*
+*----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "solpos00.h"
+#include "solbin.h"
+#include "solcsv.h"
+#include "solrt.h"
+#include "soltmy.h"
+
+static int run( const char *in, const char *out, unsigned cols, int threads );
+static int import( const char *csvpath, const char *out );
+static int weather( int year, char **files, int nfile, const char *out );
+static int grid( int nsite, int days, const char *out );
+static int list( const char *path, long n );
+static int columns( const char *s, unsigned *cols );
+static int usage( void );
+
+
+int main( int argc, char *argv[] )
+{
+  unsigned cols = S_COL( C_AZIM ) | S_COL( C_ELEVREF ) | S_COL( C_ZENREF ) |
+                  S_COL( C_COSINC ) | S_COL( C_ETRN ) | S_COL( C_ETRTILT );
+  int      threads = (int) sysconf( _SC_NPROCESSORS_ONLN ), k;
+
+    if ( argc > 1 && strcmp( argv[1], "-C" ) == 0 )
+        return argc == 4 ? import( argv[2], argv[3] ) : usage();
+    if ( argc > 1 && strcmp( argv[1], "-W" ) == 0 )
+        return argc >= 5 ? weather( atoi( argv[2] ), argv + 3, argc - 4,
+                                    argv[argc - 1] ) : usage();
+    if ( argc > 1 && strcmp( argv[1], "-G" ) == 0 )
+        return argc == 5 ? grid( atoi( argv[2] ), atoi( argv[3] ), argv[4] )
+                         : usage();
+    if ( argc > 1 && strcmp( argv[1], "-p" ) == 0 )
+        return argc >= 3 ? list( argv[2], argc > 3 ? atol( argv[3] ) : 10 )
+                         : usage();
+
+    for ( k = 1; k < argc - 2; k += 2 ) {
+        if ( strcmp( argv[k], "-t" ) == 0 )
+            threads = atoi( argv[k + 1] );
+        else if ( strcmp( argv[k], "-c" ) == 0 ) {
+            if ( columns( argv[k + 1], &cols ) != 0 )
+                return usage();
+        }
+        else
+            return usage();
+    }
+    if ( k != argc - 2 )
+        return usage();
+    return run( argv[argc - 2], argv[argc - 1], cols, threads < 1 ? 1 : threads );
+}
+
+
+/*============================================================================
+*    Local Int function run
+*----------------------------------------------------------------------------*/
+static int run( const char *in, const char *out, unsigned cols, int threads )
+{
+  struct solbin   bi, bo;
+  struct solbatch batch;
+  struct posdata *sites;
+  long long t0;
+  double    sec;
+  long      errors;
+  uint32_t  k;
+  int       e;
+
+    if ( (e = S_bin_open( in, 0, &bi )) != 0 ||
+         bi.head->kind != S_BIN_INPUT ) {
+        fprintf( stderr, "solpos-batch: %s: %s\n", in,
+                 e < 0 ? "cannot map" : "not a batch input file" );
+        return 1;
+    }
+    if ( S_bin_create( out, S_BIN_OUTPUT, (long) bi.head->rows, 0, cols, 0,
+                       &bo ) != 0 ) {
+        perror( out );
+        return 1;
+    }
+    sites = (struct posdata *) malloc( bi.head->nsite * sizeof( *sites ) );
+    if ( sites == NULL ) {
+        fprintf( stderr, "solpos-batch: out of memory\n" );
+        return 1;
+    }
+    for ( k = 0; k < bi.head->nsite; k++ )
+        S_bin_site( &bi.site[k], &sites[k] );
+
+    S_bin_batch( &bi, &bo, sites, &batch );
+    t0     = S_rt_now();
+    errors = S_batch_parallel( &batch, threads );
+    sec    = ( S_rt_now() - t0 ) * 1.0e-9;
+
+    fprintf( stderr, "solpos-batch: %ld rows, %ld with errors, %d threads, "
+             "%.3f s, %.0f rows/s, %.1f MB out\n", batch.count, errors,
+             threads, sec, batch.count / ( sec > 0.0 ? sec : 1.0e-9 ),
+             bo.size / 1048576.0 );
+
+    free( sites );
+    S_bin_close( &bi );
+    S_bin_close( &bo );
+    return errors < 0;
+}
+
+
+/*============================================================================
+*    Local Int function import
+*
+*    Two passes over the CSV: the first counts the rows, so the input
+*    file can be created at its final size, the second fills it.
+*----------------------------------------------------------------------------*/
+static int import( const char *csvpath, const char *out )
+{
+  struct solcsv       csv;
+  struct solcsv_block blk;
+  struct solbin       bo;
+  unsigned mask = 0;
+  long     rows = 0, n, r = 0;
+  int      fd, k;
+
+    if ( (fd = open( csvpath, O_RDONLY )) < 0 ) {
+        perror( csvpath );
+        return 1;
+    }
+    if ( S_csv_open( &csv, fd, ',', NULL, 0 ) != 0 ||
+         S_csv_block_init( &blk, 65536 ) != 0 ) {
+        fprintf( stderr, "solpos-batch: out of memory\n" );
+        return 1;
+    }
+    S_csv_map_header( &csv, NULL );
+    while ( (n = S_csv_read( &csv, &blk )) > 0 )
+        rows += n;
+    for ( k = 0; k < I_NIN; k++ )
+        if ( csv.mapped & ( 1u << ( F_INPUT + k ) ) )
+            mask |= 1u << k;
+    S_csv_free( &csv );
+
+    if ( S_bin_create( out, S_BIN_INPUT, rows, 1, mask, 0, &bo ) != 0 ) {
+        perror( out );
+        return 1;
+    }
+
+    if ( lseek( fd, 0, SEEK_SET ) != 0 ||
+         S_csv_open( &csv, fd, ',', NULL, 0 ) != 0 ) {
+        perror( csvpath );
+        return 1;
+    }
+    S_csv_map_header( &csv, NULL );
+    S_bin_put( &bo.site[0], &csv.site );
+    while ( (n = S_csv_read( &csv, &blk )) > 0 && r + n <= rows ) {
+        memcpy( bo.utc + r, blk.utc, n * sizeof( long long ) );
+        for ( k = 0; k < I_NIN; k++ )
+            if ( bo.in[k] )
+                memcpy( bo.in[k] + r, blk.in[k], n * sizeof( float ) );
+        r += n;
+    }
+
+    fprintf( stderr, "solpos-batch: %ld rows, %ld lines skipped\n", r,
+             csv.skipped );
+    S_csv_block_free( &blk );
+    S_csv_free( &csv );
+    close( fd );
+    S_bin_close( &bo );
+    return r != rows;
+}
+
+
+/*============================================================================
+*    Local Int function weather
+*
+*    One site per weather file, its records end to end, with the hourly
+*    pressure and temperature as input columns
+*----------------------------------------------------------------------------*/
+static int weather( int year, char **files, int nfile, const char *out )
+{
+  struct soltmy *tmy;
+  struct solbin  bo;
+  long  rows = 0, r = 0, i;
+  int   k, e;
+
+    if ( (tmy = (struct soltmy *) calloc( nfile, sizeof( *tmy ) )) == NULL ) {
+        fprintf( stderr, "solpos-batch: out of memory\n" );
+        return 1;
+    }
+    for ( k = 0; k < nfile; k++ ) {
+        if ( (e = S_tmy_load( &tmy[k], files[k], year )) != 0 ) {
+            if ( e < 0 )
+                perror( files[k] );
+            else
+                fprintf( stderr, "solpos-batch: %s: line %d: not an EPW or "
+                         "TMY3 record\n", files[k], e );
+            return 1;
+        }
+        rows += tmy[k].n;
+    }
+
+    if ( S_bin_create( out, S_BIN_INPUT, rows, nfile,
+                       ( 1u << I_PRESS ) | ( 1u << I_TEMP ), S_BIN_SITEID,
+                       &bo ) != 0 ) {
+        perror( out );
+        return 1;
+    }
+    for ( k = 0; k < nfile; k++ ) {
+        S_bin_put( &bo.site[k], &tmy[k].site );
+        memcpy( bo.utc + r, tmy[k].utc, tmy[k].n * sizeof( long long ) );
+        memcpy( bo.in[I_PRESS] + r, tmy[k].wx[W_PRESS],
+                tmy[k].n * sizeof( float ) );
+        memcpy( bo.in[I_TEMP] + r, tmy[k].wx[W_TEMP],
+                tmy[k].n * sizeof( float ) );
+        for ( i = 0; i < tmy[k].n; i++ )
+            bo.siteid[r + i] = k;
+        r += tmy[k].n;
+        fprintf( stderr, "solpos-batch: %s: %s, %ld records of %d s, "
+                 "%ld values missing\n", files[k], tmy[k].name, tmy[k].n,
+                 tmy[k].site.interval, tmy[k].missing );
+        S_tmy_free( &tmy[k] );
+    }
+
+    free( tmy );
+    S_bin_close( &bo );
+    return 0;
+}
+
+
+/*============================================================================
+*    Local Int function grid
+*----------------------------------------------------------------------------*/
+static int grid( int nsite, int days, const char *out )
+{
+  struct solbin  bo;
+  struct posdata pd;
+  long  ntime, rows, r;
+  int   k;
+
+    if ( nsite < 1 || days < 1 )
+        return usage();
+    ntime = 1440L * days;
+    rows  = ntime * nsite;
+    if ( S_bin_create( out, S_BIN_INPUT, rows, nsite, 0, S_BIN_SITEID,
+                       &bo ) != 0 ) {
+        perror( out );
+        return 1;
+    }
+
+    for ( k = 0; k < nsite; k++ ) {
+        S_init( &pd );
+        pd.latitude  = -60.0 + 120.0 * k / nsite;
+        pd.longitude = -180.0 + 360.0 * k / nsite;
+        pd.timezone  = (float) (int) ( pd.longitude / 15.0 );
+        pd.tilt      = pd.latitude;
+        pd.aspect    = pd.latitude < 0.0 ? 0.0 : 180.0;
+        S_bin_put( &bo.site[k], &pd );
+    }
+    for ( r = 0; r < rows; r++ ) {
+        bo.siteid[r] = (int) ( r / ntime );
+        bo.utc[r]    = 1672531200LL + ( r % ntime ) * 60;
+    }
+
+    fprintf( stderr, "solpos-batch: %d sites x %ld times = %ld rows, "
+             "%.1f MB\n", nsite, ntime, rows, bo.size / 1048576.0 );
+    S_bin_close( &bo );
+    return 0;
+}
+
+
+/*============================================================================
+*    Local Int function list
+*----------------------------------------------------------------------------*/
+static int list( const char *path, long n )
+{
+  struct solbin bin;
+  struct solbin_head *h;
+  long  r;
+  int   k, e;
+
+    if ( (e = S_bin_open( path, 0, &bin )) != 0 ) {
+        fprintf( stderr, "solpos-batch: %s: %s\n", path,
+                 e < 0 ? "cannot map" : "not a batch file" );
+        return 1;
+    }
+    h = bin.head;
+    printf( "%s: version %u, %s, %llu rows, %u sites, %llu bytes\n", path,
+            h->version, h->kind == S_BIN_INPUT ? "input" : "output",
+            (unsigned long long) h->rows, h->nsite,
+            (unsigned long long) h->size );
+    if ( n > (long) h->rows )
+        n = (long) h->rows;
+
+    if ( h->kind == S_BIN_INPUT ) {
+        printf( "utc%s", bin.siteid ? ",site" : "" );
+        for ( k = 0; k < I_NIN; k++ )
+            if ( bin.in[k] )
+                printf( ",%s", S_batch_input( k ) );
+        printf( "\n" );
+        for ( r = 0; r < n; r++ ) {
+            printf( "%lld", bin.utc[r] );
+            if ( bin.siteid )
+                printf( ",%d", bin.siteid[r] );
+            for ( k = 0; k < I_NIN; k++ )
+                if ( bin.in[k] )
+                    printf( ",%g", bin.in[k][r] );
+            printf( "\n" );
+        }
+    }
+    else {
+        printf( "retval" );
+        for ( k = 0; k < C_NCOL; k++ )
+            if ( bin.col[k] )
+                printf( ",%s", S_batch_column( k ) );
+        printf( "\n" );
+        for ( r = 0; r < n; r++ ) {
+            printf( "%ld", bin.retval[r] );
+            for ( k = 0; k < C_NCOL; k++ )
+                if ( bin.col[k] )
+                    printf( ",%g", bin.col[k][r] );
+            printf( "\n" );
+        }
+    }
+    S_bin_close( &bin );
+    return 0;
+}
+
+
+/*============================================================================
+*    Local Int function columns
+*
+*    Comma-separated column names to a mask; -1 for an unknown name
+*----------------------------------------------------------------------------*/
+static int columns( const char *s, unsigned *cols )
+{
+  const char *q;
+  size_t len;
+  int    k;
+
+    for ( *cols = 0; *s; s = *q ? q + 1 : q ) {
+        q   = s + strcspn( s, "," );
+        len = q - s;
+        for ( k = 0; k < C_NCOL; k++ )
+            if ( strlen( S_batch_column( k ) ) == len &&
+                 strncmp( S_batch_column( k ), s, len ) == 0 )
+                break;
+        if ( k == C_NCOL ) {
+            fprintf( stderr, "solpos-batch: no column %.*s\n", (int) len, s );
+            return -1;
+        }
+        *cols |= S_COL( k );
+    }
+    return 0;
+}
+
+
+/*============================================================================
+*    Local Int function usage
+*----------------------------------------------------------------------------*/
+static int usage( void )
+{
+    fprintf( stderr,
+             "usage: solpos-batch [-t threads] [-c column,...] input output\n"
+             "       solpos-batch -C file.csv input\n"
+             "       solpos-batch -W year file... input\n"
+             "       solpos-batch -G sites days input\n"
+             "       solpos-batch -p file [rows]\n" );
+    return 2;
+}
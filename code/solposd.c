@@ -0,0 +1,364 @@
+/*============================================================================
+*
+*    NAME:  solposd.c
+*
+*    Local solar position daemon.  Listens on a Unix domain socket
+*    (soldaemon.h) and serves S_solpos requests from any number of
+*    clients through the batch engine (solbatch.h).
+*
+*    Each pass of the event loop reads everything that has arrived on
+*    every connection, coalesces all complete requests into one batch,
+*    computes it with S_batch_parallel, and queues the responses.  Under
+*    load, concurrent clients therefore share large batches; when idle, a
+*    lone request is answered on the next pass.
+*
+*    Coalescing saves wakeups and system calls, not arithmetic: the batch
+*    is scalar.  S_batch_parallel splits it over the threads, and each
+*    thread runs its rows through S_solpos one at a time, so a response
+*    is bit for bit the S_solpos of its request (sdtest checks this).
+*
+*    A client is not read while its input buffer is full, or while more
+*    than OUTMAX bytes of its responses are waiting to be written (a
+*    client that sends without reading); the kernel's socket buffer then
+*    holds it back until it catches up.
+*
+*    Usage:
+*         solposd [-s socket] [-t threads] [-b max batch]
+*
+*         SIGINT or SIGTERM stops the daemon and prints its counters.
+*
+*----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "soldaemon.h"
+#include "solrt.h"
+
+#define MAXCLIENT  128
+#define INBUF      ( 256 * sizeof( struct sold_req ) )
+#define OUTMAX     ( 4096 * sizeof( struct sold_rsp ) )
+
+struct client
+{
+    int    fd;
+    char   in[INBUF];     /* partial requests */
+    size_t inlen;
+    char  *out;           /* responses not yet written */
+    size_t outlen;
+    size_t outcap;
+};
+
+static volatile sig_atomic_t stop;
+
+static void on_signal( int sig );
+static int  listen_on( const char *path );
+static size_t room( const struct client *c );
+static int  queue_out( struct client *c, const void *buf, size_t len );
+static void flush_out( struct client *c );
+static void drop( struct client *c );
+
+
+int main( int argc, char *argv[] )
+{
+  static struct client client[MAXCLIENT];
+  struct pollfd  pfd[MAXCLIENT + 1];
+  struct solbatch batch;
+  struct posdata  deflt;       /* S_init defaults for the templates */
+  struct posdata *sites;
+  struct sold_req  req;
+  struct sold_rsp  rsp;
+  const char *path = S_D_SOCKET;
+  long long  *utc, *recv_ns, t_done;
+  unsigned long long *tag;
+  short      *owner;
+  int        *siteid;      /* row i is request i's own site */
+  float      *colbuf;
+  long       *retval;
+  long        maxbatch = 65536, n, i, nbatch = 0, nreq = 0;
+  size_t      off, want;
+  ssize_t     got;
+  int         threads = 1, lfd, busy, k, c, fd;
+
+    for ( k = 1; k < argc - 1; k += 2 ) {
+        if ( strcmp( argv[k], "-s" ) == 0 )
+            path = argv[k + 1];
+        else if ( strcmp( argv[k], "-t" ) == 0 )
+            threads = atoi( argv[k + 1] );
+        else if ( strcmp( argv[k], "-b" ) == 0 )
+            maxbatch = atol( argv[k + 1] );
+    }
+    if ( maxbatch < 1 )
+        maxbatch = 1;
+
+    sites   = (struct posdata *) malloc( maxbatch * sizeof( *sites ) );
+    utc     = (long long *) malloc( maxbatch * sizeof( *utc ) );
+    recv_ns = (long long *) malloc( maxbatch * sizeof( *recv_ns ) );
+    tag     = (unsigned long long *) malloc( maxbatch * sizeof( *tag ) );
+    owner   = (short *) malloc( maxbatch * sizeof( *owner ) );
+    siteid  = (int *) malloc( maxbatch * sizeof( *siteid ) );
+    retval  = (long *) malloc( maxbatch * sizeof( *retval ) );
+    colbuf  = (float *) malloc( maxbatch * C_NCOL * sizeof( float ) );
+    if ( !sites || !utc || !recv_ns || !tag || !owner || !siteid || !retval ||
+         !colbuf ) {
+        fprintf( stderr, "solposd: out of memory\n" );
+        return 1;
+    }
+
+    memset( &batch, 0, sizeof( batch ) );
+    batch.utc    = utc;
+    batch.site   = siteid;
+    batch.sites  = sites;
+    batch.retval = retval;
+    for ( k = 0; k < C_NCOL; k++ )
+        batch.col[k] = colbuf + k * maxbatch;
+    for ( i = 0; i < maxbatch; i++ )
+        siteid[i] = (int) i;
+
+    S_init( &deflt );
+    for ( c = 0; c < MAXCLIENT; c++ )
+        client[c].fd = -1;
+
+    signal( SIGINT,  on_signal );
+    signal( SIGTERM, on_signal );
+    signal( SIGPIPE, SIG_IGN );
+
+    if ( (lfd = listen_on( path )) < 0 )
+        return 1;
+    fprintf( stderr, "solposd: listening on %s, %d thread(s)\n",
+             path, threads );
+
+    while ( !stop ) {
+        /* wait for requests, new clients, or room to write */
+        pfd[0].fd     = lfd;
+        pfd[0].events = POLLIN;
+        for ( c = 0; c < MAXCLIENT; c++ ) {
+            pfd[c + 1].fd     = client[c].fd;
+            pfd[c + 1].events = ( room( &client[c] ) ? POLLIN : 0 ) |
+                                ( client[c].outlen ? POLLOUT : 0 );
+        }
+        /* requests left over from a full batch go out without waiting */
+        for ( busy = 0, c = 0; c < MAXCLIENT; c++ )
+            if ( client[c].fd >= 0 && client[c].inlen >= sizeof( req ) )
+                busy = 1;
+        if ( poll( pfd, MAXCLIENT + 1, busy ? 0 : 1000 ) < 0 )
+            continue;
+
+        if ( pfd[0].revents & POLLIN ) {
+            while ( (fd = accept( lfd, NULL, NULL )) >= 0 ) {
+                for ( c = 0; c < MAXCLIENT && client[c].fd >= 0; c++ )
+                    ;
+                if ( c == MAXCLIENT ) {
+                    close( fd );
+                    continue;
+                }
+                fcntl( fd, F_SETFL, O_NONBLOCK );
+                client[c].fd    = fd;
+                client[c].inlen = 0;
+            }
+        }
+
+        /* coalesce every complete request that has arrived */
+        n = 0;
+        for ( c = 0; c < MAXCLIENT; c++ ) {
+            if ( client[c].fd < 0 )
+                continue;
+            if ( pfd[c + 1].revents & POLLOUT )
+                flush_out( &client[c] );
+            if ( client[c].fd >= 0 &&
+                 ( pfd[c + 1].revents & ( POLLIN | POLLHUP | POLLERR ) ) &&
+                 (want = room( &client[c] )) > 0 ) {
+                got = read( client[c].fd, client[c].in + client[c].inlen,
+                            want );
+                if ( got == 0 ||
+                     ( got < 0 && errno != EAGAIN && errno != EINTR ) ) {
+                    drop( &client[c] );
+                    continue;
+                }
+                if ( got > 0 )
+                    client[c].inlen += got;
+            }
+            else if ( client[c].fd >= 0 && client[c].outlen &&
+                      ( pfd[c + 1].revents & ( POLLHUP | POLLERR ) ) )
+                flush_out( &client[c] );  /* not read: the write fails */
+            if ( client[c].fd < 0 )
+                continue;
+
+            for ( off = 0; off + sizeof( req ) <= client[c].inlen &&
+                           n < maxbatch; off += sizeof( req ) ) {
+                memcpy( &req, client[c].in + off, sizeof( req ) );
+                sites[n]           = deflt;
+                sites[n].function  = req.function;
+                sites[n].latitude  = req.latitude;
+                sites[n].longitude = req.longitude;
+                sites[n].timezone  = req.timezone;
+                sites[n].press     = req.press;
+                sites[n].temp      = req.temp;
+                sites[n].tilt      = req.tilt;
+                sites[n].aspect    = req.aspect;
+                utc[n]     = req.utc;
+                tag[n]     = req.tag;
+                owner[n]   = (short) c;
+                recv_ns[n] = S_rt_now();
+                n++;
+            }
+            memmove( client[c].in, client[c].in + off,
+                     client[c].inlen - off );
+            client[c].inlen -= off;
+        }
+        if ( n == 0 )
+            continue;
+
+        /* one batch for everybody, then fan the results back out */
+        batch.count = n;
+        S_batch_parallel( &batch, threads );
+        t_done = S_rt_now();
+        nbatch++;
+        nreq += n;
+
+        for ( i = 0; i < n; i++ ) {
+            c = owner[i];
+            if ( client[c].fd < 0 )
+                continue;
+            rsp.tag     = tag[i];
+            rsp.latency = t_done - recv_ns[i];
+            rsp.retval  = retval[i];
+            for ( k = 0; k < C_NCOL; k++ )
+                rsp.col[k] = batch.col[k][i];
+            if ( queue_out( &client[c], &rsp, sizeof( rsp ) ) != 0 )
+                drop( &client[c] );
+        }
+        for ( c = 0; c < MAXCLIENT; c++ )
+            if ( client[c].fd >= 0 && client[c].outlen )
+                flush_out( &client[c] );
+    }
+
+    fprintf( stderr, "solposd: %ld requests in %ld batches (%.1f per batch)\n",
+             nreq, nbatch, nbatch ? (double) nreq / nbatch : 0.0 );
+
+    for ( c = 0; c < MAXCLIENT; c++ )
+        if ( client[c].fd >= 0 )
+            drop( &client[c] );
+    close( lfd );
+    unlink( path );
+    return 0;
+}
+
+
+/*============================================================================
+*    Local Void function on_signal
+*----------------------------------------------------------------------------*/
+static void on_signal( int sig )
+{
+    (void) sig;
+    stop = 1;
+}
+
+
+/*============================================================================
+*    Local Int function listen_on
+*
+*    Non-blocking listening socket bound to path (replacing a stale one)
+*----------------------------------------------------------------------------*/
+static int listen_on( const char *path )
+{
+  struct sockaddr_un addr;
+  int fd;
+
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    strncpy( addr.sun_path, path, sizeof( addr.sun_path ) - 1 );
+
+    if ( (fd = socket( AF_UNIX, SOCK_STREAM, 0 )) < 0 ) {
+        perror( "solposd: socket" );
+        return -1;
+    }
+    unlink( path );
+    if ( bind( fd, (struct sockaddr *) &addr, sizeof( addr ) ) != 0 ||
+         listen( fd, 64 ) != 0 ) {
+        perror( "solposd: bind" );
+        close( fd );
+        return -1;
+    }
+    fcntl( fd, F_SETFL, O_NONBLOCK );
+    return fd;
+}
+
+
+/*============================================================================
+*    Local Size function room
+*
+*    Bytes to read from a client now: none while its input buffer is full
+*    or its output is backed up past OUTMAX
+*----------------------------------------------------------------------------*/
+static size_t room( const struct client *c )
+{
+    if ( c->fd < 0 || c->outlen >= OUTMAX )
+        return 0;
+    return INBUF - c->inlen;
+}
+
+
+/*============================================================================
+*    Local Int function queue_out
+*
+*    Appends to a client's output buffer; -1 if memory ran out
+*----------------------------------------------------------------------------*/
+static int queue_out( struct client *c, const void *buf, size_t len )
+{
+  char  *p;
+  size_t cap;
+
+    if ( c->outlen + len > c->outcap ) {
+        cap = c->outcap ? 2 * c->outcap : 64 * len;
+        while ( cap < c->outlen + len )
+            cap *= 2;
+        if ( (p = (char *) realloc( c->out, cap )) == NULL )
+            return -1;
+        c->out    = p;
+        c->outcap = cap;
+    }
+    memcpy( c->out + c->outlen, buf, len );
+    c->outlen += len;
+    return 0;
+}
+
+
+/*============================================================================
+*    Local Void function flush_out
+*
+*    Writes as much of the output buffer as the socket takes
+*----------------------------------------------------------------------------*/
+static void flush_out( struct client *c )
+{
+  ssize_t put;
+
+    put = write( c->fd, c->out, c->outlen );
+    if ( put < 0 ) {
+        if ( errno != EAGAIN )
+            drop( c );
+        return;
+    }
+    memmove( c->out, c->out + put, c->outlen - put );
+    c->outlen -= put;
+}
+
+
+/*============================================================================
+*    Local Void function drop
+*----------------------------------------------------------------------------*/
+static void drop( struct client *c )
+{
+    close( c->fd );
+    c->fd     = -1;
+    c->inlen  = 0;
+    c->outlen = 0;
+}
@@ -0,0 +1,91 @@
+/*============================================================================
+*    Contains:
+*        S_py_batch    (runs a batch described by flat arrays)
+*        S_py_version  (interface version)
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solpy.h"
+*
+*----------------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "solpy.h"
+
+#define NSTACK  16    /* sites set up without malloc */
+
+
+/*============================================================================
+*    Long integer function S_py_batch
+*
+*    sitein holds nsite rows of I_NIN floats (latitude .. aspect, the
+*    solbatch.h input order); function is the S_solpos mask for every
+*    site, 0 for S_ALL.  in[I_NIN] and col[C_NCOL] are per-row input
+*    and output columns, NULL where unused (in itself may be NULL).
+*    site may be NULL when nsite is 1.  Returns the number of rows with
+*    errors, -1 if a thread or memory could not be had, or -2 for a
+*    site index out of range (nothing is computed then).
+*----------------------------------------------------------------------------*/
+long S_py_batch (long count, const long long *utc, const int *site,
+                 int nsite, const float *sitein, int function,
+                 const float * const *in, float * const *col,
+                 long *retval, int threads)
+{
+  struct posdata  stack[NSTACK], *sites = stack;
+  struct solbatch batch;
+  const float    *s;
+  long   errors, i;
+  int    k;
+
+    if ( nsite < 1 || ( site == NULL && nsite != 1 ) )
+        return -2;
+    for ( i = 0; site && i < count; i++ )
+        if ( site[i] < 0 || site[i] >= nsite )
+            return -2;
+
+    if ( nsite > NSTACK &&
+         (sites = (struct posdata *) malloc( nsite * sizeof( *sites ) ))
+         == NULL )
+        return -1;
+    for ( k = 0; k < nsite; k++ ) {
+        s = sitein + (long) k * I_NIN;
+        S_init( &sites[k] );
+        sites[k].latitude  = s[I_LATITUDE];
+        sites[k].longitude = s[I_LONGITUDE];
+        sites[k].timezone  = s[I_TIMEZONE];
+        sites[k].press     = s[I_PRESS];
+        sites[k].temp      = s[I_TEMP];
+        sites[k].tilt      = s[I_TILT];
+        sites[k].aspect    = s[I_ASPECT];
+        if ( function )
+            sites[k].function = function;
+    }
+
+    memset( &batch, 0, sizeof( batch ) );
+    batch.count  = count;
+    batch.utc    = utc;
+    batch.site   = site;
+    batch.sites  = sites;
+    batch.retval = retval;
+    for ( k = 0; in && k < I_NIN; k++ )
+        batch.in[k] = in[k];
+    for ( k = 0; col && k < C_NCOL; k++ )
+        batch.col[k] = col[k];
+
+    errors = threads > 1 ? S_batch_parallel( &batch, threads )
+                         : S_batch( &batch, 0, count );
+
+    if ( sites != stack )
+        free( sites );
+    return errors;
+}
+
+
+/*============================================================================
+*    Int function S_py_version
+*----------------------------------------------------------------------------*/
+int S_py_version (void)
+{
+    return S_PY_VERSION;
+}
@@ -0,0 +1,35 @@
+/*============================================================================
+*
+*    NAME:  solpy.h
+*
+*    Contains:
+*        S_py_batch    (runs a batch described by flat arrays)
+*        S_py_version  (interface version)
+*
+*    Entry point of the shared library libsolpy used from Python
+*    (solpos.py, through ctypes).  Everything is passed as plain arrays
+*    and counts, so the caller needs no copy of struct posdata or struct
+*    solbatch; the arrays are used in place.  ctypes releases the GIL
+*    for the duration of the call, so other Python threads keep running
+*    while the batch is computed on the engine's own threads.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solpy.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLPY_H
+#define SOLPY_H
+
+#include "solbatch.h"
+
+#define S_PY_VERSION  1
+
+extern long S_py_batch (long count, const long long *utc, const int *site,
+                        int nsite, const float *sitein, int function,
+                        const float * const *in, float * const *col,
+                        long *retval, int threads);
+extern int  S_py_version (void);
+
+#endif /* SOLPY_H */
@@ -0,0 +1,221 @@
+/*============================================================================
+*    Contains:
+*        S_qc_init  (sets up quality control of one station's log)
+*        S_qc       (checks the next rows of the log)
+*        S_qc_name  (name of a flag)
+*        S_qc_free  (releases a solqc)
+*
+*    Each block of rows is three passes: the batch positions, the Sa and
+*    sbcf columns (copies of the day's values, recomputed only when the
+*    local day changes) and the checks.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solqc.h"
+*
+*----------------------------------------------------------------------------*/
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "solqc.h"
+#include "solvec.h"
+
+enum { B_COSZEN, B_ETR, B_SA, B_PRIME, B_SBCF, B_KT, B_KTP, B_N };
+
+static const char *flagname[Q_NFLAG] = { "missing", "ghi_ppl", "ghi_erl",
+                                         "dni_ppl", "dni_erl", "dhi_ppl",
+                                         "dhi_erl", "closure", "diffuse" };
+
+static float cos75 = 0.258819045;   /* zenith 75 degrees */
+static float cos93 = -0.0523359562; /* zenith 93 degrees */
+
+static void  today( struct solqc *qc, long day );
+static void  check( long n, const float *restrict coszen,
+                    const float *restrict etr, const float *restrict sa,
+                    const float *restrict prime, const float *restrict sbcf,
+                    const float *restrict ghi, const float *restrict dni,
+                    float *restrict dhi, unsigned *restrict flags,
+                    float *restrict kt, float *restrict ktp );
+
+
+/*============================================================================
+*    Integer function S_qc_init
+*----------------------------------------------------------------------------*/
+int S_qc_init (struct solqc *qc, const struct posdata *site, int shadowband)
+{
+    memset( qc, 0, sizeof( *qc ) );
+    qc->site          = *site;
+    qc->site.function = S_PRIME | S_ETR;
+    qc->shadowband    = shadowband;
+    qc->day           = LONG_MIN;
+    qc->buf = (float *) malloc( B_N * S_QC_BLOCK * sizeof( float ) );
+    return qc->buf ? 0 : -1;
+}
+
+
+/*============================================================================
+*    Long integer function S_qc
+*
+*    Checks n rows; utc is as in solbatch.h (the end of an interval if
+*    the site has one).  dhi is corrected in place; kt and ktp may be
+*    NULL.
+*----------------------------------------------------------------------------*/
+long S_qc (struct solqc *qc, long n, const long long *utc, const float *ghi,
+           const float *dni, float *dhi, unsigned *flags, float *kt,
+           float *ktp)
+{
+  struct solbatch batch;
+  float *col[B_N];
+  long long t, tz = (long long) floor( qc->site.timezone * 3600.0 + 0.5 );
+  long  first, m, i, day, bad = 0;
+  int   f;
+
+    for ( f = 0; f < B_N; f++ )
+        col[f] = qc->buf + f * S_QC_BLOCK;
+    memset( &batch, 0, sizeof( batch ) );
+    batch.sites = &qc->site;
+    batch.col[C_COSZEN] = col[B_COSZEN];
+    batch.col[C_ETR]    = col[B_ETR];
+    batch.col[C_PRIME]  = col[B_PRIME];
+
+    for ( first = 0; first < n; first += m ) {
+        m = n - first < S_QC_BLOCK ? n - first : S_QC_BLOCK;
+        batch.count = m;
+        batch.utc   = utc + first;
+        S_batch( &batch, 0, m );
+
+        for ( i = 0; i < m; i++ ) {
+            t   = utc[first + i] - qc->site.interval / 2 + tz;
+            day = (long) ( t >= 0 ? t / 86400 : -( ( 86399 - t ) / 86400 ) );
+            if ( day != qc->day ) {
+                qc->day = day;
+                today( qc, day );
+            }
+            col[B_SA][i]   = qc->sa;
+            col[B_SBCF][i] = qc->sbcf;
+        }
+
+        check( m, col[B_COSZEN], col[B_ETR], col[B_SA], col[B_PRIME],
+               col[B_SBCF], ghi + first, dni + first, dhi + first,
+               flags + first, kt ? kt + first : col[B_KT],
+               ktp ? ktp + first : col[B_KTP] );
+
+        for ( i = first; i < first + m; i++ ) {
+            for ( f = 0; f < Q_NFLAG; f++ )
+                qc->count[f] += ( flags[i] >> f ) & 1;
+            bad += ( flags[i] & ~S_QC( Q_MISSING ) ) != 0;
+        }
+    }
+    qc->rows += n;
+    return bad;
+}
+
+
+/*============================================================================
+*    Const char pointer function S_qc_name
+*----------------------------------------------------------------------------*/
+const char *S_qc_name (int flag)
+{
+    return flag >= 0 && flag < Q_NFLAG ? flagname[flag] : NULL;
+}
+
+
+/*============================================================================
+*    Void function S_qc_free
+*----------------------------------------------------------------------------*/
+void S_qc_free (struct solqc *qc)
+{
+    free( qc->buf );
+    qc->buf = NULL;
+}
+
+
+/*============================================================================
+*    Local Void function today
+*
+*    sa and sbcf of a local standard day, from the earth radius vector,
+*    declination and sunset hour angle at local noon.  sbcf is 1 without
+*    a shadowband, or if S_solpos rejects the site's.
+*----------------------------------------------------------------------------*/
+static void today( struct solqc *qc, long day )
+{
+  struct posdata pd = qc->site;
+
+    pd.function = qc->shadowband ? S_SBCF : S_GEOM;
+    pd.interval = 0;
+    S_epoch( &pd, (long long) day * 86400 + 43200 -
+                  (long long) floor( pd.timezone * 3600.0 + 0.5 ) );
+    qc->days++;
+    qc->sbcf = 1.0f;
+    if ( S_solpos( &pd ) != 0 ) {
+        pd.function = S_GEOM;
+        S_solpos( &pd );
+    }
+    else if ( qc->shadowband )
+        qc->sbcf = pd.sbcf;
+    qc->sa = pd.solcon * pd.erv;
+}
+
+
+/*============================================================================
+*    Local Void function check
+*
+*    The flags of n rows.  Each test is a comparison turned into a bit,
+*    so there are no branches; a NaN compares false everywhere.
+*----------------------------------------------------------------------------*/
+static void check( long n, const float *restrict coszen,
+                   const float *restrict etr, const float *restrict sa,
+                   const float *restrict prime, const float *restrict sbcf,
+                   const float *restrict ghi, const float *restrict dni,
+                   float *restrict dhi, unsigned *restrict flags,
+                   float *restrict kt, float *restrict ktp )
+{
+  float    u, u12, u02, g, b, d, sum, lim, k;
+  int32_t  up, low;
+  unsigned f;
+  long     i;
+
+    for ( i = 0; i < n; i++ ) {
+        up  = -( coszen[i] > 0.0f );
+        u   = vsel( up, coszen[i], 1.0f );
+        u12 = vsel( up, vpow( u, 1.2f ), 0.0f );
+        u02 = vsel( up, vpow( u, 0.2f ), 0.0f );
+        u   = vsel( up, u, 0.0f );
+        g   = ghi[i];
+        b   = dni[i];
+        d   = dhi[i] * sbcf[i];
+        dhi[i] = d;
+
+        f  = (unsigned) ( ( g != g ) | ( b != b ) | ( d != d ) ) << Q_MISSING;
+        f |= (unsigned) ( ( g < -4.0f ) |
+                          ( g > 1.5f * sa[i] * u12 + 100.0f ) ) << Q_GHI_PPL;
+        f |= (unsigned) ( ( g < -2.0f ) |
+                          ( g > 1.2f * sa[i] * u12 + 50.0f ) ) << Q_GHI_ERL;
+        f |= (unsigned) ( ( b < -4.0f ) | ( b > sa[i] ) ) << Q_DNI_PPL;
+        f |= (unsigned) ( ( b < -2.0f ) |
+                          ( b > 0.95f * sa[i] * u02 + 10.0f ) ) << Q_DNI_ERL;
+        f |= (unsigned) ( ( d < -4.0f ) |
+                          ( d > 0.95f * sa[i] * u12 + 50.0f ) ) << Q_DHI_PPL;
+        f |= (unsigned) ( ( d < -2.0f ) |
+                          ( d > 0.75f * sa[i] * u12 + 30.0f ) ) << Q_DHI_ERL;
+
+        low = coszen[i] <= cos75;
+        sum = b * u + d;
+        lim = vsel( -low, 0.15f, 0.08f );
+        f |= (unsigned) ( ( coszen[i] > cos93 ) & ( sum > 50.0f ) &
+                          ( fabsf( g / vsel( -( sum > 50.0f ), sum, 1.0f ) -
+                                   1.0f ) > lim ) ) << Q_CLOSURE;
+        lim = vsel( -low, 1.10f, 1.05f );
+        f |= (unsigned) ( ( coszen[i] > cos93 ) & ( g > 50.0f ) &
+                          ( d / vsel( -( g > 50.0f ), g, 1.0f ) > lim ) )
+             << Q_DIFFUSE;
+        flags[i] = f;
+
+        up     = -( etr[i] > 0.0f );
+        k      = vsel( up, g / vsel( up, etr[i], 1.0f ), 0.0f );
+        kt[i]  = k;
+        ktp[i] = k * vsel( up, prime[i], 0.0f );
+    }
+}
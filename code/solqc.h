@@ -0,0 +1,88 @@
+/*============================================================================
+*
+*    NAME:  solqc.h
+*
+*    Contains:
+*        S_qc_init  (sets up quality control of one station's log)
+*        S_qc       (checks the next rows of the log)
+*        S_qc_name  (name of a flag)
+*        S_qc_free  (releases a solqc)
+*
+*    Streaming quality control of radiometer data: GHI, DNI and DHI rows
+*    with their UTC times are passed in chunks of any size, in time
+*    order, and each row gets a word of flags.  Per row the positions
+*    come from the batch engine (coszen, etr, prime); Sa, solcon times
+*    erv, and the shadowband correction factor sbcf depend only on the
+*    site and the day, so they are computed once per local standard day
+*    (sbcf from the site's sbwid, sbrad and sbsky) and kept until the
+*    day changes.
+*
+*    When shadowband is set, the DHI passed in is from a shadowband
+*    pyranometer and is multiplied in place by sbcf before the checks.
+*    Kt = GHI / etr and Kt' = Kt prime are returned if asked for (0 with
+*    the sun down).
+*
+*    The checks are those of the BSRN recommended QC (Long and Dutton
+*    2002), with u0 = max( coszen, 0 ) and Sa the day's value above
+*    (not etrn, which is 0 with the sun down):
+*        Q_x_PPL   physically possible:  GHI  -4 .. 1.5  Sa u0^1.2 + 100
+*                                        DNI  -4 .. Sa
+*                                        DHI  -4 .. 0.95 Sa u0^1.2 + 50
+*        Q_x_ERL   extremely rare:       GHI  -2 .. 1.2  Sa u0^1.2 + 50
+*                                        DNI  -2 .. 0.95 Sa u0^0.2 + 10
+*                                        DHI  -2 .. 0.75 Sa u0^1.2 + 30
+*        Q_CLOSURE GHI / ( DNI u0 + DHI ) off 1 by more than 8 % (zenith
+*                  below 75) or 15 % (75 to 93), when the sum is over 50
+*        Q_DIFFUSE DHI / GHI over 1.05 (zenith below 75) or 1.10 (75 to
+*                  93), when GHI is over 50
+*        Q_MISSING any of the three is NaN (the tests of a NaN value do
+*                  not flag)
+*    Flag bits are S_QC( Q_... ), as columns are S_COL( C_... ).
+*
+*    The flag loop is branch-free and vectorizes; the cost is the batch
+*    positions, computed with just S_PRIME | S_ETR, in blocks of
+*    S_QC_BLOCK rows.
+*
+*    S_qc_init returns 0, or -1 if out of memory.  S_qc returns the
+*    number of rows with any flag but Q_MISSING.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solqc.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLQC_H
+#define SOLQC_H
+
+#include "solbatch.h"
+
+#define S_QC_BLOCK  4096
+#define S_QC(f)     ( 1u << (f) )
+
+enum { Q_MISSING, Q_GHI_PPL, Q_GHI_ERL, Q_DNI_PPL, Q_DNI_ERL, Q_DHI_PPL,
+       Q_DHI_ERL, Q_CLOSURE, Q_DIFFUSE, Q_NFLAG };
+
+struct solqc
+{
+    struct posdata site;        /* location, press, temp, interval, sb* */
+    int        shadowband;      /* DHI needs the shadowband correction */
+    long       rows;            /* rows checked */
+    long       count[Q_NFLAG];  /* rows with each flag */
+    long       day;             /* local day of sa and sbcf (days since
+                                   1970) */
+    float      sa;              /* solcon erv */
+    float      sbcf;
+    long       days;            /* computations of sa and sbcf */
+    float     *buf;             /* block columns */
+};
+
+extern int         S_qc_init (struct solqc *qc, const struct posdata *site,
+                              int shadowband);
+extern long        S_qc (struct solqc *qc, long n, const long long *utc,
+                         const float *ghi, const float *dni, float *dhi,
+                         unsigned *flags, float *kt, float *ktp);
+extern const char *S_qc_name (int flag);
+extern void        S_qc_free (struct solqc *qc);
+
+#endif /* SOLQC_H */
@@ -0,0 +1,460 @@
+/*============================================================================
+*    Contains:
+*        S_queue_plan    (splits a grid into chunk files under a directory)
+*        S_queue_work    (claims and computes chunks until none are left)
+*        S_queue_gather  (reads the finished chunks back into columns)
+*
+*    A done file is a struct qhead followed by the chunk's return codes
+*    (long) and then each column selected in the grid's cols, in C_
+*    order (float), all in native byte order.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solqueue.h"
+*
+*----------------------------------------------------------------------------*/
+#define _DEFAULT_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "solqueue.h"
+
+#define PATHLEN  1024
+#define PIECE    16384   /* rows computed between lease renewals */
+
+struct qplan       /* the plan file */
+{
+    char      magic[8];
+    int       nsite;
+    int       cols;
+    long long start;
+    long      step;
+    long      ntime;
+    long      chunk;
+};
+
+struct qhead       /* start of a done file */
+{
+    char      magic[8];
+    long      chunk;          /* chunk index */
+    long      first;          /* first grid row */
+    long      rows;
+    int       cols;
+};
+
+static int  read_plan( const char *dir, const struct solgrid *grid,
+                       struct qplan *plan );
+static int  make_todo( const char *dir, const struct qplan *plan );
+static int  compute( const char *dir, const struct solgrid *grid,
+                     const struct qplan *plan, const char *name, int lease );
+static int  requeue( const char *dir, int lease, int *pending );
+static int  full_io( int fd, void *buf, size_t len, int writing );
+static long nchunk( const struct qplan *plan );
+
+
+/*============================================================================
+*    Int function S_queue_plan
+*
+*    Creates the queue for grid in chunks of chunk rows, or checks that an
+*    existing queue is for the same grid shape.  Any number of processes
+*    may call it at once.  Returns 0, or -1 on an I/O error or a plan
+*    mismatch.
+*----------------------------------------------------------------------------*/
+int S_queue_plan (const char *dir, const struct solgrid *grid, long chunk)
+{
+  struct qplan plan;
+  struct stat  sb;
+  char   path[PATHLEN], tmp[PATHLEN];
+  int    fd, r;
+
+    mkdir( dir, 0777 );
+    snprintf( path, PATHLEN, "%s/claim", dir );  mkdir( path, 0777 );
+    snprintf( path, PATHLEN, "%s/done", dir );   mkdir( path, 0777 );
+    snprintf( path, PATHLEN, "%s/tmp", dir );    mkdir( path, 0777 );
+
+    memset( &plan, 0, sizeof( plan ) );
+    memcpy( plan.magic, "SOLQPLN1", 8 );
+    plan.nsite = grid->nsite;
+    plan.cols  = grid->cols;
+    plan.start = grid->start;
+    plan.step  = grid->step;
+    plan.ntime = grid->ntime;
+    plan.chunk = chunk > 0 ? chunk : 1;
+
+    /* write the plan whole, then link it in: the first one wins */
+    snprintf( path, PATHLEN, "%s/plan", dir );
+    snprintf( tmp, PATHLEN, "%s/tmp/plan.%ld", dir, (long) getpid() );
+    if ( (fd = open( tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) < 0 )
+        return -1;
+    r = full_io( fd, &plan, sizeof( plan ), 1 );
+    if ( close( fd ) != 0 || r != 0 ) {
+        unlink( tmp );
+        return -1;
+    }
+    r = link( tmp, path );
+    unlink( tmp );
+    if ( r != 0 && errno != EEXIST )
+        return -1;
+    if ( read_plan( dir, grid, &plan ) != 0 )
+        return -1;
+
+    /* the todo directory appears whole, or not at all */
+    snprintf( path, PATHLEN, "%s/todo", dir );
+    if ( stat( path, &sb ) == 0 )
+        return 0;
+    return make_todo( dir, &plan );
+}
+
+
+/*============================================================================
+*    Long integer function S_queue_work
+*
+*    Claims and computes chunks until the queue is empty, requeueing
+*    claims older than lease seconds.  Waits while other workers still
+*    hold live claims, so that when it returns every chunk is done.
+*    Returns the number of chunks this call computed, or -1 if the queue
+*    is missing, is for another grid, or a result could not be written.
+*----------------------------------------------------------------------------*/
+long S_queue_work (const char *dir, const struct solgrid *grid, int lease)
+{
+  struct qplan   plan;
+  struct dirent *de;
+  DIR   *d;
+  char   from[PATHLEN], to[PATHLEN];
+  long   count = 0;
+  int    got, pending;
+
+    if ( read_plan( dir, grid, &plan ) != 0 )
+        return -1;
+
+    for ( ;; ) {
+        snprintf( from, PATHLEN, "%s/todo", dir );
+        if ( (d = opendir( from )) == NULL )
+            return -1;
+
+        for ( got = 0; (de = readdir( d )) != NULL; ) {
+            if ( de->d_name[0] != 'c' )
+                continue;
+            snprintf( from, PATHLEN, "%s/todo/%s", dir, de->d_name );
+            snprintf( to, PATHLEN, "%s/claim/%s", dir, de->d_name );
+            /* rename() keeps the mtime, so touch the marker first: a
+               claim must never arrive already looking expired */
+            if ( utimensat( AT_FDCWD, from, NULL, 0 ) != 0 ||
+                 rename( from, to ) != 0 )      /* somebody else's */
+                continue;
+            got = 1;
+            switch ( compute( dir, grid, &plan, de->d_name, lease ) ) {
+                case 1:  count++;  break;
+                case 0:            break;
+                default: closedir( d );  return -1;
+            }
+        }
+        closedir( d );
+        if ( got )
+            continue;
+
+        /* queue empty: take back expired claims or wait for live ones */
+        if ( requeue( dir, lease, &pending ) > 0 )
+            continue;
+        if ( pending == 0 )
+            return count;
+        sleep( 1 );
+    }
+}
+
+
+/*============================================================================
+*    Long integer function S_queue_gather
+*
+*    Reads every done chunk into col[] and retval (grid rows; NULL arrays
+*    are skipped).  Returns the number of chunks not yet done, or -1 if the
+*    queue is missing or for another grid.
+*----------------------------------------------------------------------------*/
+long S_queue_gather (const char *dir, const struct solgrid *grid,
+                     float * const col[C_NCOL], long *retval)
+{
+  struct qplan plan;
+  struct qhead head;
+  char   path[PATHLEN];
+  long   missing = 0, c, n;
+  int    fd, k, ok;
+
+    if ( read_plan( dir, grid, &plan ) != 0 )
+        return -1;
+
+    for ( c = 0; c < nchunk( &plan ); c++ ) {
+        snprintf( path, PATHLEN, "%s/done/c%08ld", dir, c );
+        if ( (fd = open( path, O_RDONLY )) < 0 ) {
+            missing++;
+            continue;
+        }
+        ok = full_io( fd, &head, sizeof( head ), 0 ) == 0 &&
+             memcmp( head.magic, "SOLQCHK1", 8 ) == 0 && head.chunk == c;
+        n  = head.rows;
+
+        if ( ok && retval )
+            ok = full_io( fd, retval + head.first, n * sizeof( long ), 0 ) == 0;
+        else if ( ok )
+            lseek( fd, n * sizeof( long ), SEEK_CUR );
+
+        for ( k = 0; ok && k < C_NCOL; k++ ) {
+            if ( !( plan.cols & S_COL( k ) ) )
+                continue;
+            if ( col[k] )
+                ok = full_io( fd, col[k] + head.first,
+                              n * sizeof( float ), 0 ) == 0;
+            else
+                lseek( fd, n * sizeof( float ), SEEK_CUR );
+        }
+        close( fd );
+        if ( !ok )
+            missing++;
+    }
+
+    return missing;
+}
+
+
+/*============================================================================
+*    Local Int function read_plan
+*
+*    Reads the plan and checks it against grid; 0 if they agree
+*----------------------------------------------------------------------------*/
+static int read_plan( const char *dir, const struct solgrid *grid,
+                      struct qplan *plan )
+{
+  char path[PATHLEN];
+  int  fd, r;
+
+    snprintf( path, PATHLEN, "%s/plan", dir );
+    if ( (fd = open( path, O_RDONLY )) < 0 )
+        return -1;
+    r = full_io( fd, plan, sizeof( *plan ), 0 );
+    close( fd );
+
+    if ( r != 0 || memcmp( plan->magic, "SOLQPLN1", 8 ) != 0 ||
+         plan->nsite != grid->nsite || plan->cols  != grid->cols  ||
+         plan->start != grid->start || plan->step  != grid->step  ||
+         plan->ntime != grid->ntime || plan->chunk <= 0 )
+        return -1;
+    return 0;
+}
+
+
+/*============================================================================
+*    Local Int function make_todo
+*
+*    Builds the todo directory in tmp/ and renames it into place.  A
+*    chunk already done is left out.  Losing the race to another planner
+*    is not an error.
+*----------------------------------------------------------------------------*/
+static int make_todo( const char *dir, const struct qplan *plan )
+{
+  struct stat sb;
+  char   stage[PATHLEN], path[PATHLEN + 32];
+  long   c;
+  int    fd, r;
+
+    snprintf( stage, PATHLEN, "%s/tmp/todo.%ld", dir, (long) getpid() );
+    if ( mkdir( stage, 0777 ) != 0 && errno != EEXIST )
+        return -1;
+
+    for ( c = 0; c < nchunk( plan ); c++ ) {
+        snprintf( path, PATHLEN, "%s/done/c%08ld", dir, c );
+        if ( stat( path, &sb ) == 0 )
+            continue;
+        snprintf( path, sizeof( path ), "%s/c%08ld", stage, c );
+        if ( (fd = open( path, O_WRONLY | O_CREAT, 0666 )) < 0 )
+            break;
+        close( fd );
+    }
+
+    snprintf( path, PATHLEN, "%s/todo", dir );
+    r = c == nchunk( plan ) ? rename( stage, path ) : -1;
+    if ( r == 0 )
+        return 0;
+
+    /* lost the race (or ran out of room): clean up the stage */
+    while ( c-- > 0 ) {
+        snprintf( path, sizeof( path ), "%s/c%08ld", stage, c );
+        unlink( path );
+    }
+    rmdir( stage );
+    snprintf( path, PATHLEN, "%s/todo", dir );
+    return stat( path, &sb ) == 0 ? 0 : -1;
+}
+
+
+/*============================================================================
+*    Local Int function compute
+*
+*    Computes and commits a claimed chunk, renewing the lease every
+*    PIECE rows once half of it has gone.  Returns 1 if computed, 0 if
+*    it was already done, -1 if the result could not be written.
+*----------------------------------------------------------------------------*/
+static int compute( const char *dir, const struct solgrid *grid,
+                    const struct qplan *plan, const char *name, int lease )
+{
+  struct solfork_stats st;
+  struct qhead head;
+  struct stat  sb;
+  char   claim[PATHLEN], done[PATHLEN], tmp[PATHLEN], host[64];
+  float *col[C_NCOL], *part[C_NCOL], *buf;
+  long  *retval;
+  long   rows = (long) grid->nsite * grid->ntime;
+  long   off, n;
+  time_t renewed;
+  int    fd, k, ncol, r;
+
+    snprintf( claim, PATHLEN, "%s/claim/%s", dir, name );
+    snprintf( done, PATHLEN, "%s/done/%s", dir, name );
+
+    if ( stat( done, &sb ) == 0 ) {                /* finished before */
+        unlink( claim );
+        return 0;
+    }
+
+    memset( &head, 0, sizeof( head ) );
+    memcpy( head.magic, "SOLQCHK1", 8 );
+    head.chunk = strtol( name + 1, NULL, 10 );
+    head.first = head.chunk * plan->chunk;
+    head.rows  = rows - head.first < plan->chunk ? rows - head.first
+                                                 : plan->chunk;
+    head.cols  = grid->cols;
+
+    for ( ncol = 0, k = 0; k < C_NCOL; k++ )
+        if ( grid->cols & S_COL( k ) )
+            ncol++;
+    retval = (long *) malloc( head.rows * sizeof( long ) );
+    buf    = (float *) malloc( ( ncol ? ncol : 1 ) * head.rows *
+                               sizeof( float ) );
+    if ( retval == NULL || buf == NULL ) {
+        free( retval );
+        free( buf );
+        return -1;
+    }
+    for ( ncol = 0, k = 0; k < C_NCOL; k++ )
+        col[k] = ( grid->cols & S_COL( k ) ) ? buf + head.rows * ncol++
+                                             : NULL;
+
+    memset( &st, 0, sizeof( st ) );
+    renewed = time( NULL );
+    for ( off = 0; off < head.rows; off += n ) {
+        n = head.rows - off < PIECE ? head.rows - off : PIECE;
+        for ( k = 0; k < C_NCOL; k++ )
+            part[k] = col[k] ? col[k] + off : NULL;
+        S_grid_run( grid, head.first + off, head.first + off + n, part,
+                    retval + off, &st );
+        if ( 2 * ( time( NULL ) - renewed ) >= lease ) {
+            utimensat( AT_FDCWD, claim, NULL, 0 );
+            renewed = time( NULL );
+        }
+    }
+
+    /* write it all to tmp/, make it durable, then rename it into done/ */
+    gethostname( host, sizeof( host ) );
+    host[sizeof( host ) - 1] = 0;
+    snprintf( tmp, PATHLEN, "%s/tmp/%s.%s.%ld", dir, name, host,
+              (long) getpid() );
+    r = -1;
+    if ( (fd = open( tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) >= 0 ) {
+        r = full_io( fd, &head, sizeof( head ), 1 ) |
+            full_io( fd, retval, head.rows * sizeof( long ), 1 ) |
+            full_io( fd, buf, ncol * head.rows * sizeof( float ), 1 ) |
+            fsync( fd );
+        if ( close( fd ) != 0 )
+            r = -1;
+        if ( r == 0 )
+            r = rename( tmp, done );
+        if ( r != 0 )
+            unlink( tmp );
+    }
+    free( retval );
+    free( buf );
+    if ( r != 0 )
+        return -1;
+
+    unlink( claim );
+    return 1;
+}
+
+
+/*============================================================================
+*    Local Int function requeue
+*
+*    Clears claims of done chunks and moves expired claims back to todo.
+*    Returns the number requeued; *pending gets the number of live claims.
+*----------------------------------------------------------------------------*/
+static int requeue( const char *dir, int lease, int *pending )
+{
+  struct dirent *de;
+  struct stat    sb;
+  DIR   *d;
+  char   claim[PATHLEN], path[PATHLEN];
+  time_t now = time( NULL );
+  int    moved = 0;
+
+    *pending = 0;
+    snprintf( path, PATHLEN, "%s/claim", dir );
+    if ( (d = opendir( path )) == NULL )
+        return 0;
+
+    while ( (de = readdir( d )) != NULL ) {
+        if ( de->d_name[0] != 'c' )
+            continue;
+        snprintf( claim, PATHLEN, "%s/claim/%s", dir, de->d_name );
+        snprintf( path, PATHLEN, "%s/done/%s", dir, de->d_name );
+        if ( stat( path, &sb ) == 0 ) {
+            unlink( claim );
+            continue;
+        }
+        if ( stat( claim, &sb ) != 0 )          /* just committed */
+            continue;
+        if ( now - sb.st_mtime > lease ) {
+            snprintf( path, PATHLEN, "%s/todo/%s", dir, de->d_name );
+            if ( rename( claim, path ) == 0 )
+                moved++;
+        }
+        else
+            ++*pending;
+    }
+    closedir( d );
+    return moved;
+}
+
+
+/*============================================================================
+*    Local Int function full_io
+*
+*    Reads or writes exactly len bytes; -1 on error or end of file
+*----------------------------------------------------------------------------*/
+static int full_io( int fd, void *buf, size_t len, int writing )
+{
+  char   *p = (char *) buf;
+  ssize_t n;
+
+    while ( len > 0 ) {
+        n = writing ? write( fd, p, len ) : read( fd, p, len );
+        if ( n <= 0 )
+            return -1;
+        p   += n;
+        len -= n;
+    }
+    return 0;
+}
+
+
+/*============================================================================
+*    Local Long integer function nchunk
+*----------------------------------------------------------------------------*/
+static long nchunk( const struct qplan *plan )
+{
+    return ( (long) plan->nsite * plan->ntime + plan->chunk - 1 ) / plan->chunk;
+}
@@ -0,0 +1,57 @@
+/*============================================================================
+*
+*    NAME:  solqueue.h
+*
+*    Contains:
+*        S_queue_plan    (splits a grid into chunk files under a directory)
+*        S_queue_work    (claims and computes chunks until none are left)
+*        S_queue_gather  (reads the finished chunks back into columns)
+*
+*    A checkpointed work queue for grids (solfork.h) too big for one
+*    machine or one run.  The queue is a directory, typically on a
+*    filesystem shared by every node:
+*
+*        plan           grid shape and chunk size, written once
+*        todo/cNNNNNNNN chunks nobody has claimed (empty marker files)
+*        claim/cNNN...  chunks being computed; mtime is the owner's lease
+*        done/cNNN...   finished chunks: return codes and columns
+*        tmp/           results being written
+*
+*    A chunk is chunk consecutive grid rows.  Every transition is one
+*    rename(), which is atomic, so any number of workers on any number
+*    of nodes can start, stop or die at any time with no coordinator:
+*
+*        claim    todo  -> claim   exactly one worker wins a chunk
+*        commit   tmp   -> done    results appear whole or not at all
+*        requeue  claim -> todo    a claim whose lease expired (its owner
+*                                  died) goes back to the queue
+*
+*    A claimed chunk whose done file already exists is dropped without
+*    computing, so a finished chunk is never recomputed, whatever
+*    happened between its commit and the removal of its claim.
+*
+*    Leases are file modification times compared with the local clock.
+*    A worker touches a todo marker just before renaming it, so a claim
+*    starts with a fresh lease, and renews the lease while it computes
+*    (every 16384 rows, once half of it has gone): lease must exceed
+*    twice the time for 16384 rows plus any clock skew between nodes.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solqueue.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLQUEUE_H
+#define SOLQUEUE_H
+
+#include "solfork.h"
+
+extern int  S_queue_plan (const char *dir, const struct solgrid *grid,
+                          long chunk);
+extern long S_queue_work (const char *dir, const struct solgrid *grid,
+                          int lease);
+extern long S_queue_gather (const char *dir, const struct solgrid *grid,
+                            float * const col[C_NCOL], long *retval);
+
+#endif /* SOLQUEUE_H */
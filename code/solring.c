@@ -0,0 +1,148 @@
+/*============================================================================
+*    Contains:
+*        S_ring_init   (allocates a bounded queue of pointers)
+*        S_ring_put    (producer: queues a pointer, waiting while full)
+*        S_ring_take   (consumer: takes a pointer, waiting while empty)
+*        S_ring_close  (producer: no more pointers will come)
+*        S_ring_free   (releases the memory held by a solring)
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solring.h"
+*
+*----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "solring.h"
+
+static void backoff( int round );
+
+
+/*============================================================================
+*    Int function S_ring_init
+*
+*    slots is rounded up to a power of two.  Returns 0, or -1 if memory
+*    could not be allocated.
+*----------------------------------------------------------------------------*/
+int S_ring_init (struct solring *ring, unsigned long slots)
+{
+  unsigned long n;
+
+    memset( ring, 0, sizeof( *ring ) );
+    for ( n = 2; n < slots; n <<= 1 )
+        ;
+    if ( (ring->slot = (void **) calloc( n, sizeof( void * ) )) == NULL )
+        return -1;
+    ring->idx.mask = n - 1;
+    atomic_init( &ring->idx.head, 0 );
+    atomic_init( &ring->idx.tail, 0 );
+    atomic_init( &ring->closed, 0 );
+    return 0;
+}
+
+
+/*============================================================================
+*    Void function S_ring_put
+*----------------------------------------------------------------------------*/
+void S_ring_put (struct solring *ring, void *p, long long *waited)
+{
+  unsigned long head, tail;
+  long long     t0 = 0;
+  int           round;
+
+    head = atomic_load_explicit( &ring->idx.head, memory_order_relaxed );
+    for ( round = 0; ; round++ ) {
+        tail = atomic_load_explicit( &ring->idx.tail, memory_order_acquire );
+        if ( head - tail <= ring->idx.mask )
+            break;
+        if ( round == 0 )
+            t0 = S_rt_now();
+        backoff( round );
+    }
+    if ( round && waited )
+        *waited += S_rt_now() - t0;
+
+    ring->slot[head & ring->idx.mask] = p;
+    atomic_store_explicit( &ring->idx.head, head + 1, memory_order_release );
+}
+
+
+/*============================================================================
+*    Void pointer function S_ring_take
+*
+*    Returns the next pointer, or NULL once the ring is closed and empty
+*----------------------------------------------------------------------------*/
+void *S_ring_take (struct solring *ring, long long *waited)
+{
+  unsigned long head, tail;
+  long long     t0 = 0;
+  void         *p = NULL;
+  int           round;
+
+    tail = atomic_load_explicit( &ring->idx.tail, memory_order_relaxed );
+    for ( round = 0; ; round++ ) {
+        head = atomic_load_explicit( &ring->idx.head, memory_order_acquire );
+        if ( head != tail )
+            break;
+        if ( atomic_load_explicit( &ring->closed, memory_order_acquire ) ) {
+            /* recheck: the last put may have come just before the close */
+            head = atomic_load_explicit( &ring->idx.head,
+                                         memory_order_acquire );
+            if ( head == tail )
+                goto out;
+            break;
+        }
+        if ( round == 0 )
+            t0 = S_rt_now();
+        backoff( round );
+    }
+
+    p = ring->slot[tail & ring->idx.mask];
+    atomic_store_explicit( &ring->idx.tail, tail + 1, memory_order_release );
+
+out:
+    if ( round && waited )
+        *waited += S_rt_now() - t0;
+    return p;
+}
+
+
+/*============================================================================
+*    Void function S_ring_close
+*----------------------------------------------------------------------------*/
+void S_ring_close (struct solring *ring)
+{
+    atomic_store_explicit( &ring->closed, 1, memory_order_release );
+}
+
+
+/*============================================================================
+*    Void function S_ring_free
+*----------------------------------------------------------------------------*/
+void S_ring_free (struct solring *ring)
+{
+    free( ring->slot );
+    ring->slot = NULL;
+}
+
+
+/*============================================================================
+*    Local Void function backoff
+*
+*    Spin, then yield, then nap 50 microseconds
+*----------------------------------------------------------------------------*/
+static void backoff( int round )
+{
+  struct timespec nap = { 0, 50000 };
+
+    if ( round < 64 )
+        return;
+    if ( round < 128 )
+        sched_yield();
+    else
+        nanosleep( &nap, NULL );
+}
@@ -0,0 +1,47 @@
+/*============================================================================
+*
+*    NAME:  solring.h
+*
+*    Contains:
+*        S_ring_init   (allocates a bounded queue of pointers)
+*        S_ring_put    (producer: queues a pointer, waiting while full)
+*        S_ring_take   (consumer: takes a pointer, waiting while empty)
+*        S_ring_close  (producer: no more pointers will come)
+*        S_ring_free   (releases the memory held by a solring)
+*
+*    A bounded single-producer, single-consumer lock-free queue of
+*    pointers, for passing blocks of records between pipeline stages.
+*    The indices use the solrt.h ring protocol.  A full queue makes the
+*    producer wait, so a slow stage holds back the stages before it and
+*    memory stays bounded (backpressure).
+*
+*    Waiting spins briefly, then yields, then sleeps in short naps, so an
+*    idle stage costs little CPU.  Both put and take add the time they
+*    spent waiting to *waited (nanoseconds) if it is not NULL, which is
+*    what the stage utilization counters of a pipeline are made of.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solring.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLRING_H
+#define SOLRING_H
+
+#include "solrt.h"
+
+struct solring
+{
+    struct solrt_ring idx;       /* head, tail, mask */
+    void            **slot;
+    atomic_int        closed;
+};
+
+extern int   S_ring_init (struct solring *ring, unsigned long slots);
+extern void  S_ring_put (struct solring *ring, void *p, long long *waited);
+extern void *S_ring_take (struct solring *ring, long long *waited);
+extern void  S_ring_close (struct solring *ring);
+extern void  S_ring_free (struct solring *ring);
+
+#endif /* SOLRING_H */
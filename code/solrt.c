@@ -0,0 +1,324 @@
+/*============================================================================
+*    Contains:
+*        S_rt_init    (allocates and warms up a real-time feed for one site)
+*        S_rt_push    (producer: queues a UTC timestamp)
+*        S_rt_step    (worker: computes positions for queued timestamps)
+*        S_rt_pop     (consumer: takes the next computed position)
+*        S_rt_free    (releases the memory held by a solrt)
+*        S_rt_now     (monotonic clock, nanoseconds)
+*        S_rt_hist_add, S_rt_hist_quantile  (latency histogram)
+*
+*    Ring protocol: head and tail are free-running counters; a slot is
+*    index & mask.  The writer fills the slot, then publishes it with a
+*    release store of head; the reader sees it with an acquire load of
+*    head, copies it out, then frees it with a release store of tail.
+*    Each counter has a single writer, so no compare-and-swap is needed.
+*
+*    To keep the worst case close to the typical case, S_rt_init touches
+*    every ring slot and both histograms and runs S_solpos once, so that
+*    no page faults or first-call costs land on the hot path.  Choose the
+*    smallest function mask the tracker needs for the site template
+*    (S_SOLAZM | S_REFRAC for pointing); each extra function is extra
+*    libm work per update.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solrt.h"
+*
+*----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "solrt.h"
+
+static int  msb64( unsigned long long v );
+static int  bucket( long long ns );
+static long long bucket_value( int idx );
+
+
+/*============================================================================
+*    Int function S_rt_init
+*
+*    Sets up a feed for the site in the posdata template (latitude,
+*    longitude, timezone, press, temp, tilt, aspect and function; the date
+*    and time are ignored).  slots is rounded up to a power of two.
+*
+*    Returns 0, the S_solpos error code for an out-of-range site, or -1 if
+*    memory could not be allocated.
+*----------------------------------------------------------------------------*/
+int S_rt_init (struct solrt *rt, const struct posdata *site,
+               unsigned long slots)
+{
+  struct posdata pd;
+  unsigned long  n;
+  long           retval;
+
+    memset( rt, 0, sizeof( *rt ) );
+    for ( n = 2; n < slots; n <<= 1 )
+        ;
+
+    rt->site = *site;
+    rt->req  = (struct solrt_req *) calloc( n, sizeof( struct solrt_req ) );
+    rt->pos  = (struct solrt_pos *) calloc( n, sizeof( struct solrt_pos ) );
+    if ( rt->req == NULL || rt->pos == NULL ) {
+        S_rt_free( rt );
+        return -1;
+    }
+    memset( rt->req, 0, n * sizeof( struct solrt_req ) );
+    memset( rt->pos, 0, n * sizeof( struct solrt_pos ) );
+
+    rt->in.mask  = n - 1;
+    rt->out.mask = n - 1;
+    atomic_init( &rt->in.head,  0 );
+    atomic_init( &rt->in.tail,  0 );
+    atomic_init( &rt->out.head, 0 );
+    atomic_init( &rt->out.tail, 0 );
+
+    rt->service.min = rt->total.min = 0x7FFFFFFFFFFFFFFFLL;
+
+    /* warm up: validates the site and runs every function once */
+    pd = rt->site;
+    S_epoch( &pd, 946728000LL );      /* 1 Jan 2000 12:00 UTC */
+    if ( (retval = S_solpos( &pd )) != 0 ) {
+        S_rt_free( rt );
+        return (int) retval;
+    }
+    (void) S_rt_now();
+
+    return 0;
+}
+
+
+/*============================================================================
+*    Int function S_rt_push
+*
+*    Producer side.  Returns 0, or -1 if the input ring is full.
+*----------------------------------------------------------------------------*/
+int S_rt_push (struct solrt *rt, long long utc)
+{
+  unsigned long head, tail;
+  struct solrt_req *r;
+
+    head = atomic_load_explicit( &rt->in.head, memory_order_relaxed );
+    tail = atomic_load_explicit( &rt->in.tail, memory_order_acquire );
+    if ( head - tail > rt->in.mask )
+        return -1;
+
+    r        = &rt->req[head & rt->in.mask];
+    r->utc   = utc;
+    r->stamp = S_rt_now();
+    atomic_store_explicit( &rt->in.head, head + 1, memory_order_release );
+
+    return 0;
+}
+
+
+/*============================================================================
+*    Int function S_rt_step
+*
+*    Worker side.  Computes every queued timestamp, as long as the output
+*    ring has room, and returns how many were computed.
+*----------------------------------------------------------------------------*/
+int S_rt_step (struct solrt *rt)
+{
+  struct posdata pd;
+  struct solrt_req *r;
+  struct solrt_pos *p;
+  unsigned long in_head, in_tail, out_head, out_tail;
+  long long     t0, t1;
+  int           count;
+
+    in_head  = atomic_load_explicit( &rt->in.head,  memory_order_acquire );
+    in_tail  = atomic_load_explicit( &rt->in.tail,  memory_order_relaxed );
+    out_head = atomic_load_explicit( &rt->out.head, memory_order_relaxed );
+    out_tail = atomic_load_explicit( &rt->out.tail, memory_order_acquire );
+
+    for ( count = 0; in_tail != in_head; count++ ) {
+        if ( out_head - out_tail > rt->out.mask ) {
+            out_tail = atomic_load_explicit( &rt->out.tail,
+                                             memory_order_acquire );
+            if ( out_head - out_tail > rt->out.mask )
+                break;                        /* consumer is behind */
+        }
+
+        r  = &rt->req[in_tail & rt->in.mask];
+        t0 = S_rt_now();
+
+        pd = rt->site;
+        S_epoch( &pd, r->utc );
+        p  = &rt->pos[out_head & rt->out.mask];
+        p->retval  = S_solpos( &pd );
+        p->utc     = r->utc;
+        p->azim    = pd.azim;
+        p->elevref = pd.elevref;
+        p->zenref  = pd.zenref;
+        p->cosinc  = ( pd.function & L_TILT ) ? pd.cosinc : 0.0f;
+
+        t1 = S_rt_now();
+        p->latency = t1 - r->stamp;
+        S_rt_hist_add( &rt->service, t1 - t0 );
+        S_rt_hist_add( &rt->total,   p->latency );
+
+        atomic_store_explicit( &rt->out.head, ++out_head,
+                               memory_order_release );
+        atomic_store_explicit( &rt->in.tail,  ++in_tail,
+                               memory_order_release );
+    }
+
+    return count;
+}
+
+
+/*============================================================================
+*    Int function S_rt_pop
+*
+*    Consumer side.  Returns 1 and fills pos, or 0 if nothing is ready.
+*----------------------------------------------------------------------------*/
+int S_rt_pop (struct solrt *rt, struct solrt_pos *pos)
+{
+  unsigned long head, tail;
+
+    tail = atomic_load_explicit( &rt->out.tail, memory_order_relaxed );
+    head = atomic_load_explicit( &rt->out.head, memory_order_acquire );
+    if ( head == tail )
+        return 0;
+
+    *pos = rt->pos[tail & rt->out.mask];
+    atomic_store_explicit( &rt->out.tail, tail + 1, memory_order_release );
+
+    return 1;
+}
+
+
+/*============================================================================
+*    Void function S_rt_free
+*----------------------------------------------------------------------------*/
+void S_rt_free (struct solrt *rt)
+{
+    free( rt->req );
+    free( rt->pos );
+    rt->req = NULL;
+    rt->pos = NULL;
+}
+
+
+/*============================================================================
+*    Long long function S_rt_now
+*
+*    Monotonic clock in nanoseconds
+*----------------------------------------------------------------------------*/
+long long S_rt_now (void)
+{
+  struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+/*============================================================================
+*    Void function S_rt_hist_add
+*----------------------------------------------------------------------------*/
+void S_rt_hist_add (struct solrt_hist *hist, long long ns)
+{
+    if ( ns < 0 )
+        ns = 0;
+    hist->count[bucket( ns )]++;
+    hist->total++;
+    if ( ns < hist->min )
+        hist->min = ns;
+    if ( ns > hist->max )
+        hist->max = ns;
+}
+
+
+/*============================================================================
+*    Long long function S_rt_hist_quantile
+*
+*    Value (ns) at quantile q (0 - 1), as the upper edge of the bucket it
+*    falls in, and never above the largest value recorded.
+*----------------------------------------------------------------------------*/
+long long S_rt_hist_quantile (const struct solrt_hist *hist, double q)
+{
+  unsigned long long rank, seen;
+  long long          v;
+  int                i;
+
+    if ( hist->total == 0 )
+        return 0;
+    if ( q >= 1.0 )
+        return hist->max;
+
+    rank = (unsigned long long) ( q * hist->total );
+    seen = 0;
+    for ( i = 0; i < S_RT_NBUCKET; i++ ) {
+        seen += hist->count[i];
+        if ( seen > rank ) {
+            v = bucket_value( i + 1 ) - 1;
+            return ( v < hist->max ) ? v : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+
+/*============================================================================
+*    Local Int function msb64
+*
+*    Index of the most significant set bit (v > 0)
+*----------------------------------------------------------------------------*/
+static int msb64( unsigned long long v )
+{
+  int m = 0;
+
+    if ( v >> 32 ) { v >>= 32; m += 32; }
+    if ( v >> 16 ) { v >>= 16; m += 16; }
+    if ( v >>  8 ) { v >>=  8; m +=  8; }
+    if ( v >>  4 ) { v >>=  4; m +=  4; }
+    if ( v >>  2 ) { v >>=  2; m +=  2; }
+    if ( v >>  1 ) {           m +=  1; }
+    return m;
+}
+
+
+/*============================================================================
+*    Local Int function bucket
+*
+*    Log-linear bucket of a value: exact below 2^(SUBBITS+1), then 2^SUBBITS
+*    linear sub-buckets per power of two
+*----------------------------------------------------------------------------*/
+static int bucket( long long ns )
+{
+  unsigned long long v = (unsigned long long) ns;
+  int m;
+
+    if ( v < ( 2ULL << S_RT_SUBBITS ) )
+        return (int) v;
+
+    m = msb64( v );
+    return ( ( m - S_RT_SUBBITS + 1 ) << S_RT_SUBBITS ) +
+           (int) ( ( v >> ( m - S_RT_SUBBITS ) ) - ( 1ULL << S_RT_SUBBITS ) );
+}
+
+
+/*============================================================================
+*    Local Long long function bucket_value
+*
+*    Lowest value that falls in bucket idx (inverse of bucket)
+*----------------------------------------------------------------------------*/
+static long long bucket_value( int idx )
+{
+  int m, off;
+
+    if ( idx < ( 2 << S_RT_SUBBITS ) )
+        return idx;
+    if ( idx >= S_RT_NBUCKET )
+        return 0x7FFFFFFFFFFFFFFFLL;
+
+    m   = ( idx >> S_RT_SUBBITS ) + S_RT_SUBBITS - 1;
+    off = idx & ( ( 1 << S_RT_SUBBITS ) - 1 );
+    return (long long) ( ( ( 1ULL << S_RT_SUBBITS ) + off ) <<
+                         ( m - S_RT_SUBBITS ) );
+}
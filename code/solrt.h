@@ -0,0 +1,97 @@
+/*============================================================================
+*
+*    NAME:  solrt.h
+*
+*    Contains:
+*        S_rt_init    (allocates and warms up a real-time feed for one site)
+*        S_rt_push    (producer: queues a UTC timestamp)
+*        S_rt_step    (worker: computes positions for queued timestamps)
+*        S_rt_pop     (consumer: takes the next computed position)
+*        S_rt_free    (releases the memory held by a solrt)
+*        S_rt_now     (monotonic clock, nanoseconds)
+*        S_rt_hist_add, S_rt_hist_quantile  (latency histogram)
+*
+*    A feed is a per-site posdata template plus two single-producer,
+*    single-consumer lock-free rings: timestamps in, positions out.  Each
+*    ring has exactly one writer thread and one reader thread; push, step
+*    and pop may each run on their own thread.  All memory is allocated
+*    by S_rt_init; push, step and pop never allocate, lock or do stdio.
+*
+*    The worker records two latency histograms (nanoseconds): service
+*    (dequeue to result) and total (push to result).  They are written
+*    only by the worker thread; read them once it has stopped.
+*
+*    Histogram buckets are log-linear (HDR style): values below
+*    2^(S_RT_SUBBITS+1) ns are exact, larger ones are resolved to
+*    1 part in 2^S_RT_SUBBITS.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solrt.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLRT_H
+#define SOLRT_H
+
+#include <stdatomic.h>
+#include "solpos00.h"
+
+#define S_RT_SUBBITS  7
+#define S_RT_NBUCKET  ( ( 64 - S_RT_SUBBITS + 1 ) << S_RT_SUBBITS )
+
+struct solrt_req     /* one queued timestamp */
+{
+    long long utc;       /* UTC seconds since 1970 */
+    long long stamp;     /* S_rt_now() when pushed */
+};
+
+struct solrt_pos     /* one computed position */
+{
+    long long utc;       /* UTC seconds since 1970, as pushed */
+    long long latency;   /* push to result, nanoseconds */
+    long      retval;    /* S_solpos return code */
+    float     azim;
+    float     elevref;
+    float     zenref;
+    float     cosinc;    /* only if the site function includes S_TILT */
+};
+
+struct solrt_ring
+{
+    _Alignas(64) atomic_ulong head;   /* next slot to write */
+    _Alignas(64) atomic_ulong tail;   /* next slot to read */
+    _Alignas(64) unsigned long mask;  /* slots - 1, slots a power of 2 */
+};
+
+struct solrt_hist
+{
+    unsigned long long count[S_RT_NBUCKET];
+    unsigned long long total;         /* samples */
+    long long          min;
+    long long          max;
+};
+
+struct solrt
+{
+    struct posdata     site;    /* inputs other than date and time */
+    struct solrt_ring  in;
+    struct solrt_ring  out;
+    struct solrt_req  *req;
+    struct solrt_pos  *pos;
+    struct solrt_hist  service;
+    struct solrt_hist  total;
+};
+
+extern int       S_rt_init (struct solrt *rt, const struct posdata *site,
+                            unsigned long slots);
+extern int       S_rt_push (struct solrt *rt, long long utc);
+extern int       S_rt_step (struct solrt *rt);
+extern int       S_rt_pop (struct solrt *rt, struct solrt_pos *pos);
+extern void      S_rt_free (struct solrt *rt);
+extern long long S_rt_now (void);
+extern void      S_rt_hist_add (struct solrt_hist *hist, long long ns);
+extern long long S_rt_hist_quantile (const struct solrt_hist *hist,
+                                     double q);
+
+#endif /* SOLRT_H */
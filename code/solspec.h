@@ -0,0 +1,57 @@
+/*============================================================================
+*
+*    NAME:  solspec.h
+*
+*    Contains:
+*        S_spec             (clear-sky spectral irradiance for rows of a
+*                            batch, 122 wavelengths per row)
+*        S_spec_band        (wavelength and coefficients of a band)
+*
+*    Bird and Riordan's SPCTRAL2 (1986), computed from the outputs of a
+*    batch (solbatch.h) that has already been run: it reads the amass,
+*    ampress, zenref and etrn columns, and cosinc for the tilted plane.
+*    erv is not a column; it is recovered as etrn / solcon, which is how
+*    S_solpos makes etrn.  The atmosphere is that of a struct
+*    solclear_site (solclear.h): ozone, precipitable water, aerosol
+*    optical depth at 500 nm with the Angstrom exponent taken from the
+*    380 and 500 nm depths, and ground albedo.
+*
+*    For each row the results are S_SPEC_NBAND spectral irradiances, W/sq
+*    m/micrometer, from 0.3 to 4.0 micrometers, at
+*        dni[( i - first ) * S_SPEC_NBAND + k]
+*    and the same for ghi, dhi and poa (global on the plane given by
+*    cosinc and the tilt of in[I_TILT] or the site).  Any of the four
+*    may be NULL.  Rows with the sun down are 0.
+*
+*    The extraterrestrial spectrum and the water vapor, ozone and mixed
+*    gas absorption coefficients are the table of the paper; per site
+*    the Rayleigh, aerosol and ground-reflection terms of every band are
+*    made once, so the loop along wavelength for a row is straight-line
+*    code (with the float exp and log of solvec.h) and vectorizes.
+*    S_spec_band gives a row of the table: wavelength (micrometers),
+*    extraterrestrial irradiance and the three absorption coefficients.
+*
+*    S_spec returns the number of rows done, or -1 when a needed column
+*    is missing.  Like S_clear it does not start threads.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solspec.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLSPEC_H
+#define SOLSPEC_H
+
+#include "solbatch.h"
+#include "solclear.h"
+
+#define S_SPEC_NBAND 122
+
+extern long         S_spec (const struct solbatch *batch,
+                            const struct solclear_site *cs, long first,
+                            long last, float *dni, float *ghi, float *dhi,
+                            float *poa);
+extern const float *S_spec_band (int band);
+
+#endif /* SOLSPEC_H */
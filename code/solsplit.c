@@ -0,0 +1,624 @@
+/*============================================================================
+*    Contains:
+*        S_split         (DNI and DHI from measured GHI for rows of a batch)
+*        S_split_dirint  (replaces the resident DIRINT coefficients)
+*        S_split_load    (reads a DIRINT coefficient table from a file)
+*        S_split_name    (name of a model)
+*
+*    The sun being low is handled by selects, as in solclear.c: the
+*    formulas run on stand-in values (kt 0, coszen 1) and the result is
+*    replaced by DNI 0, DHI = GHI.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solsplit.h"
+*
+*----------------------------------------------------------------------------*/
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "solsplit.h"
+#include "solvec.h"
+
+static const char *modelname[D_NMODEL] = { "erbs", "disc", "dirint" };
+
+static float cos87 = 0.0523359562; /* coszen below which there is no beam */
+
+/* Perez, Ineichen, Maxwell, Seals and Zelenka 1992, as published with the
+   model's code: by Kt', zenith, stability and water bin (the edges of
+   perez92); stability bin 7 is "no stability", water bin 5 "unknown" */
+static float dirint[6][6][7][5] = {
+    {   /* Kt' bin 1 */
+        {   /* zenith bin 1 */
+            { 0.385230f, 0.385230f, 0.385230f, 0.462880f, 0.317440f },
+            { 0.338390f, 0.338390f, 0.221270f, 0.316730f, 0.503650f },
+            { 0.235680f, 0.235680f, 0.241280f, 0.157830f, 0.269440f },
+            { 0.830130f, 0.830130f, 0.171970f, 0.841070f, 0.457370f },
+            { 0.548010f, 0.548010f, 0.478000f, 0.966880f, 1.036370f },
+            { 0.548010f, 0.548010f, 1.000000f, 3.012370f, 1.976540f },
+            { 0.582690f, 0.582690f, 0.229720f, 0.892710f, 0.569950f }
+        },
+        {   /* zenith bin 2 */
+            { 0.131280f, 0.131280f, 0.385460f, 0.511070f, 0.127940f },
+            { 0.223710f, 0.223710f, 0.193560f, 0.304560f, 0.193940f },
+            { 0.229970f, 0.229970f, 0.275020f, 0.312730f, 0.244610f },
+            { 0.090100f, 0.184580f, 0.260500f, 0.687480f, 0.579440f },
+            { 0.131530f, 0.131530f, 0.370190f, 1.380350f, 1.052270f },
+            { 1.116250f, 1.116250f, 0.928030f, 3.525490f, 2.316920f },
+            { 0.090100f, 0.237000f, 0.300040f, 0.812470f, 0.664970f }
+        },
+        {   /* zenith bin 3 */
+            { 0.587510f, 0.130000f, 0.400000f, 0.537210f, 0.832490f },
+            { 0.306210f, 0.129830f, 0.204460f, 0.500000f, 0.681640f },
+            { 0.224020f, 0.260620f, 0.334080f, 0.501040f, 0.350470f },
+            { 0.421540f, 0.753970f, 0.750660f, 3.706840f, 0.983790f },
+            { 0.706680f, 0.373530f, 1.245670f, 0.864860f, 1.992630f },
+            { 4.864400f, 0.117390f, 0.265180f, 0.359180f, 3.310820f },
+            { 0.392080f, 0.493290f, 0.651560f, 1.932780f, 0.898730f }
+        },
+        {   /* zenith bin 4 */
+            { 0.126970f, 0.126970f, 0.126970f, 0.126970f, 0.126970f },
+            { 0.810820f, 0.810820f, 0.810820f, 0.810820f, 0.810820f },
+            { 3.241680f, 2.500000f, 2.291440f, 2.291440f, 2.291440f },
+            { 4.000000f, 3.000000f, 2.000000f, 0.975430f, 1.965570f },
+            { 12.494170f, 12.494170f, 8.000000f, 5.083520f, 8.792390f },
+            { 21.744240f, 21.744240f, 21.744240f, 21.744240f, 21.744240f },
+            { 3.241680f, 12.494170f, 1.620760f, 1.375250f, 2.331620f }
+        },
+        {   /* zenith bin 5 */
+            { 0.126970f, 0.126970f, 0.126970f, 0.126970f, 0.126970f },
+            { 0.810820f, 0.810820f, 0.810820f, 0.810820f, 0.810820f },
+            { 3.241680f, 2.500000f, 2.291440f, 2.291440f, 2.291440f },
+            { 4.000000f, 3.000000f, 2.000000f, 0.975430f, 1.965570f },
+            { 12.494170f, 12.494170f, 8.000000f, 5.083520f, 8.792390f },
+            { 21.744240f, 21.744240f, 21.744240f, 21.744240f, 21.744240f },
+            { 3.241680f, 12.494170f, 1.620760f, 1.375250f, 2.331620f }
+        },
+        {   /* zenith bin 6 */
+            { 0.126970f, 0.126970f, 0.126970f, 0.126970f, 0.126970f },
+            { 0.810820f, 0.810820f, 0.810820f, 0.810820f, 0.810820f },
+            { 3.241680f, 2.500000f, 2.291440f, 2.291440f, 2.291440f },
+            { 4.000000f, 3.000000f, 2.000000f, 0.975430f, 1.965570f },
+            { 12.494170f, 12.494170f, 8.000000f, 5.083520f, 8.792390f },
+            { 21.744240f, 21.744240f, 21.744240f, 21.744240f, 21.744240f },
+            { 3.241680f, 12.494170f, 1.620760f, 1.375250f, 2.331620f }
+        }
+    },
+    {   /* Kt' bin 2 */
+        {   /* zenith bin 1 */
+            { 0.337440f, 0.337440f, 0.969110f, 1.097190f, 1.116080f },
+            { 0.337440f, 0.337440f, 0.969110f, 1.116030f, 0.623900f },
+            { 0.337440f, 0.337440f, 1.530590f, 1.024420f, 0.908480f },
+            { 0.584040f, 0.584040f, 0.847250f, 0.914940f, 1.289300f },
+            { 0.337440f, 0.337440f, 0.310240f, 1.435020f, 1.852830f },
+            { 0.337440f, 0.337440f, 1.015010f, 1.097190f, 2.117230f },
+            { 0.337440f, 0.337440f, 0.969110f, 1.145730f, 1.476400f }
+        },
+        {   /* zenith bin 2 */
+            { 0.300000f, 0.300000f, 0.700000f, 1.100000f, 0.796940f },
+            { 0.219870f, 0.219870f, 0.526530f, 0.809610f, 0.649300f },
+            { 0.386650f, 0.386650f, 0.119320f, 0.576120f, 0.685460f },
+            { 0.746730f, 0.399830f, 0.470970f, 0.986530f, 0.785370f },
+            { 0.575420f, 0.936700f, 1.649200f, 1.495840f, 1.335590f },
+            { 1.319670f, 4.002570f, 1.276390f, 2.644550f, 2.518670f },
+            { 0.665190f, 0.678910f, 1.012360f, 1.199940f, 0.986580f }
+        },
+        {   /* zenith bin 3 */
+            { 0.378870f, 0.974060f, 0.500000f, 0.491880f, 0.665290f },
+            { 0.105210f, 0.263470f, 0.407040f, 0.553460f, 0.582590f },
+            { 0.312900f, 0.345240f, 1.144180f, 0.854790f, 0.612280f },
+            { 0.119070f, 0.365120f, 0.560520f, 0.793720f, 0.802600f },
+            { 0.781610f, 0.837390f, 1.270420f, 1.537980f, 1.292950f },
+            { 1.152290f, 1.152290f, 1.492080f, 1.245370f, 2.177100f },
+            { 0.424660f, 0.529550f, 0.966910f, 1.033460f, 0.958730f }
+        },
+        {   /* zenith bin 4 */
+            { 0.310590f, 0.714410f, 0.252450f, 0.500000f, 0.607600f },
+            { 0.975190f, 0.363420f, 0.500000f, 0.400000f, 0.502800f },
+            { 0.175580f, 0.196250f, 0.476360f, 1.072470f, 0.490510f },
+            { 0.719280f, 0.698620f, 0.657770f, 1.190840f, 0.681110f },
+            { 0.426240f, 1.464840f, 0.678550f, 1.157730f, 0.978430f },
+            { 2.501120f, 1.789130f, 1.387090f, 2.394180f, 2.394180f },
+            { 0.491640f, 0.677570f, 0.685610f, 1.082400f, 0.735410f }
+        },
+        {   /* zenith bin 5 */
+            { 0.597000f, 0.500000f, 0.300000f, 0.310050f, 0.413510f },
+            { 0.314790f, 0.336310f, 0.400000f, 0.400000f, 0.442460f },
+            { 0.166510f, 0.460440f, 0.552570f, 1.000000f, 0.461610f },
+            { 0.401020f, 0.559110f, 0.403630f, 1.016710f, 0.671490f },
+            { 0.400360f, 0.750830f, 0.842640f, 1.802600f, 1.023830f },
+            { 3.315300f, 1.510380f, 2.443650f, 1.638820f, 2.133990f },
+            { 0.530790f, 0.745850f, 0.693050f, 1.458040f, 0.804500f }
+        },
+        {   /* zenith bin 6 */
+            { 0.597000f, 0.500000f, 0.300000f, 0.310050f, 0.800920f },
+            { 0.314790f, 0.336310f, 0.400000f, 0.400000f, 0.237040f },
+            { 0.166510f, 0.460440f, 0.552570f, 1.000000f, 0.581990f },
+            { 0.401020f, 0.559110f, 0.403630f, 1.016710f, 0.898570f },
+            { 0.400360f, 0.750830f, 0.842640f, 1.802600f, 3.400390f },
+            { 3.315300f, 1.510380f, 2.443650f, 1.638820f, 2.508780f },
+            { 0.204340f, 1.157740f, 2.003080f, 2.622080f, 1.409380f }
+        }
+    },
+    {   /* Kt' bin 3 */
+        {   /* zenith bin 1 */
+            { 1.242210f, 1.242210f, 1.242210f, 1.242210f, 1.242210f },
+            { 0.056980f, 0.056980f, 0.656990f, 0.656990f, 0.925160f },
+            { 0.089090f, 0.089090f, 1.040430f, 1.232480f, 1.205300f },
+            { 1.053850f, 1.053850f, 1.399690f, 1.084640f, 1.233340f },
+            { 1.151540f, 1.151540f, 1.118290f, 1.531640f, 1.411840f },
+            { 1.494980f, 1.494980f, 1.700000f, 1.800810f, 1.671600f },
+            { 1.018450f, 1.018450f, 1.153600f, 1.321890f, 1.294670f }
+        },
+        {   /* zenith bin 2 */
+            { 0.700000f, 0.700000f, 1.023460f, 0.700000f, 0.945830f },
+            { 0.886300f, 0.886300f, 1.333620f, 0.800000f, 1.066620f },
+            { 0.902180f, 0.902180f, 0.954330f, 1.126690f, 1.097310f },
+            { 1.095300f, 1.075060f, 1.176490f, 1.139470f, 1.096110f },
+            { 1.201660f, 1.201660f, 1.438200f, 1.256280f, 1.198060f },
+            { 1.525850f, 1.525850f, 1.869160f, 1.985410f, 1.911590f },
+            { 1.288220f, 1.082810f, 1.286370f, 1.166170f, 1.119330f }
+        },
+        {   /* zenith bin 3 */
+            { 0.600000f, 1.029910f, 0.859890f, 0.550000f, 0.813600f },
+            { 0.604450f, 1.029910f, 0.859890f, 0.656700f, 0.928840f },
+            { 0.455850f, 0.750580f, 0.804930f, 0.823000f, 0.911000f },
+            { 0.526580f, 0.932310f, 0.908620f, 0.983520f, 0.988090f },
+            { 1.036110f, 1.100690f, 0.848380f, 1.035270f, 1.042380f },
+            { 1.048440f, 1.652720f, 0.900000f, 2.350410f, 1.082950f },
+            { 0.817410f, 0.976160f, 0.861300f, 0.974780f, 1.004580f }
+        },
+        {   /* zenith bin 4 */
+            { 0.782110f, 0.564280f, 0.600000f, 0.600000f, 0.665740f },
+            { 0.894480f, 0.680730f, 0.541990f, 0.800000f, 0.669140f },
+            { 0.487460f, 0.818950f, 0.841830f, 0.872540f, 0.709040f },
+            { 0.709310f, 0.872780f, 0.908480f, 0.953290f, 0.844350f },
+            { 0.863920f, 0.947770f, 0.876220f, 1.078750f, 0.936910f },
+            { 1.280350f, 0.866720f, 0.769790f, 1.078750f, 0.975130f },
+            { 0.725420f, 0.869970f, 0.868810f, 0.951190f, 0.829220f }
+        },
+        {   /* zenith bin 5 */
+            { 0.791750f, 0.654040f, 0.483170f, 0.409000f, 0.597180f },
+            { 0.566140f, 0.948990f, 0.971820f, 0.653570f, 0.718550f },
+            { 0.648710f, 0.637730f, 0.870510f, 0.860600f, 0.694300f },
+            { 0.637630f, 0.767610f, 0.925670f, 0.990310f, 0.847670f },
+            { 0.736380f, 0.946060f, 1.117590f, 1.029340f, 0.947020f },
+            { 1.180970f, 0.850000f, 1.050000f, 0.950000f, 0.888580f },
+            { 0.700560f, 0.801440f, 0.961970f, 0.906140f, 0.823880f }
+        },
+        {   /* zenith bin 6 */
+            { 0.500000f, 0.500000f, 0.586770f, 0.470550f, 0.629790f },
+            { 0.500000f, 0.500000f, 1.056220f, 1.260140f, 0.658140f },
+            { 0.500000f, 0.500000f, 0.631830f, 0.842620f, 0.582780f },
+            { 0.554710f, 0.734730f, 0.985820f, 0.915640f, 0.898260f },
+            { 0.712510f, 1.205990f, 0.909510f, 1.078260f, 0.885610f },
+            { 1.899260f, 1.559710f, 1.000000f, 1.150000f, 1.120390f },
+            { 0.653880f, 0.793120f, 0.903320f, 0.944070f, 0.796130f }
+        }
+    },
+    {   /* Kt' bin 4 */
+        {   /* zenith bin 1 */
+            { 1.000000f, 1.000000f, 1.050000f, 1.170380f, 1.178090f },
+            { 0.960580f, 0.960580f, 1.059530f, 1.179030f, 1.131690f },
+            { 0.871470f, 0.871470f, 0.995860f, 1.141910f, 1.114600f },
+            { 1.201590f, 1.201590f, 0.993610f, 1.109380f, 1.126320f },
+            { 1.065010f, 1.065010f, 0.828660f, 0.939970f, 1.017930f },
+            { 1.065010f, 1.065010f, 0.623690f, 1.119620f, 1.132260f },
+            { 1.071570f, 1.071570f, 0.958070f, 1.114130f, 1.127110f }
+        },
+        {   /* zenith bin 2 */
+            { 0.950000f, 0.973390f, 0.852520f, 1.092200f, 1.096590f },
+            { 0.804120f, 0.913870f, 0.980990f, 1.094580f, 1.042420f },
+            { 0.737540f, 0.935970f, 0.999940f, 1.056490f, 1.050060f },
+            { 1.032980f, 1.034540f, 0.968460f, 1.032080f, 1.015780f },
+            { 0.900000f, 0.977210f, 0.945960f, 1.008840f, 0.969960f },
+            { 0.600000f, 0.750000f, 0.750000f, 0.844710f, 0.899100f },
+            { 0.926800f, 0.965030f, 0.968520f, 1.044910f, 1.032310f }
+        },
+        {   /* zenith bin 3 */
+            { 0.850000f, 1.029710f, 0.961100f, 1.055670f, 1.009700f },
+            { 0.818530f, 0.960010f, 0.996450f, 1.081970f, 1.036470f },
+            { 0.765380f, 0.953500f, 0.948260f, 1.052110f, 1.000140f },
+            { 0.775610f, 0.909610f, 0.927800f, 0.987800f, 0.952100f },
+            { 1.000990f, 0.881880f, 0.875950f, 0.949100f, 0.893690f },
+            { 0.902370f, 0.875960f, 0.807990f, 0.942410f, 0.917920f },
+            { 0.856580f, 0.928270f, 0.946820f, 1.032260f, 0.972990f }
+        },
+        {   /* zenith bin 4 */
+            { 0.750000f, 0.857930f, 0.983800f, 1.056540f, 0.980240f },
+            { 0.750000f, 0.987010f, 1.013730f, 1.133780f, 1.038250f },
+            { 0.800000f, 0.947380f, 1.012380f, 1.091270f, 0.999840f },
+            { 0.800000f, 0.914550f, 0.908570f, 0.999190f, 0.915230f },
+            { 0.778540f, 0.800590f, 0.799070f, 0.902180f, 0.851560f },
+            { 0.680190f, 0.317410f, 0.507680f, 0.388910f, 0.646710f },
+            { 0.794920f, 0.912780f, 0.960830f, 1.057110f, 0.947950f }
+        },
+        {   /* zenith bin 5 */
+            { 0.750000f, 0.833890f, 0.867530f, 1.059890f, 0.932840f },
+            { 0.979700f, 0.971470f, 0.995510f, 1.068490f, 1.030150f },
+            { 0.858850f, 0.987920f, 1.043220f, 1.108700f, 1.044900f },
+            { 0.802400f, 0.955110f, 0.911660f, 1.045070f, 0.944470f },
+            { 0.884890f, 0.766210f, 0.885390f, 0.859070f, 0.818190f },
+            { 0.615680f, 0.700000f, 0.850000f, 0.624620f, 0.669300f },
+            { 0.835570f, 0.946150f, 0.977090f, 1.049350f, 0.979970f }
+        },
+        {   /* zenith bin 6 */
+            { 0.689220f, 0.809600f, 0.900000f, 0.789500f, 0.853990f },
+            { 0.854660f, 0.852840f, 0.938200f, 0.923110f, 0.955010f },
+            { 0.938600f, 0.932980f, 1.010390f, 1.043950f, 1.041640f },
+            { 0.843620f, 0.981300f, 0.951590f, 0.946100f, 0.966330f },
+            { 0.694740f, 0.814690f, 0.572650f, 0.400000f, 0.726830f },
+            { 0.211370f, 0.671780f, 0.416340f, 0.297290f, 0.498050f },
+            { 0.843540f, 0.882330f, 0.911760f, 0.898420f, 0.960210f }
+        }
+    },
+    {   /* Kt' bin 5 */
+        {   /* zenith bin 1 */
+            { 1.054880f, 1.075210f, 1.068460f, 1.153370f, 1.069220f },
+            { 1.000000f, 1.062220f, 1.013470f, 1.088170f, 1.046200f },
+            { 0.885090f, 0.993530f, 0.942590f, 1.054990f, 1.012740f },
+            { 0.920000f, 0.950000f, 0.978720f, 1.020280f, 0.984440f },
+            { 0.850000f, 0.908500f, 0.839940f, 0.985570f, 0.962180f },
+            { 0.800000f, 0.800000f, 0.810080f, 0.950000f, 0.961550f },
+            { 1.038590f, 1.063200f, 1.034440f, 1.112780f, 1.037800f }
+        },
+        {   /* zenith bin 2 */
+            { 1.017610f, 1.028360f, 1.058960f, 1.133180f, 1.045620f },
+            { 0.920000f, 0.998970f, 1.033590f, 1.089030f, 1.022060f },
+            { 0.912370f, 0.949930f, 0.979770f, 1.020420f, 0.981770f },
+            { 0.847160f, 0.935300f, 0.930540f, 0.955050f, 0.946560f },
+            { 0.880260f, 0.867110f, 0.874130f, 0.972650f, 0.883420f },
+            { 0.627150f, 0.627150f, 0.700000f, 0.774070f, 0.845130f },
+            { 0.973700f, 1.006240f, 1.026190f, 1.071960f, 1.017240f }
+        },
+        {   /* zenith bin 3 */
+            { 1.028710f, 1.017570f, 1.025900f, 1.081790f, 1.024240f },
+            { 0.924980f, 0.985500f, 1.014100f, 1.092210f, 0.999610f },
+            { 0.828570f, 0.934920f, 0.994950f, 1.024590f, 0.949710f },
+            { 0.900810f, 0.901330f, 0.928830f, 0.979570f, 0.913100f },
+            { 0.761030f, 0.845150f, 0.805360f, 0.936790f, 0.853460f },
+            { 0.626400f, 0.546750f, 0.730500f, 0.850000f, 0.689050f },
+            { 0.957630f, 0.985480f, 0.991790f, 1.050220f, 0.987900f }
+        },
+        {   /* zenith bin 4 */
+            { 0.992730f, 0.993880f, 1.017150f, 1.059120f, 1.017450f },
+            { 0.975610f, 0.987160f, 1.026820f, 1.075440f, 1.007250f },
+            { 0.871090f, 0.933190f, 0.974690f, 0.979840f, 0.952730f },
+            { 0.828750f, 0.868090f, 0.834920f, 0.905510f, 0.871530f },
+            { 0.781540f, 0.782470f, 0.767910f, 0.764140f, 0.795890f },
+            { 0.743460f, 0.693390f, 0.514870f, 0.630150f, 0.715660f },
+            { 0.945450f, 0.942880f, 0.970450f, 1.002440f, 0.952730f }
+        },
+        {   /* zenith bin 5 */
+            { 0.990000f, 0.947340f, 1.005000f, 1.021210f, 0.979230f },
+            { 0.959590f, 0.967570f, 0.981580f, 1.022180f, 0.966300f },
+            { 0.875470f, 0.904460f, 0.909290f, 0.960030f, 0.888630f },
+            { 0.782090f, 0.779050f, 0.773570f, 0.797040f, 0.778790f },
+            { 0.600000f, 0.695050f, 0.651860f, 0.588340f, 0.619200f },
+            { 0.549350f, 0.501730f, 0.367560f, 0.530660f, 0.553710f },
+            { 0.860260f, 0.885760f, 0.879220f, 0.928590f, 0.867440f }
+        },
+        {   /* zenith bin 6 */
+            { 0.834460f, 0.880550f, 0.885540f, 0.958700f, 0.883380f },
+            { 0.955350f, 0.866680f, 0.919350f, 0.937760f, 0.880130f },
+            { 0.754490f, 0.826350f, 0.822940f, 0.866350f, 0.845530f },
+            { 0.663940f, 0.659080f, 0.692620f, 0.790740f, 0.709250f },
+            { 0.495010f, 0.444430f, 0.470530f, 0.432460f, 0.496740f },
+            { 0.292270f, 0.322450f, 0.280720f, 0.332190f, 0.397390f },
+            { 0.801630f, 0.794100f, 0.803620f, 0.879050f, 0.806140f }
+        }
+    },
+    {   /* Kt' bin 6 */
+        {   /* zenith bin 1 */
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f }
+        },
+        {   /* zenith bin 2 */
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f }
+        },
+        {   /* zenith bin 3 */
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f }
+        },
+        {   /* zenith bin 4 */
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f }
+        },
+        {   /* zenith bin 5 */
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f }
+        },
+        {   /* zenith bin 6 */
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f },
+            { 1.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f }
+        }
+    }
+};
+static int   havedirint = 1;
+
+static void  erbs( long n, const float *restrict ghi,
+                   const float *restrict etr, const float *restrict coszen,
+                   float *restrict dni, float *restrict dhi );
+static void  disc( long n, const float *restrict ghi,
+                   const float *restrict etr, const float *restrict etrn,
+                   const float *restrict ampress,
+                   const float *restrict coszen,
+                   float *restrict dni, float *restrict dhi );
+static float ktprime( const struct solbatch *batch, const float *ghi,
+                      long i );
+static void  perez92( const struct solbatch *batch, const float *ghi,
+                      const float *water, long first, long last,
+                      float *dni, float *dhi );
+
+
+/*============================================================================
+*    Long integer function S_split
+*
+*    DNI and DHI for rows first .. last - 1 of batch from ghi (indexed,
+*    like water, by batch row)
+*----------------------------------------------------------------------------*/
+long S_split (int model, const struct solbatch *batch, const float *ghi,
+              const float *water, long first, long last, float *dni,
+              float *dhi)
+{
+  float * const *col = batch->col;
+  long  n = last - first;
+
+    if ( model < 0 || model >= D_NMODEL || !ghi || !col[C_ETR] ||
+         !col[C_COSZEN] ||
+         ( model != D_ERBS && ( !col[C_ETRN] || !col[C_AMPRESS] ) ) ||
+         ( model == D_DIRINT && ( !havedirint || !col[C_PRIME] ||
+                                  !col[C_ZENREF] ) ) )
+        return -1;
+
+    if ( model == D_ERBS ) {
+        erbs( n, ghi + first, col[C_ETR] + first, col[C_COSZEN] + first,
+              dni, dhi );
+        return n;
+    }
+    disc( n, ghi + first, col[C_ETR] + first, col[C_ETRN] + first,
+          col[C_AMPRESS] + first, col[C_COSZEN] + first, dni, dhi );
+    if ( model == D_DIRINT )
+        perez92( batch, ghi, water, first, last, dni, dhi );
+    return n;
+}
+
+
+/*============================================================================
+*    Void function S_split_dirint
+*
+*    Copies S_DIRINT_NCOEF coefficients over the resident table (the
+*    published one until then); NULL removes it.  Not to be called
+*    while S_split is running.
+*----------------------------------------------------------------------------*/
+void S_split_dirint (const float *coef)
+{
+    if ( coef )
+        memcpy( dirint, coef, sizeof( dirint ) );
+    havedirint = coef != NULL;
+}
+
+
+/*============================================================================
+*    Integer function S_split_load
+*----------------------------------------------------------------------------*/
+int S_split_load (const char *path)
+{
+  float coef[S_DIRINT_NCOEF];
+  FILE *fp;
+  int   k;
+
+    if ( (fp = fopen( path, "r" )) == NULL )
+        return -1;
+    for ( k = 0; k < S_DIRINT_NCOEF && fscanf( fp, "%f", &coef[k] ) == 1;
+          k++ )
+        ;
+    fclose( fp );
+    if ( k < S_DIRINT_NCOEF )
+        return 1 + k;
+    S_split_dirint( coef );
+    return 0;
+}
+
+
+/*============================================================================
+*    Const char pointer function S_split_name
+*----------------------------------------------------------------------------*/
+const char *S_split_name (int model)
+{
+    return model >= 0 && model < D_NMODEL ? modelname[model] : NULL;
+}
+
+
+/*============================================================================
+*    Local Void function erbs
+*
+*    Erbs, D. G., S. A. Klein and J. A. Duffie.  1982.  Estimation of the
+*    diffuse radiation fraction for hourly, daily and monthly-average
+*    global radiation.  Solar Energy 28 (4), pp. 293-302.
+*----------------------------------------------------------------------------*/
+static void erbs( long n, const float *restrict ghi,
+                  const float *restrict etr, const float *restrict coszen,
+                  float *restrict dni, float *restrict dhi )
+{
+  float   g, e, cz, kt, df, d;
+  int32_t up;
+  long    i;
+
+    for ( i = 0; i < n; i++ ) {
+        g  = vsel( -( ghi[i] > 0.0f ), ghi[i], 0.0f );
+        up = -( ( coszen[i] > cos87 ) & ( etr[i] > 0.0f ) );
+        e  = vsel( up, etr[i], 1.0f );
+        cz = vsel( up, coszen[i], 1.0f );
+        kt = vsel( up, g / e, 0.0f );
+        kt = vsel( -( kt > 1.0f ), 1.0f, kt );
+        df = vsel( -( kt <= 0.22f ), 1.0f - 0.09f * kt,
+             vsel( -( kt <= 0.8f ), 0.9511f + kt * ( -0.1604f +
+                   kt * ( 4.388f + kt * ( -16.638f + kt * 12.336f ) ) ),
+                   0.165f ) );
+        d      = df * g;
+        dhi[i] = vsel( up, d, g );
+        dni[i] = vsel( up, ( g - d ) / cz, 0.0f );
+    }
+}
+
+
+/*============================================================================
+*    Local Void function disc
+*
+*    Maxwell, E. L.  1987.  A quasi-physical model for converting hourly
+*    global horizontal to direct normal insolation.  SERI/TR-215-3087.
+*----------------------------------------------------------------------------*/
+static void disc( long n, const float *restrict ghi,
+                  const float *restrict etr, const float *restrict etrn,
+                  const float *restrict ampress,
+                  const float *restrict coszen,
+                  float *restrict dni, float *restrict dhi )
+{
+  float   g, e, cz, kt, am, a, b, c, knc, kn, bn, cap;
+  int32_t up, lo;
+  long    i;
+
+    for ( i = 0; i < n; i++ ) {
+        g   = vsel( -( ghi[i] > 0.0f ), ghi[i], 0.0f );
+        up  = -( ( coszen[i] > cos87 ) & ( etr[i] > 0.0f ) );
+        e   = vsel( up, etr[i], 1.0f );
+        cz  = vsel( up, coszen[i], 1.0f );
+        am  = vsel( up, ampress[i], 1.0f );
+        am  = vsel( -( am > 12.0f ), 12.0f, am );
+        kt  = vsel( up, g / e, 0.0f );
+        kt  = vsel( -( kt > 1.0f ), 1.0f, kt );
+
+        lo  = -( kt <= 0.6f );
+        a   = vsel( lo, 0.512f + kt * ( -1.56f + kt * ( 2.286f -
+                        2.222f * kt ) ),
+                        -5.743f + kt * ( 21.77f + kt * ( -27.49f +
+                        11.56f * kt ) ) );
+        b   = vsel( lo, 0.37f + 0.962f * kt,
+                        41.4f + kt * ( -118.5f + kt * ( 66.05f +
+                        31.9f * kt ) ) );
+        c   = vsel( lo, -0.28f + kt * ( 0.932f - 2.048f * kt ),
+                        -47.01f + kt * ( 184.2f + kt * ( -222.0f +
+                        73.81f * kt ) ) );
+        knc = 0.866f + am * ( -0.122f + am * ( 0.0121f + am * ( -0.000653f +
+              am * 0.000014f ) ) );
+        kn  = knc - ( a + b * vexp( c * am ) );
+        kn  = vsel( -( kn > 0.0f ), kn, 0.0f );
+        bn  = kn * etrn[i];
+        cap = g / cz;
+        bn  = vsel( -( bn > cap ), cap, bn );
+
+        dni[i] = vsel( up, bn, 0.0f );
+        dhi[i] = vsel( up, g - bn * cz, g );
+    }
+}
+
+
+/*============================================================================
+*    Local float function ktprime
+*
+*    Kt' of row i, or -1 if there is none
+*----------------------------------------------------------------------------*/
+static float ktprime( const struct solbatch *batch, const float *ghi,
+                      long i )
+{
+  float * const *col = batch->col;
+  float g = ghi[i] > 0.0f ? ghi[i] : 0.0f, kt;
+
+    if ( col[C_COSZEN][i] <= cos87 || col[C_ETR][i] <= 0.0f ||
+         col[C_PRIME][i] <= 0.0f )
+        return -1.0f;
+    kt = fminf( g / col[C_ETR][i], 1.0f ) * col[C_PRIME][i];
+    return fminf( kt, 0.82f );
+}
+
+
+/*============================================================================
+*    Local Void function perez92
+*
+*    Perez, R., P. Ineichen, E. Maxwell, R. Seals and A. Zelenka.  1992.
+*    Dynamic global-to-direct irradiance conversion models.  ASHRAE
+*    Transactions 98 (1), pp. 354-369.  Scales the DISC results in dni
+*    and dhi (indexed from first) by the resident coefficients.
+*----------------------------------------------------------------------------*/
+static void perez92( const struct solbatch *batch, const float *ghi,
+                     const float *water, long first, long last,
+                     float *dni, float *dhi )
+{
+  static const float ktbin[5]  = { 0.24f, 0.4f, 0.56f, 0.7f, 0.8f };
+  static const float zenbin[5] = { 25.0f, 40.0f, 55.0f, 70.0f, 80.0f };
+  static const float dktbin[5] = { 0.015f, 0.035f, 0.07f, 0.15f, 0.3f };
+  const int *site = batch->site;
+  float k, kp, kn, d, g, cz, z;
+  long  i, j;
+  int   a, b, c, w;
+
+    for ( i = first; i < last; i++ ) {
+        if ( (k = ktprime( batch, ghi, i )) < 0.0f )
+            continue;
+        kp = i > first && ( !site || site[i - 1] == site[i] ) ?
+             ktprime( batch, ghi, i - 1 ) : -1.0f;
+        kn = i + 1 < last && ( !site || site[i + 1] == site[i] ) ?
+             ktprime( batch, ghi, i + 1 ) : -1.0f;
+        if ( kp >= 0.0f && kn >= 0.0f )
+            d = 0.5f * ( fabsf( k - kp ) + fabsf( k - kn ) );
+        else if ( kp >= 0.0f )
+            d = fabsf( k - kp );
+        else if ( kn >= 0.0f )
+            d = fabsf( k - kn );
+        else
+            d = -1.0f;
+
+        z = batch->col[C_ZENREF][i];
+        for ( a = 0; a < 5 && k >= ktbin[a]; a++ )
+            ;
+        for ( b = 0; b < 5 && z >= zenbin[b]; b++ )
+            ;
+        for ( c = 0; c < 5 && d >= dktbin[c]; c++ )
+            ;
+        if ( d < 0.0f )
+            c = 6;
+        w = 4;
+        if ( water && water[i] >= 0.0f )
+            w = water[i] < 1.0f ? 0 : water[i] < 2.0f ? 1 :
+                water[i] < 3.0f ? 2 : 3;
+
+        j  = i - first;
+        g  = ghi[i] > 0.0f ? ghi[i] : 0.0f;
+        cz = batch->col[C_COSZEN][i];
+        dni[j] = fminf( dni[j] * dirint[a][b][c][w], g / cz );
+        dhi[j] = g - dni[j] * cz;
+    }
+}
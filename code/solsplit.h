@@ -0,0 +1,77 @@
+/*============================================================================
+*
+*    NAME:  solsplit.h
+*
+*    Contains:
+*        S_split         (DNI and DHI from measured GHI for rows of a batch)
+*        S_split_dirint  (replaces the resident DIRINT coefficients)
+*        S_split_load    (reads a DIRINT coefficient table from a file)
+*        S_split_name    (name of a model)
+*
+*    Decomposition of global horizontal irradiance into its beam and
+*    diffuse parts, computed from the outputs of a batch (solbatch.h)
+*    that has already been run:
+*
+*        D_ERBS    Erbs, Klein and Duffie (1982): diffuse fraction as a
+*                  piecewise polynomial of kt = GHI / etr; uses etr and
+*                  coszen
+*        D_DISC    Maxwell (1987): Kn = Knc( am ) - ( a + b exp( c am ) )
+*                  with a, b, c cubic in kt; uses etr, etrn, ampress and
+*                  coszen
+*        D_DIRINT  Perez, Ineichen, Maxwell, Seals and Zelenka (1992):
+*                  DISC times a coefficient chosen by the bins of Kt'
+*                  (kt times the prime column), the zenith angle, the
+*                  stability of Kt' (its change from the neighbouring
+*                  rows of the same site) and precipitable water; uses
+*                  also prime and zenref
+*
+*    Rows with the refracted zenith at 87 degrees or more get DNI 0 and
+*    DHI = GHI; kt is held to [0, 1], the DISC air mass to at most 12
+*    and Kt' to at most 0.82; DNI is held so that DHI is not negative.
+*    Negative (missing) GHI is taken as 0.
+*
+*    DIRINT's stability bin needs the rows of a site to be consecutive
+*    times, as they are in a time series; a row whose neighbours are
+*    missing (other site, sun down, outside first .. last - 1) gets the
+*    "no stability" bin.  water (cm, per row) may be NULL for the
+*    "unknown" water bin.
+*
+*    The 6 x 6 x 7 x 5 DIRINT coefficients published with the model are
+*    resident in the library from the start, and S_split( D_DIRINT, ... )
+*    calls share them read-only, from any number of threads.  To use
+*    another table, S_split_dirint copies one over them (Kt' bin
+*    slowest, then zenith, stability and water bins) before any such
+*    calls; S_split_load reads the same 1260 numbers, whitespace
+*    separated, from a text file.
+*
+*    The Erbs and DISC loops are branch-free (selects and the float exp
+*    of solvec.h) and vectorize; DIRINT adds one scalar pass for the bins
+*    and the table lookup.  S_split returns the number of rows done, or
+*    -1 for an unknown model, a missing column, or DIRINT after the
+*    table was removed with S_split_dirint( NULL ).  S_split_load
+*    returns 0, -1 if the file cannot be opened, or 1 + the number of
+*    coefficients read if there are too few.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solsplit.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLSPLIT_H
+#define SOLSPLIT_H
+
+#include "solbatch.h"
+
+enum { D_ERBS, D_DISC, D_DIRINT, D_NMODEL };    /* model */
+
+#define S_DIRINT_NCOEF ( 6 * 6 * 7 * 5 )
+
+extern long        S_split (int model, const struct solbatch *batch,
+                            const float *ghi, const float *water,
+                            long first, long last, float *dni, float *dhi);
+extern void        S_split_dirint (const float *coef);
+extern int         S_split_load (const char *path);
+extern const char *S_split_name (int model);
+
+#endif /* SOLSPLIT_H */
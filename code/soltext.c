@@ -0,0 +1,464 @@
+/*============================================================================
+*    Contains:
+*        S_text_float   (formats a float, shortest or fixed decimals)
+*        S_text_int     (formats an integer)
+*        S_text_header  (formats the header line of a batch)
+*        S_text_rows    (formats rows of a batch)
+*        S_text_write   (writes a whole batch as text, in parallel)
+*
+*    Why the double arithmetic is exact: a float has a 24-bit
+*    significand, and half an ulp or a quarter of one below it fits in
+*    26 bits; 10^p is 2^p times 5^p, which for p <= 10 fits in 24 bits.
+*    Products of the two fit the 53 bits of a double, so v * 10^p and
+*    the scaled rounding interval of v are exact, and rounding them
+*    half to even is what printf and strtof do.
+*
+*    The formatter threads of S_text_write are fed like the compute
+*    stage of solpipe: formatter k does blocks k, k + T, ..., each into
+*    one of its two buffers, which go to the writer and back through a
+*    pair of solring.h queues, so a formatter can fill one buffer while
+*    the other is being written.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "soltext.h"
+*
+*----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "soltext.h"
+#include "solring.h"
+
+#define NBUF  2                  /* buffers per formatter */
+
+struct textbuf
+{
+    long   block;
+    size_t len;
+    char  *data;
+};
+
+struct formatter
+{
+    const struct soltext  *fmt;
+    const struct solbatch *batch;
+    long           first;        /* first block */
+    long           nblock;
+    int            step;         /* formatters */
+    struct solring free, done;
+    struct textbuf buf[NBUF];
+    long long      ns;
+};
+
+static const char digits2[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233"
+    "34353637383940414243444546474849505152535455565758596061626364656667"
+    "6869707172737475767778798081828384858687888990919293949596979899";
+
+static const double p10[11] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10 };
+
+static const unsigned long long p10i[11] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL };
+
+static int    utoa( char *buf, unsigned long long u );
+static int    fixed( char *buf, int neg, unsigned long long c, int p );
+static double even( double v );
+static int    span( double lo, double hi, int odd, int p, double *cl,
+                    double *ch );
+static size_t rowmax( const struct solbatch *batch );
+static void  *format_thread( void *arg );
+
+
+/*============================================================================
+*    Int function S_text_float
+*
+*    Writes v to buf (at least S_TEXT_FIELD bytes; not terminated) with
+*    prec decimals, or the shortest round trip for S_TEXT_SHORTEST.
+*    Returns the number of characters.
+*----------------------------------------------------------------------------*/
+int S_text_float (char *buf, float v, int prec)
+{
+  char   tmp[S_TEXT_FIELD];
+  double a = fabs( (double) v ), lo, hi, gap, cl, ch, c, m;
+  int    neg = signbit( v ) != 0, e, odd, p, pl, ph, n;
+
+    if ( prec > 9 )
+        prec = 9;
+
+    if ( prec >= 0 ) {
+        if ( isfinite( a ) && a * p10[prec] < 9.0e15 )
+            return fixed( buf, neg, (unsigned long long) even( a * p10[prec] ),
+                          prec );
+        n = snprintf( tmp, sizeof( tmp ), "%.*f", prec, v );
+        memcpy( buf, tmp, n );
+        return n;
+    }
+
+    if ( a == 0.0 )
+        return fixed( buf, neg, 0, 0 );
+
+    if ( a >= 1.0e-2 && a < 1.0e9 ) {
+        /* the interval of reals that round to v */
+        frexp( a, &e );
+        gap = ldexp( 1.0, e - 24 );                    /* ulp of v */
+        odd = (long long) ( a / gap ) & 1;
+        hi  = a + gap / 2;
+        lo  = a - ( a == ldexp( 0.5, e ) ? gap / 4 : gap / 2 );
+
+        /* fewest decimals with an integer in the scaled interval (if p
+           decimals do, so do p + 1, so the count can be bisected) */
+        for ( pl = 0, ph = 10; pl < ph; )
+            if ( span( lo, hi, odd, ( pl + ph ) / 2, &cl, &ch ) )
+                ph = ( pl + ph ) / 2;
+            else
+                pl = ( pl + ph ) / 2 + 1;
+        span( lo, hi, odd, pl, &cl, &ch );
+
+        /* no decimals: as many trailing zeros as the interval allows */
+        for ( m = 1.0; pl == 0 && ceil( cl / ( m * 10.0 ) ) * m * 10.0 <= ch; )
+            m *= 10.0;
+        c = even( a * p10[pl] / m ) * m;               /* nearest multiple */
+        if ( c < cl ) c = ceil( cl / m ) * m;
+        if ( c > ch ) c = floor( ch / m ) * m;
+        return fixed( buf, neg, (unsigned long long) c, pl );
+    }
+
+    for ( p = 1; p <= 9; p++ ) {                       /* slow but rare */
+        n = snprintf( tmp, sizeof( tmp ), "%.*g", p, v );
+        if ( strtof( tmp, NULL ) == v || isnan( v ) )
+            break;
+    }
+    memcpy( buf, tmp, n );
+    return n;
+}
+
+
+/*============================================================================
+*    Int function S_text_int
+*
+*    Writes v to buf (not terminated); returns the number of characters
+*----------------------------------------------------------------------------*/
+int S_text_int (char *buf, long long v)
+{
+    if ( v < 0 ) {
+        *buf = '-';
+        return 1 + utoa( buf + 1, 0ULL - (unsigned long long) v );
+    }
+    return utoa( buf, (unsigned long long) v );
+}
+
+
+/*============================================================================
+*    Size_t function S_text_header
+*
+*    Writes the header line, with its newline, to buf (S_TEXT_FIELD
+*    bytes per field); returns its length
+*----------------------------------------------------------------------------*/
+size_t S_text_header (const struct soltext *fmt,
+                      const struct solbatch *batch, char *buf)
+{
+  size_t len = 0;
+  int    k;
+
+    len += sprintf( buf, "utc" );
+    if ( batch->site )
+        len += sprintf( buf + len, "%csite", fmt->delim );
+    if ( batch->retval )
+        len += sprintf( buf + len, "%cretval", fmt->delim );
+    for ( k = 0; k < C_NCOL; k++ )
+        if ( batch->col[k] )
+            len += sprintf( buf + len, "%c%s", fmt->delim,
+                            S_batch_column( k ) );
+    buf[len++] = '\n';
+    return len;
+}
+
+
+/*============================================================================
+*    Size_t function S_text_rows
+*
+*    Writes rows first .. last-1 to buf, which must hold (last - first)
+*    rows of 3 + C_NCOL fields of S_TEXT_FIELD bytes; returns the length
+*----------------------------------------------------------------------------*/
+size_t S_text_rows (const struct soltext *fmt, const struct solbatch *batch,
+                    long first, long last, char *buf)
+{
+  float * const *col = batch->col;
+  char  *p = buf, d = fmt->delim;
+  int    cols[C_NCOL], ncol = 0, k;
+  long   i;
+
+    for ( k = 0; k < C_NCOL; k++ )
+        if ( col[k] )
+            cols[ncol++] = k;
+
+    for ( i = first; i < last; i++ ) {
+        p += S_text_int( p, batch->utc[i] );
+        if ( batch->site ) {
+            *p++ = d;
+            p += S_text_int( p, batch->site[i] );
+        }
+        if ( batch->retval ) {
+            *p++ = d;
+            p += S_text_int( p, batch->retval[i] );
+        }
+        for ( k = 0; k < ncol; k++ ) {
+            *p++ = d;
+            p += S_text_float( p, col[cols[k]][i], fmt->prec );
+        }
+        *p++ = '\n';
+    }
+    return p - buf;
+}
+
+
+/*============================================================================
+*    Int function S_text_write
+*
+*    Writes the batch (and the header line first, if header) to fd.
+*    stats may be NULL.  Returns 0, -1 if out of memory or a formatter
+*    thread could not be started (nothing is written then), or -2 if a
+*    write() failed (errno set).
+*----------------------------------------------------------------------------*/
+int S_text_write (const struct soltext *fmt, const struct solbatch *batch,
+                  int fd, int header, struct soltext_stats *stats)
+{
+  struct soltext_stats st;
+  struct formatter *fm;
+  struct textbuf   *tb;
+  pthread_t *tid;
+  long long  t0;
+  long   block = fmt->block > 0 ? fmt->block : 16384;
+  long   nblock = ( batch->count + block - 1 ) / block, b;
+  size_t size = block * rowmax( batch ), hlen, off;
+  ssize_t put;
+  char  *head;
+  int    threads = fmt->threads > 0 ? fmt->threads : 1, k, j, e = 0;
+  int    started = 0, failed = 0, fmtid;
+
+    memset( &st, 0, sizeof( st ) );
+    if ( threads > nblock )
+        threads = nblock > 0 ? (int) nblock : 1;
+
+    fm  = (struct formatter *) calloc( threads, sizeof( *fm ) );
+    tid = (pthread_t *) calloc( threads, sizeof( *tid ) );
+    if ( fm == NULL || tid == NULL )
+        failed = 1;
+    for ( k = 0; !failed && k < threads; k++ ) {
+        fm[k].fmt    = fmt;
+        fm[k].batch  = batch;
+        fm[k].first  = k;
+        fm[k].nblock = nblock;
+        fm[k].step   = threads;
+        if ( S_ring_init( &fm[k].free, NBUF ) != 0 ||
+             S_ring_init( &fm[k].done, NBUF ) != 0 )
+            failed = 1;
+        for ( j = 0; !failed && j < NBUF; j++ ) {
+            if ( (fm[k].buf[j].data = (char *) malloc( size )) == NULL )
+                failed = 1;
+            else
+                S_ring_put( &fm[k].free, &fm[k].buf[j], NULL );
+        }
+    }
+    for ( k = 0; !failed && k < threads; k++ )
+        if ( pthread_create( &tid[k], NULL, format_thread, &fm[k] ) == 0 )
+            started++;
+        else
+            failed = 1;
+
+    if ( failed ) {
+        for ( k = 0; k < started; k++ )    /* let them finish, unwritten */
+            while ( (tb = (struct textbuf *) S_ring_take( &fm[k].done,
+                                                           NULL )) )
+                S_ring_put( &fm[k].free, tb, NULL );
+        e = -1;
+        goto out;
+    }
+
+    /* no room for the header: drain the formatters, writing nothing */
+    if ( header &&
+         (head = (char *) malloc( ( 3 + C_NCOL ) * S_TEXT_FIELD )) == NULL )
+        e = -1;
+    else if ( header ) {
+        hlen = S_text_header( fmt, batch, head );
+        for ( off = 0; e == 0 && off < hlen; off += put )
+            if ( (put = write( fd, head + off, hlen - off )) < 0 ) {
+                if ( errno == EINTR ) { put = 0; continue; }
+                e = -2;
+            }
+        st.bytes += hlen;
+        free( head );
+    }
+
+    /* write the blocks in order, returning each buffer to its formatter */
+    for ( b = 0; b < nblock; b++ ) {
+        fmtid = (int) ( b % threads );
+        tb = (struct textbuf *) S_ring_take( &fm[fmtid].done, &st.ns_wait );
+        t0 = S_rt_now();
+        for ( off = 0; e == 0 && off < tb->len; off += put )
+            if ( (put = write( fd, tb->data + off, tb->len - off )) < 0 ) {
+                if ( errno == EINTR ) { put = 0; continue; }
+                e = -2;
+            }
+        st.ns_write += S_rt_now() - t0;
+        st.bytes    += tb->len;
+        st.blocks++;
+        S_ring_put( &fm[fmtid].free, tb, NULL );
+    }
+
+out:
+    for ( k = 0; k < started; k++ ) {
+        pthread_join( tid[k], NULL );
+        st.ns_format += fm[k].ns;
+    }
+    for ( k = 0; fm && k < threads; k++ ) {
+        for ( j = 0; j < NBUF; j++ )
+            free( fm[k].buf[j].data );
+        S_ring_free( &fm[k].free );
+        S_ring_free( &fm[k].done );
+    }
+    free( fm );
+    free( tid );
+    if ( stats )
+        *stats = st;
+    return e;
+}
+
+
+/*============================================================================
+*    Local Int function utoa
+*----------------------------------------------------------------------------*/
+static int utoa( char *buf, unsigned long long u )
+{
+  char  tmp[24], *p = tmp + sizeof( tmp );
+  int   n, r;
+
+    while ( u >= 100 ) {
+        r  = (int) ( u % 100 ) * 2;
+        u /= 100;
+        *--p = digits2[r + 1];
+        *--p = digits2[r];
+    }
+    if ( u >= 10 ) {
+        *--p = digits2[u * 2 + 1];
+        *--p = digits2[u * 2];
+    }
+    else
+        *--p = (char) ( '0' + u );
+
+    n = (int) ( tmp + sizeof( tmp ) - p );
+    memcpy( buf, p, n );
+    return n;
+}
+
+
+/*============================================================================
+*    Local Int function fixed
+*
+*    Writes c / 10^p with exactly p decimals
+*----------------------------------------------------------------------------*/
+static int fixed( char *buf, int neg, unsigned long long c, int p )
+{
+  unsigned long long frac;
+  char *q = buf;
+  int   k;
+
+    if ( neg )
+        *q++ = '-';
+    q   += utoa( q, c / p10i[p] );
+    frac = c % p10i[p];
+    if ( p > 0 ) {
+        *q++ = '.';
+        for ( k = p - 1; k >= 0; k-- ) {
+            q[k] = (char) ( '0' + frac % 10 );
+            frac /= 10;
+        }
+        q += p;
+    }
+    return (int) ( q - buf );
+}
+
+
+/*============================================================================
+*    Local Double function even
+*
+*    v rounded to an integer, halves to even
+*----------------------------------------------------------------------------*/
+static double even( double v )
+{
+  double u = floor( v ), fr = v - u;
+
+    if ( fr > 0.5 || ( fr == 0.5 && fmod( u, 2.0 ) != 0.0 ) )
+        u += 1.0;
+    return u;
+}
+
+
+/*============================================================================
+*    Local Int function span
+*
+*    The integers *cl .. *ch in the interval lo .. hi scaled by 10^p (ends
+*    excluded if odd); returns 0 if there are none
+*----------------------------------------------------------------------------*/
+static int span( double lo, double hi, int odd, int p, double *cl,
+                 double *ch )
+{
+  double L = lo * p10[p], H = hi * p10[p];
+
+    *cl = ceil( L );
+    *ch = floor( H );
+    if ( odd && *cl == L ) *cl += 1.0;
+    if ( odd && *ch == H ) *ch -= 1.0;
+    return *cl <= *ch;
+}
+
+
+/*============================================================================
+*    Local Size_t function rowmax
+*----------------------------------------------------------------------------*/
+static size_t rowmax( const struct solbatch *batch )
+{
+  int n = 1, k;
+
+    n += batch->site != NULL;
+    n += batch->retval != NULL;
+    for ( k = 0; k < C_NCOL; k++ )
+        n += batch->col[k] != NULL;
+    return (size_t) n * S_TEXT_FIELD;
+}
+
+
+/*============================================================================
+*    Local void pointer function format_thread
+*----------------------------------------------------------------------------*/
+static void *format_thread( void *arg )
+{
+  struct formatter *fm = (struct formatter *) arg;
+  struct textbuf   *tb;
+  long long t0;
+  long   block = fm->fmt->block > 0 ? fm->fmt->block : 16384;
+  long   b, first, last;
+
+    for ( b = fm->first; b < fm->nblock; b += fm->step ) {
+        tb    = (struct textbuf *) S_ring_take( &fm->free, NULL );
+        first = b * block;
+        last  = first + block < fm->batch->count ? first + block
+                                                 : fm->batch->count;
+        t0 = S_rt_now();
+        tb->block = b;
+        tb->len   = S_text_rows( fm->fmt, fm->batch, first, last, tb->data );
+        fm->ns   += S_rt_now() - t0;
+        S_ring_put( &fm->done, tb, NULL );
+    }
+    S_ring_close( &fm->done );
+    return NULL;
+}
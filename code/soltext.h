@@ -0,0 +1,73 @@
+/*============================================================================
+*
+*    NAME:  soltext.h
+*
+*    Contains:
+*        S_text_float   (formats a float, shortest or fixed decimals)
+*        S_text_int     (formats an integer)
+*        S_text_header  (formats the header line of a batch)
+*        S_text_rows    (formats rows of a batch)
+*        S_text_write   (writes a whole batch as text, in parallel)
+*
+*    Text output of batch results (solbatch.h) without printf.  A float
+*    is written either with a fixed number of decimals, giving exactly
+*    the characters printf( "%.*f" ) would, or as the shortest decimal
+*    that reads back (strtof) as the same float, like Ryu.  Both are
+*    done with a few exact double operations for the magnitudes solar
+*    data has; other values (very small or large, NaN, infinities) go
+*    through snprintf.
+*
+*    A row is the UTC time, the site index (if the batch has one), the
+*    return code (if it has one) and the batch's non-NULL columns, in
+*    solbatch.h order, separated by the format's delimiter (',' for
+*    CSV, '\t' for TSV).
+*
+*    S_text_write cuts the batch into blocks; formatter threads take
+*    blocks in turn and fill their own reusable buffers, and the calling
+*    thread write()s the buffers in block order, one write() per block,
+*    so the text is the same for any number of threads.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "soltext.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLTEXT_H
+#define SOLTEXT_H
+
+#include <stddef.h>
+#include "solbatch.h"
+
+#define S_TEXT_FIELD    64       /* most bytes one field can take */
+#define S_TEXT_SHORTEST (-1)     /* prec: shortest round trip */
+
+struct soltext
+{
+    char delim;                  /* ',' or '\t' */
+    int  prec;                   /* decimals 0 .. 9, or S_TEXT_SHORTEST */
+    int  threads;                /* formatters; 0 means 1 */
+    long block;                  /* rows per block; 0 means 16384 */
+};
+
+struct soltext_stats
+{
+    long      blocks;
+    long long bytes;
+    long long ns_format;         /* summed over the formatters */
+    long long ns_write;          /* in write() */
+    long long ns_wait;           /* writer waiting for a formatter */
+};
+
+extern int    S_text_float (char *buf, float v, int prec);
+extern int    S_text_int (char *buf, long long v);
+extern size_t S_text_header (const struct soltext *fmt,
+                             const struct solbatch *batch, char *buf);
+extern size_t S_text_rows (const struct soltext *fmt,
+                           const struct solbatch *batch, long first,
+                           long last, char *buf);
+extern int    S_text_write (const struct soltext *fmt,
+                            const struct solbatch *batch, int fd,
+                            int header, struct soltext_stats *stats);
+
+#endif /* SOLTEXT_H */
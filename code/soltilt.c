@@ -0,0 +1,153 @@
+/*============================================================================
+*    Contains:
+*        S_tilt_sweep         (cosinc and etrtilt for many panel orientations
+*                              from a single sun state)
+*        S_tilt_normals       (panel normals from tilt/aspect pairs)
+*        S_tilt_sweep_normals (cosinc and etrtilt for precomputed normals)
+*
+*    The tilt() function in solpos.c recomputes the sine and cosine of
+*    azim and zenref for every call, although they only depend on the sun.
+*    These functions do that trig once per sun state and reduce each panel
+*    to a dot product between the sun vector and the panel normal:
+*
+*        cosinc = coszen * ct + sz * st * ( ca * cp + sa * sp )
+*               = sun . normal
+*
+*    The inner loops carry no function calls or data-dependent branches,
+*    so the compiler vectorizes them over the panel arrays.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "soltilt.h"
+*
+*----------------------------------------------------------------------------*/
+#include <math.h>
+#include "soltilt.h"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Structures defined for this module
+*
+*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
+struct sunvec /* sun direction and normal-incidence ETR for one instant */
+{
+    float sx;       /* east component of the unit sun vector */
+    float sy;       /* north component of the unit sun vector */
+    float sz;       /* up component (= coszen) */
+    float etrn;     /* ETR normal to the sun, W/sq m */
+};
+
+static float raddeg = 0.0174532925; /* converts from degrees to radians */
+
+static void sunvec( const struct posdata *pdat, struct sunvec *sun );
+
+
+/*============================================================================
+*    Void function S_tilt_sweep
+*
+*    Cosine of the incidence angle and tilted-surface ETR for count panels
+*    described by tilt and aspect (degrees, same conventions as posdata).
+*
+*    Requires (from the struct posdata parameter):
+*            azim, zenref, coszen, etrn
+*
+*    Returns:
+*            cosinc[count], etrtilt[count]  (etrtilt may be NULL)
+*----------------------------------------------------------------------------*/
+void S_tilt_sweep (const struct posdata *pdat, int count,
+                   const float *tilt, const float *aspect,
+                   float *cosinc, float *etrtilt)
+{
+  struct sunvec sun;
+  float ct;          /* cosine of the panel tilt */
+  float st;          /* sine of the panel tilt */
+  float cp;          /* cosine of the panel aspect */
+  float sp;          /* sine of the panel aspect */
+  float ci;          /* cosine of the incidence angle */
+  int   i;
+
+    sunvec( pdat, &sun );
+
+    for ( i = 0; i < count; i++ ) {
+        ct = cos ( raddeg * tilt[i] );
+        st = sin ( raddeg * tilt[i] );
+        cp = cos ( raddeg * aspect[i] );
+        sp = sin ( raddeg * aspect[i] );
+        ci = sun.sz * ct + st * ( sun.sy * cp + sun.sx * sp );
+        cosinc[i] = ci;
+        if ( etrtilt )
+            etrtilt[i] = ( ci > 0.0f ) ? sun.etrn * ci : 0.0f;
+    }
+}
+
+
+/*============================================================================
+*    Void function S_tilt_normals
+*
+*    Unit panel normals (east, north, up) from tilt and aspect in degrees.
+*    Do this once per panel set; the result can be reused for every sun
+*    state with S_tilt_sweep_normals.
+*----------------------------------------------------------------------------*/
+void S_tilt_normals (int count, const float *tilt, const float *aspect,
+                     float *nx, float *ny, float *nz)
+{
+  float st;          /* sine of the panel tilt */
+  int   i;
+
+    for ( i = 0; i < count; i++ ) {
+        st    = sin ( raddeg * tilt[i] );
+        nx[i] = st * sin ( raddeg * aspect[i] );
+        ny[i] = st * cos ( raddeg * aspect[i] );
+        nz[i] = cos ( raddeg * tilt[i] );
+    }
+}
+
+
+/*============================================================================
+*    Void function S_tilt_sweep_normals
+*
+*    Same as S_tilt_sweep, for panel normals from S_tilt_normals.  This is
+*    the fast path: no trig at all per panel.
+*----------------------------------------------------------------------------*/
+void S_tilt_sweep_normals (const struct posdata *pdat, int count,
+                           const float *restrict nx, const float *restrict ny,
+                           const float *restrict nz,
+                           float *restrict cosinc, float *restrict etrtilt)
+{
+  struct sunvec sun;
+  float ci;          /* cosine of the incidence angle */
+  int   i;
+
+    sunvec( pdat, &sun );
+
+    if ( etrtilt ) {
+        for ( i = 0; i < count; i++ ) {
+            ci = sun.sx * nx[i] + sun.sy * ny[i] + sun.sz * nz[i];
+            cosinc[i]  = ci;
+            etrtilt[i] = ( ci > 0.0f ) ? sun.etrn * ci : 0.0f;
+        }
+    }
+    else {
+        for ( i = 0; i < count; i++ )
+            cosinc[i] = sun.sx * nx[i] + sun.sy * ny[i] + sun.sz * nz[i];
+    }
+}
+
+
+/*============================================================================
+*    Local Void function sunvec
+*
+*    Unit sun vector from the refracted zenith angle and azimuth, matching
+*    the trig done per call in tilt()
+*----------------------------------------------------------------------------*/
+static void sunvec( const struct posdata *pdat, struct sunvec *sun )
+{
+  float sz;          /* sine of the refraction corrected solar zenith angle */
+
+    sz        = sin ( raddeg * pdat->zenref );
+    sun->sx   = sz * sin ( raddeg * pdat->azim );
+    sun->sy   = sz * cos ( raddeg * pdat->azim );
+    sun->sz   = pdat->coszen;
+    sun->etrn = pdat->etrn;
+}
@@ -0,0 +1,42 @@
+/*============================================================================
+*
+*    NAME:  soltilt.h
+*
+*    Contains:
+*        S_tilt_sweep         (cosinc and etrtilt for many panel orientations
+*                              from a single sun state)
+*        S_tilt_normals       (converts tilt/aspect pairs to panel normals)
+*        S_tilt_sweep_normals (cosinc and etrtilt for precomputed normals)
+*
+*    The sun state is a struct posdata that has already been through
+*    S_solpos with at least (S_SOLAZM | S_REFRAC | S_ETR) set, so that
+*    azim, zenref, coszen and etrn are valid.  The panel inputs and the
+*    outputs are plain float arrays of length count.
+*
+*    Normals are unit vectors in a local east/north/up frame:
+*        nx = sin(tilt) * sin(aspect)   (east)
+*        ny = sin(tilt) * cos(aspect)   (north)
+*        nz = cos(tilt)                 (up)
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "soltilt.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLTILT_H
+#define SOLTILT_H
+
+#include "solpos00.h"
+
+extern void S_tilt_sweep (const struct posdata *pdat, int count,
+                          const float *tilt, const float *aspect,
+                          float *cosinc, float *etrtilt);
+extern void S_tilt_normals (int count, const float *tilt, const float *aspect,
+                            float *nx, float *ny, float *nz);
+extern void S_tilt_sweep_normals (const struct posdata *pdat, int count,
+                                  const float *nx, const float *ny,
+                                  const float *nz,
+                                  float *cosinc, float *etrtilt);
+
+#endif /* SOLTILT_H */
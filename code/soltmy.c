@@ -0,0 +1,545 @@
+/*============================================================================
+*    Contains:
+*        S_tmy_read      (reads an EPW or TMY3 weather file)
+*        S_tmy_load      (opens and reads a weather file by name)
+*        S_tmy_free      (releases a weather file)
+*        S_tmy_run_init  (lays out the annual run of several files)
+*        S_tmy_run       (computes an annual run)
+*        S_tmy_run_free  (releases an annual run)
+*
+*    A weather file is small (about 1.5 MB for a year of hours), so it
+*    is read whole and its lines are split in place.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "soltmy.h"
+*
+*----------------------------------------------------------------------------*/
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "soltmy.h"
+#include "solrt.h"
+
+#define MAXFIELD  40              /* fields looked at per line */
+
+static char     *slurp( int fd, size_t *len );
+static char     *nextline( char **p );
+static int       split( char *line, char **f, int max );
+static int       number( const char *s, double *v );
+static long long civil( long year, int month, int day );
+static int       epw( struct soltmy *tmy, char *p, int year );
+static int       tmy3( struct soltmy *tmy, char *p, int year );
+static void      station( struct soltmy *tmy, double lat, double lon,
+                          double tz, double elev );
+static int       record( struct soltmy *tmy, long year, int month, int day,
+                         long end, const double wx[W_NWX],
+                         const double miss[W_NWX] );
+
+
+/*============================================================================
+*    Int function S_tmy_read
+*
+*    Reads a whole weather file from fd, moving every record to year,
+*    or to the year of the first record if year <= 0.  Returns 0; -1 if
+*    out of memory or unreadable; or the number of the first line that
+*    does not parse (also left in tmy->line), the file's first line if
+*    the format is unknown.
+*----------------------------------------------------------------------------*/
+int S_tmy_read (struct soltmy *tmy, int fd, int year)
+{
+  size_t len, k, lines = 1;
+  char  *buf;
+  int    r = -1;
+
+    memset( tmy, 0, sizeof( *tmy ) );
+    S_init( &tmy->site );
+    if ( (buf = slurp( fd, &len )) == NULL )
+        return -1;
+
+    for ( k = 0; k < len; k++ )
+        lines += buf[k] == '\n';
+    tmy->utc = (long long *) malloc( lines * sizeof( long long ) );
+    for ( k = 0; k < W_NWX; k++ )
+        tmy->wx[k] = (float *) malloc( lines * sizeof( float ) );
+    for ( k = 0; k < W_NWX && tmy->wx[k]; k++ )
+        ;
+
+    if ( tmy->utc && k == W_NWX ) {
+        if ( strncmp( buf, "LOCATION", 8 ) == 0 )
+            r = epw( tmy, buf, year );
+        else
+            r = tmy3( tmy, buf, year );
+    }
+    free( buf );
+    if ( r != 0 ) {
+        tmy->line = r;
+        S_tmy_free( tmy );
+    }
+    return r;
+}
+
+
+/*============================================================================
+*    Int function S_tmy_load
+*
+*    As S_tmy_read, from the file at path
+*----------------------------------------------------------------------------*/
+int S_tmy_load (struct soltmy *tmy, const char *path, int year)
+{
+  int fd, r;
+
+    if ( (fd = open( path, O_RDONLY )) < 0 ) {
+        memset( tmy, 0, sizeof( *tmy ) );
+        return -1;
+    }
+    r = S_tmy_read( tmy, fd, year );
+    close( fd );
+    return r;
+}
+
+
+/*============================================================================
+*    Void function S_tmy_free
+*----------------------------------------------------------------------------*/
+void S_tmy_free (struct soltmy *tmy)
+{
+  int k;
+
+    free( tmy->utc );
+    tmy->utc = NULL;
+    for ( k = 0; k < W_NWX; k++ ) {
+        free( tmy->wx[k] );
+        tmy->wx[k] = NULL;
+    }
+    tmy->n = 0;
+}
+
+
+/*============================================================================
+*    Int function S_tmy_run_init
+*
+*    Lays the records of ntmy files end to end as one batch, file k as
+*    site k, with their pressures and temperatures as per-row inputs,
+*    and allocates the S_COL() columns in cols (C_ETR and C_ETRN are
+*    always added, for kt and kn).  Returns 0, or -1 if out of memory.
+*----------------------------------------------------------------------------*/
+int S_tmy_run_init (struct soltmy_run *run, const struct soltmy *tmy,
+                    int ntmy, unsigned cols)
+{
+  long long *utc;
+  float     *press, *temp;
+  int       *site;
+  long       rows = 0, r = 0, i;
+  int        k, bad;
+
+    memset( run, 0, sizeof( *run ) );
+    run->tmy  = tmy;
+    run->ntmy = ntmy;
+    for ( k = 0; k < ntmy; k++ )
+        rows += tmy[k].n;
+
+    run->sites = (struct posdata *) malloc( ntmy * sizeof( struct posdata ) );
+    utc   = (long long *) malloc( rows * sizeof( long long ) );
+    site  = (int *) malloc( rows * sizeof( int ) );
+    press = (float *) malloc( rows * sizeof( float ) );
+    temp  = (float *) malloc( rows * sizeof( float ) );
+    run->batch.count          = rows;
+    run->batch.utc            = utc;
+    run->batch.site           = site;
+    run->batch.sites          = run->sites;
+    run->batch.in[I_PRESS]    = press;
+    run->batch.in[I_TEMP]     = temp;
+    run->batch.retval         = (long *) malloc( rows * sizeof( long ) );
+    run->kt = (float *) malloc( rows * sizeof( float ) );
+    run->kn = (float *) malloc( rows * sizeof( float ) );
+
+    cols |= S_COL( C_ETR ) | S_COL( C_ETRN );
+    bad = !run->sites || !utc || !site || !press || !temp ||
+          !run->batch.retval || !run->kt || !run->kn;
+    for ( k = 0; k < C_NCOL && !bad; k++ )
+        if ( cols & S_COL( k ) )
+            bad = (run->batch.col[k] =
+                   (float *) malloc( rows * sizeof( float ) )) == NULL;
+    if ( bad ) {
+        S_tmy_run_free( run );
+        return -1;
+    }
+
+    for ( k = 0; k < ntmy; k++ ) {
+        run->sites[k] = tmy[k].site;
+        memcpy( utc + r, tmy[k].utc, tmy[k].n * sizeof( long long ) );
+        memcpy( press + r, tmy[k].wx[W_PRESS], tmy[k].n * sizeof( float ) );
+        memcpy( temp + r, tmy[k].wx[W_TEMP], tmy[k].n * sizeof( float ) );
+        for ( i = 0; i < tmy[k].n; i++ )
+            site[r + i] = k;
+        r += tmy[k].n;
+    }
+    return 0;
+}
+
+
+/*============================================================================
+*    Long integer function S_tmy_run
+*
+*    Computes every row on up to threads threads, then kt and kn.
+*    Returns the number of rows S_solpos rejected.
+*----------------------------------------------------------------------------*/
+long S_tmy_run (struct soltmy_run *run, int threads)
+{
+  const float *etr = run->batch.col[C_ETR], *etrn = run->batch.col[C_ETRN];
+  const struct soltmy *t;
+  long long t0 = S_rt_now();
+  long      r = 0, i;
+  int       k;
+
+    run->errors = S_batch_parallel( &run->batch, threads );
+
+    for ( k = 0; k < run->ntmy; k++ ) {
+        t = &run->tmy[k];
+        for ( i = 0; i < t->n; i++, r++ ) {
+            run->kt[r] = etr[r] > 0.0 ? t->wx[W_GHI][i] / etr[r] : 0.0;
+            run->kn[r] = etrn[r] > 0.0 && etr[r] > 0.0 ?
+                         t->wx[W_DNI][i] / etrn[r] : 0.0;
+        }
+    }
+
+    run->sec = ( S_rt_now() - t0 ) * 1.0e-9;
+    return run->errors;
+}
+
+
+/*============================================================================
+*    Void function S_tmy_run_free
+*----------------------------------------------------------------------------*/
+void S_tmy_run_free (struct soltmy_run *run)
+{
+  int k;
+
+    free( run->sites );
+    free( (void *) run->batch.utc );
+    free( (void *) run->batch.site );
+    free( (void *) run->batch.in[I_PRESS] );
+    free( (void *) run->batch.in[I_TEMP] );
+    free( run->batch.retval );
+    for ( k = 0; k < C_NCOL; k++ )
+        free( run->batch.col[k] );
+    free( run->kt );
+    free( run->kn );
+    memset( run, 0, sizeof( *run ) );
+}
+
+
+/*============================================================================
+*    Local Int function epw
+*
+*    LOCATION,city,state,country,source,WMO,lat,lon,tz,elevation; six
+*    more header lines; DATA PERIODS,n,records per hour,...; then
+*    year,month,day,hour,minute,flags,dry bulb,dew point,RH,pressure
+*    (Pa),ETR,ETRN,sky IR,GHI,DNI,DHI,...
+*----------------------------------------------------------------------------*/
+static int epw( struct soltmy *tmy, char *p, int year )
+{
+  static const double miss[W_NWX] = { 99.9, 999999.0, 9999.0, 9999.0,
+                                      9999.0 };
+  char  *f[MAXFIELD], *s;
+  double v[10], wx[W_NWX];
+  long   line = 0, end;
+  int    nf, k, rph = 1, minute;
+
+    while ( (s = nextline( &p )) != NULL ) {
+        line++;
+        nf = split( s, f, MAXFIELD );
+        if ( line == 1 ) {
+            if ( nf < 10 )
+                return 1;
+            for ( k = 6; k < 10; k++ )
+                if ( !number( f[k], &v[k] ) )
+                    return 1;
+            strncpy( tmy->name, f[1], sizeof( tmy->name ) - 1 );
+            station( tmy, v[6], v[7], v[8], v[9] );
+            continue;
+        }
+        if ( line < 9 ) {
+            if ( strcmp( f[0], "DATA PERIODS" ) == 0 && nf > 2 &&
+                 number( f[2], &v[0] ) && v[0] >= 1.0 && v[0] <= 60.0 )
+                rph = (int) v[0];
+            continue;
+        }
+        if ( nf == 1 && f[0][0] == '\0' )
+            continue;
+
+        if ( nf < 16 )
+            return (int) line;
+        for ( k = 0; k < 5; k++ )
+            if ( !number( f[k], &v[k] ) )
+                return (int) line;
+        if ( !number( f[6], &wx[W_TEMP] ) || !number( f[9], &wx[W_PRESS] ) ||
+             !number( f[13], &wx[W_GHI] ) || !number( f[14], &wx[W_DNI] ) ||
+             !number( f[15], &wx[W_DHI] ) )
+            return (int) line;
+
+        /* end of the record: hour 1-24, minute within it (0 or 60 = :00) */
+        minute = (int) v[4];
+        if ( rph == 1 || minute == 0 )
+            minute = 60;
+        end = ( (long) v[3] - 1 ) * 3600L + minute * 60L;
+        if ( wx[W_PRESS] < miss[W_PRESS] )
+            wx[W_PRESS] /= 100.0;                     /* Pa to mb */
+        if ( year <= 0 )
+            year = (int) v[0];
+        if ( record( tmy, year, (int) v[1], (int) v[2], end, wx,
+                     miss ) != 0 )
+            return (int) line;
+    }
+    tmy->format        = S_TMY_EPW;
+    tmy->site.interval = 3600 / rph;
+    return tmy->n ? 0 : (int) line + 1;
+}
+
+
+/*============================================================================
+*    Local Int function tmy3
+*
+*    USAF,name,state,tz,lat,lon,elevation; the column names; then
+*    MM/DD/YYYY,HH:MM,... with the columns found by name
+*----------------------------------------------------------------------------*/
+static int tmy3( struct soltmy *tmy, char *p, int year )
+{
+  static const char *names[W_NWX] = { "Dry-bulb (C)", "Pressure (mbar)",
+                                      "GHI (W/m^2)", "DNI (W/m^2)",
+                                      "DHI (W/m^2)" };
+  static const double miss[W_NWX] = { -9900.0, -9900.0, -9900.0, -9900.0,
+                                      -9900.0 };
+  char  *f[MAXFIELD * 2], *s;
+  double v[7], wx[W_NWX];
+  long   line = 0;
+  int    col[W_NWX], nf, k, mo, dy, yr, hh, mm;
+
+    while ( (s = nextline( &p )) != NULL ) {
+        line++;
+        nf = split( s, f, MAXFIELD * 2 );
+        if ( line == 1 ) {
+            if ( nf < 7 )
+                return 1;
+            for ( k = 3; k < 7; k++ )
+                if ( !number( f[k], &v[k] ) )
+                    return 1;
+            strncpy( tmy->name, f[1], sizeof( tmy->name ) - 1 );
+            station( tmy, v[4], v[5], v[3], v[6] );
+            continue;
+        }
+        if ( line == 2 ) {
+            for ( k = 0; k < W_NWX; k++ ) {
+                for ( col[k] = 0; col[k] < nf; col[k]++ )
+                    if ( strcmp( f[col[k]], names[k] ) == 0 )
+                        break;
+                if ( col[k] == nf )
+                    return 2;
+            }
+            continue;
+        }
+        if ( nf == 1 && f[0][0] == '\0' )
+            continue;
+
+        if ( sscanf( f[0], "%d/%d/%d", &mo, &dy, &yr ) != 3 ||
+             nf < 2 || sscanf( f[1], "%d:%d", &hh, &mm ) != 2 )
+            return (int) line;
+        for ( k = 0; k < W_NWX; k++ )
+            if ( col[k] >= nf || !number( f[col[k]], &wx[k] ) )
+                return (int) line;
+        if ( year <= 0 )
+            year = yr;
+        if ( record( tmy, year, mo, dy, hh * 3600L + mm * 60L, wx,
+                     miss ) != 0 )
+            return (int) line;
+    }
+    tmy->format        = S_TMY_TMY3;
+    tmy->site.interval = 3600;
+    return tmy->n ? 0 : (int) line + 1;
+}
+
+
+/*============================================================================
+*    Local Void function station
+*----------------------------------------------------------------------------*/
+static void station( struct soltmy *tmy, double lat, double lon, double tz,
+                     double elev )
+{
+    tmy->site.latitude  = lat;
+    tmy->site.longitude = lon;
+    tmy->site.timezone  = tz;
+    tmy->elevation      = elev;
+    tmy->site.press     = 1013.25 * pow( 1.0 - 2.25577e-5 * elev, 5.25588 );
+    tmy->site.temp      = 15.0;
+}
+
+
+/*============================================================================
+*    Local Int function record
+*
+*    Stores one record ending end seconds after local midnight of the
+*    date; values at or beyond miss (in the direction away from real
+*    data) are replaced.  29 February of a common year is dropped.
+*    Returns 0, or -1 for an impossible date.
+*----------------------------------------------------------------------------*/
+static int record( struct soltmy *tmy, long year, int month, int day,
+                   long end, const double wx[W_NWX],
+                   const double miss[W_NWX] )
+{
+  static const int mdays[13] = { 0, 31, 29, 31, 30, 31, 30, 31, 31, 30, 31,
+                                 30, 31 };
+  double v;
+  long   n = tmy->n;
+  int    k;
+
+    if ( month < 1 || month > 12 || day < 1 || day > mdays[month] ||
+         end < 0 || end > 86400 )
+        return -1;
+    if ( month == 2 && day == 29 &&
+         !( year % 4 == 0 && ( year % 100 != 0 || year % 400 == 0 ) ) ) {
+        tmy->dropped++;
+        return 0;
+    }
+    tmy->utc[n] = civil( year, month, day ) * 86400 + end -
+                  (long long) floor( tmy->site.timezone * 3600.0 + 0.5 );
+
+    for ( k = 0; k < W_NWX; k++ ) {
+        v = wx[k];
+        if ( miss[k] > 0.0 ? v >= miss[k] : v <= miss[k] ) {
+            tmy->missing++;
+            v = k == W_TEMP ? tmy->site.temp :
+                k == W_PRESS ? tmy->site.press : 0.0;
+        }
+        tmy->wx[k][n] = (float) v;
+    }
+    tmy->n++;
+    return 0;
+}
+
+
+/*============================================================================
+*    Local Char pointer function slurp
+*
+*    Reads fd to the end into a NUL-terminated buffer
+*----------------------------------------------------------------------------*/
+static char *slurp( int fd, size_t *len )
+{
+  size_t  cap = 1 << 21;
+  ssize_t got;
+  char   *buf = (char *) malloc( cap + 1 ), *nb;
+
+    *len = 0;
+    while ( buf ) {
+        if ( *len == cap ) {
+            nb = (char *) realloc( buf, 2 * cap + 1 );
+            if ( nb == NULL )
+                break;
+            buf  = nb;
+            cap *= 2;
+        }
+        got = read( fd, buf + *len, cap - *len );
+        if ( got < 0 )
+            break;
+        if ( got == 0 ) {
+            buf[*len] = '\0';
+            return buf;
+        }
+        *len += got;
+    }
+    free( buf );
+    return NULL;
+}
+
+
+/*============================================================================
+*    Local Char pointer function nextline
+*
+*    Cuts the next line (without its CR LF or LF) out of *p
+*----------------------------------------------------------------------------*/
+static char *nextline( char **p )
+{
+  char *s = *p, *e;
+
+    if ( *s == '\0' )
+        return NULL;
+    if ( (e = strchr( s, '\n' )) != NULL ) {
+        *p = e + 1;
+        *e = '\0';
+    }
+    else
+        *p = e = s + strlen( s );
+    if ( e > s && e[-1] == '\r' )
+        e[-1] = '\0';
+    return s;
+}
+
+
+/*============================================================================
+*    Local Int function split
+*
+*    Splits a line at commas in place, dropping the double quotes around
+*    a quoted field; fields beyond max are left joined in the last
+*----------------------------------------------------------------------------*/
+static int split( char *line, char **f, int max )
+{
+  char *s = line;
+  int   n = 0;
+
+    for ( ;; ) {
+        if ( *s == '"' ) {
+            f[n++] = ++s;
+            while ( *s && *s != '"' )
+                s++;
+            if ( *s )
+                *s++ = '\0';
+        }
+        else
+            f[n++] = s;
+        while ( *s && *s != ',' )
+            s++;
+        if ( *s == '\0' || n == max )
+            return n;
+        *s++ = '\0';
+    }
+}
+
+
+/*============================================================================
+*    Local Int function number
+*
+*    1 if s is a whole decimal number (blanks around it allowed)
+*----------------------------------------------------------------------------*/
+static int number( const char *s, double *v )
+{
+  char *e;
+
+    *v = strtod( s, &e );
+    if ( e == s )
+        return 0;
+    while ( *e == ' ' || *e == '\t' )
+        e++;
+    return *e == '\0';
+}
+
+
+/*============================================================================
+*    Local Long long function civil
+*
+*    Days since 1 January 1970 of a Gregorian date
+*----------------------------------------------------------------------------*/
+static long long civil( long year, int month, int day )
+{
+  long era, yoe, doy, doe;
+
+    year -= month <= 2;
+    era   = ( year >= 0 ? year : year - 399 ) / 400;
+    yoe   = year - era * 400;
+    doy   = ( 153L * ( month + ( month > 2 ? -3 : 9 ) ) + 2 ) / 5 + day - 1;
+    doe   = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return (long long) era * 146097 + doe - 719468;
+}
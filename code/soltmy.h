@@ -0,0 +1,99 @@
+/*============================================================================
+*
+*    NAME:  soltmy.h
+*
+*    Contains:
+*        S_tmy_read      (reads an EPW or TMY3 weather file)
+*        S_tmy_load      (opens and reads a weather file by name)
+*        S_tmy_free      (releases a weather file)
+*        S_tmy_run_init  (lays out the annual run of several files)
+*        S_tmy_run       (computes an annual run)
+*        S_tmy_run_free  (releases an annual run)
+*
+*    Typical meteorological year files: EnergyPlus EPW (8 header lines,
+*    then one line per record) and NREL TMY3 CSV (a station line, a
+*    column-name line, then one line per hour).  The format is told from
+*    the first line.  Each record gives the end of its interval in
+*    local standard time (EPW hour 1-24 and minute; TMY3 01:00-24:00),
+*    and these are turned into UTC with the file's timezone, as S_epoch
+*    would read them back.
+*
+*    The file's site is a posdata template with the station's latitude,
+*    longitude and timezone and interval set to the record length (3600
+*    for hourly files), so S_solpos places every record at the midpoint
+*    of its interval: the sun position for an hour ending 13:00 is the
+*    one at 12:30, as an hourly irradiance value needs.
+*
+*    TMY months come from different years, so every record is moved to
+*    one year: year if it is > 0, else the year of the file's first
+*    record.  A 29 February record is left out (and counted in dropped)
+*    when that year is not a leap year; a typical year has none, and
+*    kept it would land on 1 March beside the real one.
+*
+*    Missing values (EPW 99.9, 999999, 9999; TMY3 -9900) are replaced:
+*    pressure by the standard atmosphere at the station's elevation,
+*    temperature by 15 C, irradiance by 0.
+*
+*    An annual run lays the records of several files end to end as one
+*    batch (solbatch.h), with each hour's pressure and temperature as
+*    per-row inputs so they reach the refraction correction, and
+*    computes every row in one parallel pass.  Along with the chosen
+*    solbatch columns it gives the hourly clearness indexes kt (GHI over
+*    horizontal ETR) and kn (DNI over ETRN), 0 when the sun is down.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "soltmy.h"
+*
+*         struct soltmy tmy;  struct soltmy_run run;
+*         S_tmy_load( &tmy, "site.epw", 2023 );
+*         S_tmy_run_init( &run, &tmy, 1, S_COL( C_ZENREF ) );
+*         S_tmy_run( &run, threads );    ... run.batch.col, run.kt
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLTMY_H
+#define SOLTMY_H
+
+#include "solbatch.h"
+
+enum { S_TMY_EPW = 1, S_TMY_TMY3 = 2 };              /* format */
+
+/* weather columns */
+enum { W_TEMP, W_PRESS, W_GHI, W_DNI, W_DHI, W_NWX };
+
+struct soltmy
+{
+    int            format;
+    char           name[64];        /* station name */
+    struct posdata site;            /* latitude, longitude, timezone,
+                                       interval, press (standard) */
+    float          elevation;       /* m */
+    long           n;               /* records */
+    long long     *utc;             /* end of each record, UTC seconds */
+    float         *wx[W_NWX];       /* C, mb, W/sq m, W/sq m, W/sq m */
+    long           missing;         /* values replaced */
+    long           dropped;         /* 29 February records left out */
+    long           line;            /* first line that did not parse, or 0 */
+};
+
+struct soltmy_run
+{
+    const struct soltmy *tmy;
+    int              ntmy;
+    struct posdata  *sites;         /* one per file */
+    struct solbatch  batch;         /* all rows; col[] as chosen */
+    float           *kt, *kn;       /* per row */
+    long             errors;        /* rows S_solpos rejected */
+    double           sec;           /* time of the last S_tmy_run */
+};
+
+extern int  S_tmy_read (struct soltmy *tmy, int fd, int year);
+extern int  S_tmy_load (struct soltmy *tmy, const char *path, int year);
+extern void S_tmy_free (struct soltmy *tmy);
+extern int  S_tmy_run_init (struct soltmy_run *run, const struct soltmy *tmy,
+                            int ntmy, unsigned cols);
+extern long S_tmy_run (struct soltmy_run *run, int threads);
+extern void S_tmy_run_free (struct soltmy_run *run);
+
+#endif /* SOLTMY_H */
@@ -0,0 +1,278 @@
+/*============================================================================
+*    Contains:
+*        S_track        (single-axis tracker rotation, surface orientation
+*                        and incidence for rows of a batch times tracker
+*                        rows)
+*        S_track_slope  (cross-axis tilt of a tracker row on sloping
+*                        ground)
+*
+*    The time rows are done in blocks of BLOCK: the sun vectors of a
+*    block first, then the tracker loop.  Each tracker row is reduced
+*    once per call to the unit vectors of its frame, 1 / ( gcr cos
+*    cross_tilt ) and the cosine and sine of its limit.  The sun vectors
+*    and the frames are made from angles converted in double: the
+*    backtracking correction is acos t, steep as t nears 1, and an
+*    azimuth rounded to float radians alone moves t by several units in
+*    its last place.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "soltrack.h"
+*
+*----------------------------------------------------------------------------*/
+#include <math.h>
+#include <stdlib.h>
+#include "soltrack.h"
+#include "solvec.h"
+
+#define BLOCK  1024
+
+enum { A_SA, A_CA, A_SB, A_CB, A_L, A_CC, A_SC, A_CMAX, A_SMAX, A_BT, A_N };
+
+static double raddeg = 0.017453292519943295; /* degrees to radians */
+static float  degrad = 57.2957795;           /* radians to degrees */
+
+static inline void aim( float sx, float sy, float sz, int32_t up,
+                        float sa, float ca, float sb, float cb, float l,
+                        float cc, float sc, float cmax, float smax,
+                        int32_t bt, float v[5] );
+static void across( int ntrack, float sx, float sy, float sz, int32_t up,
+                    float *const *ax, float *restrict ideal,
+                    float *restrict theta, float *restrict tilt,
+                    float *restrict aspect, float *restrict cosinc );
+static void along( long n, const float *restrict sx,
+                   const float *restrict sy, const float *restrict sz,
+                   const float *restrict up, float *const *ax,
+                   float *restrict ideal, float *restrict theta,
+                   float *restrict tilt, float *restrict aspect,
+                   float *restrict cosinc );
+
+
+/*============================================================================
+*    Long integer function S_track
+*
+*    Rows first .. last - 1 of batch, for ntrack tracker rows
+*----------------------------------------------------------------------------*/
+long S_track (const struct solbatch *batch, long first, long last,
+              int ntrack, const struct soltracker *track, float *ideal,
+              float *theta, float *tilt, float *aspect, float *cosinc)
+{
+  float * const *col = batch->col;
+  float *buf, *ax[A_N], *sun[4], *out[5], *scratch[5], *o[5];
+  double z, a, m;
+  long   b, n, i, j, w;
+  int    k, f;
+
+    if ( ntrack < 1 || !track || !col[C_ZENREF] || !col[C_AZIM] )
+        return -1;
+    for ( k = 0; k < ntrack; k++ )
+        if ( track[k].backtrack && !( track[k].gcr > 0.0f ) )
+            return -1;
+
+    w   = ntrack > BLOCK ? ntrack : BLOCK;
+    buf = (float *) malloc( ( A_N * ntrack + 4 * BLOCK + 5 * w ) *
+                            sizeof( float ) );
+    if ( !buf )
+        return -1;
+    for ( f = 0; f < A_N; f++ )
+        ax[f] = buf + f * ntrack;
+    for ( f = 0; f < 4; f++ )
+        sun[f] = buf + A_N * ntrack + f * BLOCK;
+    for ( f = 0; f < 5; f++ )
+        scratch[f] = buf + A_N * ntrack + 4 * BLOCK + f * w;
+    out[0] = ideal;
+    out[1] = theta;
+    out[2] = tilt;
+    out[3] = aspect;
+    out[4] = cosinc;
+
+    for ( k = 0; k < ntrack; k++ ) {
+        a = raddeg * track[k].axis_azimuth;
+        z = raddeg * track[k].axis_tilt;
+        m = track[k].max_angle;
+        m = raddeg * ( m < 0.0f ? 0.0f : m > 180.0f ? 180.0f : m );
+        ax[A_SA][k]   = sin( a );
+        ax[A_CA][k]   = cos( a );
+        ax[A_SB][k]   = sin( z );
+        ax[A_CB][k]   = cos( z );
+        z = raddeg * track[k].cross_tilt;
+        ax[A_L][k]    = track[k].backtrack ?
+                        1.0 / ( track[k].gcr * cos( z ) ) : 0.0;
+        ax[A_CC][k]   = cos( z );
+        ax[A_SC][k]   = sin( z );
+        ax[A_CMAX][k] = cos( m );
+        ax[A_SMAX][k] = sin( m );
+        ax[A_BT][k]   = track[k].backtrack ? 1.0f : 0.0f;
+    }
+
+    for ( b = first; b < last; b += n ) {
+        n = last - b < BLOCK ? last - b : BLOCK;
+        for ( i = 0; i < n; i++ ) {
+            z = raddeg * col[C_ZENREF][b + i];
+            a = raddeg * col[C_AZIM][b + i];
+            sun[0][i] = sin( z ) * sin( a );
+            sun[1][i] = sin( z ) * cos( a );
+            sun[2][i] = cos( z );
+            sun[3][i] = col[C_ZENREF][b + i] < 90.0f ? 1.0f : 0.0f;
+        }
+
+        if ( ntrack == 1 ) {
+            for ( f = 0; f < 5; f++ )
+                o[f] = out[f] ? out[f] + ( b - first ) : scratch[f];
+            along( n, sun[0], sun[1], sun[2], sun[3], ax, o[0], o[1], o[2],
+                   o[3], o[4] );
+            continue;
+        }
+
+        for ( i = 0; i < n; i++ ) {
+            j = ( b + i - first ) * ntrack;
+            for ( f = 0; f < 5; f++ )
+                o[f] = out[f] ? out[f] + j : scratch[f];
+            across( ntrack, sun[0][i], sun[1][i], sun[2][i],
+                    -( sun[3][i] > 0.0f ), ax, o[0], o[1], o[2], o[3],
+                    o[4] );
+        }
+    }
+
+    free( buf );
+    return last - first;
+}
+
+
+/*============================================================================
+*    Float function S_track_slope
+*
+*    Sets track->cross_tilt for ground of slope_tilt degrees falling
+*    toward slope_azimuth, from the ground's normal in the frame of the
+*    axis, and returns it
+*----------------------------------------------------------------------------*/
+float S_track_slope (struct soltracker *track, float slope_tilt,
+                     float slope_azimuth)
+{
+  double b = raddeg * track->axis_tilt, s = raddeg * slope_tilt;
+  double d = raddeg * ( slope_azimuth - track->axis_azimuth );
+
+    track->cross_tilt = degrad * atan2( sin( s ) * sin( d ),
+                                        sin( s ) * sin( b ) * cos( d ) +
+                                        cos( s ) * cos( b ) );
+    return track->cross_tilt;
+}
+
+
+/*============================================================================
+*    Local Void function aim
+*
+*    One time row and tracker row.  The sun (sx, sy, sz: east, north,
+*    up) in the tracker frame is xp across the axis and zp normal to it;
+*    true tracking is the rotation atan2( xp, zp ), with cosine cw and
+*    sine sw.  The backtracking correction has cosine t, the ratio of the
+*    panel's shadow to the row pitch across the sun, when t < 1; t is
+*    taken from xp and zp with one division, and its sine from
+*    ( 1 - t )( 1 + t ), to keep the roundings in t few.
+*----------------------------------------------------------------------------*/
+static inline void aim( float sx, float sy, float sz, int32_t up,
+                        float sa, float ca, float sb, float cb, float l,
+                        float cc, float sc, float cmax, float smax,
+                        int32_t bt, float v[5] )
+{
+  float   xp, zp, r, cw, sw, t, cu, su, ct, st, nx, ny, nz, az;
+  int32_t ok, bk, over;
+
+    xp = sx * ca - sy * sa;
+    zp = ( sx * sa + sy * ca ) * sb + sz * cb;
+    r  = vsqrt( xp * xp + zp * zp );
+    ok = -( r > 0.0f );
+    r  = vsel( ok, r, 1.0f );
+    cw = vsel( ok, zp / r, 1.0f );
+    sw = xp / r;
+
+    t  = l * fabsf( zp * cc + xp * sc ) / r;
+    bk = bt & -( t < 1.0f );
+    cu = vsel( bk, t, 1.0f );
+    su = vsqrt( vsel( bk, ( 1.0f - t ) * ( 1.0f + t ), 0.0f ) );
+    su = bitsf( fbits( su ) ^ ( fbits( xp ) & (int32_t) 0x80000000 ) ^
+                (int32_t) 0x80000000 );
+    su = vsel( bk, su, 0.0f );
+    ct = cw * cu - sw * su;
+    st = sw * cu + cw * su;
+
+    over = -( ct < cmax );
+    ct   = vsel( over, cmax, ct );
+    st   = vsel( over, bitsf( fbits( smax ) |
+                              ( fbits( st ) & (int32_t) 0x80000000 ) ), st );
+    ct   = vsel( up, ct, 1.0f );
+    st   = vsel( up, st, 0.0f );
+
+    nx = sb * sa * ct + ca * st;
+    ny = sb * ca * ct - sa * st;
+    nz = cb * ct;
+    az = degrad * vatan2( nx, ny );
+
+    v[0] = vsel( up, degrad * vatan2( sw, cw ), 0.0f );
+    v[1] = degrad * vatan2( st, ct );
+    v[2] = degrad * vatan2( vsqrt( nx * nx + ny * ny ), nz );
+    v[3] = vsel( -( az < 0.0f ), az + 360.0f, az );
+    v[4] = nx * sx + ny * sy + nz * sz;
+}
+
+
+/*============================================================================
+*    Local Void function across
+*
+*    One time row, all the tracker rows
+*----------------------------------------------------------------------------*/
+static void across( int ntrack, float sx, float sy, float sz, int32_t up,
+                    float *const *ax, float *restrict ideal,
+                    float *restrict theta, float *restrict tilt,
+                    float *restrict aspect, float *restrict cosinc )
+{
+  const float *restrict sa = ax[A_SA], *restrict ca = ax[A_CA];
+  const float *restrict sb = ax[A_SB], *restrict cb = ax[A_CB];
+  const float *restrict l  = ax[A_L],  *restrict cc = ax[A_CC];
+  const float *restrict sc = ax[A_SC], *restrict cmax = ax[A_CMAX];
+  const float *restrict smax = ax[A_SMAX], *restrict bt = ax[A_BT];
+  float v[5];
+  int   k;
+
+    for ( k = 0; k < ntrack; k++ ) {
+        aim( sx, sy, sz, up, sa[k], ca[k], sb[k], cb[k], l[k], cc[k], sc[k],
+             cmax[k], smax[k], -( bt[k] > 0.0f ), v );
+        ideal[k]  = v[0];
+        theta[k]  = v[1];
+        tilt[k]   = v[2];
+        aspect[k] = v[3];
+        cosinc[k] = v[4];
+    }
+}
+
+
+/*============================================================================
+*    Local Void function along
+*
+*    n time rows, one tracker row
+*----------------------------------------------------------------------------*/
+static void along( long n, const float *restrict sx,
+                   const float *restrict sy, const float *restrict sz,
+                   const float *restrict up, float *const *ax,
+                   float *restrict ideal, float *restrict theta,
+                   float *restrict tilt, float *restrict aspect,
+                   float *restrict cosinc )
+{
+  float   sa = ax[A_SA][0], ca = ax[A_CA][0], sb = ax[A_SB][0];
+  float   cb = ax[A_CB][0], l = ax[A_L][0], cc = ax[A_CC][0];
+  float   sc = ax[A_SC][0], cmax = ax[A_CMAX][0], smax = ax[A_SMAX][0];
+  float   v[5];
+  int32_t bt = -( ax[A_BT][0] > 0.0f );
+  long    i;
+
+    for ( i = 0; i < n; i++ ) {
+        aim( sx[i], sy[i], sz[i], -( up[i] > 0.0f ), sa, ca, sb, cb, l, cc,
+             sc, cmax, smax, bt, v );
+        ideal[i]  = v[0];
+        theta[i]  = v[1];
+        tilt[i]   = v[2];
+        aspect[i] = v[3];
+        cosinc[i] = v[4];
+    }
+}
@@ -0,0 +1,78 @@
+/*============================================================================
+*
+*    NAME:  soltrack.h
+*
+*    Contains:
+*        S_track        (single-axis tracker rotation, surface orientation
+*                        and incidence for rows of a batch times tracker
+*                        rows)
+*        S_track_slope  (cross-axis tilt of a tracker row on sloping
+*                        ground)
+*
+*    Single-axis trackers, from the sun vector of a batch (solbatch.h)
+*    that has already been run with zenref and azim.  The axis points
+*    toward axis_azimuth (degrees clockwise from north) and is tilted
+*    axis_tilt degrees from horizontal, its axis_azimuth end down; the
+*    rotation is about the axis, 0 with the panel's normal in the
+*    vertical plane of the axis and positive turning the normal toward
+*    the right of the axis direction (west, for an axis pointing south).
+*    The frames and signs are those of Marion and Dobos (2013), so the
+*    angles agree with pvlib's singleaxis().
+*
+*    For each time row and tracker row:
+*        ideal   the rotation that puts the sun in the plane of the
+*                normal and the axis (true tracking), degrees
+*        theta   the rotation used: ideal, backtracked if asked for, and
+*                limited to +/- max_angle; 0 (flat) with the sun down
+*        tilt    surface tilt, degrees
+*        aspect  surface azimuth, degrees clockwise from north (0 when
+*                flat)
+*        cosinc  cosine of the incidence angle on the panel
+*
+*    Backtracking (Anderson and Mikofski 2020) turns the panel away from
+*    the sun just enough that the next row does not shade it: gcr is the
+*    collector width over the horizontal row pitch, and the rows stand on
+*    ground that falls cross_tilt degrees toward positive rotation (0 on
+*    flat ground; S_track_slope fills it in from the slope of the
+*    ground).  Each tracker row has its own axis, gcr, limit and slope.
+*
+*    Backtracking and the limit are applied to the cosine and sine of the
+*    rotation, by angle sums, so the loop has no trigonometric calls;
+*    the angles themselves come from the vatan2 of solvec.h.  The loop
+*    is straight-line code and vectorizes over the tracker rows, or over
+*    time when there is one tracker row.
+*
+*    The outputs are row-major: theta[( i - first ) * ntrack + k] for
+*    time row i and tracker row k.  Any output may be NULL.  S_track
+*    returns the number of rows done, or -1 for missing columns, no
+*    tracker rows, a backtracking tracker with gcr <= 0, or no memory.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "soltrack.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLTRACK_H
+#define SOLTRACK_H
+
+#include "solbatch.h"
+
+struct soltracker
+{
+    float axis_tilt;       /* degrees from horizontal */
+    float axis_azimuth;    /* degrees clockwise from north */
+    float gcr;             /* collector width / horizontal row pitch */
+    float max_angle;       /* rotation limit either way, degrees */
+    float cross_tilt;      /* ground slope across the rows, degrees */
+    int   backtrack;       /* avoid row-to-row shading */
+};
+
+extern long  S_track (const struct solbatch *batch, long first, long last,
+                      int ntrack, const struct soltracker *track,
+                      float *ideal, float *theta, float *tilt,
+                      float *aspect, float *cosinc);
+extern float S_track_slope (struct soltracker *track, float slope_tilt,
+                            float slope_azimuth);
+
+#endif /* SOLTRACK_H */
@@ -0,0 +1,160 @@
+/*============================================================================
+*
+*    NAME:  solvec.h
+*
+*    Contains:
+*        vsel  (select by an all-ones or all-zero mask)
+*        vexp  (float exp)
+*        vlog  (float log of x > 0)
+*        vpow  (float pow of x > 0)
+*        vsqrt   (float sqrt of x >= 0)
+*        vatan2  (float atan2)
+*        vsincos (float sine and cosine)
+*
+*    Float helpers for the loops of solclear.c and solspec.c that must
+*    stay straight-line code to vectorize.  Everything here is static
+*    inline; there is no matching .c file.
+*
+*    vsel picks a where the mask m is all ones and b where it is 0, by
+*    bits: GCC will not if-convert a float ?: whose result feeds more
+*    arithmetic (the arithmetic might trap), but does vectorize this.
+*
+*    exp, log and pow (of x > 0) in float to about 1 ulp, in straight-line
+*    code that vectorizes: exp by rounding x / ln 2 to an integer n and a
+*    Taylor polynomial of the remainder, times 2^n put in the exponent
+*    bits; log from the exponent bits and the atanh series of the
+*    mantissa.
+*
+*    sqrt and atan2 are there because GCC keeps the libm calls (errno,
+*    in the case of sqrtf) and so does not vectorize: sqrt from the
+*    reciprocal square root guess by exponent bits and three Newton
+*    steps; atan2 from the ratio of the smaller to the larger of |x| and
+*    |y|, the Abramowitz and Stegun 4.4.49 polynomial (2e-8 rad) and
+*    selects for the octant.  vatan2( 0, 0 ) is 0.
+*
+*    vsincos reduces x (radians, |x| up to about 1e5) by the nearest
+*    multiple of pi / 2 in three parts (Cody and Waite), takes the
+*    Cephes sinf and cosf polynomials of the remainder and swaps and
+*    negates them by the quadrant, to about 1 ulp.
+*
+*    Usage:
+*         In calling program, just after other 'includes', insert:
+*
+*              #include "solvec.h"
+*
+*----------------------------------------------------------------------------*/
+#ifndef SOLVEC_H
+#define SOLVEC_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+static inline int32_t fbits( float f )
+{
+  int32_t k;
+
+    memcpy( &k, &f, sizeof( k ) );
+    return k;
+}
+
+static inline float bitsf( int32_t k )
+{
+  float f;
+
+    memcpy( &f, &k, sizeof( f ) );
+    return f;
+}
+
+static inline float vsel( int32_t m, float a, float b )
+{
+    return bitsf( ( fbits( a ) & m ) | ( fbits( b ) & ~m ) );
+}
+
+static inline float vexp( float x )
+{
+  float n, r, p;
+
+    x = vsel( -( x < -87.0f ), -87.0f, x );
+    x = vsel( -( x > 88.0f ), 88.0f, x );
+    n = x * 1.44269504f + 12582912.0f;      /* 1.5 * 2^23: rounds */
+    n = n - 12582912.0f;
+    r = x - n * 0.693145752f - n * 1.42860677e-6f;
+    p = 1.0f + r * ( 1.0f + r * ( 0.5f + r * ( 1.66666667e-1f +
+        r * ( 4.16666667e-2f + r * ( 8.33333333e-3f +
+        r * 1.38888889e-3f ) ) ) ) );
+    return p * bitsf( ( (int32_t) n + 127 ) << 23 );
+}
+
+static inline float vlog( float x )
+{
+  float m, f, s, z;
+  int32_t k = fbits( x ), e, big;
+
+    e   = ( ( k >> 23 ) & 0xff ) - 127;
+    m   = bitsf( ( k & 0x007fffff ) | 0x3f800000 );  /* in [1, 2) */
+    big = -( m > 1.41421356f );
+    m   = m * vsel( big, 0.5f, 1.0f );
+    e  -= big;
+    f   = m - 1.0f;
+    s   = f / ( 2.0f + f );
+    z   = s * s;
+    return e * 0.693147181f + 2.0f * s * ( 1.0f + z * ( 3.33333333e-1f +
+           z * ( 0.2f + z * ( 1.42857143e-1f + z * 1.11111111e-1f ) ) ) );
+}
+
+static inline float vpow( float x, float y )
+{
+    return vexp( y * vlog( x ) );
+}
+
+static inline float vsqrt( float x )
+{
+  float y = bitsf( 0x5f3759df - ( fbits( x ) >> 1 ) );
+
+    y = y * ( 1.5f - 0.5f * x * y * y );
+    y = y * ( 1.5f - 0.5f * x * y * y );
+    y = y * ( 1.5f - 0.5f * x * y * y );
+    return x * y;
+}
+
+static inline float vatan2( float y, float x )
+{
+  float   ax = fabsf( x ), ay = fabsf( y ), mn, mx, a, z, p;
+  int32_t big = -( ay > ax );
+
+    mn = vsel( big, ax, ay );
+    mx = vsel( big, ay, ax );
+    a  = mn / vsel( -( mx > 0.0f ), mx, 1.0f );
+    z  = a * a;
+    p  = a * ( 1.0f + z * ( -0.3333314528f + z * ( 0.1999355085f +
+         z * ( -0.1420889944f + z * ( 0.1065626393f +
+         z * ( -0.0752896400f + z * ( 0.0429096138f +
+         z * ( -0.0161657367f + z * 0.0028662257f ) ) ) ) ) ) ) );
+    p  = vsel( big, 1.57079633f - p, p );
+    p  = vsel( -( x < 0.0f ), 3.14159265f - p, p );
+    return bitsf( fbits( p ) | ( fbits( y ) & (int32_t) 0x80000000 ) );
+}
+
+static inline void vsincos( float x, float *s, float *c )
+{
+  float   n, r, z, ps, pc;
+  int32_t q, swap;
+
+    n  = x * 0.636619772f + 12582912.0f;     /* 1.5 * 2^23: rounds */
+    n  = n - 12582912.0f;
+    q  = (int32_t) n;
+    r  = x - n * 1.5703125f - n * 4.83751297e-4f - n * 7.54978995e-8f;
+    z  = r * r;
+    ps = r + r * z * ( -1.66666546e-1f + z * ( 8.33216087e-3f +
+         z * -1.95152959e-4f ) );
+    pc = 1.0f - 0.5f * z + z * z * ( 4.16666457e-2f + z * ( -1.38873163e-3f +
+         z * 2.44331571e-5f ) );
+    swap = -( q & 1 );
+    *s = bitsf( fbits( vsel( swap, pc, ps ) ) ^
+                (int32_t) ( (uint32_t) ( q & 2 ) << 30 ) );
+    *c = bitsf( fbits( vsel( swap, ps, pc ) ) ^
+                (int32_t) ( (uint32_t) ( ( q + 1 ) & 2 ) << 30 ) );
+}
+
+#endif /* SOLVEC_H */
@@ -0,0 +1,260 @@
+/*============================================================================
+*
+*    名称：sptest00.c
+*
+*    目的：测试 'solspec.c' 中的 SPCTRAL2 晴空光谱辐射模型。
+*
+*        若干站点（0 号为大连，1 号为海拔约 3600 米的拉萨）一年的
+*        逐时批量计算，面板倾角 30 度朝南；每个时刻算 122 个波长的
+*        法向直射、水平总辐射、散射和面板总辐射：
+*
+*        一、与按公式逐个波长用双精度 exp/pow 写成的对照计算比较，
+*        打印（1 W/平方米/微米以上的）最大相对偏差。
+*        二、打印每秒的时刻数、站点年数，以及对照计算的速度。
+*        三、夏至日正午的光谱按波长积分，与 'solclear.c' 的宽波段
+*        Bird 模型比较；并打印大连正午的部分光谱。
+*
+*        第一部分的相对偏差超过 3.5e-6 时返回 1。
+*
+*    用法：
+*         sptest [站点数]        默认 64 个站点
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solpos00.h"
+#include "solclear.h"
+#include "solrt.h"
+#include "solspec.h"
+
+#define START  1672531200LL          /* 2023-01-01 00:00 UTC */
+#define NTIME  8760L
+#define NB     S_SPEC_NBAND
+#define RAD    0.0174532925199433
+
+/* solspec.c 的系数表：波长、地外辐射、水汽、臭氧、混合气体 */
+static double tab[NB][5];
+
+/* 对照：双精度逐个波长计算一个时刻 */
+static void reference(const struct solclear_site *cs, double press,
+                      double am, double amp, double zen, double erv,
+                      double ci, double tilt, double out[4][NB])
+{
+    double cz = cos(zen * RAD), alpha, tau, w, lw, alg, afs, bfs, fs, fsp;
+    double om, tr, ta, taa, tas, tw, to, tu, id, ir, ia, ig, is, rs, x, c;
+    double trp, taap, tasp, twp, top, ct = cos(tilt * RAD);
+    int    k;
+
+    alpha = log(cs->aod380 / cs->aod500) / log(500.0 / 380.0);
+    alg   = log(1.0 - 0.65);
+    afs   = alg * (1.459 + alg * (0.1595 + alg * 0.4129));
+    bfs   = alg * (0.0783 + alg * (-0.3824 - alg * 0.5874));
+    fs    = 1.0 - 0.5 * exp((afs + bfs * cz) * cz);
+    fsp   = 1.0 - 0.5 * exp((afs + bfs / 1.8) / 1.8);
+    om    = (1.0 + 22.0 / 6370.0) / sqrt(cz * cz + 2.0 * 22.0 / 6370.0);
+    ci    = fmax(ci, 0.0);
+    for (k = 0; k < NB; k++)
+    {
+        tau = cs->aod500 * pow(tab[k][0] / 0.5, -alpha);
+        lw  = log(tab[k][0] / 0.4);
+        w   = 0.945 * exp(-0.095 * lw * lw);
+        x   = pow(tab[k][0], 4.0) * (115.6406 - 1.335 / pow(tab[k][0], 2.0));
+        tr  = exp(-amp / x);
+        ta  = exp(-tau * am);
+        taa = exp(-(1.0 - w) * tau * am);
+        tas = exp(-w * tau * am);
+        tw  = exp(-0.2385 * tab[k][2] * cs->water * am /
+                  pow(1.0 + 20.07 * tab[k][2] * cs->water * am, 0.45));
+        to  = exp(-tab[k][3] * cs->ozone * om);
+        tu  = exp(-1.41 * tab[k][4] * amp /
+                  pow(1.0 + 118.93 * tab[k][4] * amp, 0.45));
+        trp  = exp(-1.8 * press / 1013.25 / x);
+        taap = exp(-(1.0 - w) * tau * 1.8);
+        tasp = exp(-w * tau * 1.8);
+        twp  = exp(-0.2385 * tab[k][2] * cs->water * 1.8 /
+                   pow(1.0 + 20.07 * tab[k][2] * cs->water * 1.8, 0.45));
+        top  = exp(-tab[k][3] * cs->ozone * 1.8);
+        rs   = top * twp * taap * (0.5 * (1.0 - trp) +
+                                   (1.0 - fsp) * trp * (1.0 - tasp));
+
+        id = tab[k][1] * erv * tr * ta * tw * to * tu;
+        ir = tab[k][1] * erv * cz * to * tu * tw * taa *
+             (1.0 - pow(tr, 0.95)) * 0.5;
+        ia = tab[k][1] * erv * cz * to * tu * tw * taa * pow(tr, 1.5) *
+             (1.0 - tas) * fs;
+        ig = (id * cz + ir + ia) * rs * cs->albedo / (1.0 - rs * cs->albedo);
+        c  = tab[k][0] <= 0.45 ? pow(tab[k][0] + 0.55, 1.8) : 1.0;
+        is = (ir + ia + ig) * c;
+        out[0][k] = id;
+        out[1][k] = id * cz + is;
+        out[2][k] = is;
+        out[3][k] = id * ci + is * (id / (tab[k][1] * erv) * ci / cz +
+                                    0.5 * (1.0 + ct) *
+                                    (1.0 - id / (tab[k][1] * erv))) +
+                    0.5 * out[1][k] * cs->albedo * (1.0 - ct);
+    }
+}
+
+/* 梯形积分，W/平方米 */
+static double integral(const float *f)
+{
+    double sum = 0.0;
+    int    k;
+
+    for (k = 0; k + 1 < NB; k++)
+        sum += 0.5 * (f[k] + f[k + 1]) * (tab[k + 1][0] - tab[k][0]);
+    return sum;
+}
+
+int main(int argc, char *argv[])
+{
+    struct posdata       *sites;
+    struct solclear_site *cs;
+    struct solbatch       batch;
+    long long *utc, t0;
+    int       *site;
+    float     *buf, *spec, *cghi, *cdni, *cdhi;
+    double     ref[4][NB], sec, rsec, d, drel, erv;
+    long       rows, r, n, noon;
+    int        nsite = 64, k, s, j;
+
+    if (argc > 1) nsite = atoi(argv[1]);
+    if (nsite < 2) nsite = 2;
+
+    for (k = 0; k < NB; k++)
+        for (j = 0; j < 5; j++)
+            tab[k][j] = S_spec_band(k)[j];
+
+    rows  = NTIME * nsite;
+    sites = (struct posdata *) malloc(nsite * sizeof(*sites));
+    cs    = (struct solclear_site *) malloc(nsite * sizeof(*cs));
+    utc   = (long long *) malloc(rows * sizeof(*utc));
+    site  = (int *) malloc(rows * sizeof(*site));
+    buf   = (float *) malloc(9 * rows * sizeof(float));
+    spec  = (float *) malloc(4 * NTIME * NB * sizeof(float));
+    if (!sites || !cs || !utc || !site || !buf || !spec)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    for (k = 0; k < nsite; k++)
+    {
+        S_init(&sites[k]);
+        sites[k].latitude  = -60.0 + 120.0 * k / nsite + 1.0;
+        sites[k].longitude = -180.0 + 360.0 * k / nsite;
+        sites[k].timezone  = (float) (int) (sites[k].longitude / 15.0);
+        sites[k].press     = 1013.0 - 400.0 * k / nsite;
+        sites[k].interval  = 3600;
+        sites[k].tilt      = 30.0;
+        sites[k].aspect    = sites[k].latitude >= 0.0 ? 180.0 : 0.0;
+    }
+    sites[0].latitude  = 38.9;            /* 大连 */
+    sites[0].longitude = 121.6;
+    sites[0].timezone  = 8.0;
+    sites[1].latitude  = 29.65;           /* 拉萨 */
+    sites[1].longitude = 91.13;
+    sites[1].timezone  = 8.0;
+    sites[1].press     = 650.0;
+    for (k = 0; k < nsite; k++)
+        S_clear_site(&cs[k], &sites[k]);
+
+    for (r = 0; r < rows; r++)
+    {
+        site[r] = (int) (r / NTIME);
+        utc[r]  = START + (r % NTIME + 1) * 3600;
+    }
+    memset(&batch, 0, sizeof(batch));
+    batch.count = rows;
+    batch.utc   = utc;
+    batch.site  = site;
+    batch.sites = sites;
+    batch.col[C_AMASS]   = buf;
+    batch.col[C_AMPRESS] = buf + rows;
+    batch.col[C_ZENREF]  = buf + 2 * rows;
+    batch.col[C_ETRN]    = buf + 3 * rows;
+    batch.col[C_COSINC]  = buf + 4 * rows;
+    batch.col[C_COSZEN]  = buf + 5 * rows;
+    cghi = buf + 6 * rows;
+    cdni = buf + 7 * rows;
+    cdhi = buf + 8 * rows;
+    S_batch_parallel(&batch, 4);
+    S_clear(K_BIRD, &batch, cs, NULL, 0, rows, cghi, cdni, cdhi);
+    printf("%d 站点 x %ld 时 = %ld 行，每行 %d 个波长（%.3f - %.3f 微米）\n\n",
+           nsite, NTIME, rows, NB, tab[0][0], tab[NB - 1][0]);
+
+    /* 一、二：逐站点计算，每次一个站点年 */
+    t0 = S_rt_now();
+    for (s = 0; s < nsite; s++)
+        S_spec(&batch, cs, s * NTIME, (s + 1) * NTIME, spec,
+               spec + NTIME * NB, spec + 2 * NTIME * NB, spec + 3 * NTIME * NB);
+    sec = (S_rt_now() - t0) * 1.0e-9;
+
+    drel = 0.0;
+    n    = 0;
+    t0   = S_rt_now();
+    for (r = 0; r < NTIME; r++)           /* 最后一个站点 */
+    {
+        s = nsite - 1;
+        if (batch.col[C_ZENREF][s * NTIME + r] >= 90.0)
+            continue;
+        erv = batch.col[C_ETRN][s * NTIME + r] / sites[s].solcon;
+        reference(&cs[s], sites[s].press, batch.col[C_AMASS][s * NTIME + r],
+                  batch.col[C_AMPRESS][s * NTIME + r],
+                  batch.col[C_ZENREF][s * NTIME + r], erv,
+                  batch.col[C_COSINC][s * NTIME + r], sites[s].tilt, ref);
+        n++;
+        for (j = 0; j < 4; j++)
+            for (k = 0; k < NB; k++)
+            {
+                d = fabs(spec[j * NTIME * NB + r * NB + k] - ref[j][k]);
+                if (ref[j][k] > 1.0 && d / ref[j][k] > drel)
+                    drel = d / ref[j][k];
+            }
+    }
+    rsec = (S_rt_now() - t0) * 1.0e-9;
+    printf("批量：%.3f 秒，%.0f 时/秒，%.1f 站点年/秒\n", sec, rows / sec,
+           nsite / sec);
+    printf("对照：%ld 个白天时刻 %.3f 秒，%.0f 时/秒；最大相对偏差 %.2g\n\n",
+           n, rsec, n / rsec, drel);
+
+    /* 三、夏至日正午 */
+    printf("夏至日正午，按波长积分 / 宽波段 Bird（W/平方米）\n");
+    for (s = 0; s < 2; s++)
+    {
+        noon = 171 * 24 + 12 - (long) sites[s].timezone - 1;
+        S_spec(&batch, cs, s * NTIME, (s + 1) * NTIME, spec,
+               spec + NTIME * NB, spec + 2 * NTIME * NB, spec + 3 * NTIME * NB);
+        printf("  %s  DNI %6.1f / %6.1f   GHI %6.1f / %6.1f   DHI %5.1f / %5.1f"
+               "   面板 %6.1f\n", s == 0 ? "大连" : "拉萨",
+               integral(spec + noon * NB), cdni[s * NTIME + noon],
+               integral(spec + NTIME * NB + noon * NB), cghi[s * NTIME + noon],
+               integral(spec + 2 * NTIME * NB + noon * NB),
+               cdhi[s * NTIME + noon],
+               integral(spec + 3 * NTIME * NB + noon * NB));
+    }
+
+    noon = 171 * 24 + 12 - 8 - 1;
+    S_spec(&batch, cs, 0, NTIME, spec, spec + NTIME * NB,
+           spec + 2 * NTIME * NB, spec + 3 * NTIME * NB);
+    printf("\n大连夏至日正午光谱（W/平方米/微米）\n"
+           "  波长     DNI      GHI      DHI     面板\n");
+    for (k = 0; k < NB; k += 8)
+        printf("  %.3f %8.1f %8.1f %8.1f %8.1f\n", tab[k][0],
+               spec[noon * NB + k], spec[NTIME * NB + noon * NB + k],
+               spec[2 * NTIME * NB + noon * NB + k],
+               spec[3 * NTIME * NB + noon * NB + k]);
+
+    free(sites);
+    free(cs);
+    free(utc);
+    free(site);
+    free(buf);
+    free(spec);
+    printf("\n相对偏差%s 3.5e-6\n", drel > 3.5e-6 ? "超过" : "不超过");
+    return drel > 3.5e-6;
+}
@@ -51,6 +51,7 @@
 #include <math.h>
 
 #include "solpos00.h"     /* <-- 这是我提到的 'include' */
+#include "soltilt.h"
 
 int main()
 {
@@ -129,6 +130,83 @@ int main()
            pdat->ssetr, pdat->unprime, pdat->zenref);
 
 
+/**********************************************************************/
+    /* 多个面板朝向（soltilt.h）
+
+       上面的 pdat 没有设时区，S_solpos 返回错误，不能拿来比较。这里另用
+       一个有效的 posdata（NREL 基准的亚特兰大，1999 年第 203 天），取一天中
+       的三个时刻，对 37 x 73 个 (倾斜角, 方位角) 用 S_tilt_sweep 和
+       S_tilt_normals + S_tilt_sweep_normals 一次算出 cosinc 和 etrtilt，
+       再对每个面板单独调用 S_solpos（S_TILT）作对照，打印最大偏差。 */
+    {
+        enum { NT = 37, NA = 73, NP = NT * NA };
+        static float sw_tilt[NP], sw_aspect[NP], sw_cosinc[NP], sw_etrtilt[NP];
+        static float nx[NP], ny[NP], nz[NP], nm_cosinc[NP], nm_etrtilt[NP];
+        static const int hours[3] = { 7, 9, 15 };
+        struct posdata sun, one;
+        double d, dc = 0.0, de = 0.0;
+        long   rv, bad = 0;
+        int    h, i;
+
+        for (i = 0; i < NP; i++)
+        {
+            sw_tilt[i]   = 5.0f * (i / NA) * 0.5f;   /* 0 - 90 度 */
+            sw_aspect[i] = 5.0f * (i % NA);          /* 0 - 360 度 */
+        }
+        S_tilt_normals(NP, sw_tilt, sw_aspect, nx, ny, nz);
+
+        for (h = 0; h < 3; h++)
+        {
+            S_init(&sun);
+            sun.longitude = -84.43;
+            sun.latitude  = 33.65;
+            sun.timezone  = -5.0;
+            sun.year      = 1999;
+            sun.daynum    = 203;
+            sun.hour      = hours[h];
+            sun.minute    = 45;
+            sun.second    = 37;
+            sun.temp      = 27.0;
+            sun.press     = 1006.0;
+            if ((rv = S_solpos(&sun)) != 0)
+            {
+                S_decode(rv, &sun);
+                return 1;
+            }
+            S_tilt_sweep(&sun, NP, sw_tilt, sw_aspect, sw_cosinc, sw_etrtilt);
+            S_tilt_sweep_normals(&sun, NP, nx, ny, nz, nm_cosinc, nm_etrtilt);
+
+            for (i = 0; i < NP; i++)
+            {
+                one          = sun;
+                one.tilt     = sw_tilt[i];
+                one.aspect   = sw_aspect[i];
+                one.function = S_TILT | S_ETR;
+                if (S_solpos(&one) != 0)
+                {
+                    bad++;
+                    continue;
+                }
+                d  = fmax(fabs(sw_cosinc[i] - one.cosinc),
+                          fabs(nm_cosinc[i] - one.cosinc));
+                dc = fmax(dc, d);
+                d  = fmax(fabs(sw_etrtilt[i] - one.etrtilt),
+                          fabs(nm_etrtilt[i] - one.etrtilt));
+                de = fmax(de, d);
+            }
+        }
+        printf("\nS_tilt_sweep / S_tilt_sweep_normals 与逐面板 S_solpos（%d 个时刻 x %d 个朝向）：\n",
+               3, NP);
+        printf("cosinc 最大偏差 %.2g，etrtilt 最大偏差 %.2g W/m2，S_solpos 出错 %ld 次\n",
+               dc, de, bad);
+        if (bad || dc > 1.0e-5 || de > 1.0e-2)
+        {
+            printf("偏差超出范围\n");
+            return 1;
+        }
+    }
+
+
 
 
 /**********************************************************************/
@@ -0,0 +1,273 @@
+/*============================================================================
+*
+*    名称：tmtest00.c
+*
+*    目的：测试 'soltmy.c' 的典型气象年文件读取和全年计算。
+*
+*        先生成两个示例文件：大连的 EPW 文件和凤凰城的 TMY3 文件，
+*        逐时气温、气压随季节和昼夜变化，GHI 取时段中点地外水平辐射
+*        的 0.7 倍，DNI 取法向地外辐射的 0.75 倍，另故意留几个缺测值。
+*
+*        一、读回两个文件，打印站点、记录数、时段长度和缺测值个数。
+*        二、按以前的做法逐时手工填 posdata（文件中的年月日时，
+*        interval = 3600，当时的气压和气温）调用 S_solpos，与全年
+*        批量计算的时段中点太阳位置比较；并核对 kt、kn 回到 0.7、0.75。
+*        三、把大连的文件复制成许多站点（纬度各不相同），一次批量
+*        计算，打印每秒站点年数。
+*        四、各月取自不同年份的 TMY3 文件（1998 年 1 月 31 日、2004 年
+*        2 月 28、29 日、2011 年 3 月 1 日，各 24 时）：年份给 0 时应
+*        全部移到第一条记录的 1998 年，平年里的 2 月 29 日应丢掉；给
+*        2024 年时应保留。检查记录数、丢掉数、年份和时刻严格递增。
+*
+*        第二、四部分检查不过时返回 1。
+*
+*    用法：
+*         tmtest [站点数 [线程数]]        默认 256 个站点，4 线程
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solpos00.h"
+#include "soltmy.h"
+
+#define START  1672531200LL          /* 2023-01-01 00:00 UTC */
+#define PI     3.14159265358979
+
+/* 一年 8760 个时段，结束时刻（当地标准时）为 1 月 1 日 1:00 起每小时一个 */
+static void makefile(const char *path, int epw, double lat, double lon,
+                     double tz, double elev)
+{
+    struct posdata pd;
+    FILE     *fp = fopen(path, "w");
+    long long end, local;
+    double    temp, press, ghi, dni, dhi;
+    int       h, k, hour;
+
+    if (fp == NULL)
+    {
+        perror(path);
+        exit(1);
+    }
+    if (epw)
+    {
+        fprintf(fp, "LOCATION,Dalian,Liaoning,CHN,CSWD,546620,%.2f,%.2f,%.1f,"
+                "%.1f\n", lat, lon, tz, elev);
+        fprintf(fp, "DESIGN CONDITIONS,0\nTYPICAL/EXTREME PERIODS,0\n"
+                "GROUND TEMPERATURES,0\nHOLIDAYS/DAYLIGHT SAVINGS,No,0,0,0\n"
+                "COMMENTS 1,synthetic\nCOMMENTS 2,\n"
+                "DATA PERIODS,1,1,Data,Sunday, 1/ 1,12/31\n");
+    }
+    else
+    {
+        fprintf(fp, "722780,\"PHOENIX SKY HARBOR INTL AP\",AZ,%.1f,%.3f,%.3f,"
+                "%.0f\n", tz, lat, lon, elev);
+        fprintf(fp, "Date (MM/DD/YYYY),Time (HH:MM),ETR (W/m^2),ETRN (W/m^2),"
+                "GHI (W/m^2),GHI source,GHI uncert (%%),DNI (W/m^2),"
+                "DNI source,DNI uncert (%%),DHI (W/m^2),DHI source,"
+                "DHI uncert (%%),Dry-bulb (C),Dry-bulb source,"
+                "Pressure (mbar)\n");
+    }
+
+    S_init(&pd);
+    pd.latitude  = lat;
+    pd.longitude = lon;
+    pd.timezone  = tz;
+    pd.interval  = 3600;
+    for (h = 0; h < 8760; h++)
+    {
+        local = START + (h + 1) * 3600LL;
+        end   = local - (long long) (tz * 3600);
+        temp  = 10.0 - 12.0 * cos(2.0 * PI * h / 8760.0)
+                     - 4.0 * cos(2.0 * PI * (h % 24) / 24.0);
+        press = 1013.25 * pow(1.0 - 2.25577e-5 * elev, 5.25588)
+                + 8.0 * cos(2.0 * PI * h / 8760.0);
+        S_epoch(&pd, end);
+        pd.temp  = temp;                  /* etr 用折射修正后的天顶角 */
+        pd.press = press;
+        S_solpos(&pd);
+
+        ghi   = 0.7 * pd.etr;
+        dni   = 0.75 * pd.etrn;
+        dhi   = ghi - dni * pd.cosinc;
+        if (h == 1000 || h == 5000)       /* 缺测 */
+        {
+            temp  = epw ? 99.9 : -9900;
+            press = epw ? 9999.99 : -9900;
+        }
+
+        /* 日期取时段开始的那一天，小时为 1 - 24 */
+        S_epoch(&pd, START + h * 3600LL - (long long) (tz * 3600));
+        hour = h % 24 + 1;
+        if (epw)
+            fprintf(fp, "2023,%d,%d,%d,60,?9?9?9?9E0,%.1f,0.0,50,%.0f,%.0f,%.0f,"
+                    "300,%.1f,%.1f,%.1f", pd.month, pd.day, hour, temp,
+                    press * 100.0, pd.etr, pd.etrn, ghi, dni, dhi);
+        else
+            fprintf(fp, "%02d/%02d/2023,%02d:00,%.0f,%.0f,%.1f,1,8,%.1f,1,8,"
+                    "%.1f,1,8,%.1f,A,%.1f", pd.month, pd.day, hour, pd.etr,
+                    pd.etrn, ghi, dni, dhi, temp, press);
+        for (k = 0; epw && k < 19; k++)
+            fprintf(fp, ",0");
+        fprintf(fp, "\n");
+    }
+    fclose(fp);
+}
+
+/* 四：各月取自不同年份的文件 */
+static long mixed(const char *path, int year, long n, long dropped, int first)
+{
+    static const int date[4][3] = { {1998, 1, 31}, {2004, 2, 28},
+                                    {2004, 2, 29}, {2011, 3, 1} };
+    struct soltmy tmy;
+    struct posdata pd;
+    FILE *fp = fopen(path, "w");
+    long  i, bad = 0;
+    int   d, h;
+
+    if (fp == NULL)
+        return 1;
+    fprintf(fp, "722780,\"PHOENIX SKY HARBOR INTL AP\",AZ,-7.0,33.450,"
+            "-111.983,337\n");
+    fprintf(fp, "Date (MM/DD/YYYY),Time (HH:MM),GHI (W/m^2),DNI (W/m^2),"
+            "DHI (W/m^2),Dry-bulb (C),Pressure (mbar)\n");
+    for (d = 0; d < 4; d++)
+        for (h = 1; h <= 24; h++)
+            fprintf(fp, "%02d/%02d/%d,%02d:00,0,0,0,20,980\n", date[d][1],
+                    date[d][2], date[d][0], h);
+    fclose(fp);
+
+    if (S_tmy_load(&tmy, path, year) != 0)
+        return 1;
+    S_init(&pd);
+    S_epoch(&pd, tmy.utc[0]);
+    for (i = 1; i < tmy.n; i++)
+        if (tmy.utc[i] <= tmy.utc[i - 1])
+            bad++;
+    printf("年份 %4d：%ld 条记录，丢掉 %ld 条，第一条在 %d 年，时刻不增 %ld 处"
+           "（应为 %ld、%ld、%d、0）\n", year, tmy.n, tmy.dropped, pd.year, bad,
+           n, dropped, first);
+    bad += tmy.n != n || tmy.dropped != dropped || pd.year != first;
+    S_tmy_free(&tmy);
+    return bad;
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *path[2] = { "/tmp/tmtest-dalian.epw",
+                                   "/tmp/tmtest-phoenix.csv" };
+    struct soltmy     tmy[2], *many;
+    struct soltmy_run run;
+    struct posdata    pd;
+    double    dz, dmax = 0.0, dkt = 0.0, dkn = 0.0, local;
+    long      r, i, bad = 0, day = 0;
+    int       nsite = 256, threads = 4, k, e, hour;
+
+    if (argc > 1) nsite   = atoi(argv[1]);
+    if (argc > 2) threads = atoi(argv[2]);
+    if (nsite < 1) nsite = 1;
+
+    makefile(path[0], 1, 38.90, 121.63, 8.0, 92.0);
+    makefile(path[1], 0, 33.450, -111.983, -7.0, 337.0);
+
+    /* 一、读取 */
+    for (k = 0; k < 2; k++)
+    {
+        if ((e = S_tmy_load(&tmy[k], path[k], 2023)) != 0)
+        {
+            printf("%s：第 %d 行读不懂\n", path[k], e);
+            return 1;
+        }
+        printf("%s（%s）：%s，纬度 %.2f，经度 %.2f，时区 %.0f，海拔 %.0f 米，"
+               "%ld 条记录，时段 %d 秒，缺测值 %ld 个\n", path[k],
+               tmy[k].format == S_TMY_EPW ? "EPW" : "TMY3", tmy[k].name,
+               tmy[k].site.latitude, tmy[k].site.longitude,
+               tmy[k].site.timezone, tmy[k].elevation, tmy[k].n,
+               tmy[k].site.interval, tmy[k].missing);
+    }
+
+    /* 二、与逐时手工计算比较 */
+    if (S_tmy_run_init(&run, tmy, 2, S_COL(C_ZENREF) | S_COL(C_AZIM)) != 0)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    S_tmy_run(&run, threads);
+    for (k = 0, r = 0; k < 2; k++)
+        for (i = 0; i < tmy[k].n; i++, r++)
+        {
+            /* 文件中的日期和 1 - 24 时，与以前手工填写一样 */
+            local = tmy[k].utc[i] + tmy[k].site.timezone * 3600.0;
+            day   = (long) floor((local - 1.0) / 86400.0);
+            hour  = (int) ((local - day * 86400.0) / 3600.0 + 0.5);
+            pd = tmy[k].site;
+            S_epoch(&pd, (long long) day * 86400 -
+                         (long long) (tmy[k].site.timezone * 3600));
+            pd.hour   = hour;
+            pd.minute = 0;
+            pd.second = 0;
+            pd.press  = tmy[k].wx[W_PRESS][i];
+            pd.temp   = tmy[k].wx[W_TEMP][i];
+            if (S_solpos(&pd) != 0 || run.batch.retval[r] != 0)
+            {
+                bad++;
+                continue;
+            }
+            dz = fabs(pd.zenref - run.batch.col[C_ZENREF][r]);
+            if (dz > dmax) dmax = dz;
+            if (run.batch.col[C_ETR][r] > 10.0)
+            {
+                if (fabs(run.kt[r] - 0.7) > dkt)  dkt = fabs(run.kt[r] - 0.7);
+                if (fabs(run.kn[r] - 0.75) > dkn) dkn = fabs(run.kn[r] - 0.75);
+            }
+        }
+    printf("与逐时手工计算比较：出错 %ld 个，天顶角最大偏差 %.2g 度；"
+           "kt 与 0.7 最大偏差 %.2g，kn 与 0.75 最大偏差 %.2g\n",
+           bad, dmax, dkt, dkn);
+    S_tmy_run_free(&run);
+
+    /* 三、多站点全年计算 */
+    many = (struct soltmy *) malloc(nsite * sizeof(*many));
+    if (many == NULL)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    for (k = 0; k < nsite; k++)
+    {
+        many[k] = tmy[0];                 /* 共用同一份逐时数据 */
+        many[k].site.latitude = -60.0 + 120.0 * k / nsite;
+    }
+    if (S_tmy_run_init(&run, many, nsite,
+                       S_COL(C_ZENREF) | S_COL(C_AZIM) | S_COL(C_COSINC) |
+                       S_COL(C_AMPRESS)) != 0)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    for (k = 1; k <= threads; k *= 2)
+    {
+        S_tmy_run(&run, k);
+        printf("%d 个站点年，%d 线程：%.3f 秒，%.1f 站点年/秒（%.0f 时/秒），"
+               "出错 %ld\n", nsite, k, run.sec, nsite / run.sec,
+               run.batch.count / run.sec, run.errors);
+    }
+    S_tmy_run_free(&run);
+
+    /* 四、年份不一的文件 */
+    printf("\n");
+    bad += mixed("/tmp/tmtest-mixed.csv", 0, 72, 24, 1998);
+    bad += mixed("/tmp/tmtest-mixed.csv", 2023, 72, 24, 2023);
+    bad += mixed("/tmp/tmtest-mixed.csv", 2024, 96, 0, 2024);
+    remove("/tmp/tmtest-mixed.csv");
+
+    free(many);
+    S_tmy_free(&tmy[0]);
+    S_tmy_free(&tmy[1]);
+    printf("\n检查不过 %ld 处\n", bad);
+    return bad != 0;
+}
@@ -0,0 +1,265 @@
+/*============================================================================
+*
+*    名称：txtest00.c
+*
+*    目的：测试 'soltext.c' 的数值文本输出。
+*
+*        一、正确性：随机抽取大量单精度数（覆盖全部指数范围，另加太阳
+*        数据常见范围的密集抽样），固定小数位输出应与 printf("%.*f")
+*        逐字节相同；最短输出用 strtof 读回应与原数相同，且有效数字
+*        位数不多于 printf("%.*g") 能读回的最少位数。
+*
+*        二、速度：计算一批数据后，分别用 snprintf 和 'soltext.c'
+*        （固定 4 位小数、最短表示、不同线程数）写到 /dev/null，打印
+*        吞吐量，并核对 snprintf 与固定小数位两种方式的文本完全相同。
+*        三、多线程：S_text_write（两种格式，1 到格式线程数个线程，带
+*        表头）写到临时文件，读回应与 S_text_header 加 S_text_rows
+*        单线程的文本逐字节相同。
+*
+*        第一、三部分有不符或第二部分文本不同时返回 1。
+*
+*    用法：
+*         txtest [格式线程数 [站点数 [天数]]]   默认 4 个，64 站点，7 天
+*
+*----------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#define TMP  "/tmp/txtest.txt"
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "solpos00.h"
+#include "soltext.h"
+#include "solrt.h"
+
+static unsigned long long seed = 88172645463325252ULL;
+
+static unsigned rnd(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return (unsigned) (seed >> 11);
+}
+
+static float randfloat(int dense)
+{
+    unsigned u;
+    float    f;
+
+    if (dense)                            /* -2000 .. 2000 附近 */
+        return (float) ((int) (rnd() % 4000001) - 2000000) / (1 << (rnd() % 14));
+    do
+    {
+        u = rnd();
+        memcpy(&f, &u, sizeof(f));
+    } while (!isfinite(f));
+    return f;
+}
+
+/* 有效数字位数 */
+static int sigdigits(const char *s, int n)
+{
+    int k, d = 0, lead = 1, z = 0;
+
+    for (k = 0; k < n && s[k] != 'e'; k++)
+    {
+        if (s[k] < '0' || s[k] > '9')
+            continue;
+        if (lead && s[k] == '0')
+            continue;
+        lead = 0;
+        d++;
+        z = s[k] == '0' ? z + 1 : 0;
+    }
+    return d - z;                         /* 整数部分末尾的零不算 */
+}
+
+int main(int argc, char *argv[])
+{
+    struct posdata      *sites;
+    struct solbatch      batch;
+    struct soltext       fmt;
+    struct soltext_stats st;
+    char      mine[S_TEXT_FIELD + 1], ref[S_TEXT_FIELD + 1], *b1, *b2, *p;
+    long long *utc, t0;
+    int       *site;
+    float     *buf, f;
+    long      *retval, rows, ntime, r, checks = 0, bad_fix = 0, bad_rt = 0,
+               bad_len = 0, bad_thr = 0, len1, len2, got;
+    double     sec;
+    int        threads = 4, nsite = 64, days = 7, fd, k, n, m, prec, mode;
+
+    if (argc > 1) threads = atoi(argv[1]);
+    if (argc > 2) nsite   = atoi(argv[2]);
+    if (argc > 3) days    = atoi(argv[3]);
+    if (nsite < 1) nsite = 1;
+
+    /* 一、正确性 */
+    for (r = 0; r < 2000000; r++)
+    {
+        f = randfloat(r & 1);
+        prec = (int) (r % 10);
+        n = S_text_float(mine, f, prec);
+        mine[n] = 0;
+        snprintf(ref, sizeof(ref), "%.*f", prec, f);
+        if (strcmp(mine, ref) != 0 && bad_fix++ < 5)
+            printf("  固定 %d 位不同：%s 与 %s\n", prec, mine, ref);
+
+        n = S_text_float(mine, f, S_TEXT_SHORTEST);
+        mine[n] = 0;
+        if (strtof(mine, NULL) != f && bad_rt++ < 5)
+            printf("  读回不同：%.9g 写成 %s\n", f, mine);
+        for (m = 1; m < 9; m++)
+        {
+            snprintf(ref, sizeof(ref), "%.*g", m, f);
+            if (strtof(ref, NULL) == f)
+                break;
+        }
+        if (sigdigits(mine, n) > m && bad_len++ < 5)
+            printf("  不是最短：%s（%d 位即可）\n", mine, m);
+        checks++;
+    }
+    printf("抽查 %ld 个数：固定小数位不同 %ld，最短表示读回不同 %ld，"
+           "不是最短 %ld\n", checks, bad_fix, bad_rt, bad_len);
+
+    /* 二、速度 */
+    sites = (struct posdata *) malloc(nsite * sizeof(*sites));
+    ntime = 1440L * days;
+    rows  = ntime * nsite;
+    utc    = (long long *) malloc(rows * sizeof(*utc));
+    site   = (int *) malloc(rows * sizeof(*site));
+    retval = (long *) malloc(rows * sizeof(*retval));
+    buf    = (float *) malloc(6 * rows * sizeof(float));
+    if (!sites || !utc || !site || !retval || !buf)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+    for (k = 0; k < nsite; k++)
+    {
+        S_init(&sites[k]);
+        sites[k].latitude  = -60.0 + 120.0 * k / nsite;
+        sites[k].longitude = -180.0 + 360.0 * k / nsite;
+        sites[k].timezone  = (float) (int) (sites[k].longitude / 15.0);
+        sites[k].tilt      = 30.0;
+    }
+    for (r = 0; r < rows; r++)
+    {
+        site[r] = (int) (r / ntime);
+        utc[r]  = 1672531200LL + (r % ntime) * 60;
+    }
+    memset(&batch, 0, sizeof(batch));
+    batch.count  = rows;
+    batch.utc    = utc;
+    batch.site   = site;
+    batch.sites  = sites;
+    batch.retval = retval;
+    batch.col[C_AZIM]    = buf;
+    batch.col[C_COSINC]  = buf + rows;
+    batch.col[C_ELEVREF] = buf + 2 * rows;
+    batch.col[C_ETRN]    = buf + 3 * rows;
+    batch.col[C_ETRTILT] = buf + 4 * rows;
+    batch.col[C_ZENREF]  = buf + 5 * rows;
+    S_batch_parallel(&batch, threads);
+
+    fd = open("/dev/null", O_WRONLY);
+    b1 = (char *) malloc(rows * 9 * S_TEXT_FIELD / 4);
+    b2 = (char *) malloc(rows * 9 * S_TEXT_FIELD / 4);
+    if (fd < 0 || !b1 || !b2)
+    {
+        printf("内存不足\n");
+        return 1;
+    }
+
+    /* snprintf，单线程，与 soltext 固定 4 位小数同样的布局 */
+    t0 = S_rt_now();
+    for (p = b1, r = 0; r < rows; r++)
+    {
+        p += sprintf(p, "%lld,%d,%ld", utc[r], site[r], retval[r]);
+        for (k = 0; k < C_NCOL; k++)
+            if (batch.col[k])
+                p += sprintf(p, ",%.4f", batch.col[k][r]);
+        *p++ = '\n';
+    }
+    len1 = p - b1;
+    if (write(fd, b1, len1) < 0)
+        perror("write");
+    sec = (S_rt_now() - t0) * 1.0e-9;
+    printf("%ld 行，%.1f MB 文本\n", rows, len1 / 1048576.0);
+    printf("snprintf %%.4f      1 线程  %7.3f 秒  %8.1f MB/秒  %10.0f 行/秒\n",
+           sec, len1 / 1048576.0 / sec, rows / sec);
+
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.delim = ',';
+    fmt.prec  = 4;
+    len2 = (long) S_text_rows(&fmt, &batch, 0, rows, b2);
+    if (len1 != len2 || memcmp(b1, b2, len1) != 0)
+        bad_fix++;
+    printf("与 snprintf 文本%s\n",
+           len1 == len2 && memcmp(b1, b2, len1) == 0 ? "完全相同" : "不同！");
+
+    for (mode = 0; mode < 2; mode++)
+        for (n = 1; n <= threads; n *= 2)
+        {
+            fmt.prec    = mode ? S_TEXT_SHORTEST : 4;
+            fmt.threads = n;
+            t0 = S_rt_now();
+            S_text_write(&fmt, &batch, fd, 1, &st);
+            sec = (S_rt_now() - t0) * 1.0e-9;
+            printf("soltext %-8s %3d 线程  %7.3f 秒  %8.1f MB/秒  %10.0f 行/秒"
+                   "  （等待格式化 %.0f%%）\n",
+                   mode ? "最短" : "4 位", n, sec, st.bytes / 1048576.0 / sec,
+                   rows / sec, 100.0 * st.ns_wait * 1.0e-9 / sec);
+        }
+
+    close(fd);
+
+    /* 三、多线程写出的文本与单线程格式化的相同 */
+    for (mode = 0; mode < 2; mode++)
+    {
+        fmt.prec    = mode ? S_TEXT_SHORTEST : 4;
+        fmt.threads = 1;
+        len2  = (long) S_text_header(&fmt, &batch, b2);
+        len2 += (long) S_text_rows(&fmt, &batch, 0, rows, b2 + len2);
+        for (n = 1; n <= threads; n++)
+        {
+            fmt.threads = n;
+            fmt.block   = 1000 + 37 * n;          /* 块的边界各不相同 */
+            fd = open(TMP, O_RDWR | O_CREAT | O_TRUNC, 0666);
+            if (fd < 0 || S_text_write(&fmt, &batch, fd, 1, NULL) != 0 ||
+                lseek(fd, 0, SEEK_SET) != 0)
+            {
+                bad_thr++;
+                if (fd >= 0)
+                    close(fd);
+                continue;
+            }
+            for (len1 = 0; (got = read(fd, b1 + len1, len2 + 1 - len1)) > 0;)
+                len1 += got;
+            close(fd);
+            if (len1 != len2 || memcmp(b1, b2, len2) != 0)
+            {
+                printf("  %s %d 线程：%ld 字节，应为 %ld 字节\n",
+                       mode ? "最短" : "4 位", n, len1, len2);
+                bad_thr++;
+            }
+        }
+    }
+    fmt.block = 0;
+    remove(TMP);
+    printf("多线程 S_text_write 与单线程文本不同 %ld 次\n", bad_thr);
+
+    free(sites);
+    free(utc);
+    free(site);
+    free(retval);
+    free(buf);
+    free(b1);
+    free(b2);
+    return bad_fix != 0 || bad_rt != 0 || bad_len != 0 || bad_thr != 0;
+}